@@ -0,0 +1,543 @@
+#include "Benchmark.h"
+#include "Renderer.h"
+#include "RenderPipeline.h"
+#include "ColorGradingLUT.h"
+#include "Input.h"
+#include "Camera.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "TextureStreamer.h"
+#include "Material.h"
+#include "Mesh.h"
+#include "MeshRenderer.h"
+#include "StaticMeshRenderer.h"
+#include "CommandBucket.h"
+#include "UploadRing.h"
+#include "GPUProfiler.h"
+#include "CPUProfiler.h"
+#include "PointLightManager.h"
+#include "glm.hpp"
+#include "glm/include/ext.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <vector>
+
+// Distance between instances on the scene grid.
+#define BENCHMARK_GRID_SPACING 2.5f
+
+// Smallest half width of the scene, so small scenes still fill the camera path.
+#define BENCHMARK_MIN_EXTENTS 10.0f
+
+// Models instances are drawn with in addition to the sphere and C++ logo, skipped if their .obj has not been downloaded.
+static const char* s_szStanfordModels[] =
+{
+	"Assets/Objects/Stanford/Bunny.obj",
+	"Assets/Objects/Stanford/Dragon.obj",
+	"Assets/Objects/Stanford/Buddha.obj",
+	"Assets/Objects/Stanford/Lucy.obj"
+};
+
+// Summary of a set of samples.
+struct BenchmarkDistribution
+{
+	float m_fMean;
+	float m_fMedian;
+	float m_fPercentile95;
+	float m_fPercentile99;
+	float m_fMax;
+};
+
+// Percentiles by nearest rank, matching the GPU profiler.
+static BenchmarkDistribution Distribution(std::vector<float> samples)
+{
+	BenchmarkDistribution distribution = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+
+	if (samples.empty())
+		return distribution;
+
+	std::sort(samples.begin(), samples.end());
+
+	double dTotal = 0.0;
+
+	for (size_t i = 0; i < samples.size(); ++i)
+		dTotal += samples[i];
+
+	size_t nLast = samples.size() - 1;
+
+	distribution.m_fMean = static_cast<float>(dTotal / samples.size());
+	distribution.m_fMedian = samples[nLast / 2];
+	distribution.m_fPercentile95 = samples[(nLast * 95 + 99) / 100];
+	distribution.m_fPercentile99 = samples[(nLast * 99 + 99) / 100];
+	distribution.m_fMax = samples[nLast];
+
+	return distribution;
+}
+
+// Write a string as a quoted JSON string, escaping quotes, backslashes and control characters.
+static void WriteString(std::ofstream& file, const char* szString)
+{
+	const char* szHexDigits = "0123456789abcdef";
+
+	file << '"';
+
+	for(const char* c = szString; *c; ++c)
+	{
+		unsigned char nChar = static_cast<unsigned char>(*c);
+
+		if (nChar == '"' || nChar == '\\')
+			file << '\\' << *c;
+		else if (nChar < 0x20)
+			file << "\\u00" << szHexDigits[nChar >> 4] << szHexDigits[nChar & 0xF];
+		else
+			file << *c;
+	}
+
+	file << '"';
+}
+
+static void WriteDistribution(std::ofstream& file, const BenchmarkDistribution& distribution)
+{
+	file << "{\"mean\":" << distribution.m_fMean << ",\"p50\":" << distribution.m_fMedian << ",\"p95\":" << distribution.m_fPercentile95
+		<< ",\"p99\":" << distribution.m_fPercentile99 << ",\"max\":" << distribution.m_fMax << "}";
+}
+
+// Scale and offset a mesh so its bounding sphere has the provided diameter and is centred on the position.
+static glm::mat4 FitMesh(Mesh* mesh, glm::vec3 v3Position, float fYaw, float fDiameter)
+{
+	const glm::vec4& v4Sphere = mesh->BoundingSphere();
+	float fScale = v4Sphere.w > 0.0f ? (fDiameter * 0.5f) / v4Sphere.w : 1.0f;
+
+	return glm::translate(v3Position) * glm::rotate(fYaw, glm::vec3(0.0f, 1.0f, 0.0f)) * glm::scale(glm::vec3(fScale)) * glm::translate(-glm::vec3(v4Sphere));
+}
+
+Benchmark::Benchmark(const BenchmarkSettings& settings) : m_frames(1024, 1024)
+{
+	m_settings = settings;
+	m_nRandomState = settings.m_nSeed;
+	m_dynamicResolution.SetTargetFrameTime(settings.m_fTargetFrameTime);
+
+	m_renderer = nullptr;
+	m_pipeline = nullptr;
+	m_colorGradingLUT = nullptr;
+
+	m_sceneShader = nullptr;
+	m_streamedMap = nullptr;
+	m_instanceMaterial = nullptr;
+	m_staticMaterial = nullptr;
+	m_planeMesh = nullptr;
+	m_staticMeshes = nullptr;
+	m_fSceneExtents = BENCHMARK_MIN_EXTENTS;
+}
+
+Benchmark::~Benchmark()
+{
+	delete m_pipeline;
+	delete m_colorGradingLUT;
+	ReleaseScene();
+	delete m_renderer;
+}
+
+bool Benchmark::Run()
+{
+	if (!m_cameraPath.Load(m_settings.m_szCameraPath))
+		return false;
+
+	// Every frame of the path past the warmup is measured unless a frame count is set.
+	int nFrameCount = m_settings.m_nFrameCount > 0 ? m_settings.m_nWarmupFrames + m_settings.m_nFrameCount : m_cameraPath.FrameCount();
+
+	if(m_cameraPath.FrameCount() == 0 || nFrameCount <= m_settings.m_nWarmupFrames)
+	{
+		std::cout << "Benchmark Error: " << m_settings.m_szCameraPath << " has " << m_cameraPath.FrameCount() << " frames, no more than the "
+			<< m_settings.m_nWarmupFrames << " warmup frames." << std::endl;
+		return false;
+	}
+
+	CPUProfiler::Create();
+	CPUProfiler* cpuProfiler = CPUProfiler::GetInstance();
+	cpuProfiler->SetThreadName("Main");
+
+	m_renderer = new Renderer(m_settings.m_nWidth, m_settings.m_nHeight);
+
+	// Must precede every shader that reads or writes the G-buffer.
+	m_renderer->SetGBufferLayout(m_settings.m_eGBufferLayout);
+	m_renderer->SetLightingMode(m_settings.m_eLightingMode);
+
+	LoadMeshes();
+	BuildScene();
+
+	m_pipeline = new RenderPipeline(m_renderer, [this](CommandBucket* bucket)
+	{
+		m_instanceMaterial->DrawMeshes(bucket);
+		m_staticMaterial->DrawStaticMeshes(bucket);
+	});
+
+	m_pipeline->SetTemporalAA(m_settings.m_bTemporalAA);
+	m_pipeline->SetBloomStrength(m_settings.m_fBloomStrength);
+	m_pipeline->SetBloomLevelCount(m_settings.m_nBloomLevelCount);
+	m_pipeline->SetRenderScale(m_settings.m_fRenderScale);
+
+	if(m_settings.m_szColorGradingLUT)
+	{
+		m_colorGradingLUT = new ColorGradingLUT(m_settings.m_szColorGradingLUT);
+		m_pipeline->SetColorGradingLUT(m_colorGradingLUT);
+	}
+
+	// The camera path drives the input instead of GLFW callbacks.
+	Input::Create();
+	Input* input = Input::GetInstance();
+
+	// Same camera settings as the application the path was recorded in, starting behind the grid.
+	const Camera startCamera({ 0.0f, 4.0f, m_fSceneExtents + 4.0f }, { 0.0f, 0.0f, 0.0f }, 0.05f, 10.0f);
+	Camera camera = startCamera;
+
+	GPUProfiler* gpuProfiler = GPUProfiler::GetInstance();
+	UploadRing* uploadRing = UploadRing::GetInstance();
+	TextureStreamer* textureStreamer = TextureStreamer::GetInstance();
+	CommandBucket* commandBucket = m_renderer->GetCommandBucket();
+
+	// Keep a GPU sample of every measured frame, so GPU timings cover the whole run like the frame statistics.
+	gpuProfiler->SetSampleCount(nFrameCount - m_settings.m_nWarmupFrames);
+
+	std::cout << "Benchmark: " << m_settings.m_szName << ", " << nFrameCount << " frames at " << m_settings.m_nWidth << "x" << m_settings.m_nHeight << std::endl;
+
+	for(int i = 0; i < nFrameCount; ++i)
+	{
+		// Discard GPU timings of the warmup frames, waiting for those still in flight.
+		if(i == m_settings.m_nWarmupFrames)
+		{
+			gpuProfiler->Flush();
+			gpuProfiler->Reset();
+		}
+
+		// Each replay of the path starts from the same camera, so it renders the same frames.
+		int nPathFrame = i % m_cameraPath.FrameCount();
+
+		if (nPathFrame == 0)
+			camera = startCamera;
+
+		cpuProfiler->BeginFrame();
+
+		{
+			CPU_PROFILE_ZONE("Camera");
+
+			// Moved with the recorded delta time so the path is the same regardless of frame time.
+			m_cameraPath.PlayFrame(nPathFrame, input);
+			camera.Update(m_cameraPath.FrameDeltaTime(nPathFrame), input, nullptr);
+
+			m_renderer->SetViewMatrix(camera.GetViewMatrix(), camera.GetPosition());
+		}
+
+		m_renderer->Start();
+
+		m_pipeline->Execute(m_cameraPath.FrameDeltaTime(nPathFrame));
+
+		m_renderer->End();
+
+		// Scale the next frame's resolution, the scale of this frame is recorded below.
+		float fRenderScale = m_pipeline->RenderScale();
+
+		if (m_settings.m_fTargetFrameTime > 0.0f && m_dynamicResolution.Update())
+			m_pipeline->SetRenderScale(m_dynamicResolution.Scale());
+
+		input->EndFrame();
+
+		cpuProfiler->EndFrame();
+
+		if (i < m_settings.m_nWarmupFrames)
+			continue;
+
+		FrameStats stats;
+		stats.m_fFrameTime = cpuProfiler->LastFrameTime();
+		stats.m_nDrawCount = commandBucket->DrawCount();
+		stats.m_nDrawCallCount = commandBucket->DrawCallCount();
+		stats.m_nBytesUploaded = uploadRing->BytesUploaded();
+		stats.m_nBytesStreamed = textureStreamer->BytesUploaded();
+		stats.m_nStreamingPendingCount = textureStreamer->PendingCount();
+		stats.m_nVisibleLightCount = m_renderer->VisibleLightCount();
+		stats.m_fRenderScale = fRenderScale;
+
+		m_frames.Push(stats);
+	}
+
+	gpuProfiler->Flush();
+
+	bool bWritten = WriteReport();
+
+	Input::Destroy();
+
+	// Scene resources must be released while the renderer's context exists.
+	delete m_pipeline;
+	m_pipeline = nullptr;
+
+	delete m_colorGradingLUT;
+	m_colorGradingLUT = nullptr;
+
+	ReleaseScene();
+
+	delete m_renderer;
+	m_renderer = nullptr;
+
+	CPUProfiler::Destroy();
+
+	return bWritten;
+}
+
+void Benchmark::LoadMeshes()
+{
+	m_planeMesh = new Mesh("Assets/Primitives/plane.obj");
+
+	m_meshes.Push(new Mesh("Assets/Primitives/sphere.obj"));
+	m_meshes.Push(new Mesh("Assets/Objects/CPP/C++.obj"));
+
+	for(int i = 0; i < static_cast<int>(sizeof(s_szStanfordModels) / sizeof(const char*)); ++i)
+	{
+		std::ifstream modelFile(s_szStanfordModels[i]);
+
+		if (modelFile.good())
+			m_meshes.Push(new Mesh(s_szStanfordModels[i]));
+		else
+		{
+			std::cout << "Benchmark: " << s_szStanfordModels[i] << " not found, it is not part of the scene." << std::endl;
+			m_missingMeshes.Push(s_szStanfordModels[i]);
+		}
+	}
+}
+
+void Benchmark::BuildScene()
+{
+	Shader::SetGlobalDefine("NORMAL_MAP", m_settings.m_bStreamTextures);
+	m_sceneShader = new Shader("Shaders/plain.vs", "Shaders/plain.fs");
+	Shader::SetGlobalDefine("NORMAL_MAP", false);
+
+	m_instanceMaterial = new Material(m_sceneShader);
+	m_staticMaterial = new Material(m_sceneShader);
+
+	// Requested now and uploaded over the first frames, the materials use the streamer's placeholder until then.
+	if(m_settings.m_bStreamTextures)
+	{
+		m_streamedMap = new Texture("Assets/Objects/Metal/normal.tga", true);
+
+		m_instanceMaterial->AddMap(m_streamedMap);
+		m_staticMaterial->AddMap(m_streamedMap);
+	}
+
+	// Square grid wide enough for every instance...
+	int nGridSize = static_cast<int>(ceilf(sqrtf(static_cast<float>(m_settings.m_nInstanceCount))));
+	m_fSceneExtents = std::max(nGridSize * BENCHMARK_GRID_SPACING * 0.5f, BENCHMARK_MIN_EXTENTS);
+
+	// Instances are dealt out to a mesh renderer per mesh.
+	int nMeshCount = m_meshes.Count();
+
+	for (int i = 0; i < nMeshCount; ++i)
+		m_meshRenderers.Push(new MeshRenderer(m_meshes[i], m_instanceMaterial, m_settings.m_nInstanceCount / nMeshCount + 1));
+
+	for(int i = 0; i < m_settings.m_nInstanceCount; ++i)
+	{
+		float fX = (static_cast<float>(i % nGridSize) - (nGridSize - 1) * 0.5f) * BENCHMARK_GRID_SPACING;
+		float fZ = (static_cast<float>(i / nGridSize) - (nGridSize - 1) * 0.5f) * BENCHMARK_GRID_SPACING;
+		float fYaw = Random() * glm::two_pi<float>();
+
+		glm::mat4 model = FitMesh(m_meshes[i % nMeshCount], glm::vec3(fX, 1.0f, fZ), fYaw, 1.5f);
+		NVZMathLib::Vector4 v4Color(0.25f + Random() * 0.75f, 0.25f + Random() * 0.75f, 0.25f + Random() * 0.75f, 1.0f);
+
+		MeshRenderer* meshRenderer = m_meshRenderers[i % nMeshCount];
+		meshRenderer->UpdateInstance(meshRenderer->AddInstance(), glm::value_ptr(model), v4Color);
+	}
+
+	// Floor covering the grid, with the static meshes scattered over and above it.
+	m_staticMeshes = new StaticMeshRenderer(m_staticMaterial);
+
+	float fFloorDiameter = (m_fSceneExtents + BENCHMARK_GRID_SPACING) * 2.0f * glm::root_two<float>();
+	m_staticMeshes->PushMesh(m_planeMesh, glm::value_ptr(FitMesh(m_planeMesh, glm::vec3(0.0f), 0.0f, fFloorDiameter)));
+
+	for(int i = 0; i < m_settings.m_nStaticMeshCount; ++i)
+	{
+		glm::vec3 v3Position((Random() * 2.0f - 1.0f) * m_fSceneExtents, 0.5f + Random() * 4.0f, (Random() * 2.0f - 1.0f) * m_fSceneExtents);
+		float fYaw = Random() * glm::two_pi<float>();
+
+		m_staticMeshes->PushMesh(m_meshes[i % nMeshCount], glm::value_ptr(FitMesh(m_meshes[i % nMeshCount], v3Position, fYaw, 1.0f)));
+	}
+
+	m_staticMeshes->FinalizeBuffers();
+
+	// Point lights scattered over the grid.
+	int nLightCount = m_settings.m_nLightCount;
+
+	if(nLightCount > MAX_LIGHT_COUNT)
+	{
+		std::cout << "Benchmark Warning: " << nLightCount << " lights requested, only " << MAX_LIGHT_COUNT << " are supported." << std::endl;
+		nLightCount = MAX_LIGHT_COUNT;
+	}
+
+	for(int i = 0; i < nLightCount; ++i)
+	{
+		NVZMathLib::Vector4 v4Color(0.25f + Random() * 0.75f, 0.25f + Random() * 0.75f, 0.25f + Random() * 0.75f, 1.0f);
+		NVZMathLib::Vector3 v3Position((Random() * 2.0f - 1.0f) * m_fSceneExtents, 0.5f + Random() * 3.5f, (Random() * 2.0f - 1.0f) * m_fSceneExtents);
+
+		m_renderer->AddPointLight(v4Color, v3Position, 3.0f + Random() * 4.0f);
+	}
+}
+
+void Benchmark::ReleaseScene()
+{
+	// Renderers remove themselves from their material by index, so remove the last first.
+	for (int i = m_meshRenderers.Count() - 1; i >= 0; --i)
+		delete m_meshRenderers[i];
+
+	m_meshRenderers.Clear();
+
+	delete m_staticMeshes;
+	m_staticMeshes = nullptr;
+
+	delete m_instanceMaterial;
+	delete m_staticMaterial;
+	delete m_sceneShader;
+
+	m_instanceMaterial = nullptr;
+	m_staticMaterial = nullptr;
+	m_sceneShader = nullptr;
+
+	delete m_streamedMap;
+	m_streamedMap = nullptr;
+
+	for (int i = 0; i < m_meshes.Count(); ++i)
+		delete m_meshes[i];
+
+	m_meshes.Clear();
+	m_missingMeshes.Clear();
+
+	delete m_planeMesh;
+	m_planeMesh = nullptr;
+}
+
+bool Benchmark::WriteReport()
+{
+	std::ofstream file(m_settings.m_szReportPath);
+
+	if(!file.good())
+	{
+		std::cout << "Benchmark Error: Failed to open " << m_settings.m_szReportPath << " for writing." << std::endl;
+		return false;
+	}
+
+	std::vector<float> frameTimes;
+	std::vector<float> drawCounts;
+	std::vector<float> drawCallCounts;
+	std::vector<float> uploadSizes;
+	std::vector<float> streamedSizes;
+	std::vector<float> streamingPendingCounts;
+	std::vector<float> visibleLightCounts;
+	std::vector<float> renderScales;
+
+	double dTotalUploaded = 0.0;
+	double dTotalStreamed = 0.0;
+
+	for(int i = 0; i < m_frames.Count(); ++i)
+	{
+		const FrameStats& stats = m_frames[i];
+
+		frameTimes.push_back(stats.m_fFrameTime);
+		drawCounts.push_back(static_cast<float>(stats.m_nDrawCount));
+		drawCallCounts.push_back(static_cast<float>(stats.m_nDrawCallCount));
+		uploadSizes.push_back(static_cast<float>(stats.m_nBytesUploaded));
+		streamedSizes.push_back(static_cast<float>(stats.m_nBytesStreamed));
+		streamingPendingCounts.push_back(static_cast<float>(stats.m_nStreamingPendingCount));
+		visibleLightCounts.push_back(static_cast<float>(stats.m_nVisibleLightCount));
+		renderScales.push_back(stats.m_fRenderScale);
+
+		dTotalUploaded += stats.m_nBytesUploaded;
+		dTotalStreamed += stats.m_nBytesStreamed;
+	}
+
+	BenchmarkDistribution frameTime = Distribution(frameTimes);
+
+	// The renderer falls back to another layout where the requested one isn't supported.
+	const char* szLayoutNames[] = { "wide", "compact", "visibility" };
+	const char* szLightingModeNames[] = { "volume", "stencil", "clustered" };
+
+	file << std::fixed << std::setprecision(4);
+	file << "{\n";
+	file << "  \"name\": ";
+	WriteString(file, m_settings.m_szName);
+
+	// Mesh types count only the models found, those missing are listed so runs with different assets aren't compared unknowingly.
+	file << ",\n  \"settings\": {\"width\":" << m_settings.m_nWidth << ",\"height\":" << m_settings.m_nHeight << ",\"instances\":" << m_settings.m_nInstanceCount
+		<< ",\"lights\":" << m_settings.m_nLightCount << ",\"staticMeshes\":" << m_settings.m_nStaticMeshCount << ",\"meshTypes\":" << m_meshes.Count() << ",\"missingMeshes\":[";
+
+	for(int i = 0; i < m_missingMeshes.Count(); ++i)
+	{
+		file << (i > 0 ? "," : "");
+		WriteString(file, m_missingMeshes[i]);
+	}
+
+	file << "],\"seed\":" << m_settings.m_nSeed << ",\"renderScale\":" << m_settings.m_fRenderScale << ",\"targetFrameTimeMs\":" << m_settings.m_fTargetFrameTime
+		<< ",\"temporalAA\":" << (m_settings.m_bTemporalAA ? "true" : "false") << ",\"bloomStrength\":" << m_pipeline->BloomStrength() << ",\"bloomLevels\":" << m_pipeline->BloomLevelCount()
+		<< ",\"gBufferLayout\":\"" << szLayoutNames[m_renderer->GetGBufferLayout()] << "\",\"lighting\":\"" << szLightingModeNames[m_renderer->GetLightingMode()]
+		<< "\",\"colorGrading\":" << (m_pipeline->GetColorGradingLUT() ? "true" : "false")
+		<< ",\"streamTextures\":" << (m_settings.m_bStreamTextures ? "true" : "false") << ",\"warmupFrames\":" << m_settings.m_nWarmupFrames << ",\"cameraPath\":";
+	WriteString(file, m_settings.m_szCameraPath);
+	file << "},\n";
+	file << "  \"frames\": " << m_frames.Count() << ",\n";
+
+	file << "  \"frameTimeMs\": ";
+	WriteDistribution(file, frameTime);
+	file << ",\n  \"drawCalls\": ";
+	WriteDistribution(file, Distribution(drawCallCounts));
+	file << ",\n  \"draws\": ";
+	WriteDistribution(file, Distribution(drawCounts));
+	file << ",\n  \"bytesUploaded\": ";
+	WriteDistribution(file, Distribution(uploadSizes));
+	file << ",\n  \"bytesUploadedTotal\": " << std::setprecision(0) << dTotalUploaded << std::setprecision(4);
+	file << ",\n  \"bytesStreamed\": ";
+	WriteDistribution(file, Distribution(streamedSizes));
+	file << ",\n  \"bytesStreamedTotal\": " << std::setprecision(0) << dTotalStreamed << std::setprecision(4);
+	file << ",\n  \"texturesPending\": ";
+	WriteDistribution(file, Distribution(streamingPendingCounts));
+	file << ",\n  \"visibleLights\": ";
+	WriteDistribution(file, Distribution(visibleLightCounts));
+	file << ",\n  \"renderScale\": ";
+	WriteDistribution(file, Distribution(renderScales));
+
+	// GPU timings cover every measured frame, less those whose queries the profiler dropped.
+	GPUProfiler* gpuProfiler = GPUProfiler::GetInstance();
+
+	file << ",\n  \"gpuDroppedFrames\": " << gpuProfiler->DroppedFrameCount();
+	file << ",\n  \"gpuScopesMs\": [";
+
+	bool bFirstScope = true;
+
+	for(int i = 0; i < gpuProfiler->ScopeCount(); ++i)
+	{
+		GPUScopeTimings timings;
+
+		if (!gpuProfiler->GetTimings(i, timings))
+			continue;
+
+		file << (bFirstScope ? "\n" : ",\n");
+		bFirstScope = false;
+
+		file << "    {\"name\":";
+		WriteString(file, gpuProfiler->ScopeName(i));
+		file << ",\"depth\":" << gpuProfiler->ScopeDepth(i) << ",\"samples\":" << timings.m_nSampleCount
+			<< ",\"mean\":" << timings.m_fAverage << ",\"p50\":" << timings.m_fMedian << ",\"p95\":" << timings.m_fPercentile95
+			<< ",\"p99\":" << timings.m_fPercentile99 << ",\"max\":" << timings.m_fMax << "}";
+	}
+
+	file << "\n  ]\n}\n";
+
+	std::cout << "Benchmark: Frame time mean " << frameTime.m_fMean << "ms p50 " << frameTime.m_fMedian << "ms p95 " << frameTime.m_fPercentile95
+		<< "ms p99 " << frameTime.m_fPercentile99 << "ms, report written to " << m_settings.m_szReportPath << std::endl;
+
+	return file.good();
+}
+
+float Benchmark::Random()
+{
+	// Numerical Recipes LCG, the same sequence on every platform unlike rand().
+	m_nRandomState = m_nRandomState * 1664525u + 1013904223u;
+
+	return static_cast<float>(m_nRandomState >> 8) / 16777216.0f;
+}
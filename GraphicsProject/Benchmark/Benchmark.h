@@ -0,0 +1,113 @@
+#pragma once
+#include "DynamicArray.h"
+#include "InputRecording.h"
+#include "DynamicResolution.h"
+#include "Renderer.h"
+
+class RenderPipeline;
+class ColorGradingLUT;
+class Shader;
+class Texture;
+class Material;
+class Mesh;
+class MeshRenderer;
+class StaticMeshRenderer;
+
+// Parameters of a benchmark run.
+struct BenchmarkSettings
+{
+	const char* m_szName;
+	int m_nWidth;
+	int m_nHeight;
+	int m_nInstanceCount; // MeshRenderer instances, spread over a grid.
+	int m_nLightCount; // Point lights scattered over the grid.
+	int m_nStaticMeshCount; // Meshes merged into the static mesh renderer along with the floor.
+	int m_nWarmupFrames; // Frames rendered before any statistics are recorded.
+	int m_nFrameCount; // Frames measured after the warmup, replaying the camera path as often as needed, or zero to play the path once.
+	unsigned int m_nSeed; // Seed of light and instance placement.
+	float m_fRenderScale; // Scale of the internal render resolution, until dynamic resolution changes it.
+	float m_fTargetFrameTime; // GPU frame time dynamic resolution holds in milliseconds, or zero to keep the render scale.
+	bool m_bTemporalAA;
+	float m_fBloomStrength;
+	int m_nBloomLevelCount;
+	EGBufferLayout m_eGBufferLayout;
+	ELightingMode m_eLightingMode;
+	const char* m_szColorGradingLUT; // Lookup table the final image is graded with, or nullptr for no grading.
+	bool m_bStreamTextures; // Normal map the scene materials with a texture streamed in while the camera path plays.
+	const char* m_szCameraPath;
+	const char* m_szReportPath;
+};
+
+/*
+Renders a generated scene headless while flying the camera along a recorded input path, then writes the frame statistics as JSON.
+The scene is built from the settings and a fixed seed, and the camera is moved with the recorded delta times rather than the measured ones,
+so every run of the same settings renders exactly the same frames and runs are comparable before and after a change.
+*/
+class Benchmark
+{
+public:
+
+	Benchmark(const BenchmarkSettings& settings);
+
+	~Benchmark();
+
+	/*
+	Description: Create the renderer, build the scene, play the camera path and write the report.
+	Return Type: bool
+	Returns true if the camera path was played and the report written.
+	*/
+	bool Run();
+
+private:
+
+	// Statistics of a single measured frame.
+	struct FrameStats
+	{
+		float m_fFrameTime; // Milliseconds between the start of the frame and its end.
+		int m_nDrawCount;
+		int m_nDrawCallCount;
+		unsigned int m_nBytesUploaded;
+		unsigned int m_nBytesStreamed;
+		int m_nStreamingPendingCount;
+		int m_nVisibleLightCount;
+		float m_fRenderScale;
+	};
+
+	// Load the meshes instances are drawn with, the Stanford models are only used if present.
+	void LoadMeshes();
+
+	// Create the instances, static meshes and lights of the scene.
+	void BuildScene();
+
+	// Delete everything created by BuildScene and LoadMeshes.
+	void ReleaseScene();
+
+	// Write the settings and statistics of the run to the report path.
+	bool WriteReport();
+
+	// Deterministic random number in the range [0, 1).
+	float Random();
+
+	BenchmarkSettings m_settings;
+	unsigned int m_nRandomState;
+
+	Renderer* m_renderer;
+	RenderPipeline* m_pipeline;
+	ColorGradingLUT* m_colorGradingLUT;
+	InputRecording m_cameraPath;
+	DynamicResolution m_dynamicResolution;
+
+	// Scene
+	Shader* m_sceneShader;
+	Texture* m_streamedMap;
+	Material* m_instanceMaterial;
+	Material* m_staticMaterial;
+	Mesh* m_planeMesh;
+	DynamicArray<Mesh*> m_meshes;
+	DynamicArray<const char*> m_missingMeshes; // Models left out of the scene as their .obj was not found.
+	DynamicArray<MeshRenderer*> m_meshRenderers;
+	StaticMeshRenderer* m_staticMeshes;
+	float m_fSceneExtents; // Half the width of the square area the scene covers.
+
+	DynamicArray<FrameStats> m_frames;
+};
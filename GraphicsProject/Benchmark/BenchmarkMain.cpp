@@ -0,0 +1,148 @@
+#include "Benchmark.h"
+#include "RenderPipeline.h"
+
+#include <crtdbg.h>
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+
+static void PrintUsage()
+{
+	std::cout << "Usage: Benchmark [--name name] [--size width height] [--instances N] [--lights M] [--static K] [--warmup frames] [--frames N] [--seed seed]" << std::endl;
+	std::cout << "                 [--scale render_scale] [--target gpu_ms] [--taa 0|1] [--bloom strength levels] [--gbuffer wide|compact|visibility] [--lut color_grading_lut.png]" << std::endl;
+	std::cout << "                 [--lighting volume|stencil|clustered] [--stream] [--path camera_path.txt] [--out report.json]" << std::endl;
+	std::cout << "--frames measures N frames after the warmup, replaying the camera path as often as needed, by default the path is played once." << std::endl;
+	std::cout << "--scale renders at a fraction of the output resolution, --target enables dynamic resolution holding the GPU frame time." << std::endl;
+	std::cout << "--bloom scales the bloom added to the scene and sets the levels of its pyramid, " << BLOOM_STRENGTH << " and " << BLOOM_LEVEL_COUNT << " by default." << std::endl;
+	std::cout << "--stream normal maps the scene with a texture streamed in during the run, reporting the bytes streamed and textures pending per frame." << std::endl;
+	std::cout << "By default frames render at full resolution with temporal anti-aliasing into the compact G-buffer, lit by light volumes." << std::endl;
+	std::cout << "Run from the GraphicsProject directory so shaders and assets are found." << std::endl;
+}
+
+static bool ParseGBufferLayout(const char* szName, EGBufferLayout& eOutLayout)
+{
+	const char* szLayoutNames[] = { "wide", "compact", "visibility" };
+
+	for(int i = 0; i < 3; ++i)
+	{
+		if(strcmp(szName, szLayoutNames[i]) == 0)
+		{
+			eOutLayout = static_cast<EGBufferLayout>(i);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool ParseLightingMode(const char* szName, ELightingMode& eOutMode)
+{
+	const char* szModeNames[] = { "volume", "stencil", "clustered" };
+
+	for(int i = 0; i < LIGHTING_MODE_COUNT; ++i)
+	{
+		if(strcmp(szName, szModeNames[i]) == 0)
+		{
+			eOutMode = static_cast<ELightingMode>(i);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+int main(int argc, char** argv)
+{
+	_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
+
+	BenchmarkSettings settings;
+	settings.m_szName = "default";
+	settings.m_nWidth = 1280;
+	settings.m_nHeight = 720;
+	settings.m_nInstanceCount = 256;
+	settings.m_nLightCount = 128;
+	settings.m_nStaticMeshCount = 64;
+	settings.m_nWarmupFrames = 30;
+	settings.m_nFrameCount = 0;
+	settings.m_nSeed = 1;
+	settings.m_fRenderScale = 1.0f;
+	settings.m_fTargetFrameTime = 0.0f;
+	settings.m_bTemporalAA = true;
+	settings.m_fBloomStrength = BLOOM_STRENGTH;
+	settings.m_nBloomLevelCount = BLOOM_LEVEL_COUNT;
+	settings.m_eGBufferLayout = GBUFFER_LAYOUT_COMPACT;
+	settings.m_eLightingMode = LIGHTING_MODE_VOLUME;
+	settings.m_szColorGradingLUT = nullptr;
+	settings.m_bStreamTextures = false;
+	settings.m_szCameraPath = "Assets/CameraPaths/flythrough.txt";
+	settings.m_szReportPath = "benchmark.json";
+
+	for(int i = 1; i < argc; ++i)
+	{
+		bool bHasValue = i + 1 < argc;
+
+		if (strcmp(argv[i], "--name") == 0 && bHasValue)
+			settings.m_szName = argv[++i];
+		else if (strcmp(argv[i], "--size") == 0 && i + 2 < argc)
+		{
+			settings.m_nWidth = atoi(argv[++i]);
+			settings.m_nHeight = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--instances") == 0 && bHasValue)
+			settings.m_nInstanceCount = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--lights") == 0 && bHasValue)
+			settings.m_nLightCount = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--static") == 0 && bHasValue)
+			settings.m_nStaticMeshCount = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--warmup") == 0 && bHasValue)
+			settings.m_nWarmupFrames = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--frames") == 0 && bHasValue)
+			settings.m_nFrameCount = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--seed") == 0 && bHasValue)
+			settings.m_nSeed = static_cast<unsigned int>(atoi(argv[++i]));
+		else if (strcmp(argv[i], "--scale") == 0 && bHasValue)
+			settings.m_fRenderScale = static_cast<float>(atof(argv[++i]));
+		else if (strcmp(argv[i], "--target") == 0 && bHasValue)
+			settings.m_fTargetFrameTime = static_cast<float>(atof(argv[++i]));
+		else if (strcmp(argv[i], "--taa") == 0 && bHasValue)
+			settings.m_bTemporalAA = atoi(argv[++i]) != 0;
+		else if (strcmp(argv[i], "--bloom") == 0 && i + 2 < argc)
+		{
+			settings.m_fBloomStrength = static_cast<float>(atof(argv[++i]));
+			settings.m_nBloomLevelCount = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--gbuffer") == 0 && bHasValue && ParseGBufferLayout(argv[i + 1], settings.m_eGBufferLayout))
+			++i;
+		else if (strcmp(argv[i], "--lighting") == 0 && bHasValue && ParseLightingMode(argv[i + 1], settings.m_eLightingMode))
+			++i;
+		else if (strcmp(argv[i], "--lut") == 0 && bHasValue)
+			settings.m_szColorGradingLUT = argv[++i];
+		else if (strcmp(argv[i], "--stream") == 0)
+			settings.m_bStreamTextures = true;
+		else if (strcmp(argv[i], "--path") == 0 && bHasValue)
+			settings.m_szCameraPath = argv[++i];
+		else if (strcmp(argv[i], "--out") == 0 && bHasValue)
+			settings.m_szReportPath = argv[++i];
+		else
+		{
+			PrintUsage();
+			return -1;
+		}
+	}
+
+	if(settings.m_nWidth <= 0 || settings.m_nHeight <= 0 || settings.m_nInstanceCount < 0 || settings.m_nLightCount < 0 || settings.m_nStaticMeshCount < 0 || settings.m_nWarmupFrames < 0
+		|| settings.m_nFrameCount < 0 || settings.m_fRenderScale <= 0.0f || settings.m_fRenderScale > 1.0f || settings.m_fBloomStrength < 0.0f || settings.m_nBloomLevelCount < 1 
+		|| settings.m_nBloomLevelCount > BLOOM_MAX_LEVEL_COUNT)
+	{
+		PrintUsage();
+		return -1;
+	}
+
+	Benchmark* benchmark = new Benchmark(settings);
+
+	int code = benchmark->Run() ? 0 : -1;
+
+	delete benchmark;
+
+	return code;
+}
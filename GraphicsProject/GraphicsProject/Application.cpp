@@ -10,7 +10,9 @@
 #include "Shader.h"
 #include "Texture.h"
 #include "CubeMap.h"
+#include "TextureCompressor.h"
 #include "Material.h"
+#include "MaterialTable.h"
 #include "Mesh.h"
 #include "Batch.h"
 #include "StaticMeshRenderer.h"
@@ -23,10 +25,24 @@
 #include "glm/include/ext.hpp"
 
 #include "RenderSingle.h"
+#include "RenderPipeline.h"
+#include "UploadRing.h"
+#include "GLState.h"
+#include "CommandBucket.h"
+#include "GPUProfiler.h"
+#include "CPUProfiler.h"
 
 #define MOUSE_SENSITIVITY 0.1f
 #define CAMERA_MOVE_SPEED 5.0f
-#define BLOOM_PASS_COUNT 2
+
+// Frames taking longer than this many milliseconds are written to a CPU trace along with the frames around them.
+#define CPU_HITCH_BUDGET 100.0f
+
+// GPU frame time in milliseconds the internal resolution is scaled to hold.
+#define DYNAMIC_RESOLUTION_TARGET 16.6f
+
+// File camera paths recorded with R are written to, the benchmark plays them back.
+#define CAMERA_PATH_RECORDING "camera_path.txt"
 
 using namespace NVZMathLib;
 
@@ -35,30 +51,39 @@ Renderer* Application::m_renderer = nullptr;
 
 Application::Application()
 {
+	// Create the CPU profiler first, so loading is recorded.
+	CPUProfiler::Create();
+	CPUProfiler::GetInstance()->SetThreadName("Main");
+	CPUProfiler::GetInstance()->SetHitchBudget(CPU_HITCH_BUDGET);
 
+	m_window = nullptr;
+	m_bGLFWInit = false;
+	m_nHeadlessFrameCount = 0;
+	m_szCapturePath = nullptr;
+	m_bRecordingCameraPath = false;
+	m_bDynamicResolution = false;
 }
 
 Application::~Application()
 {
-	if (m_bGLFWInit)
-		glfwTerminate();
-	else
-		return;
-
-	// Destroy renderer.
+	// Destroy renderer, a headless renderer destroys its own context.
 	delete m_renderer;
 
 	// Destroy window.
-	glfwDestroyWindow(m_window);
+	if (m_window)
+		glfwDestroyWindow(m_window);
+
+	if (m_bGLFWInit)
+		glfwTerminate();
 
 	// Destroy input.
 	Input::Destroy();
+
+	CPUProfiler::Destroy();
 }
 
 int Application::Init() 
 {
-	m_bGLFWInit = false;
-
 	if (!glfwInit())
 		return -1;
 
@@ -89,44 +114,51 @@ int Application::Init()
 	// Initialize camera.
 	m_camera = Camera({ 0.0f, 2.5f, 5.0f }, { 0.0f, 0.0f, 0.0f }, 0.05f, 10.0f);
 
+	// Scale resolution to hold the target frame time, headless runs always render at full resolution.
+	m_dynamicResolution = DynamicResolution(DYNAMIC_RESOLUTION_TARGET);
+	m_bDynamicResolution = true;
+
 	return 0;
 }
 
-void Application::Run() 
+int Application::InitHeadless(int nWidth, int nHeight, int nFrameCount, const char* szCapturePath)
 {
-	// Fullscreen quad shaders.
-	Shader* quadShader = new Shader("Shaders/quad/standard_fsquad.vs", "Shaders/quad/standard_fsquad.fs");
-	Shader* brightShader = new Shader("Shaders/quad/standard_fsquad.vs", "Shaders/quad/standard_bright.fs");
-	Shader* bloomHDRShader = new Shader("Shaders/quad/standard_fsquad.vs", "Shaders/quad/standard_bloom_hdr.fs");
-	Shader* directionalLightSdr = new Shader("Shaders/quad/standard_fsquad.vs", "Shaders/light/deferred_directional_light_pbr.fs");
-	
-	Shader* gaussianHrzntl = new Shader("Shaders/quad/standard_fsquad.vs", "Shaders/quad/standard_gaussian_h.fs");
-	Shader* gaussianVert = new Shader("Shaders/quad/standard_fsquad.vs", "Shaders/quad/standard_gaussian_v.fs");
+	m_nHeadlessFrameCount = nFrameCount;
+	m_szCapturePath = szCapturePath;
 
-	// Skybox shader.
-	Shader* skyboxShader = new Shader("Shaders/skybox/skybox.vs", "Shaders/skybox/skybox.fs");
+	// Create renderer with its own context and offscreen backbuffer.
+	m_renderer = new Renderer(nWidth, nHeight);
 
-	// Bloom uniform variables
-	gaussianHrzntl->Use();
-	gaussianHrzntl->SetUniformFloat("power", 0.003f);
+	// Input is never updated, but keeps key queries valid.
+	Input::Create();
+	m_input = Input::GetInstance();
 
-	gaussianVert->Use();
-	gaussianVert->SetUniformFloat("power", 0.003f);
+	// Initialize camera, it stays in place as there is no input.
+	m_camera = Camera({ 0.0f, 2.5f, 5.0f }, { 0.0f, 0.0f, 0.0f }, 0.05f, 10.0f);
 
-	bloomHDRShader->Use();
-	bloomHDRShader->SetUniformFloat("exposure", 1.0f);
+	return 0;
+}
 
-	Shader::ResetBinding();
+void Application::Run() 
+{
+	// Loading is recorded as a zone, hitch captures reaching back to the first frame include it.
+	unsigned long long nSetupStart = CPUProfiler::GetInstance()->Now();
 
-	// Scene object shaders
-	Shader* plainShader = new Shader("Shaders/plain.vs", "Shaders/plain.fs");
+	// Skybox shader.
+	Shader* skyboxShader = new Shader("Shaders/skybox/skybox.vs", "Shaders/skybox/skybox.fs");
 
-	Shader* lightShader = new Shader("Shaders/light/deferred_point_light_pbr.vs", "Shaders/light/deferred_point_light_pbr.fs");
+	// Scene object shader, reading the normal map from the material's first map.
+	// Where bindless textures are supported maps are read from the material table, so the floor and sphere can share a multi-draw.
+	Shader::SetGlobalDefine("NORMAL_MAP", true);
+	Shader::SetGlobalDefine("MATERIAL_TABLE", MaterialTable::GetInstance() != nullptr);
+	Shader* normalMappedShader = new Shader("Shaders/plain.vs", "Shaders/plain.fs");
+	Shader::SetGlobalDefine("MATERIAL_TABLE", false);
+	Shader::SetGlobalDefine("NORMAL_MAP", false);
 
 	Mesh* planeMesh = new Mesh("Assets/Primitives/plane.obj");
 	Mesh* sphereMesh = new Mesh("Assets/Primitives/sphere.obj");
 
-	DynamicArray<const char*> mapFaces = 
+	const char* szSkyboxFaces[] = 
 	{
 		"Assets/Skybox/stormydays_ft.tga",
 		"Assets/Skybox/stormydays_bk.tga",
@@ -136,217 +168,280 @@ void Application::Run()
 		"Assets/Skybox/stormydays_lf.tga"
 	};
 
-	CubeMap* skyTex = new CubeMap(mapFaces);
-
-	// Floor plane material
-	Material* floorMat = new Material(plainShader);
+	// Faces are compressed to BC1 the first time they are loaded, later runs read the compressed copies.
+	std::string compressedFaces[6];
+	DynamicArray<const char*> mapFaces;
 
-	// Model matrix for the plane
-	glm::mat4 floorModelMatrix;
+	for(int i = 0; i < 6; ++i)
+	{
+		compressedFaces[i] = TextureCompressor::CompressedPath(szSkyboxFaces[i], TEXTURE_COMPRESSION_BC1);
+		mapFaces.Push(compressedFaces[i].c_str());
+	}
 
-	Framebuffer* gBuffer = new Framebuffer(m_renderer->WindowWidth(), m_renderer->WindowHeight());
-	gBuffer->AddBufferColorAttachment(BUFFER_FLOAT_RGBA16); // Diffuse buffer.
-	gBuffer->AddBufferColorAttachment(BUFFER_FLOAT_RGBA16); // Position buffer.
-	gBuffer->AddBufferColorAttachment(BUFFER_FLOAT_RGBA16); // Normal buffer.
-	gBuffer->AddBufferColorAttachment(BUFFER_FLOAT_RGBA16); // Specular buffer.
-	gBuffer->AddBufferColorAttachment(BUFFER_RGB); // Roughness, spec strength, reflection coefficent
-	gBuffer->AddBufferColorAttachment(BUFFER_RGB); // Emission
-	gBuffer->AddDepthAttachment();
+	CubeMap* skyTex = new CubeMap(mapFaces);
 
-	// Color buffer for HDR.
-	Framebuffer* brightColorBuffer = new Framebuffer(m_renderer->WindowWidth(), m_renderer->WindowHeight());
-	brightColorBuffer->AddBufferColorAttachment(BUFFER_RGB); // Bright color.
+	// Material maps are compressed to the format suiting their kind, normal maps keep only X and Y in BC5.
+	std::string metalNormalPath = TextureCompressor::CompressedPath("Assets/Objects/Metal/normal.tga", TextureCompressor::FormatForMap(TEXTURE_MAP_NORMAL));
+	Texture* metalNormalMap = new Texture(metalNormalPath.c_str());
 
-	Framebuffer* bloomBuffer = new Framebuffer(m_renderer->WindowWidth(), m_renderer->WindowHeight());
-	bloomBuffer->AddBufferColorAttachment(BUFFER_FLOAT_RGB16); // Albedo color.
+	// Sphere material
+	Material* metalMat = new Material(normalMappedShader);
+	metalMat->AddMap(metalNormalMap);
 
-	Framebuffer* blurBuffers[2] = { new Framebuffer(m_renderer->WindowWidth(), m_renderer->WindowHeight()), new Framebuffer(m_renderer->WindowWidth(), m_renderer->WindowHeight()) };
-	blurBuffers[0]->AddBufferColorAttachment(BUFFER_RGB); // Bright colors.
-	blurBuffers[1]->AddBufferColorAttachment(BUFFER_RGB); // Bright colors.
+	// The floor's map is decoded and uploaded over the first frames instead, it is drawn with a placeholder until then.
+	Texture* floorNormalMap = new Texture("Assets/Objects/Metal/normal.tga", true);
 
-	// Set shaders used for deferred shading pass.
-	m_renderer->SetDLightShader(directionalLightSdr);
-	m_renderer->SetPLightShader(lightShader);
+	// Floor plane material
+	Material* floorMat = new Material(normalMappedShader);
+	floorMat->AddMap(floorNormalMap);
 
 	// Contains a static mesh that can be rendered in a single draw call.
 	StaticMeshRenderer staticMeshes(floorMat);
 
-	// Add two spears to the mesh.
 	staticMeshes.PushMesh(planeMesh, glm::value_ptr(glm::mat4()));
-	staticMeshes.PushMesh(sphereMesh, glm::value_ptr(glm::translate(glm::vec3(-1.0f, 2.0f, -2.0f))));
-
 	staticMeshes.FinalizeBuffers();
 
+	StaticMeshRenderer sphereMeshes(metalMat);
+
+	sphereMeshes.PushMesh(sphereMesh, glm::value_ptr(glm::translate(glm::vec3(-1.0f, 2.0f, -2.0f))));
+	sphereMeshes.FinalizeBuffers();
+
+	// ------------------------------------------------------------------------------------
+	// Frame
+
+	RenderPipeline* pipeline = new RenderPipeline(m_renderer, [&](CommandBucket* bucket) 
+	{
+		floorMat->DrawStaticMeshes(bucket);
+		metalMat->DrawStaticMeshes(bucket);
+	});
+
 	// Add scene light.
 	m_renderer->AddPointLight(NVZMathLib::Vector4(1.0f, 1.0f, 1.0f, 1.0f), NVZMathLib::Vector3(0.0f, 3.5f, 0.0f), 5.0f);
 	m_renderer->AddPointLight(NVZMathLib::Vector4(1.0f, 0.0f, 0.0f, 1.0f), NVZMathLib::Vector3(-3.0f, 3.0f, -2.0f), 5.0f);
 
+	CPUProfiler::GetInstance()->RecordZone("Scene setup", nSetupStart, CPUProfiler::GetInstance()->Now());
+
 	float fDeltaTime = 0.0f;	
+	float fStatTimer = 0.0f;
+
+	// Headless runs render a fixed amount of frames instead of running until the window is closed.
+	bool bHeadless = m_renderer->IsHeadless();
+	int nFrameIndex = 0;
+	float fHeadlessTime = 0.0f;
 
-	while(!glfwWindowShouldClose(m_window)) 
+	while(bHeadless ? nFrameIndex < m_nHeadlessFrameCount : !glfwWindowShouldClose(m_window)) 
 	{
 		// Time
 		auto startTime = std::chrono::high_resolution_clock::now();
 
-		// Quit if escape is pressed.
-		if (m_input->GetKey(GLFW_KEY_ESCAPE))
-			glfwSetWindowShouldClose(m_window, 1);
+		CPUProfiler::GetInstance()->BeginFrame();
+
+		// Input
+		{
+			CPU_PROFILE_ZONE("Input");
+
+			// Quit if escape is pressed.
+			if (!bHeadless && m_input->GetKey(GLFW_KEY_ESCAPE))
+				glfwSetWindowShouldClose(m_window, 1);
+
+			// Cycle between point lighting techniques for comparison.
+			if (m_input->GetKey(GLFW_KEY_L) && !m_input->GetKey(GLFW_KEY_L, INPUTSTATE_PREVIOUS))
+			{
+				const char* szModeNames[LIGHTING_MODE_COUNT] = { "Light volumes", "Stencil light volumes", "Clustered" };
+
+				ELightingMode eMode = static_cast<ELightingMode>((m_renderer->GetLightingMode() + 1) % LIGHTING_MODE_COUNT);
+				m_renderer->SetLightingMode(eMode);
+
+				std::cout << "Lighting mode: " << szModeNames[eMode] << std::endl;
+			}
+
+			// Toggle Hi-Z occlusion culling for comparison.
+			if (m_input->GetKey(GLFW_KEY_O) && !m_input->GetKey(GLFW_KEY_O, INPUTSTATE_PREVIOUS))
+			{
+				pipeline->SetHiZOcclusion(!pipeline->HiZOcclusion());
+
+				std::cout << "Hi-Z occlusion culling: " << (pipeline->HiZOcclusion() ? "On" : "Off") << std::endl;
+			}
+
+			// Toggle temporal anti-aliasing for comparison.
+			if (m_input->GetKey(GLFW_KEY_J) && !m_input->GetKey(GLFW_KEY_J, INPUTSTATE_PREVIOUS))
+			{
+				pipeline->SetTemporalAA(!pipeline->TemporalAA());
+
+				std::cout << "Temporal anti-aliasing: " << (pipeline->TemporalAA() ? "On" : "Off") << std::endl;
+			}
+
+			// Write per pass GPU timings.
+			if (m_input->GetKey(GLFW_KEY_P) && !m_input->GetKey(GLFW_KEY_P, INPUTSTATE_PREVIOUS))
+			{
+				if (GPUProfiler::GetInstance()->WriteCSV("gpu_timings.csv"))
+					std::cout << "GPU timings written to gpu_timings.csv" << std::endl;
+			}
+
+			// Write the CPU zones still buffered.
+			if (m_input->GetKey(GLFW_KEY_T) && !m_input->GetKey(GLFW_KEY_T, INPUTSTATE_PREVIOUS))
+			{
+				if (CPUProfiler::GetInstance()->WriteTrace("cpu_trace.json"))
+					std::cout << "CPU trace written to cpu_trace.json" << std::endl;
+			}
+
+			// Toggle dynamic resolution, returning to full resolution when disabled.
+			if (!bHeadless && m_input->GetKey(GLFW_KEY_V) && !m_input->GetKey(GLFW_KEY_V, INPUTSTATE_PREVIOUS))
+			{
+				m_bDynamicResolution = !m_bDynamicResolution;
+				m_dynamicResolution.Reset();
+				pipeline->SetRenderScale(m_dynamicResolution.Scale());
+
+				std::cout << "Dynamic resolution: " << (m_bDynamicResolution ? "On" : "Off") << std::endl;
+			}
+
+			// Start or stop recording the input driving the camera.
+			if (m_input->GetKey(GLFW_KEY_R) && !m_input->GetKey(GLFW_KEY_R, INPUTSTATE_PREVIOUS))
+			{
+				m_bRecordingCameraPath = !m_bRecordingCameraPath;
+
+				if (m_bRecordingCameraPath)
+				{
+					m_cameraPath.Clear();
+					std::cout << "Recording camera path..." << std::endl;
+				}
+				else if (m_cameraPath.Save(CAMERA_PATH_RECORDING))
+					std::cout << "Camera path of " << m_cameraPath.FrameCount() << " frames written to " << CAMERA_PATH_RECORDING << std::endl;
+			}
+		}
 
 		// ------------------------------------------------------------------------------------
 		// Camera & View matrix
 
-		m_camera.Update(fDeltaTime, m_input, m_window);
+		{
+			CPU_PROFILE_ZONE("Camera");
+
+			if (m_bRecordingCameraPath)
+				m_cameraPath.RecordFrame(m_input, fDeltaTime);
+
+			if (!bHeadless)
+				m_camera.Update(fDeltaTime, m_input, m_window);
 
-		m_renderer->SetViewMatrix(m_camera.GetViewMatrix(), m_camera.GetPosition());
+			m_renderer->SetViewMatrix(m_camera.GetViewMatrix(), m_camera.GetPosition());
+		}
 
 		// ------------------------------------------------------------------------------------
 
 		// Poll events.
-		glfwPollEvents();
+		if (!bHeadless)
+		{
+			CPU_PROFILE_ZONE("Poll events");
+			glfwPollEvents();
+		}
 
 		// Rendering...
 
-		// Bind G Buffer...
-
 		m_renderer->Start();
-		gBuffer->Bind();
-		m_renderer->ClearFramebuffer();
-		
-		// Draw calls here...
-
-		floorMat->DrawStaticMeshes();
-		m_renderer->DrawFinal();
-
-		bloomBuffer->Bind();
-
-		// Draw fullscreen quad...
-		m_renderer->DrawFSQuad(quadShader, gBuffer->GetTextureArray(), gBuffer->GetAttachmentCount());
 
-		// Uncomment this to enable the directional light.
-		//m_renderer->RunDeferredDirectionalLight(gBuffer->GetTextureArray(), gBuffer->GetAttachmentCount(), Vector3(-1.0f, -0.5f, -1.0f).Normalised(), Vector3(1.0f));
+		pipeline->Execute(fDeltaTime);
 
-		m_renderer->ReportErrors();
-		m_renderer->RunDeferredPointLighting(gBuffer->GetTextureArray(), gBuffer->GetAttachmentCount());
+		// Stuff can be rendered in forward here.
 
-		// Bind fullscreen quad for minimal state changes during post effect rendering.
-		m_renderer->BindFSQuad();
+		/*
+		// Uncomment this to draw the skybox.
 
-		// Bind first blur buffer.
-		brightColorBuffer->Bind();
+		m_renderer->BindSkybox();
+		skyboxShader->Use();
+		skyTex->BindCubeMap();
+		m_renderer->DrawSkybox();
+		*/
 
-		// Render bright color into first hdr
-		brightShader->Use();
-		m_renderer->BindTextures(bloomBuffer->GetTextureArray(), 1);
-		m_renderer->DrawFSQuadNoState();
+		// Write the last headless frame to disk.
+		if (bHeadless && m_szCapturePath && nFrameIndex == m_nHeadlessFrameCount - 1)
+		{
+			if (m_renderer->SaveFrame(m_szCapturePath))
+				std::cout << "Saved frame to " << m_szCapturePath << std::endl;
+		}
 
-		Framebuffer* currentBuffer = blurBuffers[1];
-		Framebuffer* lastBuffer = blurBuffers[0];
+		m_renderer->End();
 
-		// Bind first blur buffer.
-		lastBuffer->Bind();
+		// Pick the internal resolution of the next frame from the latest GPU frame time.
+		if (m_bDynamicResolution && m_dynamicResolution.Update())
+			pipeline->SetRenderScale(m_dynamicResolution.Scale());
 
-		// First horizontal blur pass.
-		gaussianHrzntl->Use();
-		m_renderer->BindTextures(brightColorBuffer->GetTextureArray(), 1);
-		m_renderer->DrawFSQuadNoState();
+		// Store this frame's input state for comparison next frame.
+		m_input->EndFrame();
 
-		// Remaining horizontal passes.
-		for(int i = 0; i < BLOOM_PASS_COUNT - 1; ++i)
-		{
-			currentBuffer->Bind();
+		// Frames over the hitch budget are captured along with the frames around them.
+		CPUProfiler::GetInstance()->EndFrame();
 
-			m_renderer->BindTextures(lastBuffer->GetTextureArray(), 1);
-			m_renderer->DrawFSQuadNoState();
+		// End time...
+		auto endTime = std::chrono::high_resolution_clock::now();
 
-			Framebuffer* lastBufferCpy = lastBuffer;
+		auto timeDuration = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count();
 
-			lastBuffer = currentBuffer;
-			currentBuffer = lastBufferCpy;
-		}
+		fDeltaTime = static_cast<float>(timeDuration) / 1000000.0f;
 
-		gaussianVert->Use();
+		++nFrameIndex;
 
-		// Vertical pass.
-		for (int i = 0; i < BLOOM_PASS_COUNT; ++i)
+		if(bHeadless) 
 		{
-			currentBuffer->Bind();
-
-			m_renderer->BindTextures(lastBuffer->GetTextureArray(), 1);
-			m_renderer->DrawFSQuadNoState();
-
-			Framebuffer* lastBufferCpy = lastBuffer;
-
-			lastBuffer = currentBuffer;
-			currentBuffer = lastBufferCpy;
+			fHeadlessTime += fDeltaTime;
+			continue;
 		}
 
-		// Reset FBO binding.
-		m_renderer->ResetFramebufferBinding();
+		// Report light culling, upload and state change results in the window title twice per second.
+		fStatTimer += fDeltaTime;
 
-		// Get final textures...
-		Texture* m_finalBloomTex[2] = 
+		if(fStatTimer >= 0.5f) 
 		{
-			bloomBuffer->GetTextureArray()[0],
-			lastBuffer->GetTextureArray()[0]
-		};
+			UploadRing* uploadRing = UploadRing::GetInstance();
+			GLState* glState = GLState::GetInstance();
 
-		// Draw final result...
-		bloomHDRShader->Use();
-		m_renderer->BindTextures(&m_finalBloomTex[0], 2);
-		m_renderer->DrawFSQuadNoState();
+			CommandBucket* commandBucket = m_renderer->GetCommandBucket();
 
-		// Unbind fullscreen quad.
-		m_renderer->UnbindVAO();
+			GPUScopeTimings gpuFrameTimings;
+			GPUProfiler::GetInstance()->GetTimings("Frame", gpuFrameTimings);
 
-		// Copy G Buffer's depth to the default FBO's depth texture.
-		m_renderer->UseDepthTextureOf(gBuffer);
-		m_renderer->EnableDepthTesting();
+			char szTitle[384];
+			sprintf_s(szTitle, "OpenGL Renderer | GPU: %.2fms Scale: %i%% TAA: %s | Lights visible: %i culled: %i | Uploaded: %.1fKB Fence wait: %.2fms | State changes issued: %i elided: %i | Draws: %i calls: %i material changes: %i | Instances cull tested: %i", 
+				gpuFrameTimings.m_nSampleCount > 0 ? gpuFrameTimings.m_fAverage : 0.0f, static_cast<int>(pipeline->RenderScale() * 100.0f + 0.5f), pipeline->TemporalAA() ? "On" : "Off", 
+				m_renderer->VisibleLightCount(), m_renderer->CulledLightCount(), uploadRing->BytesUploaded() / 1024.0f, uploadRing->FenceWaitTime(),
+				glState->IssuedCount(), glState->ElidedCount(), commandBucket->DrawCount(), commandBucket->DrawCallCount(), commandBucket->MaterialChangeCount(), commandBucket->CullTestedInstanceCount());
 
-		// Stuff can be rendered in forward here.
+			glfwSetWindowTitle(m_window, szTitle);
 
-		/*
-		// Uncomment this to draw the skybox.
+			fStatTimer = 0.0f;
+		}
+	}
 
-		m_renderer->BindSkybox();
-		skyboxShader->Use();
-		skyTex->BindCubeMap();
-		m_renderer->DrawSkybox();
-		*/
+	if(bHeadless && nFrameIndex > 0) 
+	{
+		std::cout << "Rendered " << nFrameIndex << " headless frames, average frame time: " << (fHeadlessTime * 1000.0f) / nFrameIndex << "ms" << std::endl;
 
-		m_renderer->End();
+		// Report GPU time per pass, reading the frames still in flight first...
+		GPUProfiler* gpuProfiler = GPUProfiler::GetInstance();
+		gpuProfiler->Flush();
 
-		// End time...
-		auto endTime = std::chrono::high_resolution_clock::now();
+		for(int i = 0; i < gpuProfiler->ScopeCount(); ++i) 
+		{
+			GPUScopeTimings timings;
 
-		auto timeDuration = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count();
+			if (!gpuProfiler->GetTimings(i, timings))
+				continue;
 
-		fDeltaTime = static_cast<float>(timeDuration) / 1000000.0f;
+			std::cout << std::string(gpuProfiler->ScopeDepth(i) * 2, ' ') << gpuProfiler->ScopeName(i) << " GPU average: " << timings.m_fAverage 
+				<< "ms median: " << timings.m_fMedian << "ms 95th percentile: " << timings.m_fPercentile95 << "ms" << std::endl;
+		}
 	}
 
 	// Free memory.
 
-	delete gBuffer;
-	delete brightColorBuffer;
-
-	delete bloomBuffer;
+	delete pipeline;
 
-	delete blurBuffers[1];
-	delete blurBuffers[0];
-
-	delete quadShader;
-	delete brightShader;
-	delete bloomHDRShader;
-	
-	delete gaussianVert;
-	delete gaussianHrzntl;
-	
 	delete skyboxShader;
-
-	delete directionalLightSdr;
-	delete lightShader;
-	delete plainShader;
+	delete normalMappedShader;
 
 	delete floorMat;
+	delete metalMat;
+
+	delete floorNormalMap;
+	delete metalNormalMap;
 
 	delete skyTex;
 
@@ -1,5 +1,7 @@
 #pragma once
 #include "Camera.h"
+#include "InputRecording.h"
+#include "DynamicResolution.h"
 
 struct GLFWwindow;
 
@@ -16,6 +18,18 @@ public:
 
 	int Init();
 
+	/*
+	Description: Initialize without a window, rendering a fixed amount of frames from the initial camera to an offscreen backbuffer.
+	Return Type: int
+	Returns zero on success.
+	Param:
+	    int nWidth: The width of the rendered frames in pixels.
+		int nHeight: The height of the rendered frames in pixels.
+		int nFrameCount: The amount of frames Run renders before returning.
+		const char* szCapturePath: Path of the TGA file the last frame is written to, or nullptr to write nothing.
+	*/
+	int InitHeadless(int nWidth, int nHeight, int nFrameCount, const char* szCapturePath);
+
 	void Run();
 
 private:
@@ -32,6 +46,18 @@ private:
 	static Input* m_input;
 	bool m_bGLFWInit;
 
+	// Headless runs
+	int m_nHeadlessFrameCount;
+	const char* m_szCapturePath;
+
+	// Internal resolution scaling
+	DynamicResolution m_dynamicResolution;
+	bool m_bDynamicResolution;
+
+	// Camera path recording
+	InputRecording m_cameraPath;
+	bool m_bRecordingCameraPath;
+
 	Camera m_camera;
 };
 
@@ -0,0 +1,83 @@
+#include "AutoExposure.h"
+#include "glad\glad.h"
+#include "GLState.h"
+#include "Shader.h"
+#include "Texture.h"
+#include <cmath>
+
+AutoExposure::AutoExposure()
+{
+	GLState* glState = GLState::GetInstance();
+
+	// The histogram starts cleared, the adaptation pass clears it again after reading it.
+	unsigned int nClearBins[LUMINANCE_HISTOGRAM_BIN_COUNT] = {};
+
+	glGenBuffers(1, &m_glHistogramHandle);
+	glState->BindBuffer(GL_SHADER_STORAGE_BUFFER, m_glHistogramHandle);
+	glBufferStorage(GL_SHADER_STORAGE_BUFFER, sizeof(nClearBins), nClearBins, 0);
+
+	// Adapted luminance and exposure.
+	float fInitialExposure[] = { AUTO_EXPOSURE_KEY, 1.0f };
+
+	glGenBuffers(1, &m_glExposureHandle);
+	glState->BindBuffer(GL_SHADER_STORAGE_BUFFER, m_glExposureHandle);
+	glBufferStorage(GL_SHADER_STORAGE_BUFFER, sizeof(fInitialExposure), fInitialExposure, 0);
+
+	glState->BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	m_bAdapted = false;
+}
+
+AutoExposure::~AutoExposure()
+{
+	// Both stay bound to their storage bindings, GLState forgets those as it deletes them.
+	GLState::GetInstance()->DeleteBuffers(1, &m_glHistogramHandle);
+	GLState::GetInstance()->DeleteBuffers(1, &m_glExposureHandle);
+}
+
+void AutoExposure::Update(Shader* histogramShader, Shader* adaptShader, Texture* hdrTexture, float fDeltaTime)
+{
+	GLState* glState = GLState::GetInstance();
+
+	glState->BindBufferBase(GL_SHADER_STORAGE_BUFFER, LUMINANCE_HISTOGRAM_SSBO_BINDING, m_glHistogramHandle);
+	glState->BindBufferBase(GL_SHADER_STORAGE_BUFFER, EXPOSURE_SSBO_BINDING, m_glExposureHandle);
+
+	int nWidth = hdrTexture->GetWidth();
+	int nHeight = hdrTexture->GetHeight();
+
+	float fLogLuminanceRange = AUTO_EXPOSURE_MAX_LOG_LUMINANCE - AUTO_EXPOSURE_MIN_LOG_LUMINANCE;
+
+	// Bin every pixel...
+	histogramShader->Use();
+	histogramShader->SetUniformFloat("minLogLuminance", AUTO_EXPOSURE_MIN_LOG_LUMINANCE);
+	histogramShader->SetUniformFloat("inverseLogLuminanceRange", 1.0f / fLogLuminanceRange);
+
+	glState->BindTexture(0, GL_TEXTURE_2D, hdrTexture->GetHandle());
+
+	glDispatchCompute((nWidth + LUMINANCE_HISTOGRAM_GROUP_SIZE - 1) / LUMINANCE_HISTOGRAM_GROUP_SIZE, (nHeight + LUMINANCE_HISTOGRAM_GROUP_SIZE - 1) / LUMINANCE_HISTOGRAM_GROUP_SIZE, 1);
+
+	// The adaptation pass reads the histogram...
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	// Exponential adaptation, independent of the frame rate. The first update adopts the average outright.
+	float fAdaptation = m_bAdapted ? 1.0f - std::exp(-fDeltaTime * AUTO_EXPOSURE_ADAPTATION_RATE) : 1.0f;
+
+	adaptShader->Use();
+	adaptShader->SetUniformFloat("minLogLuminance", AUTO_EXPOSURE_MIN_LOG_LUMINANCE);
+	adaptShader->SetUniformFloat("logLuminanceRange", fLogLuminanceRange);
+	adaptShader->SetUniformFloat("adaptation", fAdaptation);
+	adaptShader->SetUniformFloat("key", AUTO_EXPOSURE_KEY);
+	adaptShader->SetUniformInt("pixelCount", nWidth * nHeight);
+
+	glDispatchCompute(1, 1, 1);
+
+	// The tonemap reads the exposure, and the next frame's histogram pass the cleared bins.
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	m_bAdapted = true;
+}
+
+unsigned int AutoExposure::ExposureHandle() const
+{
+	return m_glExposureHandle;
+}
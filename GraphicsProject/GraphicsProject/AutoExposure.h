@@ -0,0 +1,62 @@
+#pragma once
+
+class Shader;
+class Texture;
+
+// Must match the bindings in luminance_histogram.comp, exposure_adapt.comp and post_uber.fs.
+#define LUMINANCE_HISTOGRAM_SSBO_BINDING 13
+#define EXPOSURE_SSBO_BINDING 14
+
+// Must match HISTOGRAM_BIN_COUNT in the auto exposure shaders, and the work group size of both.
+#define LUMINANCE_HISTOGRAM_BIN_COUNT 256
+
+// Must match local_size_x and local_size_y in luminance_histogram.comp.
+#define LUMINANCE_HISTOGRAM_GROUP_SIZE 16
+
+// Range of log2 luminance covered by the histogram, darker pixels fall into the first bin and are ignored.
+#define AUTO_EXPOSURE_MIN_LOG_LUMINANCE -8.0f
+#define AUTO_EXPOSURE_MAX_LOG_LUMINANCE 4.0f
+
+// Rate at which the adapted luminance approaches the scene's, per second.
+#define AUTO_EXPOSURE_ADAPTATION_RATE 1.5f
+
+// Exposure is this divided by the adapted luminance, the average luminance of the scene is exposed to it.
+#define AUTO_EXPOSURE_KEY 0.18f
+
+/*
+Eye adaptation computed entirely on the GPU. Each frame a compute pass bins the log luminance of the lit HDR buffer into a histogram,
+and a second pass averages it and moves the adapted luminance towards the result. The exposure is written to a small
+storage buffer that the tonemap reads directly, so nothing is read back to the CPU.
+*/
+class AutoExposure
+{
+public:
+
+	AutoExposure();
+
+	~AutoExposure();
+
+	/*
+	Description: Build the luminance histogram of a HDR texture and adapt the exposure towards its average. The exposure buffer
+	is left bound to EXPOSURE_SSBO_BINDING for the tonemap.
+	Param:
+	    Shader* histogramShader: The luminance histogram compute shader.
+		Shader* adaptShader: The exposure adaptation compute shader.
+		Texture* hdrTexture: The lit HDR texture.
+		float fDeltaTime: The time since the previous frame in seconds.
+	*/
+	void Update(Shader* histogramShader, Shader* adaptShader, Texture* hdrTexture, float fDeltaTime);
+
+	/*
+	Description: Get the OpenGL handle of the exposure storage buffer.
+	Return Type: unsigned int
+	*/
+	unsigned int ExposureHandle() const;
+
+private:
+
+	unsigned int m_glHistogramHandle;
+	unsigned int m_glExposureHandle;
+
+	bool m_bAdapted; // Whether the adapted luminance holds a previous frame's result.
+};
@@ -1,8 +1,11 @@
 #include "Batch.h"
 #include "glad/glad.h"
+#include "GLState.h"
 #include "Material.h"
 #include "Shader.h"
 #include "Mesh.h"
+#include "UploadRing.h"
+#include "CommandBucket.h"
 #include <iostream>
 #include "glm/include/ext.hpp"
 
@@ -12,6 +15,7 @@ Batch::Batch(Mesh* mesh, Material* material)
 {
 	m_mesh = mesh;
 	m_material = material;
+	m_nInstanceCount = 0;
 
 	// Use material shader...
 	m_material->GetShader()->Use();
@@ -28,7 +32,7 @@ Batch::Batch(Mesh* mesh, Material* material)
 	}
 
 	// Unbind shader.
-	glUseProgram(0);
+	GLState::GetInstance()->UseProgram(0);
 
 	SetData();
 
@@ -48,7 +52,7 @@ Batch::~Batch()
 void Batch::Add(float* modelMatrix, NVZMathLib::Vector4 v4Color) 
 {
 	if (m_nInstanceCount >= MAX_INSTANCE_COUNT)
-		Flush();
+		UploadInstances();
 
 	Instance& currentInstance = m_instances[m_nInstanceCount++];
 
@@ -72,24 +76,46 @@ void Batch::Add(float* modelMatrix, NVZMathLib::Vector4 v4Color)
 	memcpy_s(currentInstance.m_normalMat, sizeof(float) * 9, &normalMat, sizeof(float) * 9);
 }
 
-void Batch::Flush() 
+void Batch::Flush(CommandBucket* bucket) 
 {
-	// Use shader...
-	m_material->Use();
+	UploadInstances();
+
+	// Add a draw for every run uploaded since the last flush...
+	for(int i = 0; i < m_uploadedRuns.Count(); ++i) 
+	{
+		const UploadedRun& run = m_uploadedRuns[i];
+
+		bucket->AddDraw(DRAW_PASS_OPAQUE, m_material, m_mesh->DrawRange(), run.m_nInstanceCount, run.m_nBaseInstance, bucket->ViewDepth(run.m_v3Center));
+	}
+
+	m_uploadedRuns.Clear();
+}
+
+void Batch::UploadInstances() 
+{
+	if (m_nInstanceCount == 0)
+		return;
+
+	// Copy instances into the upload ring, aligned so their offset is a whole number of instances...
+	unsigned int nOffset = 0;
+
+	if(!UploadRing::GetInstance()->Upload(m_instances, sizeof(Instance) * m_nInstanceCount, sizeof(Instance), nOffset)) 
+	{
+		m_nInstanceCount = 0;
+		return;
+	}
 
-	// Bind buffers.
-	m_mesh->Bind();
+	UploadedRun run;
+	run.m_nBaseInstance = nOffset / sizeof(Instance);
+	run.m_nInstanceCount = m_nInstanceCount;
+	run.m_v3Center = glm::vec3(0.0f);
 
-	// Update mesh instance buffer...
-	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(Instance) * m_nInstanceCount, m_instances);
+	for (unsigned int i = 0; i < m_nInstanceCount; ++i)
+		run.m_v3Center += glm::vec3(m_instances[i].m_modelMat[12], m_instances[i].m_modelMat[13], m_instances[i].m_modelMat[14]);
 
-	// Draw...
-	glDrawElementsInstanced(GL_TRIANGLES, m_mesh->IndexCount(), GL_UNSIGNED_INT, 0, m_nInstanceCount);
+	run.m_v3Center /= static_cast<float>(m_nInstanceCount);
 
-	// Unbind buffers...
-	glBindVertexArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	m_uploadedRuns.Push(run);
 
 	m_nInstanceCount = 0;
 }
@@ -2,10 +2,12 @@
 #include "Vector4.h"
 #include "Matrix4.h"
 #include "glm.hpp"
+#include "DynamicArray.h"
 
 class Mesh;
 class Material;
 class Shader;
+class CommandBucket;
 
 #define MAX_INSTANCE_COUNT 512
 
@@ -28,12 +30,17 @@ public:
 	void Add(float* modelMatrix, NVZMathLib::Vector4 v4Color = { 1.0f, 1.0f, 1.0f, 1.0f });
 
 	/*
-	Description: Send the current state of the batch to the GPU and draw. And make way for the more instances.
+	Description: Send the current state of the batch to the GPU and add draws of it to a command bucket. And make way for the more instances.
+	Param:
+	    CommandBucket* bucket: The bucket to add the draw to.
 	*/
-	void Flush();
+	void Flush(CommandBucket* bucket);
 
 private:
 
+	// Copy the batched instances into the upload ring, recording them as a run to be drawn on the next flush.
+	void UploadInstances();
+
 	void SetData();
 
 	void CreateBuffers();
@@ -62,9 +69,20 @@ private:
 	Instance m_instances[MAX_INSTANCE_COUNT];
 	unsigned int m_nInstanceCount;
 
+	// Instances already in the upload ring which have not been added to a bucket.
+	struct UploadedRun
+	{
+		unsigned int m_nBaseInstance;
+		unsigned int m_nInstanceCount;
+		glm::vec3 m_v3Center; // Average worldspace origin of the run's instances, for depth sorting.
+	};
+
+	DynamicArray<UploadedRun> m_uploadedRuns;
+
 	unsigned int m_nSamplerLocations[MAX_MAP_COUNT];
 
 	Mesh* m_mesh;
 	Material* m_material;
+
 };
 
@@ -0,0 +1,296 @@
+#include "CPUProfiler.h"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+
+CPUProfiler* CPUProfiler::m_instance = nullptr;
+
+// Incremented per profiler so threads never reuse a buffer cached from a destroyed profiler.
+static unsigned int s_nProfilerGeneration = 0;
+
+// The calling thread's buffer in the current profiler.
+struct ThreadBufferCache
+{
+	unsigned int m_nGeneration;
+	void* m_buffer;
+};
+
+static thread_local ThreadBufferCache s_threadBuffer = { 0, nullptr };
+
+// Write a string as a JSON string literal.
+static void WriteJSONString(std::ofstream& file, const char* szString)
+{
+	file << '"';
+
+	for(const char* c = szString; *c; ++c)
+	{
+		if (*c == '"' || *c == '\\')
+			file << '\\';
+
+		file << *c;
+	}
+
+	file << '"';
+}
+
+CPUProfiler::CPUProfiler()
+{
+	m_nEpoch = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+	++s_nProfilerGeneration;
+
+	m_nFrameIndex = 0;
+	m_nFrameStart = 0;
+	m_fLastFrameTime = 0.0f;
+
+	m_fHitchBudget = 0.0f;
+	m_szCapturePrefix = "hitch";
+	m_nPendingHitchFrame = -1;
+	m_nHitchCount = 0;
+	m_nCaptureCount = 0;
+}
+
+CPUProfiler::~CPUProfiler()
+{
+	for(int i = 0; i < m_threads.Count(); ++i)
+	{
+		delete[] m_threads[i]->m_zones;
+		delete m_threads[i];
+	}
+}
+
+void CPUProfiler::BeginFrame()
+{
+	m_nFrameStart = Now();
+}
+
+void CPUProfiler::EndFrame()
+{
+	unsigned long long nFrameEnd = Now();
+
+	Frame& frame = m_frames[m_nFrameIndex % CPU_PROFILER_FRAME_HISTORY];
+	frame.m_nIndex = m_nFrameIndex;
+	frame.m_nStart = m_nFrameStart;
+	frame.m_nEnd = nFrameEnd;
+
+	RecordZone("Frame", m_nFrameStart, nFrameEnd);
+
+	m_fLastFrameTime = static_cast<float>(nFrameEnd - m_nFrameStart) / 1000000.0f;
+
+	// Capture the first hitch of a window, later hitches within it are part of the same capture...
+	if(m_fHitchBudget > 0.0f && m_fLastFrameTime > m_fHitchBudget)
+	{
+		++m_nHitchCount;
+
+		if (m_nPendingHitchFrame < 0 && m_nCaptureCount < CPU_PROFILER_MAX_HITCH_CAPTURES)
+			m_nPendingHitchFrame = m_nFrameIndex;
+	}
+
+	if(m_nPendingHitchFrame >= 0 && m_nFrameIndex >= m_nPendingHitchFrame + CPU_PROFILER_HITCH_FRAMES_AFTER)
+	{
+		WriteHitchCapture(m_nPendingHitchFrame);
+		m_nPendingHitchFrame = -1;
+	}
+
+	++m_nFrameIndex;
+}
+
+void CPUProfiler::SetHitchBudget(float fBudget, const char* szCapturePrefix)
+{
+	m_fHitchBudget = fBudget;
+	m_szCapturePrefix = szCapturePrefix;
+}
+
+void CPUProfiler::SetThreadName(const char* szName)
+{
+	GetThreadBuffer()->m_szName = szName;
+}
+
+void CPUProfiler::RecordZone(const char* szName, unsigned long long nStart, unsigned long long nEnd)
+{
+	ThreadBuffer* buffer = GetThreadBuffer();
+
+	// Only this thread writes the buffer, publishing the zone after it is written is enough for readers...
+	unsigned int nWriteCount = buffer->m_nWriteCount.load(std::memory_order_relaxed);
+
+	CPUZone& zone = buffer->m_zones[nWriteCount % CPU_PROFILER_THREAD_CAPACITY];
+	zone.m_szName = szName;
+	zone.m_nStart = nStart;
+	zone.m_nEnd = nEnd;
+
+	buffer->m_nWriteCount.store(nWriteCount + 1, std::memory_order_release);
+}
+
+bool CPUProfiler::WriteTrace(const char* szPath)
+{
+	return WriteTrace(szPath, 0, ~0ULL);
+}
+
+unsigned long long CPUProfiler::Now() const
+{
+	long long nNow = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+	return static_cast<unsigned long long>(nNow - m_nEpoch);
+}
+
+float CPUProfiler::LastFrameTime() const
+{
+	return m_fLastFrameTime;
+}
+
+int CPUProfiler::HitchCount() const
+{
+	return m_nHitchCount;
+}
+
+CPUProfiler::ThreadBuffer* CPUProfiler::GetThreadBuffer()
+{
+	if (s_threadBuffer.m_nGeneration == s_nProfilerGeneration && s_threadBuffer.m_buffer)
+		return static_cast<ThreadBuffer*>(s_threadBuffer.m_buffer);
+
+	ThreadBuffer* buffer = new ThreadBuffer();
+	buffer->m_zones = new CPUZone[CPU_PROFILER_THREAD_CAPACITY];
+	buffer->m_nWriteCount.store(0);
+	buffer->m_szName = nullptr;
+
+	// Registration is the only time recording takes the lock.
+	{
+		std::lock_guard<std::mutex> lock(m_threadLock);
+
+		buffer->m_nThreadID = m_threads.Count() + 1;
+		m_threads.Push(buffer);
+	}
+
+	s_threadBuffer.m_nGeneration = s_nProfilerGeneration;
+	s_threadBuffer.m_buffer = buffer;
+
+	return buffer;
+}
+
+bool CPUProfiler::WriteTrace(const char* szPath, unsigned long long nRangeStart, unsigned long long nRangeEnd)
+{
+	std::ofstream file(szPath);
+
+	if(!file.good())
+	{
+		std::cout << "CPU Profiler Error: Failed to open " << szPath << " for writing." << std::endl;
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_threadLock);
+
+	// Timestamps are written in microseconds, keeping nanosecond precision...
+	file << std::fixed << std::setprecision(3);
+	file << "{\"traceEvents\":[\n";
+
+	bool bFirstEvent = true;
+
+	for(int i = 0; i < m_threads.Count(); ++i)
+	{
+		ThreadBuffer* buffer = m_threads[i];
+
+		if (!bFirstEvent)
+			file << ",\n";
+
+		bFirstEvent = false;
+
+		file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->m_nThreadID << ",\"args\":{\"name\":";
+
+		if (buffer->m_szName)
+			WriteJSONString(file, buffer->m_szName);
+		else
+			file << "\"Thread " << buffer->m_nThreadID << "\"";
+
+		file << "}}";
+
+		// Zones of other threads may be overwritten while reading if they wrap around the ring, only the latest capacity are valid.
+		unsigned int nWriteCount = buffer->m_nWriteCount.load(std::memory_order_acquire);
+		unsigned int nFirst = nWriteCount > CPU_PROFILER_THREAD_CAPACITY ? nWriteCount - CPU_PROFILER_THREAD_CAPACITY : 0;
+
+		for(unsigned int j = nFirst; j < nWriteCount; ++j)
+		{
+			const CPUZone& zone = buffer->m_zones[j % CPU_PROFILER_THREAD_CAPACITY];
+
+			if (zone.m_nEnd < nRangeStart || zone.m_nStart > nRangeEnd)
+				continue;
+
+			file << ",\n{\"name\":";
+			WriteJSONString(file, zone.m_szName);
+			file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->m_nThreadID
+				<< ",\"ts\":" << zone.m_nStart / 1000.0 << ",\"dur\":" << (zone.m_nEnd - zone.m_nStart) / 1000.0 << "}";
+		}
+	}
+
+	file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+	return file.good();
+}
+
+void CPUProfiler::WriteHitchCapture(int nHitchFrame)
+{
+	// Start from the frames before the hitch which are still in the history...
+	int nFirstFrame = nHitchFrame - CPU_PROFILER_HITCH_FRAMES_BEFORE;
+	int nOldestFrame = m_nFrameIndex - CPU_PROFILER_FRAME_HISTORY + 1;
+
+	if (nFirstFrame < nOldestFrame)
+		nFirstFrame = nOldestFrame;
+
+	if (nFirstFrame < 0)
+		nFirstFrame = 0;
+
+	// A capture reaching the first frame includes everything recorded before it, such as loading...
+	unsigned long long nRangeStart = nFirstFrame == 0 ? 0 : m_frames[nFirstFrame % CPU_PROFILER_FRAME_HISTORY].m_nStart;
+	unsigned long long nRangeEnd = m_frames[m_nFrameIndex % CPU_PROFILER_FRAME_HISTORY].m_nEnd;
+
+	const Frame& hitchFrame = m_frames[nHitchFrame % CPU_PROFILER_FRAME_HISTORY];
+	float fHitchTime = static_cast<float>(hitchFrame.m_nEnd - hitchFrame.m_nStart) / 1000000.0f;
+
+	std::string path = std::string(m_szCapturePrefix) + "_frame" + std::to_string(nHitchFrame) + ".json";
+
+	if(WriteTrace(path.c_str(), nRangeStart, nRangeEnd))
+	{
+		std::cout << "CPU Profiler: Frame " << nHitchFrame << " took " << fHitchTime << "ms (budget " << m_fHitchBudget << "ms), frames "
+			<< nFirstFrame << " to " << m_nFrameIndex << " written to " << path << std::endl;
+	}
+
+	++m_nCaptureCount;
+}
+
+void CPUProfiler::Create()
+{
+	if (!m_instance)
+		m_instance = new CPUProfiler();
+}
+
+void CPUProfiler::Destroy()
+{
+	if(m_instance)
+	{
+		delete m_instance;
+		m_instance = nullptr;
+	}
+}
+
+CPUProfiler* CPUProfiler::GetInstance()
+{
+	return m_instance;
+}
+
+// ------------------------------------------------------------------------------------
+// Zone
+
+CPUProfileZone::CPUProfileZone(const char* szName)
+{
+	m_szName = szName;
+	m_nStart = CPUProfiler::GetInstance() ? CPUProfiler::GetInstance()->Now() : 0;
+}
+
+CPUProfileZone::~CPUProfileZone()
+{
+	CPUProfiler* profiler = CPUProfiler::GetInstance();
+
+	if (profiler)
+		profiler->RecordZone(m_szName, m_nStart, profiler->Now());
+}
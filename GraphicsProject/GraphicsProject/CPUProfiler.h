@@ -0,0 +1,175 @@
+#pragma once
+#include "DynamicArray.h"
+#include <atomic>
+#include <mutex>
+
+// Zones kept per thread, older zones are overwritten once a thread has recorded this many.
+#define CPU_PROFILER_THREAD_CAPACITY 65536
+
+// Frames whose boundaries are kept for hitch captures.
+#define CPU_PROFILER_FRAME_HISTORY 512
+
+// Frames written either side of a frame exceeding the hitch budget, and the most hitch captures written per run.
+#define CPU_PROFILER_HITCH_FRAMES_BEFORE 30
+#define CPU_PROFILER_HITCH_FRAMES_AFTER 10
+#define CPU_PROFILER_MAX_HITCH_CAPTURES 8
+
+// A completed zone, times are in nanoseconds since the profiler was created.
+struct CPUZone
+{
+	const char* m_szName;
+	unsigned long long m_nStart;
+	unsigned long long m_nEnd;
+};
+
+/*
+Records named CPU zones with nanosecond timestamps into a ring buffer per thread. Each thread only ever writes its own buffer,
+so recording takes no locks, the lock is only taken the first time a thread records and when exporting.
+Zones are exported as Chrome trace event JSON, viewable in chrome://tracing or Perfetto.
+With a hitch budget set, a frame taking longer than the budget has the frames around it written to a trace automatically,
+zones recorded before the first frame, such as loading, are included in captures reaching back to it.
+*/
+class CPUProfiler
+{
+public:
+
+	CPUProfiler();
+
+	~CPUProfiler();
+
+	/*
+	Description: Mark the start of a frame on the calling thread.
+	*/
+	void BeginFrame();
+
+	/*
+	Description: Mark the end of the frame, checking it against the hitch budget and writing any capture whose frames are complete.
+	*/
+	void EndFrame();
+
+	/*
+	Description: Set the frame time above which the surrounding frames are captured to a trace file named <prefix>_frame<index>.json.
+	Param:
+	    float fBudget: The budget in milliseconds, or zero to disable hitch capture.
+		const char* szCapturePrefix: Path prefix of the capture files. The string must outlive the profiler.
+	*/
+	void SetHitchBudget(float fBudget, const char* szCapturePrefix = "hitch");
+
+	/*
+	Description: Name the calling thread in exported traces.
+	Param:
+	    const char* szName: The name of the thread. The string must outlive the profiler.
+	*/
+	void SetThreadName(const char* szName);
+
+	/*
+	Description: Record a completed zone on the calling thread's buffer.
+	Param:
+	    const char* szName: The name of the zone. The string must outlive the profiler.
+		unsigned long long nStart: The start time returned by Now.
+		unsigned long long nEnd: The end time returned by Now.
+	*/
+	void RecordZone(const char* szName, unsigned long long nStart, unsigned long long nEnd);
+
+	/*
+	Description: Write every zone still held by the thread buffers to a Chrome trace event JSON file.
+	Return Type: bool
+	Returns true if the file was written.
+	Param:
+	    const char* szPath: The path of the file to write.
+	*/
+	bool WriteTrace(const char* szPath);
+
+	/*
+	Description: Get the time since the profiler was created.
+	Return Type: unsigned long long
+	Returns the time in nanoseconds.
+	*/
+	unsigned long long Now() const;
+
+	/*
+	Description: Get the duration of the last completed frame in milliseconds.
+	Return Type: float
+	*/
+	float LastFrameTime() const;
+
+	/*
+	Description: Get the amount of frames which exceeded the hitch budget.
+	Return Type: int
+	*/
+	int HitchCount() const;
+
+	// Singleton functions.
+
+	static void Create();
+	static void Destroy();
+	static CPUProfiler* GetInstance();
+
+private:
+
+	struct ThreadBuffer
+	{
+		CPUZone* m_zones;
+		std::atomic<unsigned int> m_nWriteCount; // Total zones written, the ring index is this modulo the capacity.
+		unsigned int m_nThreadID;
+		const char* m_szName;
+	};
+
+	struct Frame
+	{
+		int m_nIndex;
+		unsigned long long m_nStart;
+		unsigned long long m_nEnd;
+	};
+
+	// Get the calling thread's buffer, creating it on the thread's first zone.
+	ThreadBuffer* GetThreadBuffer();
+
+	// Write the zones overlapping a time range to a trace file.
+	bool WriteTrace(const char* szPath, unsigned long long nRangeStart, unsigned long long nRangeEnd);
+
+	// Write the capture of a hitch frame once the frames after it have completed.
+	void WriteHitchCapture(int nHitchFrame);
+
+	static CPUProfiler* m_instance;
+
+	// Steady clock time at creation, zone times are relative to it.
+	long long m_nEpoch;
+
+	std::mutex m_threadLock;
+	DynamicArray<ThreadBuffer*> m_threads;
+
+	Frame m_frames[CPU_PROFILER_FRAME_HISTORY];
+	int m_nFrameIndex; // Index of the frame currently being recorded.
+	unsigned long long m_nFrameStart;
+	float m_fLastFrameTime;
+
+	float m_fHitchBudget;
+	const char* m_szCapturePrefix;
+	int m_nPendingHitchFrame; // Hitch frame waiting for the frames after it, or -1.
+	int m_nHitchCount;
+	int m_nCaptureCount;
+};
+
+/*
+Records a zone on the calling thread from its construction to its destruction, if the profiler exists.
+*/
+class CPUProfileZone
+{
+public:
+
+	CPUProfileZone(const char* szName);
+
+	~CPUProfileZone();
+
+private:
+
+	const char* m_szName;
+	unsigned long long m_nStart;
+};
+
+#define CPU_PROFILE_ZONE_CONCAT_INNER(a, b) a##b
+#define CPU_PROFILE_ZONE_CONCAT(a, b) CPU_PROFILE_ZONE_CONCAT_INNER(a, b)
+
+// Profile the rest of the enclosing scope as a zone of the provided name.
+#define CPU_PROFILE_ZONE(szName) CPUProfileZone CPU_PROFILE_ZONE_CONCAT(cpuProfileZone, __LINE__)(szName)
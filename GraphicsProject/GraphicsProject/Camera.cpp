@@ -55,7 +55,9 @@ void Camera::Update(float fDeltaTime, Input* input, GLFWwindow* window)
 
 		if(!m_bLooking) 
 		{
-			glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+			if (window)
+				glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
 			m_bLooking = true;
 		}
 
@@ -64,7 +66,9 @@ void Camera::Update(float fDeltaTime, Input* input, GLFWwindow* window)
 	}
 	else if(m_bLooking)
 	{
-		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+		if (window)
+			glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+
 		m_bLooking = false;
 	}
 
@@ -22,7 +22,7 @@ public:
 	Param:
 	    float fDeltaTime: Time between frames.
 		Input* input: Pointer to the input class of the application.
-		GLFWwindow* window: Pointer to the window instance.
+		GLFWwindow* window: Pointer to the window instance, or nullptr when input is played back without a window.
 	*/
 	void Update(float fDeltaTime, Input* input, GLFWwindow* window);
 
@@ -0,0 +1,84 @@
+#include "ColorGradingLUT.h"
+#include "GLAD/glad.h"
+#include "GLState.h"
+#include <iostream>
+
+#include "stb_image.h"
+
+ColorGradingLUT::ColorGradingLUT(const char* szFilePath) : Texture(0, 0, 0)
+{
+	m_nWidth = 0;
+	m_nHeight = 0;
+	m_nChannels = 0;
+	m_glHandle = 0;
+	m_bOwnsTexture = true;
+
+	int nStripWidth = 0;
+	int nStripHeight = 0;
+
+	unsigned char* stripData = stbi_load(szFilePath, &nStripWidth, &nStripHeight, &m_nChannels, STBI_rgb_alpha);
+
+	if(!stripData)
+	{
+		std::cout << "Failed to load color grading LUT: " << szFilePath << std::endl;
+		return;
+	}
+
+	if(nStripWidth != nStripHeight * nStripHeight)
+	{
+		std::cout << "Color Grading LUT Error: " << szFilePath << " is " << nStripWidth << "x" << nStripHeight << ", expected a strip " << nStripHeight * nStripHeight << " wide." << std::endl;
+
+		stbi_image_free(stripData);
+		return;
+	}
+
+	m_nWidth = nStripHeight;
+	m_nHeight = nStripHeight;
+
+	// Create and bind texture buffer.
+	glGenTextures(1, &m_glHandle);
+	GLState::GetInstance()->BindTexture(GL_TEXTURE_3D, m_glHandle);
+
+	glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA8, m_nWidth, m_nWidth, m_nWidth, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+	// The slices lie side by side in the strip, upload each one from its offset in the rows...
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, nStripWidth);
+
+	for (int i = 0; i < m_nWidth; ++i)
+		glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, i, m_nWidth, m_nWidth, 1, GL_RGBA, GL_UNSIGNED_BYTE, stripData + i * m_nWidth * 4);
+
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+	stbi_image_free(stripData);
+
+	// Specify texture parameters...
+
+	// Texture wrapping, colors outside the table take its edge.
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+	// Texture filtering, colors between the table's texels are interpolated.
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	// Unbind texture when finished.
+	GLState::GetInstance()->BindTexture(GL_TEXTURE_3D, 0);
+
+	std::cout << "Successfully loaded color grading LUT: " << szFilePath << std::endl;
+}
+
+ColorGradingLUT::~ColorGradingLUT()
+{
+
+}
+
+void ColorGradingLUT::BindLUT(unsigned int nUnit)
+{
+	GLState::GetInstance()->BindTexture(nUnit, GL_TEXTURE_3D, m_glHandle);
+}
+
+int ColorGradingLUT::Size()
+{
+	return m_nWidth;
+}
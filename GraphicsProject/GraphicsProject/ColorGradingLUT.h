@@ -0,0 +1,29 @@
+#pragma once
+#include "Texture.h"
+
+/*
+3D color lookup table for grading the final image. Loaded from a horizontal strip of N slices of N x N texels, an image
+N * N texels wide and N texels tall, where red increases along each slice, green down it and blue from slice to slice.
+An unmodified strip maps every color to itself, so a grade can be painted over a screenshot with one pasted in.
+*/
+class ColorGradingLUT : public Texture
+{
+public:
+
+	ColorGradingLUT(const char* szFilePath);
+
+	~ColorGradingLUT();
+
+	/*
+	Description: Bind this lookup table to a GPU texture unit.
+	Param:
+	    unsigned int nUnit: The texture unit to bind to.
+	*/
+	void BindLUT(unsigned int nUnit);
+
+	/*
+	Description: Get the amount of texels along each axis of the lookup table, zero if it failed to load.
+	Return Type: int
+	*/
+	int Size();
+};
@@ -0,0 +1,667 @@
+#include "CommandBucket.h"
+#include "glad\glad.h"
+#include "GLState.h"
+#include "Material.h"
+#include "Shader.h"
+#include "HiZBuffer.h"
+#include "MaterialTable.h"
+#include "UploadRing.h"
+#include "GPUProfiler.h"
+#include "gtc/type_ptr.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+/*
+Sort key bit layout, most significant first:
+
+Opaque:      | pass (4) | shader (12) | material (16) | mesh (16) | depth (16) |
+Transparent: | pass (4) | inverted depth (16) | shader (12) | material (16) | mesh (16) |
+
+Shaders are keyed by the low bits of their OpenGL program name and materials by their sort ID, or zero if they read the MaterialTable. The mesh field holds the low bits
+of the VAO name above a hash of the first index, so draws from the same VAO stay adjacent within a material and can be merged into a multi-draw.
+A collision only places unrelated draws next to each other, every packet still binds its own state.
+While drawing the visibility buffer the shader and material fields are zero, every draw uses the same shader.
+*/
+#define SORT_KEY_PASS_SHIFT 60
+#define SORT_KEY_DEPTH_MAX 0xFFFF
+
+// Must match local_size_x in instance_cull.comp.
+#define INSTANCE_CULL_GROUP_SIZE 64
+
+#define INSTANCE_SIZE (sizeof(unsigned int) * INSTANCE_WORD_COUNT)
+
+CommandBucket::CommandBucket()
+{
+	m_viewMatrix = glm::mat4();
+	m_fNear = 0.0f;
+	m_fFar = 1.0f;
+
+	for (int i = 0; i < 6; ++i)
+		m_v4FrustumPlanes[i] = glm::vec4(0.0f);
+
+	m_cullShader = nullptr;
+	m_hiZBuffer = nullptr;
+	m_visibilityShader = nullptr;
+	m_nVisibilityDrawOffset = 0;
+	m_bVisibilityReported = false;
+	m_nCullDrawOffset = 0;
+	m_nCullTestedCount = 0;
+
+	// The output buffer is given storage once the first draws are culled.
+	glGenBuffers(1, &m_glCullOutputHandle);
+	m_nCullOutputCapacity = 0;
+
+	m_nDrawCount = 0;
+	m_nDrawCallCount = 0;
+	m_nMaterialChangeCount = 0;
+}
+
+CommandBucket::~CommandBucket()
+{
+	GLState::GetInstance()->DeleteBuffers(1, &m_glCullOutputHandle);
+}
+
+void CommandBucket::SetView(const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix, float fNear, float fFar)
+{
+	m_viewMatrix = viewMatrix;
+	m_fNear = fNear;
+	m_fFar = fFar;
+
+	// Extract frustum planes from the rows of the view projection matrix. (Gribb & Hartmann)
+	glm::mat4 viewProjection = projectionMatrix * viewMatrix;
+
+	glm::vec4 v4Row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+	glm::vec4 v4Row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+	glm::vec4 v4Row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+	glm::vec4 v4Row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+	m_v4FrustumPlanes[0] = v4Row3 + v4Row0; // Left
+	m_v4FrustumPlanes[1] = v4Row3 - v4Row0; // Right
+	m_v4FrustumPlanes[2] = v4Row3 + v4Row1; // Bottom
+	m_v4FrustumPlanes[3] = v4Row3 - v4Row1; // Top
+	m_v4FrustumPlanes[4] = v4Row3 + v4Row2; // Near
+	m_v4FrustumPlanes[5] = v4Row3 - v4Row2; // Far
+
+	// Normalize planes so distances are in world units.
+	for (int i = 0; i < 6; ++i)
+		m_v4FrustumPlanes[i] /= glm::length(glm::vec3(m_v4FrustumPlanes[i]));
+}
+
+void CommandBucket::SetCullShader(Shader* cullShader)
+{
+	m_cullShader = cullShader;
+}
+
+void CommandBucket::SetHiZBuffer(HiZBuffer* hiZBuffer)
+{
+	m_hiZBuffer = hiZBuffer;
+}
+
+void CommandBucket::SetVisibilityShader(Shader* visibilityShader)
+{
+	m_visibilityShader = visibilityShader;
+}
+
+int CommandBucket::VisibilitySourceCount() const
+{
+	return m_visibilitySources.Count();
+}
+
+void CommandBucket::BindVisibilitySource(int nSource, Shader* resolveShader)
+{
+	GLState* glState = GLState::GetInstance();
+	UploadRing* uploadRing = UploadRing::GetInstance();
+
+	resolveShader->Use();
+	resolveShader->SetUniformInt("visibilitySource", nSource);
+	resolveShader->SetUniformInt("visibilityDrawCount", m_visibilityDraws.Count());
+
+	const VisibilitySource& source = m_visibilitySources[nSource];
+
+	// Vertices, indices and instances are fetched directly from the buffers the source's draws read...
+	glState->BindBufferBase(GL_SHADER_STORAGE_BUFFER, VISIBILITY_VERTEX_SSBO_BINDING, source.m_glVBO);
+	glState->BindBufferBase(GL_SHADER_STORAGE_BUFFER, VISIBILITY_INDEX_SSBO_BINDING, source.m_glIndexBuffer);
+	glState->BindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_SOURCE_SSBO_BINDING, source.m_glInstanceBuffer ? source.m_glInstanceBuffer : uploadRing->Handle());
+
+	// Draws are still in this frame's upload ring.
+	glState->BindBufferRange(GL_SHADER_STORAGE_BUFFER, VISIBILITY_DRAW_SSBO_BINDING, uploadRing->Handle(), m_nVisibilityDrawOffset, sizeof(VisibilityDraw) * m_visibilityDraws.Count());
+
+	if (MaterialTable::GetInstance())
+		glState->BindBufferBase(GL_SHADER_STORAGE_BUFFER, MATERIAL_TABLE_SSBO_BINDING, MaterialTable::GetInstance()->Handle());
+}
+
+void CommandBucket::SubmitVisibilityFallback()
+{
+	if (m_fallbackPackets.Count() == 0)
+		return;
+
+	// Key the draws by their materials and submit them like any other, the packets being drawn were already added to the visibility submission's draw count...
+	Shader* visibilityShader = m_visibilityShader;
+	m_visibilityShader = nullptr;
+
+	for(int i = 0; i < m_fallbackPackets.Count(); ++i)
+	{
+		DrawPacket& packet = m_fallbackPackets[i];
+		EDrawPass ePass = static_cast<EDrawPass>(packet.m_nKey >> SORT_KEY_PASS_SHIFT);
+
+		packet.m_nKey = MakeKey(ePass, packet.m_material, packet.m_geometry, packet.m_fViewDepth);
+		m_packets.Push(packet);
+	}
+
+	m_fallbackPackets.Clear();
+
+	int nDrawCount = m_nDrawCount;
+	int nDrawCallCount = m_nDrawCallCount;
+	int nCullTestedCount = m_nCullTestedCount;
+	int nMaterialChangeCount = m_nMaterialChangeCount;
+
+	Submit();
+
+	m_nDrawCount = nDrawCount;
+	m_nDrawCallCount += nDrawCallCount;
+	m_nCullTestedCount += nCullTestedCount;
+	m_nMaterialChangeCount += nMaterialChangeCount;
+
+	m_visibilityShader = visibilityShader;
+}
+
+float CommandBucket::ViewDepth(const glm::vec3& v3Position) const
+{
+	// The camera looks down negative Z in view space.
+	return -(m_viewMatrix[0][2] * v3Position.x + m_viewMatrix[1][2] * v3Position.y + m_viewMatrix[2][2] * v3Position.z + m_viewMatrix[3][2]);
+}
+
+float CommandBucket::ViewDepth(const float* modelMatrix) const
+{
+	// The fourth column of the model matrix is the worldspace origin of the model.
+	return ViewDepth(glm::vec3(modelMatrix[12], modelMatrix[13], modelMatrix[14]));
+}
+
+void CommandBucket::AddDraw(EDrawPass ePass, Material* material, const GeometryRange& geometry, unsigned int nInstanceCount, unsigned int nBaseInstance, float fViewDepth, unsigned int glInstanceBuffer)
+{
+	if (geometry.m_nIndexCount == 0 || nInstanceCount == 0)
+		return;
+
+	DrawPacket packet;
+	packet.m_nKey = MakeKey(ePass, material, geometry, fViewDepth);
+	packet.m_material = material;
+	packet.m_geometry = geometry;
+	packet.m_nInstanceCount = nInstanceCount;
+	packet.m_nBaseInstance = nBaseInstance;
+	packet.m_glInstanceBuffer = glInstanceBuffer;
+	packet.m_fViewDepth = fViewDepth;
+
+	m_packets.Push(packet);
+}
+
+void CommandBucket::Submit()
+{
+	m_nDrawCount = m_packets.Count();
+	m_nDrawCallCount = 0;
+	m_nCullTestedCount = 0;
+	m_nMaterialChangeCount = 0;
+
+	m_visibilitySources.Clear();
+	m_fallbackPackets.Clear();
+
+	if (m_nDrawCount == 0)
+		return;
+
+	// Sort packets by key, stable so packets with equal keys keep the order they were added in...
+	DrawPacket* packets = &m_packets[0];
+
+	std::stable_sort(packets, packets + m_nDrawCount, [](const DrawPacket& lhs, const DrawPacket& rhs)
+	{
+		return lhs.m_nKey < rhs.m_nKey;
+	});
+
+	// Build an indirect command for every packet in sorted order...
+	m_indirectCommands.Clear();
+
+	for(int i = 0; i < m_nDrawCount; ++i)
+	{
+		const DrawPacket& packet = packets[i];
+
+		DrawElementsIndirectCommand command;
+		command.m_nCount = packet.m_geometry.m_nIndexCount;
+		command.m_nInstanceCount = packet.m_nInstanceCount;
+		command.m_nFirstIndex = packet.m_geometry.m_nFirstIndex;
+		command.m_nBaseVertex = packet.m_geometry.m_nBaseVertex;
+		command.m_nBaseInstance = packet.m_nBaseInstance;
+
+		m_indirectCommands.Push(command);
+	}
+
+	GLState* glState = GLState::GetInstance();
+	UploadRing* uploadRing = UploadRing::GetInstance();
+
+	// Reserve space for the commands in the upload ring, instance culling needs to know where they will be...
+	unsigned int nCommandOffset = 0;
+	bool bIndirect = uploadRing->Allocate(sizeof(DrawElementsIndirectCommand) * m_nDrawCount, sizeof(unsigned int), nCommandOffset) != nullptr;
+	bool bCull = bIndirect && m_cullShader && PrepareCulling(packets, nCommandOffset);
+
+	// Culled draws read the compacted instances from the output buffer, the rest read them where they were added...
+	m_drawInstanceBuffers.Clear();
+
+	for(int i = 0; i < m_nDrawCount; ++i)
+	{
+		bool bCulled = bCull && packets[i].m_geometry.m_v4BoundingSphere.w >= 0.0f;
+
+		m_drawInstanceBuffers.Push(bCulled ? m_glCullOutputHandle : packets[i].m_glInstanceBuffer);
+	}
+
+	// Visibility draws need their slots, once the culled base instances are known...
+	bool bVisibility = m_visibilityShader != nullptr;
+
+	if(bVisibility && !PrepareVisibility(packets))
+	{
+		m_packets.Clear();
+		return;
+	}
+
+	// The ring may have grown since the commands were reserved, their offset is kept but the mapped pointer is not...
+	if (bIndirect)
+		memcpy(uploadRing->MappedData(nCommandOffset), m_indirectCommands.Data(), sizeof(DrawElementsIndirectCommand) * m_nDrawCount);
+
+	// Cull instances, the shader writes the visible instance counts into the commands...
+	if (bCull)
+		DispatchCulling();
+
+	// Table materials find their entry through the slot of their draw, visibility draws record it for the resolve instead...
+	bool bDrawMaterials = !bVisibility && PrepareDrawMaterials(packets);
+
+	// Bind the ring once nothing more is reserved in it this submission.
+	if (bIndirect)
+		glState->BindBuffer(GL_DRAW_INDIRECT_BUFFER, uploadRing->Handle());
+
+	if(bVisibility)
+	{
+		m_visibilityShader->Use();
+		glState->BindBufferRange(GL_SHADER_STORAGE_BUFFER, VISIBILITY_DRAW_SSBO_BINDING, uploadRing->Handle(), m_nVisibilityDrawOffset, sizeof(VisibilityDraw) * m_nDrawCount);
+
+		++m_nMaterialChangeCount;
+	}
+
+	Material* currentMaterial = nullptr;
+	int nRunStart = 0;
+
+	while(nRunStart < m_nDrawCount)
+	{
+		const DrawPacket& first = packets[nRunStart];
+
+		// Find the run of packets sharing this packet's material, VAO and instance buffer, or only the buffers when materials are ignored...
+		int nRunEnd = nRunStart + 1;
+
+		while (nRunEnd < m_nDrawCount && m_drawInstanceBuffers[nRunEnd] == m_drawInstanceBuffers[nRunStart] &&
+			(bVisibility ? packets[nRunEnd].m_geometry.m_glVAO == first.m_geometry.m_glVAO : SharesRun(first, packets[nRunEnd], bDrawMaterials)))
+			++nRunEnd;
+
+		if(!bVisibility)
+		{
+			// Table materials cannot be drawn without their slots, only possible when the upload ring is full.
+			if(first.m_material->UsesMaterialTable() && !bDrawMaterials)
+			{
+				nRunStart = nRunEnd;
+				continue;
+			}
+
+			// Bind the shader and maps only when the material changes, adjacent materials sharing a shader skip the program bind...
+			if(first.m_material != currentMaterial)
+			{
+				first.m_material->Use();
+				currentMaterial = first.m_material;
+
+				++m_nMaterialChangeCount;
+			}
+		}
+
+		// Vertex and index bindings are part of the VAO, instances are read from the run's instance buffer.
+		unsigned int glInstanceBuffer = m_drawInstanceBuffers[nRunStart];
+
+		glState->BindVertexArray(first.m_geometry.m_glVAO);
+		glBindVertexBuffer(INSTANCE_VERTEX_BINDING, glInstanceBuffer ? glInstanceBuffer : uploadRing->Handle(), 0, INSTANCE_SIZE);
+
+		int nRunLength = nRunEnd - nRunStart;
+
+		// Shaders reading per-draw data need the index of the run's first draw.
+		Shader* drawOffsetShader = nullptr;
+
+		if (bVisibility)
+			drawOffsetShader = m_visibilityShader;
+		else if (first.m_material->UsesMaterialTable())
+			drawOffsetShader = first.m_material->GetShader();
+
+		if(bIndirect)
+		{
+			// gl_DrawIDARB counts from zero within each multi-draw...
+			if (drawOffsetShader)
+				drawOffsetShader->SetUniformInt("drawOffset", nRunStart);
+
+			// Draw the whole run with one call, each command selects its mesh with first index and base vertex and its instances with base instance.
+			// Culled commands must be drawn indirectly regardless of the run length, as only the GPU knows their instance counts...
+			const void* commandOffset = reinterpret_cast<const void*>(static_cast<size_t>(nCommandOffset + sizeof(DrawElementsIndirectCommand) * nRunStart));
+
+			glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, commandOffset, nRunLength, 0);
+
+			++m_nDrawCallCount;
+		}
+		else
+		{
+			for(int i = nRunStart; i < nRunEnd; ++i)
+			{
+				const DrawPacket& packet = packets[i];
+				const void* indexOffset = reinterpret_cast<const void*>(static_cast<size_t>(sizeof(unsigned int) * packet.m_geometry.m_nFirstIndex));
+
+				// Draws the visibility buffer can't resolve have no indices, they are drawn by SubmitVisibilityFallback.
+				if (m_indirectCommands[i].m_nCount == 0)
+					continue;
+
+				// A single draw always has a draw ID of zero.
+				if (drawOffsetShader)
+					drawOffsetShader->SetUniformInt("drawOffset", i);
+
+				glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, packet.m_geometry.m_nIndexCount, GL_UNSIGNED_INT, indexOffset, 
+					packet.m_nInstanceCount, packet.m_geometry.m_nBaseVertex, packet.m_nBaseInstance);
+
+				++m_nDrawCallCount;
+			}
+		}
+
+		nRunStart = nRunEnd;
+	}
+
+	m_packets.Clear();
+}
+
+int CommandBucket::DrawCount() const
+{
+	return m_nDrawCount;
+}
+
+int CommandBucket::DrawCallCount() const
+{
+	return m_nDrawCallCount;
+}
+
+int CommandBucket::CullTestedInstanceCount() const
+{
+	return m_nCullTestedCount;
+}
+
+int CommandBucket::MaterialChangeCount() const
+{
+	return m_nMaterialChangeCount;
+}
+
+bool CommandBucket::PrepareCulling(const DrawPacket* packets, unsigned int nCommandOffset)
+{
+	m_cullDraws.Clear();
+	m_cullCommandIndices.Clear();
+	m_cullDispatches.Clear();
+
+	// Count instances of draws with bounds, one invocation tests each of them...
+	unsigned int nTestedCount = 0;
+
+	for(int i = 0; i < m_nDrawCount; ++i)
+	{
+		if (packets[i].m_geometry.m_v4BoundingSphere.w >= 0.0f)
+			nTestedCount += packets[i].m_nInstanceCount;
+	}
+
+	if (nTestedCount == 0)
+		return false;
+
+	// Grow the output buffer to fit every tested instance, its contents only last the frame...
+	if(nTestedCount > m_nCullOutputCapacity)
+	{
+		m_nCullOutputCapacity = std::max(nTestedCount, m_nCullOutputCapacity * 2);
+
+		GLState::GetInstance()->BindBuffer(GL_COPY_WRITE_BUFFER, m_glCullOutputHandle);
+		glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(INSTANCE_SIZE) * m_nCullOutputCapacity, nullptr, GL_DYNAMIC_COPY);
+		GLState::GetInstance()->BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+
+	// Group the draws by the buffer their instances are read from, each group is tested by its own dispatch...
+	for(int i = 0; i < m_nDrawCount; ++i)
+	{
+		if (packets[i].m_geometry.m_v4BoundingSphere.w < 0.0f)
+			continue;
+
+		int nDispatch = 0;
+
+		while (nDispatch < m_cullDispatches.Count() && m_cullDispatches[nDispatch].m_glInstanceBuffer != packets[i].m_glInstanceBuffer)
+			++nDispatch;
+
+		if (nDispatch == m_cullDispatches.Count())
+			m_cullDispatches.Push({ packets[i].m_glInstanceBuffer, 0, 0, 0 });
+	}
+
+	unsigned int nOutputInstance = 0;
+
+	for(int i = 0; i < m_cullDispatches.Count(); ++i)
+	{
+		CullDispatch& dispatch = m_cullDispatches[i];
+		dispatch.m_nFirstDraw = m_cullDraws.Count();
+
+		for(int j = 0; j < m_nDrawCount; ++j)
+		{
+			const DrawPacket& packet = packets[j];
+
+			if (packet.m_geometry.m_v4BoundingSphere.w < 0.0f || packet.m_glInstanceBuffer != dispatch.m_glInstanceBuffer)
+				continue;
+
+			CullDraw draw;
+			draw.m_v4BoundingSphere = packet.m_geometry.m_v4BoundingSphere;
+			draw.m_nFirstThread = dispatch.m_nInstanceCount;
+			draw.m_nInstanceCount = packet.m_nInstanceCount;
+			draw.m_nSourceWord = packet.m_nBaseInstance * INSTANCE_WORD_COUNT;
+			draw.m_nOutputWord = nOutputInstance * INSTANCE_WORD_COUNT;
+			draw.m_nCommandWord = static_cast<unsigned int>((nCommandOffset + sizeof(DrawElementsIndirectCommand) * j) / sizeof(unsigned int));
+			draw.m_nPadding[0] = draw.m_nPadding[1] = draw.m_nPadding[2] = 0;
+
+			m_cullDraws.Push(draw);
+			m_cullCommandIndices.Push(j);
+
+			dispatch.m_nInstanceCount += packet.m_nInstanceCount;
+			nOutputInstance += packet.m_nInstanceCount;
+		}
+
+		dispatch.m_nDrawCount = m_cullDraws.Count() - dispatch.m_nFirstDraw;
+	}
+
+	UploadRing* uploadRing = UploadRing::GetInstance();
+
+	if (!uploadRing->Upload(m_cullDraws.Data(), sizeof(CullDraw) * m_cullDraws.Count(), uploadRing->StorageAlignment(), m_nCullDrawOffset))
+		return false;
+
+	// Culled commands start with no instances and draw the compacted visible instances...
+	for(int i = 0; i < m_cullDraws.Count(); ++i)
+	{
+		DrawElementsIndirectCommand& command = m_indirectCommands[m_cullCommandIndices[i]];
+
+		command.m_nInstanceCount = 0;
+		command.m_nBaseInstance = m_cullDraws[i].m_nOutputWord / INSTANCE_WORD_COUNT;
+	}
+
+	m_nCullTestedCount = static_cast<int>(nTestedCount);
+
+	return true;
+}
+
+void CommandBucket::DispatchCulling()
+{
+	GPUProfileScope profileScope("Instance culling");
+
+	GLState* glState = GLState::GetInstance();
+	UploadRing* uploadRing = UploadRing::GetInstance();
+
+	m_cullShader->Use();
+
+	m_cullShader->SetUniformVec4Array("frustumPlanes", &m_v4FrustumPlanes[0].x, 6);
+
+	// Occlusion test against last frame's depth, until the first pyramid is built only the frustum is tested...
+	bool bHiZ = m_hiZBuffer && m_hiZBuffer->IsValid();
+
+	m_cullShader->SetUniformInt("hiZEnabled", bHiZ ? 1 : 0);
+
+	if(bHiZ)
+	{
+		m_cullShader->SetUniformMat4("hiZViewProjection", glm::value_ptr(m_hiZBuffer->ViewProjection()));
+		m_cullShader->SetUniformInt("hiZMipCount", m_hiZBuffer->MipCount());
+
+		glState->BindTexture(0, GL_TEXTURE_2D, m_hiZBuffer->Handle());
+	}
+
+	// Commands are written in place within the upload ring, visible instances are compacted into the output buffer...
+	glState->BindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_CULL_RING_SSBO_BINDING, uploadRing->Handle());
+	glState->BindBufferRange(GL_SHADER_STORAGE_BUFFER, INSTANCE_CULL_DRAW_SSBO_BINDING, uploadRing->Handle(), m_nCullDrawOffset, sizeof(CullDraw) * m_cullDraws.Count());
+	glState->BindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_CULL_OUTPUT_SSBO_BINDING, m_glCullOutputHandle);
+
+	for(int i = 0; i < m_cullDispatches.Count(); ++i)
+	{
+		const CullDispatch& dispatch = m_cullDispatches[i];
+
+		m_cullShader->SetUniformInt("firstDraw", dispatch.m_nFirstDraw);
+		m_cullShader->SetUniformInt("drawCount", dispatch.m_nDrawCount);
+		m_cullShader->SetUniformInt("instanceCount", static_cast<int>(dispatch.m_nInstanceCount));
+
+		glState->BindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_SOURCE_SSBO_BINDING, dispatch.m_glInstanceBuffer ? dispatch.m_glInstanceBuffer : uploadRing->Handle());
+
+		glDispatchCompute((dispatch.m_nInstanceCount + INSTANCE_CULL_GROUP_SIZE - 1) / INSTANCE_CULL_GROUP_SIZE, 1, 1);
+	}
+
+	// Make the written commands and instances visible to the draws and the visibility resolve...
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+bool CommandBucket::PrepareDrawMaterials(const DrawPacket* packets)
+{
+	MaterialTable* materialTable = MaterialTable::GetInstance();
+
+	if (!materialTable)
+		return false;
+
+	m_drawMaterials.Clear();
+
+	bool bUsesTable = false;
+
+	for(int i = 0; i < m_nDrawCount; ++i)
+	{
+		bool bTableMaterial = packets[i].m_material->UsesMaterialTable();
+
+		m_drawMaterials.Push(bTableMaterial ? static_cast<unsigned int>(packets[i].m_material->TableSlot()) : 0);
+		bUsesTable |= bTableMaterial;
+	}
+
+	if (!bUsesTable)
+		return false;
+
+	UploadRing* uploadRing = UploadRing::GetInstance();
+	unsigned int nOffset = 0;
+
+	if (!uploadRing->Upload(m_drawMaterials.Data(), sizeof(unsigned int) * m_nDrawCount, uploadRing->StorageAlignment(), nOffset))
+		return false;
+
+	GLState* glState = GLState::GetInstance();
+
+	glState->BindBufferBase(GL_SHADER_STORAGE_BUFFER, MATERIAL_TABLE_SSBO_BINDING, materialTable->Handle());
+	glState->BindBufferRange(GL_SHADER_STORAGE_BUFFER, MATERIAL_DRAW_SSBO_BINDING, uploadRing->Handle(), nOffset, sizeof(unsigned int) * m_nDrawCount);
+
+	return true;
+}
+
+bool CommandBucket::PrepareVisibility(const DrawPacket* packets)
+{
+	MaterialTable* materialTable = MaterialTable::GetInstance();
+
+	m_visibilityDraws.Clear();
+
+	// Slot zero is never assigned, IDs of zero mark pixels no triangle covers.
+	unsigned long long nNextSlot = 1;
+
+	for(int i = 0; i < m_nDrawCount; ++i)
+	{
+		const DrawPacket& packet = packets[i];
+		DrawElementsIndirectCommand& command = m_indirectCommands[i];
+
+		// Every draw keeps its entry so draw IDs still index the table, draws without buffers to fetch from or slots left aren't drawn into the visibility buffer...
+		bool bResolvable = packet.m_geometry.m_glVBO != 0 && nNextSlot + packet.m_nInstanceCount - 1 <= VISIBILITY_MAX_SLOT;
+
+		// Find the source of the draw's geometry and instances...
+		int nSource = 0;
+
+		while (nSource < m_visibilitySources.Count() && (m_visibilitySources[nSource].m_glVBO != packet.m_geometry.m_glVBO || 
+			m_visibilitySources[nSource].m_glIndexBuffer != packet.m_geometry.m_glIndexBuffer || m_visibilitySources[nSource].m_glInstanceBuffer != m_drawInstanceBuffers[i]))
+			++nSource;
+
+		if(bResolvable && nSource == m_visibilitySources.Count())
+			m_visibilitySources.Push({ packet.m_geometry.m_glVBO, packet.m_geometry.m_glIndexBuffer, m_drawInstanceBuffers[i] });
+
+		// Skipped draws take no slots, so first slots never decrease.
+		VisibilityDraw draw;
+		draw.m_nFirstIndex = command.m_nFirstIndex;
+		draw.m_nBaseVertex = command.m_nBaseVertex;
+		draw.m_nBaseInstance = command.m_nBaseInstance;
+		draw.m_nMaterialSlot = materialTable && packet.m_material->UsesMaterialTable() ? static_cast<unsigned int>(packet.m_material->TableSlot()) : VISIBILITY_NO_MATERIAL;
+		draw.m_nFirstSlot = static_cast<unsigned int>(nNextSlot);
+		draw.m_nSource = static_cast<unsigned int>(nSource);
+
+		if (bResolvable)
+			nNextSlot += packet.m_nInstanceCount;
+		else
+		{
+			// ...they are drawn with their materials once the rest is resolved.
+			command.m_nCount = 0;
+			m_fallbackPackets.Push(packet);
+		}
+
+		m_visibilityDraws.Push(draw);
+	}
+
+	if(m_fallbackPackets.Count() > 0 && !m_bVisibilityReported)
+	{
+		std::cout << "Command Bucket Warning: Draws exceeding the visibility buffer's " << VISIBILITY_MAX_SLOT << " instance slots, or drawn without buffers, " 
+			<< "are drawn with their materials after the resolve." << std::endl;
+		m_bVisibilityReported = true;
+	}
+
+	UploadRing* uploadRing = UploadRing::GetInstance();
+
+	return uploadRing->Upload(m_visibilityDraws.Data(), sizeof(VisibilityDraw) * m_visibilityDraws.Count(), uploadRing->StorageAlignment(), m_nVisibilityDrawOffset);
+}
+
+bool CommandBucket::SharesRun(const DrawPacket& first, const DrawPacket& packet, bool bDrawMaterials) const
+{
+	if (packet.m_geometry.m_glVAO != first.m_geometry.m_glVAO)
+		return false;
+
+	if (packet.m_material == first.m_material)
+		return true;
+
+	// Different materials only differ in their table entry when their shared shader reads the table.
+	return bDrawMaterials && packet.m_material->GetShader() == first.m_material->GetShader() &&
+		packet.m_material->UsesMaterialTable() && first.m_material->UsesMaterialTable();
+}
+
+unsigned long long CommandBucket::MakeKey(EDrawPass ePass, Material* material, const GeometryRange& geometry, float fViewDepth) const
+{
+	// Quantize depth between the near and far planes...
+	float fDepth = (fViewDepth - m_fNear) / (m_fFar - m_fNear);
+	fDepth = std::min(std::max(fDepth, 0.0f), 1.0f);
+
+	unsigned long long nDepth = static_cast<unsigned long long>(fDepth * SORT_KEY_DEPTH_MAX);
+	unsigned long long nShader = m_visibilityShader ? 0 : material->GetShader()->GetHandle() & 0xFFF;
+	// Table materials share one material field, so draws of the same mesh stay adjacent across materials and merge into one run.
+	unsigned long long nMaterial = m_visibilityShader || material->UsesMaterialTable() ? 0 : material->SortID();
+	unsigned long long nMesh = ((geometry.m_glVAO & 0xFF) << 8) | ((geometry.m_nFirstIndex * 2654435761u) >> 24);
+
+	unsigned long long nKey = static_cast<unsigned long long>(ePass) << SORT_KEY_PASS_SHIFT;
+
+	if (ePass == DRAW_PASS_TRANSPARENT)
+		nKey |= ((SORT_KEY_DEPTH_MAX - nDepth) << 44) | (nShader << 32) | (nMaterial << 16) | nMesh;
+	else
+		nKey |= (nShader << 48) | (nMaterial << 32) | (nMesh << 16) | nDepth;
+
+	return nKey;
+}
@@ -0,0 +1,285 @@
+#pragma once
+#include "DynamicArray.h"
+#include "glm.hpp"
+#include "GeometryPool.h"
+
+class Material;
+class Shader;
+class HiZBuffer;
+
+// Shader storage bindings used by instance culling, following the clustered lighting bindings.
+#define INSTANCE_CULL_RING_SSBO_BINDING 5
+#define INSTANCE_CULL_DRAW_SSBO_BINDING 6
+
+// Shader storage bindings of the instances culled or resolved and of the compacted visible instances, following the exposure bindings.
+#define INSTANCE_SOURCE_SSBO_BINDING 15
+#define INSTANCE_CULL_OUTPUT_SSBO_BINDING 16
+
+// Size of the per-instance data written by instanced renderers, as 32-bit words.
+#define INSTANCE_WORD_COUNT 29
+
+// Shader storage bindings of the geometry and draws read when resolving the visibility buffer, following the material table bindings.
+#define VISIBILITY_VERTEX_SSBO_BINDING 9
+#define VISIBILITY_INDEX_SSBO_BINDING 10
+#define VISIBILITY_DRAW_SSBO_BINDING 11
+
+// A visibility ID is a 32-bit instance slot and the 32-bit triangle within its draw, slot zero is left for pixels no triangle covers.
+// The last slot is never assigned either, so the first slot of a draw past every assigned slot still fits.
+#define VISIBILITY_MAX_SLOT 0xFFFFFFFEu
+
+// Material slot of visibility draws whose material doesn't read the MaterialTable, resolved as the plain material.
+#define VISIBILITY_NO_MATERIAL 0xFFFFFFFF
+
+// Passes in submission order, the pass occupies the highest bits of the sort key.
+enum EDrawPass
+{
+	DRAW_PASS_OPAQUE, // Sorted by shader, material and mesh, then front to back for early depth rejection.
+	DRAW_PASS_TRANSPARENT, // Sorted back to front for correct blending, then by shader, material and mesh.
+	DRAW_PASS_COUNT
+};
+
+/*
+Collects the draws of a frame as packets carrying a 64-bit sort key, instead of drawing in the order objects are visited.
+The bucket is sorted before submission so draws sharing a shader, material and mesh are adjacent and
+opaque geometry within each group is drawn front to back. Instance data must already be in the UploadRing or in the buffer given with the draw, such as the InstancePool.
+Consecutive draws sharing a material and VAO, such as all GeometryPool meshes of a material, are submitted as one multi-draw indirect call.
+With a cull shader set, the instances of every draw with bounds are frustum tested on the GPU, which compacts the visible instances into
+a buffer owned by the bucket and writes the instance counts of the indirect commands, so the CPU never touches per-instance visibility.
+Instances passing the frustum test are also tested against the Hi-Z pyramid of the previous frame when one is set.
+Materials reading their maps from the MaterialTable are merged into the runs of other such materials sharing their shader.
+With a visibility shader set, every draw is rasterized with it regardless of material, so all draws of a VAO form one run.
+Each visible instance gets a slot and each pixel an ID of slot and triangle, resolved later by fetching the draw's vertices from its buffers.
+Draws the visibility buffer can't resolve are kept for SubmitVisibilityFallback, which draws them with their materials.
+*/
+class CommandBucket
+{
+public:
+
+	CommandBucket();
+
+	~CommandBucket();
+
+	/*
+	Description: Set the camera used to quantize draw depths and cull instances this frame.
+	Param:
+	    const mat4& viewMatrix: The camera view matrix.
+		const mat4& projectionMatrix: The camera projection matrix.
+		float fNear: The near plane distance.
+		float fFar: The far plane distance.
+	*/
+	void SetView(const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix, float fNear, float fFar);
+
+	/*
+	Description: Set the compute shader used to cull instances on the GPU, or nullptr to draw all instances.
+	Param:
+	    Shader* cullShader: The instance culling compute shader.
+	*/
+	void SetCullShader(Shader* cullShader);
+
+	/*
+	Description: Set the depth pyramid instances are occlusion tested against, or nullptr to only frustum cull.
+	Param:
+	    HiZBuffer* hiZBuffer: The pyramid of the previous frame's depth, instances are tested with the view projection it was built with.
+	*/
+	void SetHiZBuffer(HiZBuffer* hiZBuffer);
+
+	/*
+	Description: Set the shader writing visibility IDs in place of every material's shader, or nullptr to draw with materials.
+	Must be set before the frame's draws are added, as materials no longer sort the draws.
+	Param:
+	    Shader* visibilityShader: The shader writing the ID of slot and triangle.
+	*/
+	void SetVisibilityShader(Shader* visibilityShader);
+
+	/*
+	Description: Get the amount of vertex and index buffer pairs drawn from by the last Submit with a visibility shader.
+	Return Type: int
+	*/
+	int VisibilitySourceCount() const;
+
+	/*
+	Description: Bind the buffers a resolve shader reads the geometry, instances and materials of one source's pixels from.
+	Param:
+	    int nSource: The index of the source, below VisibilitySourceCount.
+		Shader* resolveShader: The resolve shader, it is bound and told which source to resolve.
+	*/
+	void BindVisibilitySource(int nSource, Shader* resolveShader);
+
+	/*
+	Description: Draw with their materials the draws the last Submit with a visibility shader couldn't give IDs, then empty them.
+	Called once the visibility buffer is resolved, with the G-buffer and the depth of the visibility pass bound.
+	*/
+	void SubmitVisibilityFallback();
+
+	/*
+	Description: Get the view space distance of a worldspace position in front of the camera.
+	Return Type: float
+	Param:
+	    const vec3& v3Position: The worldspace position.
+	*/
+	float ViewDepth(const glm::vec3& v3Position) const;
+
+	/*
+	Description: Get the view space distance of the origin of a model matrix in front of the camera.
+	Return Type: float
+	Param:
+	    const float* modelMatrix: The model matrix in float ptr format.
+	*/
+	float ViewDepth(const float* modelMatrix) const;
+
+	/*
+	Description: Add an instanced indexed draw of 32-bit triangle indices to the bucket.
+	Param:
+	    EDrawPass ePass: The pass the draw belongs to.
+		Material* material: The material to draw with.
+		const GeometryRange& geometry: The vertex array containing the vertex, index and instance attribute bindings, and the indices to draw within it.
+		unsigned int nInstanceCount: The amount of instances to draw.
+		unsigned int nBaseInstance: The index of the first instance in the instance buffer.
+		float fViewDepth: The view space distance used for depth sorting, see ViewDepth.
+		unsigned int glInstanceBuffer: The buffer holding the instances, or 0 for this frame's upload ring.
+	*/
+	void AddDraw(EDrawPass ePass, Material* material, const GeometryRange& geometry, unsigned int nInstanceCount, unsigned int nBaseInstance, float fViewDepth, unsigned int glInstanceBuffer = 0);
+
+	/*
+	Description: Sort and draw all packets added since the last submission, then empty the bucket.
+	*/
+	void Submit();
+
+	/*
+	Description: Get the amount of draws submitted by the last Submit.
+	Return Type: int
+	*/
+	int DrawCount() const;
+
+	/*
+	Description: Get the amount of draw calls issued by the last Submit, a multi-draw counts as one call.
+	Return Type: int
+	*/
+	int DrawCallCount() const;
+
+	/*
+	Description: Get the amount of instances frustum tested on the GPU by the last Submit.
+	Return Type: int
+	*/
+	int CullTestedInstanceCount() const;
+
+	/*
+	Description: Get the amount of material changes made by the last Submit.
+	Return Type: int
+	*/
+	int MaterialChangeCount() const;
+
+private:
+
+	struct DrawPacket
+	{
+		unsigned long long m_nKey;
+		Material* m_material;
+		GeometryRange m_geometry;
+		unsigned int m_nInstanceCount;
+		unsigned int m_nBaseInstance;
+		unsigned int m_glInstanceBuffer; // Zero for the upload ring, whose buffer may change while the frame is recorded.
+		float m_fViewDepth; // Kept to sort the draw by material if the visibility buffer can't resolve it.
+	};
+
+	// Layout of a glMultiDrawElementsIndirect command.
+	struct DrawElementsIndirectCommand
+	{
+		unsigned int m_nCount;
+		unsigned int m_nInstanceCount;
+		unsigned int m_nFirstIndex;
+		int m_nBaseVertex;
+		unsigned int m_nBaseInstance;
+	};
+
+	// Per-draw input of visibility shaders, matches the std430 layout of VisibilityDraw in visibility.vs and visibility_resolve.fs.
+	struct VisibilityDraw
+	{
+		unsigned int m_nFirstIndex;
+		int m_nBaseVertex;
+		unsigned int m_nBaseInstance; // Base instance of the indirect command, after culling compacted the visible instances.
+		unsigned int m_nMaterialSlot;
+		unsigned int m_nFirstSlot; // Slot of the first instance, the rest follow it. Increases with the draw index so the resolve can search for it.
+		unsigned int m_nSource;
+	};
+
+	// Buffers a VAO drawn into the visibility buffer reads.
+	struct VisibilitySource
+	{
+		unsigned int m_glVBO;
+		unsigned int m_glIndexBuffer;
+		unsigned int m_glInstanceBuffer;
+	};
+
+	// Per-draw input of the instance culling shader, matches the std430 layout of CullDraw in instance_cull.comp.
+	struct CullDraw
+	{
+		glm::vec4 m_v4BoundingSphere;
+		unsigned int m_nFirstThread; // Index of the invocation testing the draw's first instance, within the draw's dispatch.
+		unsigned int m_nInstanceCount;
+		unsigned int m_nSourceWord; // Word offset within the instance buffer.
+		unsigned int m_nOutputWord; // Word offset within the output buffer.
+		unsigned int m_nCommandWord; // Word offset within the upload ring.
+		unsigned int m_nPadding[3];
+	};
+
+	// Cull draws reading their instances from the same buffer, tested by one dispatch.
+	struct CullDispatch
+	{
+		unsigned int m_glInstanceBuffer;
+		int m_nFirstDraw;
+		int m_nDrawCount;
+		unsigned int m_nInstanceCount;
+	};
+
+	// Upload the culling inputs of the sorted packets and point their indirect commands at their space in the output buffer, growing it to fit.
+	// Returns false without changing any command if the upload ring is full.
+	bool PrepareCulling(const DrawPacket* packets, unsigned int nCommandOffset);
+
+	// Run the culling shader, once the indirect commands are in the upload ring.
+	void DispatchCulling();
+
+	// Upload the material table slot of every sorted packet, returns false if no packet uses the table or the upload ring is full.
+	bool PrepareDrawMaterials(const DrawPacket* packets);
+
+	// Upload the visibility draws of the sorted packets, draws that can't be resolved get no indices and are kept as fallback packets.
+	// Returns false if the upload ring is full.
+	bool PrepareVisibility(const DrawPacket* packets);
+
+	// Whether two packets can be drawn by the same multi-draw.
+	bool SharesRun(const DrawPacket& first, const DrawPacket& packet, bool bDrawMaterials) const;
+
+	// Build the sort key of a packet, see CommandBucket.cpp for the bit layout.
+	unsigned long long MakeKey(EDrawPass ePass, Material* material, const GeometryRange& geometry, float fViewDepth) const;
+
+	DynamicArray<DrawPacket> m_packets;
+	DynamicArray<DrawElementsIndirectCommand> m_indirectCommands;
+	DynamicArray<CullDraw> m_cullDraws;
+	DynamicArray<int> m_cullCommandIndices; // Index of the indirect command of each cull draw.
+	DynamicArray<CullDispatch> m_cullDispatches;
+	DynamicArray<unsigned int> m_drawInstanceBuffers; // Buffer the instances of each sorted packet are drawn from, zero for the upload ring.
+	unsigned int m_glCullOutputHandle;
+	unsigned int m_nCullOutputCapacity; // Instances the output buffer holds, grown to the most instances tested by a frame.
+	DynamicArray<unsigned int> m_drawMaterials; // Material table slot of each sorted packet.
+	unsigned int m_nCullDrawOffset;
+
+	DynamicArray<VisibilityDraw> m_visibilityDraws;
+	DynamicArray<VisibilitySource> m_visibilitySources;
+	DynamicArray<DrawPacket> m_fallbackPackets; // Draws of the last visibility submission drawn with their materials after the resolve.
+	unsigned int m_nVisibilityDrawOffset;
+	bool m_bVisibilityReported;
+
+	glm::mat4 m_viewMatrix;
+	glm::vec4 m_v4FrustumPlanes[6];
+	float m_fNear;
+	float m_fFar;
+
+	Shader* m_cullShader;
+	HiZBuffer* m_hiZBuffer;
+	Shader* m_visibilityShader;
+
+	int m_nDrawCount;
+	int m_nDrawCallCount;
+	int m_nCullTestedCount;
+	int m_nMaterialChangeCount;
+};
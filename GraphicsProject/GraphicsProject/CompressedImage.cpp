@@ -0,0 +1,361 @@
+#include "CompressedImage.h"
+#include "glad/glad.h"
+#include <iostream>
+#include <fstream>
+#include <cstring>
+
+// S3TC formats, provided by EXT_texture_compression_s3tc rather than core OpenGL.
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT 0x8C4D
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+
+#define DDS_MAGIC 0x20534444 // "DDS "
+#define DDS_HEADER_SIZE 124
+#define DDS_DX10_HEADER_SIZE 20
+
+#define KTX2_HEADER_SIZE 80
+#define KTX2_LEVEL_INDEX_ENTRY_SIZE 24
+
+// Build a little endian FourCC code from its characters.
+#define FOURCC(a, b, c, d) (static_cast<unsigned int>(a) | (static_cast<unsigned int>(b) << 8) | (static_cast<unsigned int>(c) << 16) | (static_cast<unsigned int>(d) << 24))
+
+// Format codes of the DDS DX10 header and KTX2's Vulkan formats, with their OpenGL equivalents.
+struct FormatMapping
+{
+	unsigned int m_nFileFormat;
+	unsigned int m_glFormat;
+};
+
+static const FormatMapping dxgiFormats[] =
+{
+	{ 70, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT }, // BC1_TYPELESS
+	{ 71, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT }, // BC1_UNORM
+	{ 72, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT }, // BC1_UNORM_SRGB
+	{ 76, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT }, // BC3_TYPELESS
+	{ 77, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT }, // BC3_UNORM
+	{ 78, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT }, // BC3_UNORM_SRGB
+	{ 79, GL_COMPRESSED_RED_RGTC1 }, // BC4_TYPELESS
+	{ 80, GL_COMPRESSED_RED_RGTC1 }, // BC4_UNORM
+	{ 81, GL_COMPRESSED_SIGNED_RED_RGTC1 }, // BC4_SNORM
+	{ 82, GL_COMPRESSED_RG_RGTC2 }, // BC5_TYPELESS
+	{ 83, GL_COMPRESSED_RG_RGTC2 }, // BC5_UNORM
+	{ 84, GL_COMPRESSED_SIGNED_RG_RGTC2 }, // BC5_SNORM
+	{ 97, GL_COMPRESSED_RGBA_BPTC_UNORM }, // BC7_TYPELESS
+	{ 98, GL_COMPRESSED_RGBA_BPTC_UNORM }, // BC7_UNORM
+	{ 99, GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM } // BC7_UNORM_SRGB
+};
+
+static const FormatMapping vkFormats[] =
+{
+	{ 131, GL_COMPRESSED_RGB_S3TC_DXT1_EXT }, // BC1_RGB_UNORM_BLOCK
+	{ 132, GL_COMPRESSED_SRGB_S3TC_DXT1_EXT }, // BC1_RGB_SRGB_BLOCK
+	{ 133, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT }, // BC1_RGBA_UNORM_BLOCK
+	{ 134, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT }, // BC1_RGBA_SRGB_BLOCK
+	{ 137, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT }, // BC3_UNORM_BLOCK
+	{ 138, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT }, // BC3_SRGB_BLOCK
+	{ 139, GL_COMPRESSED_RED_RGTC1 }, // BC4_UNORM_BLOCK
+	{ 140, GL_COMPRESSED_SIGNED_RED_RGTC1 }, // BC4_SNORM_BLOCK
+	{ 141, GL_COMPRESSED_RG_RGTC2 }, // BC5_UNORM_BLOCK
+	{ 142, GL_COMPRESSED_SIGNED_RG_RGTC2 }, // BC5_SNORM_BLOCK
+	{ 145, GL_COMPRESSED_RGBA_BPTC_UNORM }, // BC7_UNORM_BLOCK
+	{ 146, GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM } // BC7_SRGB_BLOCK
+};
+
+// Find the OpenGL format of a file's format code, zero if it is unsupported.
+template<int N>
+static unsigned int FindFormat(const FormatMapping (&mappings)[N], unsigned int nFileFormat)
+{
+	for (int i = 0; i < N; ++i)
+	{
+		if (mappings[i].m_nFileFormat == nFileFormat)
+			return mappings[i].m_glFormat;
+	}
+
+	return 0;
+}
+
+// Read little endian values at a byte offset.
+static unsigned int ReadU32(const unsigned char* data, unsigned int nOffset)
+{
+	unsigned int nValue = 0;
+	memcpy(&nValue, data + nOffset, sizeof(unsigned int));
+
+	return nValue;
+}
+
+static unsigned long long ReadU64(const unsigned char* data, unsigned int nOffset)
+{
+	unsigned long long nValue = 0;
+	memcpy(&nValue, data + nOffset, sizeof(unsigned long long));
+
+	return nValue;
+}
+
+CompressedImage::CompressedImage(const char* szFilePath)
+{
+	m_fileData = nullptr;
+	m_nFileSize = 0;
+	m_glFormat = 0;
+	m_nWidth = 0;
+	m_nHeight = 0;
+
+	std::ifstream file(szFilePath, std::ios::binary | std::ios::ate);
+
+	if(!file.good())
+	{
+		std::cout << "Failed to load compressed image: " << szFilePath << std::endl;
+		return;
+	}
+
+	// The file is kept whole, levels point into it...
+	m_nFileSize = static_cast<unsigned int>(file.tellg());
+	m_fileData = new unsigned char[m_nFileSize];
+
+	file.seekg(0, std::ios::beg);
+	file.read(reinterpret_cast<char*>(m_fileData), m_nFileSize);
+	file.close();
+
+	bool bRead = false;
+
+	if (m_nFileSize >= 4 && ReadU32(m_fileData, 0) == DDS_MAGIC)
+		bRead = ReadDDS(szFilePath);
+	else if (m_nFileSize >= 12 && memcmp(m_fileData, "\xABKTX 20\xBB\r\n\x1A\n", 12) == 0)
+		bRead = ReadKTX2(szFilePath);
+	else
+		std::cout << "Compressed Image Error: " << szFilePath << " is neither a DDS nor a KTX2 file." << std::endl;
+
+	if(!bRead)
+	{
+		m_glFormat = 0;
+		m_levels.Clear();
+	}
+}
+
+CompressedImage::~CompressedImage()
+{
+	delete[] m_fileData;
+}
+
+bool CompressedImage::IsValid() const
+{
+	return m_glFormat != 0 && m_levels.Count() > 0;
+}
+
+unsigned int CompressedImage::Format() const
+{
+	return m_glFormat;
+}
+
+int CompressedImage::Width() const
+{
+	return m_nWidth;
+}
+
+int CompressedImage::Height() const
+{
+	return m_nHeight;
+}
+
+int CompressedImage::LevelCount() const
+{
+	return m_levels.Count();
+}
+
+const unsigned char* CompressedImage::LevelData(int nLevel) const
+{
+	return m_fileData + m_levels[nLevel].m_nOffset;
+}
+
+unsigned int CompressedImage::LevelSize(int nLevel) const
+{
+	return m_levels[nLevel].m_nSize;
+}
+
+bool CompressedImage::IsCompressedFile(const char* szFilePath)
+{
+	const char* szExtension = strrchr(szFilePath, '.');
+
+	if (!szExtension)
+		return false;
+
+	return strcmp(szExtension, ".dds") == 0 || strcmp(szExtension, ".DDS") == 0 || strcmp(szExtension, ".ktx2") == 0 || strcmp(szExtension, ".KTX2") == 0;
+}
+
+bool CompressedImage::ReadDDS(const char* szFilePath)
+{
+	if(m_nFileSize < 4 + DDS_HEADER_SIZE)
+	{
+		std::cout << "Compressed Image Error: " << szFilePath << " is truncated." << std::endl;
+		return false;
+	}
+
+	// Header fields, offsets are from the start of the file past the magic number.
+	const unsigned char* header = m_fileData + 4;
+
+	m_nHeight = static_cast<int>(ReadU32(header, 8));
+	m_nWidth = static_cast<int>(ReadU32(header, 12));
+
+	int nLevelCount = static_cast<int>(ReadU32(header, 24));
+	unsigned int nFourCC = ReadU32(header, 80);
+
+	unsigned int nDataOffset = 4 + DDS_HEADER_SIZE;
+
+	switch(nFourCC)
+	{
+	case FOURCC('D', 'X', 'T', '1'):
+		m_glFormat = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+		break;
+
+	case FOURCC('D', 'X', 'T', '5'):
+		m_glFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		break;
+
+	case FOURCC('A', 'T', 'I', '1'):
+	case FOURCC('B', 'C', '4', 'U'):
+		m_glFormat = GL_COMPRESSED_RED_RGTC1;
+		break;
+
+	case FOURCC('A', 'T', 'I', '2'):
+	case FOURCC('B', 'C', '5', 'U'):
+		m_glFormat = GL_COMPRESSED_RG_RGTC2;
+		break;
+
+	case FOURCC('D', 'X', '1', '0'):
+
+		if(m_nFileSize < nDataOffset + DDS_DX10_HEADER_SIZE)
+		{
+			std::cout << "Compressed Image Error: " << szFilePath << " is truncated." << std::endl;
+			return false;
+		}
+
+		m_glFormat = FindFormat(dxgiFormats, ReadU32(m_fileData, nDataOffset));
+		nDataOffset += DDS_DX10_HEADER_SIZE;
+		break;
+
+	default:
+		break;
+	}
+
+	if(m_glFormat == 0)
+	{
+		std::cout << "Compressed Image Error: " << szFilePath << " is not in a supported block compressed format." << std::endl;
+		return false;
+	}
+
+	// Files without mips may leave the count at zero.
+	if (nLevelCount < 1)
+		nLevelCount = 1;
+
+	if(!AddPackedLevels(nDataOffset, nLevelCount))
+	{
+		std::cout << "Compressed Image Error: " << szFilePath << " is truncated." << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool CompressedImage::ReadKTX2(const char* szFilePath)
+{
+	if(m_nFileSize < KTX2_HEADER_SIZE)
+	{
+		std::cout << "Compressed Image Error: " << szFilePath << " is truncated." << std::endl;
+		return false;
+	}
+
+	m_glFormat = FindFormat(vkFormats, ReadU32(m_fileData, 12));
+	m_nWidth = static_cast<int>(ReadU32(m_fileData, 20));
+	m_nHeight = static_cast<int>(ReadU32(m_fileData, 24));
+
+	int nLevelCount = static_cast<int>(ReadU32(m_fileData, 40));
+	unsigned int nSupercompression = ReadU32(m_fileData, 44);
+
+	if(m_glFormat == 0)
+	{
+		std::cout << "Compressed Image Error: " << szFilePath << " is not in a supported block compressed format." << std::endl;
+		return false;
+	}
+
+	// Basis and Zstandard supercompressed levels would need transcoding first.
+	if(nSupercompression != 0)
+	{
+		std::cout << "Compressed Image Error: " << szFilePath << " is supercompressed, which is not supported." << std::endl;
+		return false;
+	}
+
+	if (nLevelCount < 1)
+		nLevelCount = 1;
+
+	if(m_nFileSize < KTX2_HEADER_SIZE + static_cast<unsigned int>(nLevelCount) * KTX2_LEVEL_INDEX_ENTRY_SIZE)
+	{
+		std::cout << "Compressed Image Error: " << szFilePath << " is truncated." << std::endl;
+		return false;
+	}
+
+	// The level index lists every level's offset, the first layer or face of each starts at it...
+	for(int i = 0; i < nLevelCount; ++i)
+	{
+		unsigned int nEntry = KTX2_HEADER_SIZE + i * KTX2_LEVEL_INDEX_ENTRY_SIZE;
+
+		unsigned long long nOffset = ReadU64(m_fileData, nEntry);
+
+		int nLevelWidth = m_nWidth >> i > 0 ? m_nWidth >> i : 1;
+		int nLevelHeight = m_nHeight >> i > 0 ? m_nHeight >> i : 1;
+
+		Level level;
+		level.m_nOffset = static_cast<unsigned int>(nOffset);
+		level.m_nSize = ((nLevelWidth + 3) / 4) * ((nLevelHeight + 3) / 4) * BlockSize();
+
+		if(nOffset + level.m_nSize > m_nFileSize)
+		{
+			std::cout << "Compressed Image Error: " << szFilePath << " is truncated." << std::endl;
+			return false;
+		}
+
+		m_levels.Push(level);
+	}
+
+	return true;
+}
+
+bool CompressedImage::AddPackedLevels(unsigned int nOffset, int nLevelCount)
+{
+	for(int i = 0; i < nLevelCount; ++i)
+	{
+		int nLevelWidth = m_nWidth >> i > 0 ? m_nWidth >> i : 1;
+		int nLevelHeight = m_nHeight >> i > 0 ? m_nHeight >> i : 1;
+
+		Level level;
+		level.m_nOffset = nOffset;
+		level.m_nSize = ((nLevelWidth + 3) / 4) * ((nLevelHeight + 3) / 4) * BlockSize();
+
+		if (nOffset + level.m_nSize > m_nFileSize)
+			return false;
+
+		m_levels.Push(level);
+
+		nOffset += level.m_nSize;
+	}
+
+	return true;
+}
+
+unsigned int CompressedImage::BlockSize() const
+{
+	switch(m_glFormat)
+	{
+	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RED_RGTC1:
+	case GL_COMPRESSED_SIGNED_RED_RGTC1:
+		return 8;
+
+	default:
+		return 16;
+	}
+}
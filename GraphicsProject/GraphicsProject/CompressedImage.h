@@ -0,0 +1,99 @@
+#pragma once
+#include "DynamicArray.h"
+
+/*
+A block compressed image with its mip chain, read from a DDS or KTX2 file as stored so it can be uploaded without decoding.
+BC1, BC3, BC4, BC5 and BC7 are supported, in DDS files with legacy FourCC or DX10 headers and KTX2 files without supercompression.
+Only the first surface of array and cube map files is read.
+*/
+class CompressedImage
+{
+public:
+
+	CompressedImage(const char* szFilePath);
+
+	~CompressedImage();
+
+	/*
+	Description: Get whether the file was read and holds a supported format.
+	Return Type: bool
+	*/
+	bool IsValid() const;
+
+	/*
+	Description: Get the OpenGL internal format of the image's blocks.
+	Return Type: unsigned int
+	*/
+	unsigned int Format() const;
+
+	/*
+	Description: Get the width in pixels of the full size image.
+	Return Type: int
+	*/
+	int Width() const;
+
+	/*
+	Description: Get the height in pixels of the full size image.
+	Return Type: int
+	*/
+	int Height() const;
+
+	/*
+	Description: Get the amount of mip levels stored in the file, at least one.
+	Return Type: int
+	*/
+	int LevelCount() const;
+
+	/*
+	Description: Get the compressed blocks of a mip level, level zero is the full size image.
+	Return Type: const unsigned char*
+	Param:
+	    int nLevel: The mip level.
+	*/
+	const unsigned char* LevelData(int nLevel) const;
+
+	/*
+	Description: Get the size in bytes of a mip level's blocks.
+	Return Type: unsigned int
+	Param:
+	    int nLevel: The mip level.
+	*/
+	unsigned int LevelSize(int nLevel) const;
+
+	/*
+	Description: Get whether a file path refers to a format loaded by this class, by its extension.
+	Return Type: bool
+	Param:
+	    const char* szFilePath: The path to check.
+	*/
+	static bool IsCompressedFile(const char* szFilePath);
+
+private:
+
+	struct Level
+	{
+		unsigned int m_nOffset;
+		unsigned int m_nSize;
+	};
+
+	// Parse a DDS file's header and levels from m_fileData.
+	bool ReadDDS(const char* szFilePath);
+
+	// Parse a KTX2 file's header and levels from m_fileData.
+	bool ReadKTX2(const char* szFilePath);
+
+	// Add levels tightly packed from an offset, as DDS files store them.
+	bool AddPackedLevels(unsigned int nOffset, int nLevelCount);
+
+	// Bytes of each 4x4 block of the format.
+	unsigned int BlockSize() const;
+
+	unsigned char* m_fileData;
+	unsigned int m_nFileSize;
+
+	unsigned int m_glFormat;
+	int m_nWidth;
+	int m_nHeight;
+
+	DynamicArray<Level> m_levels;
+};
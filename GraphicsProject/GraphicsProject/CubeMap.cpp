@@ -1,19 +1,52 @@
 #include "CubeMap.h"
 #include "GLAD/glad.h"
+#include "GLState.h"
+#include "CompressedImage.h"
 #include <iostream>
 
 #include "stb_image.h"
 
 CubeMap::CubeMap(DynArr<const char*>& facePaths) : Texture(0, 0, 0)
 {
-	m_data = nullptr;
-
 	m_nWidth = 0;
 	m_nHeight = 0;
 	m_nChannels = 0;
 	m_glHandle = 0;
 	m_bOwnsTexture = true;
 
+	// Block compressed faces are uploaded as stored, other images are decoded...
+	bool bLoaded = facePaths.Count() > 0 && CompressedImage::IsCompressedFile(facePaths[0]) ? LoadCompressedFaces(facePaths) : LoadFaces(facePaths);
+
+	if (!bLoaded)
+		return;
+
+	// Specify texture parameters...
+
+	// Texture wrapping
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+	// Texture filtering
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR); // Nearest neighbour on shrink.
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR); // Nearest neighbour on expand.
+
+	// Unbind texture when finished.
+	GLState::GetInstance()->BindTexture(GL_TEXTURE_2D, 0);
+}
+
+CubeMap::~CubeMap()
+{
+
+}
+
+void CubeMap::BindCubeMap() 
+{
+	GLState::GetInstance()->BindTexture(GL_TEXTURE_CUBE_MAP, m_glHandle);
+}
+
+bool CubeMap::LoadFaces(DynArr<const char*>& facePaths)
+{
 	// Load side images...
 	DynArr<unsigned char*> imageData;
 	for (int i = 0; i < facePaths.Count(); ++i)
@@ -30,7 +63,7 @@ CubeMap::CubeMap(DynArr<const char*>& facePaths) : Texture(0, 0, 0)
 		if(!bLoadSuccessful) 
 		{
 			std::cout << "Failed to load cubemap image: " << facePaths[i] << std::endl;
-			return;
+			return false;
 		}
 		else
 			std::cout << "Successfully loaded cubemap image: " << facePaths[i] << std::endl;
@@ -38,7 +71,7 @@ CubeMap::CubeMap(DynArr<const char*>& facePaths) : Texture(0, 0, 0)
 
 	// Create and bind texture buffer.s
 	glGenTextures(1, &m_glHandle);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, m_glHandle);
+	GLState::GetInstance()->BindTexture(GL_TEXTURE_CUBE_MAP, m_glHandle);
 
 	// Send data to buffers...
 	for (int i = 0; i < imageData.Count(); ++i) 
@@ -50,27 +83,55 @@ CubeMap::CubeMap(DynArr<const char*>& facePaths) : Texture(0, 0, 0)
 
 	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
 
-	// Specify texture parameters...
+	return true;
+}
 
-	// Texture wrapping
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+bool CubeMap::LoadCompressedFaces(DynArr<const char*>& facePaths)
+{
+	DynArr<CompressedImage*> images;
 
-	// Texture filtering
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR); // Nearest neighbour on shrink.
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR); // Nearest neighbour on expand.
+	bool bLoadSuccessful = true;
 
-	// Unbind texture when finished.
-	glBindTexture(GL_TEXTURE_2D, 0);
-}
+	for (int i = 0; i < facePaths.Count() && bLoadSuccessful; ++i) 
+	{
+		images.Push(new CompressedImage(facePaths[i]));
 
-CubeMap::~CubeMap()
-{
+		// Faces share one storage, their size, format and mips must match the first.
+		bLoadSuccessful &= images[i]->IsValid() && images[i]->Width() == images[0]->Width() && images[i]->Height() == images[0]->Height() &&
+			images[i]->Format() == images[0]->Format() && images[i]->LevelCount() == images[0]->LevelCount();
 
-}
+		if(!bLoadSuccessful)
+			std::cout << "Failed to load cubemap image: " << facePaths[i] << std::endl;
+		else
+			std::cout << "Successfully loaded cubemap image: " << facePaths[i] << std::endl;
+	}
 
-void CubeMap::BindCubeMap() 
-{
-	glBindTexture(GL_TEXTURE_CUBE_MAP, m_glHandle);
-}
+	if(bLoadSuccessful)
+	{
+		m_nWidth = images[0]->Width();
+		m_nHeight = images[0]->Height();
+
+		// Create and bind texture buffer.
+		glGenTextures(1, &m_glHandle);
+		GLState::GetInstance()->BindTexture(GL_TEXTURE_CUBE_MAP, m_glHandle);
+
+		glTexStorage2D(GL_TEXTURE_CUBE_MAP, images[0]->LevelCount(), images[0]->Format(), m_nWidth, m_nHeight);
+
+		// Send every face's mips to their buffers...
+		for (int i = 0; i < images.Count(); ++i) 
+		{
+			for(int j = 0; j < images[i]->LevelCount(); ++j)
+			{
+				int nLevelWidth = m_nWidth >> j > 0 ? m_nWidth >> j : 1;
+				int nLevelHeight = m_nHeight >> j > 0 ? m_nHeight >> j : 1;
+
+				glCompressedTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, j, 0, 0, nLevelWidth, nLevelHeight, images[i]->Format(), images[i]->LevelSize(j), images[i]->LevelData(j));
+			}
+		}
+	}
+
+	for (int i = 0; i < images.Count(); ++i)
+		delete images[i];
+
+	return bLoadSuccessful;
+}
\ No newline at end of file
@@ -15,4 +15,9 @@ public:
 
 private:
 
+	// Decode the face images and upload them, mips are generated.
+	bool LoadFaces(DynArr<const char*>& facePaths);
+
+	// Upload DDS or KTX2 faces and their mips as stored.
+	bool LoadCompressedFaces(DynArr<const char*>& facePaths);
 };
\ No newline at end of file
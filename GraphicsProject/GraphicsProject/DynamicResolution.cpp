@@ -0,0 +1,99 @@
+#include "DynamicResolution.h"
+#include "GPUProfiler.h"
+#include <cmath>
+
+DynamicResolution::DynamicResolution(float fTargetFrameTime, float fMinScale, float fMaxScale)
+{
+	m_fTargetFrameTime = fTargetFrameTime;
+	m_fMinScale = fMinScale;
+	m_fMaxScale = fMaxScale;
+	m_nLastCollectedFrame = -1;
+
+	Reset();
+}
+
+DynamicResolution::~DynamicResolution()
+{
+
+}
+
+bool DynamicResolution::Update()
+{
+	GPUProfiler* profiler = GPUProfiler::GetInstance();
+
+	if (!profiler || profiler->CollectedFrameCount() == m_nLastCollectedFrame)
+		return false;
+
+	m_nLastCollectedFrame = profiler->CollectedFrameCount();
+
+	float fFrameTime = 0.0f;
+
+	if (!profiler->GetLatestSample("Frame", fFrameTime))
+		return false;
+
+	return AddSample(fFrameTime);
+}
+
+bool DynamicResolution::AddSample(float fFrameTime)
+{
+	if (m_fSmoothedFrameTime < 0.0f)
+		m_fSmoothedFrameTime = fFrameTime;
+	else
+		m_fSmoothedFrameTime += (fFrameTime - m_fSmoothedFrameTime) * DYNAMIC_RESOLUTION_SMOOTHING;
+
+	if(m_nCooldown > 0)
+	{
+		--m_nCooldown;
+		return false;
+	}
+
+	bool bOverTarget = m_fSmoothedFrameTime > m_fTargetFrameTime;
+	bool bHeadroom = m_fSmoothedFrameTime < m_fTargetFrameTime * DYNAMIC_RESOLUTION_HEADROOM;
+
+	if (!bOverTarget && !bHeadroom)
+		return false;
+
+	// Pixel count goes with the square of the scale...
+	float fIdealScale = m_fScale * sqrtf(m_fTargetFrameTime / fmaxf(m_fSmoothedFrameTime, 0.001f));
+
+	// Round down to a step, so the new scale is expected to be within the target.
+	float fNewScale = floorf(fIdealScale / DYNAMIC_RESOLUTION_STEP + 0.001f) * DYNAMIC_RESOLUTION_STEP;
+	fNewScale = fminf(fmaxf(fNewScale, m_fMinScale), m_fMaxScale);
+
+	if (fabsf(fNewScale - m_fScale) < DYNAMIC_RESOLUTION_STEP * 0.5f)
+		return false;
+
+	// Predict the frame time at the new scale, until samples measured at it arrive.
+	m_fSmoothedFrameTime *= (fNewScale * fNewScale) / (m_fScale * m_fScale);
+	m_fScale = fNewScale;
+	m_nCooldown = DYNAMIC_RESOLUTION_COOLDOWN;
+
+	return true;
+}
+
+void DynamicResolution::Reset()
+{
+	m_fScale = m_fMaxScale;
+	m_fSmoothedFrameTime = -1.0f;
+	m_nCooldown = 0;
+}
+
+void DynamicResolution::SetTargetFrameTime(float fTargetFrameTime)
+{
+	m_fTargetFrameTime = fTargetFrameTime;
+}
+
+float DynamicResolution::TargetFrameTime() const
+{
+	return m_fTargetFrameTime;
+}
+
+float DynamicResolution::Scale() const
+{
+	return m_fScale;
+}
+
+float DynamicResolution::SmoothedFrameTime() const
+{
+	return m_fSmoothedFrameTime;
+}
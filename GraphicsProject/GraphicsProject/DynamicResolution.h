@@ -0,0 +1,89 @@
+#pragma once
+
+// Range of the render scale, relative to the window's width and height.
+#define DYNAMIC_RESOLUTION_MIN_SCALE 0.5f
+#define DYNAMIC_RESOLUTION_MAX_SCALE 1.0f
+
+// The scale moves in steps of this size, so render targets are not reallocated for changes too small to matter.
+#define DYNAMIC_RESOLUTION_STEP 0.05f
+
+// Weight of each new GPU frame time in the smoothed frame time.
+#define DYNAMIC_RESOLUTION_SMOOTHING 0.15f
+
+// Samples ignored after a change. GPU timings arrive a few frames late, so the first samples after a change still measure the old scale.
+#define DYNAMIC_RESOLUTION_COOLDOWN 8
+
+// The scale is only raised once the frame time is below this fraction of the target, so it does not oscillate around the target.
+#define DYNAMIC_RESOLUTION_HEADROOM 0.85f
+
+/*
+Chooses the scale of the internal render resolution from measured GPU frame times to hold a target frame time.
+GPU time is assumed to be proportional to the rendered pixel count, so the scale expected to hit the target
+is the current scale multiplied by the square root of the target over the smoothed frame time.
+The scale drops as soon as the frame time is over the target and rises only with headroom to spare.
+*/
+class DynamicResolution
+{
+public:
+
+	DynamicResolution(float fTargetFrameTime = 16.6f, float fMinScale = DYNAMIC_RESOLUTION_MIN_SCALE, float fMaxScale = DYNAMIC_RESOLUTION_MAX_SCALE);
+
+	~DynamicResolution();
+
+	/*
+	Description: Feed the latest "Frame" GPU time from the GPU profiler if new timings have been read since the last update.
+	Return Type: bool
+	Returns true if the scale changed.
+	*/
+	bool Update();
+
+	/*
+	Description: Feed a GPU frame time measured at the current scale.
+	Return Type: bool
+	Returns true if the scale changed.
+	Param:
+	    float fFrameTime: The GPU frame time in milliseconds.
+	*/
+	bool AddSample(float fFrameTime);
+
+	/*
+	Description: Return to the maximum scale and discard the smoothed frame time.
+	*/
+	void Reset();
+
+	/*
+	Description: Set the GPU frame time to hold.
+	Param:
+	    float fTargetFrameTime: The target in milliseconds.
+	*/
+	void SetTargetFrameTime(float fTargetFrameTime);
+
+	/*
+	Description: Get the GPU frame time being held, in milliseconds.
+	Return Type: float
+	*/
+	float TargetFrameTime() const;
+
+	/*
+	Description: Get the current render scale.
+	Return Type: float
+	*/
+	float Scale() const;
+
+	/*
+	Description: Get the smoothed GPU frame time in milliseconds.
+	Return Type: float
+	*/
+	float SmoothedFrameTime() const;
+
+private:
+
+	float m_fTargetFrameTime;
+	float m_fMinScale;
+	float m_fMaxScale;
+	float m_fScale;
+
+	float m_fSmoothedFrameTime; // Negative until the first sample.
+	int m_nCooldown;
+	int m_nLastCollectedFrame;
+};
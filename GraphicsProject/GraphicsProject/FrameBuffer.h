@@ -11,7 +11,13 @@ enum EAttachmentFormat
 	BUFFER_FLOAT_RGBA16 = 0x881A,
 	BUFFER_FLOAT_RGBA32 = 0x8814,
 	BUFFER_FLOAT_RGB16 = 0x881B,
-	BUFFER_FLOAT_RGB32 = 0x8815
+	BUFFER_FLOAT_RGB32 = 0x8815,
+	BUFFER_FLOAT_RG16 = 0x822F,
+	BUFFER_FLOAT_R32 = 0x822E,
+	BUFFER_FLOAT_R11G11B10 = 0x8C3A,
+	BUFFER_UINT_R32 = 0x8236,
+	BUFFER_UINT_RG32 = 0x823C,
+	BUFFER_DEPTH24_STENCIL8 = 0x88F0
 };
 
 class Framebuffer 
@@ -40,10 +46,42 @@ public:
 	void AddDepthAttachment();
 
 	/*
-	Description: Change the width and height of the framebuffer.
+	Description: Add a combined 24 bit depth & 8 bit stencil attachment to this framebuffer to allow for depth and stencil testing.
+	*/
+	void AddDepthStencilAttachment();
+
+	/*
+	Description: Attach the depth (and stencil if present) texture of another framebuffer to this framebuffer, the other framebuffer retains ownership.
+	Param:
+	    const Framebuffer* other: The framebuffer which owns the depth texture.
+	*/
+	void ShareDepthAttachment(const Framebuffer* other);
+
+	/*
+	Description: Change the width and height of the framebuffer, reallocating every attachment it owns. Contents are lost.
+	Param:
+	    int nWidth: The new width in pixels.
+		int nHeight: The new height in pixels.
 	*/
 	void ResizeBuffers(int nWidth, int nHeight);
 
+	/*
+	Description: Allocate storage of the specified format for the currently bound 2D texture.
+	Param:
+	    EAttachmentFormat eFormat: The format of the attachment.
+		int nWidth: The width of the texture in pixels.
+		int nHeight: The height of the texture in pixels.
+	*/
+	static void AllocateAttachmentStorage(EAttachmentFormat eFormat, int nWidth, int nHeight);
+
+	/*
+	Description: Get the approximate amount of video memory used per pixel by an attachment format.
+	Return Type: int
+	Param:
+	    EAttachmentFormat eFormat: The format of the attachment.
+	*/
+	static int AttachmentPixelSize(EAttachmentFormat eFormat);
+
 	/*
 	Description: Get the the OpenGL handle for this framebuffer.
 	*/
@@ -84,6 +122,8 @@ private:
 	// Texture handles.
 	unsigned int m_glTextureHandles[MAX_COLOR_ATTACHMENT_COUNT];
 	unsigned int m_glDepthTextureHandle;
+	bool m_bHasStencil;
+	bool m_bOwnsDepth;
 	EAttachmentFormat m_eAttachmentFormats[MAX_COLOR_ATTACHMENT_COUNT];
 	// Texture objects.
 	Texture** m_attachmentTextures;
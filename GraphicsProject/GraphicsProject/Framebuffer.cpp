@@ -1,5 +1,6 @@
 #include "FrameBuffer.h"
 #include "glad\glad.h"
+#include "GLState.h"
 #include "Renderer.h"
 #include "Texture.h"
 #include <iostream>
@@ -8,6 +9,9 @@ Framebuffer::Framebuffer(int nWidth, int nHeight)
 {
 	m_attachmentTextures = new Texture*[MAX_COLOR_ATTACHMENT_COUNT];
 	m_depthTexture = nullptr;
+	m_glDepthTextureHandle = 0;
+	m_bHasStencil = false;
+	m_bOwnsDepth = false;
 	m_nAttachmentCount = 0;
 	m_glBufferHandle = 0;
 
@@ -23,7 +27,7 @@ Framebuffer::Framebuffer(int nWidth, int nHeight)
 
 	// Unbind buffers.
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLState::GetInstance()->BindTexture(GL_TEXTURE_2D, 0);
 }
 
 Framebuffer::~Framebuffer() 
@@ -39,7 +43,10 @@ Framebuffer::~Framebuffer()
 
 	// Delete all textures and the framebuffer.
 	glDeleteFramebuffers(1, &m_glBufferHandle);
-	glDeleteTextures(m_nAttachmentCount, m_glTextureHandles);
+	GLState::GetInstance()->DeleteTextures(m_nAttachmentCount, m_glTextureHandles);
+
+	if (m_bOwnsDepth)
+		GLState::GetInstance()->DeleteTextures(1, &m_glDepthTextureHandle);
 }
 
 void Framebuffer::Bind() 
@@ -59,35 +66,10 @@ void Framebuffer::AddBufferColorAttachment(EAttachmentFormat eFormat)
 
 	// Generate texture buffer.
 	glGenTextures(1, &nHandle);
-	glBindTexture(GL_TEXTURE_2D, nHandle);
+	GLState::GetInstance()->BindTexture(GL_TEXTURE_2D, nHandle);
 
 	// Allocate texture buffer memory.
-	switch (eFormat) 
-	{
-	case BUFFER_RGB:
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, m_nWidth, m_nHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, 0);
-		break;
-
-	case BUFFER_RGBA:
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_nWidth, m_nHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
-		break;
-
-	case BUFFER_FLOAT_RGB16:
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, m_nWidth, m_nHeight, 0, GL_RGB, GL_FLOAT, 0);
-		break;
-
-	case BUFFER_FLOAT_RGB32:
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB32F, m_nWidth, m_nHeight, 0, GL_RGB, GL_FLOAT, 0);
-		break;
-
-	case BUFFER_FLOAT_RGBA16:
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, m_nWidth, m_nHeight, 0, GL_RGBA, GL_FLOAT, 0);
-		break;
-
-	case BUFFER_FLOAT_RGBA32:
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, m_nWidth, m_nHeight, 0, GL_RGBA, GL_FLOAT, 0);
-		break;
-	}
+	AllocateAttachmentStorage(eFormat, m_nWidth, m_nHeight);
 
 	// Disable texture wrapping for framebuffers.
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -125,7 +107,7 @@ void Framebuffer::AddBufferColorAttachment(EAttachmentFormat eFormat)
 
 	// Unbind framebuffer and frame texture.
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLState::GetInstance()->BindTexture(GL_TEXTURE_2D, 0);
 
 	// Increment attachment count.
 	++m_nAttachmentCount;
@@ -137,7 +119,7 @@ void Framebuffer::AddDepthAttachment()
 
 	// Generate texture buffer.
 	glGenTextures(1, &m_glDepthTextureHandle);
-	glBindTexture(GL_TEXTURE_2D, m_glDepthTextureHandle);
+	GLState::GetInstance()->BindTexture(GL_TEXTURE_2D, m_glDepthTextureHandle);
 
 	// Fill depth buffer.
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, m_nWidth, m_nHeight, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_BYTE, 0);
@@ -155,9 +137,59 @@ void Framebuffer::AddDepthAttachment()
 	// Attach texture to framebuffer.
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_glDepthTextureHandle, 0);
 
+	m_bHasStencil = false;
+	m_bOwnsDepth = true;
+
 	// Unbind framebuffer and frame texture.
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLState::GetInstance()->BindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Framebuffer::AddDepthStencilAttachment() 
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, m_glBufferHandle);
+
+	// Generate texture buffer.
+	glGenTextures(1, &m_glDepthTextureHandle);
+	GLState::GetInstance()->BindTexture(GL_TEXTURE_2D, m_glDepthTextureHandle);
+
+	// Fill depth stencil buffer.
+	AllocateAttachmentStorage(BUFFER_DEPTH24_STENCIL8, m_nWidth, m_nHeight);
+
+	// Texture filtering.
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST); // Nearest neighbour on shrink.
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST); // Nearest neighbour on expand.
+
+	// Create texture object for external use.
+	if (m_depthTexture)
+		delete m_depthTexture;
+
+	m_depthTexture = new Texture(m_glDepthTextureHandle, m_nWidth, m_nHeight);
+
+	// Attach texture to framebuffer.
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, m_glDepthTextureHandle, 0);
+
+	m_bHasStencil = true;
+	m_bOwnsDepth = true;
+
+	// Unbind framebuffer and frame texture.
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLState::GetInstance()->BindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Framebuffer::ShareDepthAttachment(const Framebuffer* other) 
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, m_glBufferHandle);
+
+	// Attach the other framebuffer's texture to the same attachment point it uses.
+	glFramebufferTexture2D(GL_FRAMEBUFFER, other->m_bHasStencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, other->m_glDepthTextureHandle, 0);
+
+	m_glDepthTextureHandle = other->m_glDepthTextureHandle;
+	m_bHasStencil = other->m_bHasStencil;
+	m_bOwnsDepth = false;
+
+	// Unbind framebuffer.
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void Framebuffer::ResizeBuffers(int nWidth, int nHeight) 
@@ -168,36 +200,112 @@ void Framebuffer::ResizeBuffers(int nWidth, int nHeight)
 	// Resize color attachments...
 	for(unsigned int i = 0; i < m_nAttachmentCount; ++i) 
 	{
-		glBindTexture(GL_TEXTURE_2D, m_glTextureHandles[i]);
+		GLState::GetInstance()->BindTexture(GL_TEXTURE_2D, m_glTextureHandles[i]);
 
 		// Resize texture buffer.
-		switch (m_eAttachmentFormats[i])
-		{
-		case BUFFER_RGB:
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, m_nWidth, m_nHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, 0);
-			break;
-
-		case BUFFER_RGBA:
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_nWidth, m_nHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
-			break;
-
-		case BUFFER_FLOAT_RGB16:
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, m_nWidth, m_nHeight, 0, GL_RGB, GL_FLOAT, 0);
-			break;
-
-		case BUFFER_FLOAT_RGB32:
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB32F, m_nWidth, m_nHeight, 0, GL_RGB, GL_FLOAT, 0);
-			break;
-
-		case BUFFER_FLOAT_RGBA16:
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, m_nWidth, m_nHeight, 0, GL_RGBA, GL_FLOAT, 0);
-			break;
-
-		case BUFFER_FLOAT_RGBA32:
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, m_nWidth, m_nHeight, 0, GL_RGBA, GL_FLOAT, 0);
-			break;
-		}
+		AllocateAttachmentStorage(m_eAttachmentFormats[i], m_nWidth, m_nHeight);
+
+		// Texture objects report the size they were created with.
+		delete m_attachmentTextures[i];
+		m_attachmentTextures[i] = new Texture(m_glTextureHandles[i], m_nWidth, m_nHeight);
 	}
+
+	// Resize depth attachment, a shared depth texture is resized by the framebuffer which owns it...
+	if(m_bOwnsDepth)
+	{
+		GLState::GetInstance()->BindTexture(GL_TEXTURE_2D, m_glDepthTextureHandle);
+
+		if (m_bHasStencil)
+			AllocateAttachmentStorage(BUFFER_DEPTH24_STENCIL8, m_nWidth, m_nHeight);
+		else
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, m_nWidth, m_nHeight, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_BYTE, 0);
+
+		delete m_depthTexture;
+		m_depthTexture = new Texture(m_glDepthTextureHandle, m_nWidth, m_nHeight);
+	}
+
+	GLState::GetInstance()->BindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Framebuffer::AllocateAttachmentStorage(EAttachmentFormat eFormat, int nWidth, int nHeight) 
+{
+	switch (eFormat)
+	{
+	case BUFFER_RGB:
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, nWidth, nHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, 0);
+		break;
+
+	case BUFFER_RGBA:
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, nWidth, nHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+		break;
+
+	case BUFFER_FLOAT_RGB16:
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, nWidth, nHeight, 0, GL_RGB, GL_FLOAT, 0);
+		break;
+
+	case BUFFER_FLOAT_RGB32:
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB32F, nWidth, nHeight, 0, GL_RGB, GL_FLOAT, 0);
+		break;
+
+	case BUFFER_FLOAT_RGBA16:
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, nWidth, nHeight, 0, GL_RGBA, GL_FLOAT, 0);
+		break;
+
+	case BUFFER_FLOAT_RG16:
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, nWidth, nHeight, 0, GL_RG, GL_FLOAT, 0);
+		break;
+
+	case BUFFER_FLOAT_R32:
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, nWidth, nHeight, 0, GL_RED, GL_FLOAT, 0);
+		break;
+
+	case BUFFER_FLOAT_R11G11B10:
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R11F_G11F_B10F, nWidth, nHeight, 0, GL_RGB, GL_FLOAT, 0);
+		break;
+
+	case BUFFER_UINT_R32:
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, nWidth, nHeight, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, 0);
+		break;
+
+	case BUFFER_UINT_RG32:
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32UI, nWidth, nHeight, 0, GL_RG_INTEGER, GL_UNSIGNED_INT, 0);
+		break;
+
+	case BUFFER_FLOAT_RGBA32:
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, nWidth, nHeight, 0, GL_RGBA, GL_FLOAT, 0);
+		break;
+
+	case BUFFER_DEPTH24_STENCIL8:
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, nWidth, nHeight, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, 0);
+		break;
+	}
+}
+
+int Framebuffer::AttachmentPixelSize(EAttachmentFormat eFormat) 
+{
+	// Three component formats are padded to four components by most drivers.
+	switch (eFormat)
+	{
+	case BUFFER_RGB:
+	case BUFFER_RGBA:
+	case BUFFER_FLOAT_RG16:
+	case BUFFER_FLOAT_R32:
+	case BUFFER_FLOAT_R11G11B10:
+	case BUFFER_UINT_R32:
+	case BUFFER_DEPTH24_STENCIL8:
+		return 4;
+
+	case BUFFER_FLOAT_RGB16:
+	case BUFFER_FLOAT_RGBA16:
+	case BUFFER_UINT_RG32:
+		return 8;
+
+	case BUFFER_FLOAT_RGB32:
+	case BUFFER_FLOAT_RGBA32:
+		return 16;
+	}
+
+	return 0;
 }
 
 unsigned int Framebuffer::GetFrameBufferHandle()
@@ -0,0 +1,389 @@
+#include "GLState.h"
+#include "glad\glad.h"
+
+// Binding value which never matches a real object, forcing the next bind to be issued.
+#define GLSTATE_UNKNOWN_BINDING 0xFFFFFFFF
+
+GLState* GLState::m_instance = nullptr;
+
+// OpenGL enums of each EGLStateCapability.
+static const unsigned int g_glCapabilities[GLSTATE_CAP_COUNT] =
+{
+	GL_BLEND,
+	GL_CULL_FACE,
+	GL_DEPTH_TEST,
+	GL_STENCIL_TEST
+};
+
+GLState::GLState()
+{
+	// Start with the default state of a new context.
+	m_glProgram = 0;
+	m_glVAO = 0;
+
+	for (int i = 0; i < GLSTATE_BUFFER_TARGET_COUNT; ++i)
+		m_glBuffers[i] = 0;
+
+	for(int i = 0; i < GLSTATE_INDEXED_BINDING_COUNT; ++i)
+	{
+		m_uniformBindings[i] = { 0, 0, 0 };
+		m_storageBindings[i] = { 0, 0, 0 };
+	}
+
+	m_nActiveTexture = 0;
+
+	for(int i = 0; i < GLSTATE_TEXTURE_UNIT_COUNT; ++i)
+	{
+		m_glTextures[i][0] = 0;
+		m_glTextures[i][1] = 0;
+	}
+
+	for (int i = 0; i < GLSTATE_CAP_COUNT; ++i)
+		m_bCapabilities[i] = false;
+
+	m_glBlendSrc = GL_ONE;
+	m_glBlendDst = GL_ZERO;
+	m_glCullFace = GL_BACK;
+	m_bDepthMask = true;
+	m_glDepthFunc = GL_LESS;
+
+	m_nIssuedCount = 0;
+	m_nElidedCount = 0;
+	m_nLastIssuedCount = 0;
+	m_nLastElidedCount = 0;
+}
+
+GLState::~GLState()
+{
+
+}
+
+void GLState::BeginFrame()
+{
+	m_nLastIssuedCount = m_nIssuedCount;
+	m_nLastElidedCount = m_nElidedCount;
+
+	m_nIssuedCount = 0;
+	m_nElidedCount = 0;
+}
+
+void GLState::UseProgram(unsigned int glProgram)
+{
+	if (!Track(m_glProgram != glProgram))
+		return;
+
+	glUseProgram(glProgram);
+	m_glProgram = glProgram;
+}
+
+void GLState::BindVertexArray(unsigned int glVAO)
+{
+	if (!Track(m_glVAO != glVAO))
+		return;
+
+	glBindVertexArray(glVAO);
+	m_glVAO = glVAO;
+
+	// The element array binding belongs to the VAO.
+	m_glBuffers[GLSTATE_BUFFER_ELEMENT_ARRAY] = GLSTATE_UNKNOWN_BINDING;
+}
+
+void GLState::BindBuffer(unsigned int glTarget, unsigned int glBuffer)
+{
+	int nTarget = BufferTargetIndex(glTarget);
+
+	if(nTarget < 0)
+	{
+		Track(true);
+		glBindBuffer(glTarget, glBuffer);
+		return;
+	}
+
+	if (!Track(m_glBuffers[nTarget] != glBuffer))
+		return;
+
+	glBindBuffer(glTarget, glBuffer);
+	m_glBuffers[nTarget] = glBuffer;
+}
+
+void GLState::BindBufferRange(unsigned int glTarget, unsigned int nIndex, unsigned int glBuffer, ptrdiff_t nOffset, ptrdiff_t nSize)
+{
+	IndexedBinding* bindings = glTarget == GL_UNIFORM_BUFFER ? m_uniformBindings : (glTarget == GL_SHADER_STORAGE_BUFFER ? m_storageBindings : nullptr);
+
+	if(!bindings || nIndex >= GLSTATE_INDEXED_BINDING_COUNT)
+	{
+		Track(true);
+		glBindBufferRange(glTarget, nIndex, glBuffer, nOffset, nSize);
+		return;
+	}
+
+	IndexedBinding& binding = bindings[nIndex];
+
+	if (!Track(binding.m_glBuffer != glBuffer || binding.m_nOffset != nOffset || binding.m_nSize != nSize))
+		return;
+
+	glBindBufferRange(glTarget, nIndex, glBuffer, nOffset, nSize);
+
+	binding = { glBuffer, nOffset, nSize };
+	m_glBuffers[BufferTargetIndex(glTarget)] = glBuffer;
+}
+
+void GLState::BindBufferBase(unsigned int glTarget, unsigned int nIndex, unsigned int glBuffer)
+{
+	IndexedBinding* bindings = glTarget == GL_UNIFORM_BUFFER ? m_uniformBindings : (glTarget == GL_SHADER_STORAGE_BUFFER ? m_storageBindings : nullptr);
+
+	if (!bindings || nIndex >= GLSTATE_INDEXED_BINDING_COUNT)
+	{
+		Track(true);
+		glBindBufferBase(glTarget, nIndex, glBuffer);
+		return;
+	}
+
+	// Whole buffer bindings are stored with a size of 0.
+	IndexedBinding& binding = bindings[nIndex];
+
+	if (!Track(binding.m_glBuffer != glBuffer || binding.m_nOffset != 0 || binding.m_nSize != 0))
+		return;
+
+	glBindBufferBase(glTarget, nIndex, glBuffer);
+
+	binding = { glBuffer, 0, 0 };
+	m_glBuffers[BufferTargetIndex(glTarget)] = glBuffer;
+}
+
+void GLState::BindTexture(unsigned int nUnit, unsigned int glTarget, unsigned int glTexture)
+{
+	int nTarget = TextureTargetIndex(glTarget);
+
+	if(nTarget < 0 || nUnit >= GLSTATE_TEXTURE_UNIT_COUNT)
+	{
+		ActiveTexture(nUnit);
+
+		Track(true);
+		glBindTexture(glTarget, glTexture);
+		return;
+	}
+
+	if (!Track(m_glTextures[nUnit][nTarget] != glTexture))
+		return;
+
+	ActiveTexture(nUnit);
+
+	glBindTexture(glTarget, glTexture);
+	m_glTextures[nUnit][nTarget] = glTexture;
+}
+
+void GLState::BindTexture(unsigned int glTarget, unsigned int glTexture)
+{
+	BindTexture(m_nActiveTexture, glTarget, glTexture);
+}
+
+void GLState::SetCapability(EGLStateCapability eCapability, bool bEnabled)
+{
+	if (!Track(m_bCapabilities[eCapability] != bEnabled))
+		return;
+
+	if (bEnabled)
+		glEnable(g_glCapabilities[eCapability]);
+	else
+		glDisable(g_glCapabilities[eCapability]);
+
+	m_bCapabilities[eCapability] = bEnabled;
+}
+
+void GLState::BlendFunc(unsigned int glSrcFactor, unsigned int glDstFactor)
+{
+	if (!Track(m_glBlendSrc != glSrcFactor || m_glBlendDst != glDstFactor))
+		return;
+
+	glBlendFunc(glSrcFactor, glDstFactor);
+
+	m_glBlendSrc = glSrcFactor;
+	m_glBlendDst = glDstFactor;
+}
+
+void GLState::CullFace(unsigned int glMode)
+{
+	if (!Track(m_glCullFace != glMode))
+		return;
+
+	glCullFace(glMode);
+	m_glCullFace = glMode;
+}
+
+void GLState::DepthMask(bool bWrite)
+{
+	if (!Track(m_bDepthMask != bWrite))
+		return;
+
+	glDepthMask(bWrite ? GL_TRUE : GL_FALSE);
+	m_bDepthMask = bWrite;
+}
+
+void GLState::DepthFunc(unsigned int glFunc)
+{
+	if (!Track(m_glDepthFunc != glFunc))
+		return;
+
+	glDepthFunc(glFunc);
+	m_glDepthFunc = glFunc;
+}
+
+void GLState::DeleteProgram(unsigned int glProgram)
+{
+	glDeleteProgram(glProgram);
+
+	// A program in use is only deleted once it is no longer in use, so the binding remains valid.
+}
+
+void GLState::DeleteVertexArrays(int nCount, const unsigned int* glVAOs)
+{
+	glDeleteVertexArrays(nCount, glVAOs);
+
+	for(int i = 0; i < nCount; ++i)
+	{
+		if (glVAOs[i] == m_glVAO)
+		{
+			m_glVAO = 0;
+			m_glBuffers[GLSTATE_BUFFER_ELEMENT_ARRAY] = GLSTATE_UNKNOWN_BINDING;
+		}
+	}
+}
+
+void GLState::DeleteBuffers(int nCount, const unsigned int* glBuffers)
+{
+	glDeleteBuffers(nCount, glBuffers);
+
+	for(int i = 0; i < nCount; ++i)
+	{
+		for(int j = 0; j < GLSTATE_BUFFER_TARGET_COUNT; ++j)
+		{
+			if (m_glBuffers[j] == glBuffers[i])
+				m_glBuffers[j] = 0;
+		}
+
+		for(int j = 0; j < GLSTATE_INDEXED_BINDING_COUNT; ++j)
+		{
+			if (m_uniformBindings[j].m_glBuffer == glBuffers[i])
+				m_uniformBindings[j] = { 0, 0, 0 };
+
+			if (m_storageBindings[j].m_glBuffer == glBuffers[i])
+				m_storageBindings[j] = { 0, 0, 0 };
+		}
+	}
+
+	// Buffers bound to vertex arrays other than the current one keep their binding, the element array binding is no longer known.
+	m_glBuffers[GLSTATE_BUFFER_ELEMENT_ARRAY] = GLSTATE_UNKNOWN_BINDING;
+}
+
+void GLState::DeleteTextures(int nCount, const unsigned int* glTextures)
+{
+	glDeleteTextures(nCount, glTextures);
+
+	for(int i = 0; i < nCount; ++i)
+	{
+		for(int j = 0; j < GLSTATE_TEXTURE_UNIT_COUNT; ++j)
+		{
+			if (m_glTextures[j][0] == glTextures[i])
+				m_glTextures[j][0] = 0;
+
+			if (m_glTextures[j][1] == glTextures[i])
+				m_glTextures[j][1] = 0;
+		}
+	}
+}
+
+int GLState::IssuedCount() const
+{
+	return m_nLastIssuedCount;
+}
+
+int GLState::ElidedCount() const
+{
+	return m_nLastElidedCount;
+}
+
+void GLState::Create()
+{
+	if (!m_instance)
+		m_instance = new GLState;
+}
+
+void GLState::Destroy()
+{
+	if (m_instance)
+	{
+		delete m_instance;
+		m_instance = nullptr;
+	}
+}
+
+GLState* GLState::GetInstance()
+{
+	return m_instance;
+}
+
+bool GLState::Track(bool bChanged)
+{
+	if (bChanged)
+		++m_nIssuedCount;
+	else
+		++m_nElidedCount;
+
+	return bChanged;
+}
+
+int GLState::BufferTargetIndex(unsigned int glTarget)
+{
+	switch(glTarget)
+	{
+	case GL_ARRAY_BUFFER:
+		return GLSTATE_BUFFER_ARRAY;
+
+	case GL_ELEMENT_ARRAY_BUFFER:
+		return GLSTATE_BUFFER_ELEMENT_ARRAY;
+
+	case GL_UNIFORM_BUFFER:
+		return GLSTATE_BUFFER_UNIFORM;
+
+	case GL_SHADER_STORAGE_BUFFER:
+		return GLSTATE_BUFFER_SHADER_STORAGE;
+
+	case GL_COPY_READ_BUFFER:
+		return GLSTATE_BUFFER_COPY_READ;
+
+	case GL_COPY_WRITE_BUFFER:
+		return GLSTATE_BUFFER_COPY_WRITE;
+
+	case GL_DRAW_INDIRECT_BUFFER:
+		return GLSTATE_BUFFER_DRAW_INDIRECT;
+
+	case GL_DISPATCH_INDIRECT_BUFFER:
+		return GLSTATE_BUFFER_DISPATCH_INDIRECT;
+	}
+
+	return -1;
+}
+
+int GLState::TextureTargetIndex(unsigned int glTarget)
+{
+	switch (glTarget)
+	{
+	case GL_TEXTURE_2D:
+		return 0;
+
+	case GL_TEXTURE_CUBE_MAP:
+		return 1;
+	}
+
+	return -1;
+}
+
+void GLState::ActiveTexture(unsigned int nUnit)
+{
+	if (!Track(m_nActiveTexture != nUnit))
+		return;
+
+	glActiveTexture(GL_TEXTURE0 + nUnit);
+	m_nActiveTexture = nUnit;
+}
\ No newline at end of file
@@ -0,0 +1,216 @@
+#pragma once
+#include <cstddef>
+
+// Texture units shadowed by the state cache, binds to higher units are always issued.
+#define GLSTATE_TEXTURE_UNIT_COUNT 32
+
+// Indexed uniform and shader storage buffer binding points shadowed by the state cache.
+#define GLSTATE_INDEXED_BINDING_COUNT 16
+
+enum EGLStateBufferTarget
+{
+	GLSTATE_BUFFER_ARRAY,
+	GLSTATE_BUFFER_ELEMENT_ARRAY,
+	GLSTATE_BUFFER_UNIFORM,
+	GLSTATE_BUFFER_SHADER_STORAGE,
+	GLSTATE_BUFFER_COPY_READ,
+	GLSTATE_BUFFER_COPY_WRITE,
+	GLSTATE_BUFFER_DRAW_INDIRECT,
+	GLSTATE_BUFFER_DISPATCH_INDIRECT,
+	GLSTATE_BUFFER_TARGET_COUNT
+};
+
+enum EGLStateCapability
+{
+	GLSTATE_CAP_BLEND,
+	GLSTATE_CAP_CULL_FACE,
+	GLSTATE_CAP_DEPTH_TEST,
+	GLSTATE_CAP_STENCIL_TEST,
+	GLSTATE_CAP_COUNT
+};
+
+/*
+Shadow copy of the OpenGL binding and fixed-function state touched every frame. Calls which would not change the current
+state are skipped, all code binding programs, vertex arrays, buffers or textures must go through this cache to keep it in sync.
+Objects must also be deleted through it, as OpenGL resets bindings to deleted objects and reuses their names.
+*/
+class GLState
+{
+public:
+
+	GLState();
+
+	~GLState();
+
+	/*
+	Description: Begin counting state changes for a new frame, the counts of the previous frame remain available.
+	*/
+	void BeginFrame();
+
+	/*
+	Description: Bind a shader program.
+	Param:
+	    unsigned int glProgram: The OpenGL handle of the program.
+	*/
+	void UseProgram(unsigned int glProgram);
+
+	/*
+	Description: Bind a vertex array object. The element array buffer binding is part of the VAO and is re-issued after a VAO change.
+	Param:
+	    unsigned int glVAO: The OpenGL handle of the vertex array.
+	*/
+	void BindVertexArray(unsigned int glVAO);
+
+	/*
+	Description: Bind a buffer to a generic binding target.
+	Param:
+	    unsigned int glTarget: The OpenGL binding target, such as GL_ARRAY_BUFFER.
+		unsigned int glBuffer: The OpenGL handle of the buffer.
+	*/
+	void BindBuffer(unsigned int glTarget, unsigned int glBuffer);
+
+	/*
+	Description: Bind a range of a buffer to an indexed binding point, this also changes the generic binding of the target.
+	Param:
+	    unsigned int glTarget: GL_UNIFORM_BUFFER or GL_SHADER_STORAGE_BUFFER.
+		unsigned int nIndex: The binding point index.
+		unsigned int glBuffer: The OpenGL handle of the buffer.
+		ptrdiff_t nOffset: The offset of the range in bytes.
+		ptrdiff_t nSize: The size of the range in bytes.
+	*/
+	void BindBufferRange(unsigned int glTarget, unsigned int nIndex, unsigned int glBuffer, ptrdiff_t nOffset, ptrdiff_t nSize);
+
+	/*
+	Description: Bind a whole buffer to an indexed binding point, this also changes the generic binding of the target.
+	Param:
+	    unsigned int glTarget: GL_UNIFORM_BUFFER or GL_SHADER_STORAGE_BUFFER.
+		unsigned int nIndex: The binding point index.
+		unsigned int glBuffer: The OpenGL handle of the buffer.
+	*/
+	void BindBufferBase(unsigned int glTarget, unsigned int nIndex, unsigned int glBuffer);
+
+	/*
+	Description: Bind a texture to a texture unit.
+	Param:
+	    unsigned int nUnit: The index of the texture unit, starting at 0.
+		unsigned int glTarget: GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP.
+		unsigned int glTexture: The OpenGL handle of the texture.
+	*/
+	void BindTexture(unsigned int nUnit, unsigned int glTarget, unsigned int glTexture);
+
+	/*
+	Description: Bind a texture to the most recently selected texture unit, for texture creation and modification.
+	Param:
+		unsigned int glTarget: GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP.
+		unsigned int glTexture: The OpenGL handle of the texture.
+	*/
+	void BindTexture(unsigned int glTarget, unsigned int glTexture);
+
+	/*
+	Description: Enable or disable a capability.
+	Param:
+	    EGLStateCapability eCapability: The capability to change.
+		bool bEnabled: The new state of the capability.
+	*/
+	void SetCapability(EGLStateCapability eCapability, bool bEnabled);
+
+	/*
+	Description: Set the blend function of all draw buffers.
+	Param:
+	    unsigned int glSrcFactor: The source blend factor.
+		unsigned int glDstFactor: The destination blend factor.
+	*/
+	void BlendFunc(unsigned int glSrcFactor, unsigned int glDstFactor);
+
+	/*
+	Description: Set the faces culled when face culling is enabled.
+	Param:
+	    unsigned int glMode: GL_FRONT, GL_BACK or GL_FRONT_AND_BACK.
+	*/
+	void CullFace(unsigned int glMode);
+
+	/*
+	Description: Enable or disable writes to the depth buffer.
+	Param:
+	    bool bWrite: Whether depth writes are enabled.
+	*/
+	void DepthMask(bool bWrite);
+
+	/*
+	Description: Set the depth comparison function.
+	Param:
+	    unsigned int glFunc: The comparison function, such as GL_LESS.
+	*/
+	void DepthFunc(unsigned int glFunc);
+
+	// Deletion, bindings to deleted objects are reset to 0 as OpenGL does.
+
+	void DeleteProgram(unsigned int glProgram);
+	void DeleteVertexArrays(int nCount, const unsigned int* glVAOs);
+	void DeleteBuffers(int nCount, const unsigned int* glBuffers);
+	void DeleteTextures(int nCount, const unsigned int* glTextures);
+
+	/*
+	Description: Get the amount of state changes sent to OpenGL during the last completed frame.
+	Return Type: int
+	*/
+	int IssuedCount() const;
+
+	/*
+	Description: Get the amount of state changes skipped during the last completed frame because they matched the current state.
+	Return Type: int
+	*/
+	int ElidedCount() const;
+
+	// Singleton functions.
+
+	static void Create();
+	static void Destroy();
+	static GLState* GetInstance();
+
+private:
+
+	struct IndexedBinding
+	{
+		unsigned int m_glBuffer;
+		ptrdiff_t m_nOffset;
+		ptrdiff_t m_nSize;
+	};
+
+	// Count a state change as issued or elided, returns true if it must be issued.
+	bool Track(bool bChanged);
+
+	// Get the cache index of a buffer target, or -1 if it is not shadowed.
+	static int BufferTargetIndex(unsigned int glTarget);
+
+	// Get the cache index of a texture target, or -1 if it is not shadowed.
+	static int TextureTargetIndex(unsigned int glTarget);
+
+	// Make a texture unit active.
+	void ActiveTexture(unsigned int nUnit);
+
+	static GLState* m_instance;
+
+	// Bindings
+	unsigned int m_glProgram;
+	unsigned int m_glVAO;
+	unsigned int m_glBuffers[GLSTATE_BUFFER_TARGET_COUNT];
+	IndexedBinding m_uniformBindings[GLSTATE_INDEXED_BINDING_COUNT];
+	IndexedBinding m_storageBindings[GLSTATE_INDEXED_BINDING_COUNT];
+	unsigned int m_nActiveTexture;
+	unsigned int m_glTextures[GLSTATE_TEXTURE_UNIT_COUNT][2];
+
+	// Fixed function state
+	bool m_bCapabilities[GLSTATE_CAP_COUNT];
+	unsigned int m_glBlendSrc;
+	unsigned int m_glBlendDst;
+	unsigned int m_glCullFace;
+	bool m_bDepthMask;
+	unsigned int m_glDepthFunc;
+
+	// Statistics
+	int m_nIssuedCount;
+	int m_nElidedCount;
+	int m_nLastIssuedCount;
+	int m_nLastElidedCount;
+};
\ No newline at end of file
@@ -0,0 +1,369 @@
+#include "GPUProfiler.h"
+#include "glad/glad.h"
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+GPUProfiler* GPUProfiler::m_instance = nullptr;
+
+GPUProfiler::GPUProfiler(int nFrameLatency)
+{
+	m_nFrameLatency = nFrameLatency;
+	m_nFrameIndex = 0;
+	m_nOpenScopeCount = 0;
+	m_nIgnoredScopeCount = 0;
+	m_nDroppedFrameCount = 0;
+	m_nCollectedFrameCount = 0;
+	m_nSampleCapacity = GPU_PROFILER_SAMPLE_COUNT;
+	m_bOverflowReported = false;
+
+	m_frames = new FrameQueries[m_nFrameLatency];
+
+	for(int i = 0; i < m_nFrameLatency; ++i)
+	{
+		glGenQueries(GPU_PROFILER_MAX_FRAME_SCOPES * 2, m_frames[i].m_glQueries);
+		m_frames[i].m_nScopeCount = 0;
+	}
+}
+
+GPUProfiler::~GPUProfiler()
+{
+	for (int i = 0; i < m_nFrameLatency; ++i)
+		glDeleteQueries(GPU_PROFILER_MAX_FRAME_SCOPES * 2, m_frames[i].m_glQueries);
+
+	delete[] m_frames;
+
+	for (int i = 0; i < m_scopes.Count(); ++i)
+		delete[] m_scopes[i].m_fSamples;
+}
+
+void GPUProfiler::BeginFrame()
+{
+	m_nFrameIndex = (m_nFrameIndex + 1) % m_nFrameLatency;
+
+	// The queries of this slot were last used GPU_PROFILER_FRAME_LATENCY frames ago, read them before they are reused...
+	FrameQueries& frame = m_frames[m_nFrameIndex];
+	Collect(frame, false);
+
+	frame.m_nScopeCount = 0;
+	m_nOpenScopeCount = 0;
+	m_nIgnoredScopeCount = 0;
+
+	BeginScope("Frame");
+}
+
+void GPUProfiler::EndFrame()
+{
+	if (m_nOpenScopeCount + m_nIgnoredScopeCount > 1)
+		std::cout << "GPU Profiler Warning: " << m_nOpenScopeCount + m_nIgnoredScopeCount - 1 << " scopes were not ended before the end of the frame." << std::endl;
+
+	while (m_nOpenScopeCount + m_nIgnoredScopeCount > 0)
+		EndScope();
+}
+
+void GPUProfiler::BeginScope(const char* szName)
+{
+	if(m_nOpenScopeCount >= GPU_PROFILER_MAX_DEPTH)
+	{
+		++m_nIgnoredScopeCount;
+		return;
+	}
+
+	FrameQueries& frame = m_frames[m_nFrameIndex];
+
+	if(frame.m_nScopeCount >= GPU_PROFILER_MAX_FRAME_SCOPES)
+	{
+		if(!m_bOverflowReported)
+		{
+			std::cout << "GPU Profiler Warning: More than " << GPU_PROFILER_MAX_FRAME_SCOPES << " scopes in a frame, further scopes are not timed." << std::endl;
+			m_bOverflowReported = true;
+		}
+
+		m_openScopes[m_nOpenScopeCount++] = -1;
+		return;
+	}
+
+	int nPair = frame.m_nScopeCount++;
+	frame.m_scopes[nPair] = FindScope(szName, m_nOpenScopeCount);
+
+	glQueryCounter(frame.m_glQueries[nPair * 2], GL_TIMESTAMP);
+
+	m_openScopes[m_nOpenScopeCount++] = nPair;
+}
+
+void GPUProfiler::EndScope()
+{
+	// Scopes beyond the maximum depth are the most recently begun...
+	if(m_nIgnoredScopeCount > 0)
+	{
+		--m_nIgnoredScopeCount;
+		return;
+	}
+
+	if(m_nOpenScopeCount == 0)
+	{
+		std::cout << "GPU Profiler Error: EndScope called without a matching BeginScope." << std::endl;
+		return;
+	}
+
+	int nPair = m_openScopes[--m_nOpenScopeCount];
+
+	if (nPair >= 0)
+		glQueryCounter(m_frames[m_nFrameIndex].m_glQueries[nPair * 2 + 1], GL_TIMESTAMP);
+}
+
+void GPUProfiler::Flush()
+{
+	// Oldest frame first, so samples stay in submission order. The current frame is only read once it has ended.
+	for(int i = 1; i <= m_nFrameLatency; ++i)
+	{
+		int nFrame = (m_nFrameIndex + i) % m_nFrameLatency;
+
+		if (nFrame == m_nFrameIndex && m_nOpenScopeCount + m_nIgnoredScopeCount > 0)
+			continue;
+
+		Collect(m_frames[nFrame], true);
+		m_frames[nFrame].m_nScopeCount = 0;
+	}
+}
+
+void GPUProfiler::Reset()
+{
+	for(int i = 0; i < m_scopes.Count(); ++i)
+	{
+		m_scopes[i].m_nSampleCount = 0;
+		m_scopes[i].m_nNextSample = 0;
+	}
+
+	m_nDroppedFrameCount = 0;
+}
+
+int GPUProfiler::ScopeCount() const
+{
+	return m_scopes.Count();
+}
+
+const char* GPUProfiler::ScopeName(int nScope) const
+{
+	return m_scopes[nScope].m_szName;
+}
+
+int GPUProfiler::ScopeDepth(int nScope) const
+{
+	return m_scopes[nScope].m_nDepth;
+}
+
+bool GPUProfiler::GetTimings(int nScope, GPUScopeTimings& outTimings) const
+{
+	const Scope& scope = m_scopes[nScope];
+
+	outTimings.m_nSampleCount = scope.m_nSampleCount;
+
+	if (scope.m_nSampleCount == 0)
+		return false;
+
+	// Percentiles by nearest rank over a sorted copy of the samples...
+	std::vector<float> sorted(scope.m_fSamples, scope.m_fSamples + scope.m_nSampleCount);
+	std::sort(sorted.begin(), sorted.end());
+
+	const float* fSorted = sorted.data();
+
+	double dTotal = 0.0;
+
+	for (int i = 0; i < scope.m_nSampleCount; ++i)
+		dTotal += fSorted[i];
+
+	int nLast = scope.m_nSampleCount - 1;
+
+	outTimings.m_fAverage = static_cast<float>(dTotal / scope.m_nSampleCount);
+	outTimings.m_fMedian = fSorted[nLast / 2];
+	outTimings.m_fPercentile95 = fSorted[(nLast * 95 + 99) / 100];
+	outTimings.m_fPercentile99 = fSorted[(nLast * 99 + 99) / 100];
+	outTimings.m_fMax = fSorted[nLast];
+
+	return true;
+}
+
+bool GPUProfiler::GetTimings(const char* szName, GPUScopeTimings& outTimings) const
+{
+	for(int i = 0; i < m_scopes.Count(); ++i)
+	{
+		if (strcmp(m_scopes[i].m_szName, szName) == 0)
+			return GetTimings(i, outTimings);
+	}
+
+	outTimings.m_nSampleCount = 0;
+	return false;
+}
+
+bool GPUProfiler::GetLatestSample(const char* szName, float& fOutTime) const
+{
+	for(int i = 0; i < m_scopes.Count(); ++i)
+	{
+		const Scope& scope = m_scopes[i];
+
+		if (strcmp(scope.m_szName, szName) != 0)
+			continue;
+
+		if (scope.m_nSampleCount == 0)
+			return false;
+
+		fOutTime = scope.m_fSamples[(scope.m_nNextSample + m_nSampleCapacity - 1) % m_nSampleCapacity];
+		return true;
+	}
+
+	return false;
+}
+
+int GPUProfiler::CollectedFrameCount() const
+{
+	return m_nCollectedFrameCount;
+}
+
+bool GPUProfiler::WriteCSV(const char* szPath) const
+{
+	std::ofstream file(szPath);
+
+	if(!file.good())
+	{
+		std::cout << "GPU Profiler Error: Failed to open " << szPath << " for writing." << std::endl;
+		return false;
+	}
+
+	file << "Scope,Depth,Samples,Average (ms),Median (ms),95th percentile (ms),99th percentile (ms),Max (ms)\n";
+
+	for(int i = 0; i < m_scopes.Count(); ++i)
+	{
+		GPUScopeTimings timings;
+
+		if (!GetTimings(i, timings))
+			continue;
+
+		file << "\"" << m_scopes[i].m_szName << "\"," << m_scopes[i].m_nDepth << "," << timings.m_nSampleCount << ","
+			<< timings.m_fAverage << "," << timings.m_fMedian << "," << timings.m_fPercentile95 << ","
+			<< timings.m_fPercentile99 << "," << timings.m_fMax << "\n";
+	}
+
+	return file.good();
+}
+
+int GPUProfiler::DroppedFrameCount() const
+{
+	return m_nDroppedFrameCount;
+}
+
+void GPUProfiler::SetSampleCount(int nSampleCount)
+{
+	m_nSampleCapacity = nSampleCount > 0 ? nSampleCount : 1;
+
+	for(int i = 0; i < m_scopes.Count(); ++i)
+	{
+		delete[] m_scopes[i].m_fSamples;
+		m_scopes[i].m_fSamples = new float[m_nSampleCapacity];
+	}
+
+	Reset();
+}
+
+int GPUProfiler::SampleCount() const
+{
+	return m_nSampleCapacity;
+}
+
+void GPUProfiler::Collect(FrameQueries& frame, bool bWait)
+{
+	if (frame.m_nScopeCount == 0)
+		return;
+
+	// Drop the frame rather than stall if any result is still pending...
+	if(!bWait)
+	{
+		for(int i = 0; i < frame.m_nScopeCount * 2; ++i)
+		{
+			int nAvailable = 0;
+			glGetQueryObjectiv(frame.m_glQueries[i], GL_QUERY_RESULT_AVAILABLE, &nAvailable);
+
+			if(!nAvailable)
+			{
+				++m_nDroppedFrameCount;
+				return;
+			}
+		}
+	}
+
+	for(int i = 0; i < frame.m_nScopeCount; ++i)
+	{
+		GLuint64 nBegin = 0;
+		GLuint64 nEnd = 0;
+
+		glGetQueryObjectui64v(frame.m_glQueries[i * 2], GL_QUERY_RESULT, &nBegin);
+		glGetQueryObjectui64v(frame.m_glQueries[i * 2 + 1], GL_QUERY_RESULT, &nEnd);
+
+		Scope& scope = m_scopes[frame.m_scopes[i]];
+
+		scope.m_fSamples[scope.m_nNextSample] = static_cast<float>(nEnd - nBegin) / 1000000.0f;
+		scope.m_nNextSample = (scope.m_nNextSample + 1) % m_nSampleCapacity;
+
+		if (scope.m_nSampleCount < m_nSampleCapacity)
+			++scope.m_nSampleCount;
+	}
+
+	++m_nCollectedFrameCount;
+}
+
+int GPUProfiler::FindScope(const char* szName, int nDepth)
+{
+	for(int i = 0; i < m_scopes.Count(); ++i)
+	{
+		if (m_scopes[i].m_szName == szName || strcmp(m_scopes[i].m_szName, szName) == 0)
+			return i;
+	}
+
+	Scope scope;
+	scope.m_szName = szName;
+	scope.m_nDepth = nDepth;
+	scope.m_fSamples = new float[m_nSampleCapacity];
+	scope.m_nSampleCount = 0;
+	scope.m_nNextSample = 0;
+
+	m_scopes.Push(scope);
+
+	return m_scopes.Count() - 1;
+}
+
+void GPUProfiler::Create(int nFrameLatency)
+{
+	if (!m_instance)
+		m_instance = new GPUProfiler(nFrameLatency);
+}
+
+void GPUProfiler::Destroy()
+{
+	if(m_instance)
+	{
+		delete m_instance;
+		m_instance = nullptr;
+	}
+}
+
+GPUProfiler* GPUProfiler::GetInstance()
+{
+	return m_instance;
+}
+
+// ------------------------------------------------------------------------------------
+// Scope
+
+GPUProfileScope::GPUProfileScope(const char* szName)
+{
+	if (GPUProfiler::GetInstance())
+		GPUProfiler::GetInstance()->BeginScope(szName);
+}
+
+GPUProfileScope::~GPUProfileScope()
+{
+	if (GPUProfiler::GetInstance())
+		GPUProfiler::GetInstance()->EndScope();
+}
@@ -0,0 +1,217 @@
+#pragma once
+#include "DynamicArray.h"
+
+// Frames of queries in flight, results of a frame are read when its queries are reused this many frames later.
+#define GPU_PROFILER_FRAME_LATENCY 4
+
+// Scopes recorded per frame, and how deeply they may nest.
+#define GPU_PROFILER_MAX_FRAME_SCOPES 64
+#define GPU_PROFILER_MAX_DEPTH 8
+
+// Most recent samples kept per scope for averages and percentiles, unless changed with SetSampleCount.
+#define GPU_PROFILER_SAMPLE_COUNT 256
+
+// GPU time statistics of a scope over its recent samples, in milliseconds.
+struct GPUScopeTimings
+{
+	int m_nSampleCount;
+	float m_fAverage;
+	float m_fMedian;
+	float m_fPercentile95;
+	float m_fPercentile99;
+	float m_fMax;
+};
+
+/*
+Measures GPU time spent between scope markers with pairs of GL_TIMESTAMP queries. Timestamps are used over GL_TIME_ELAPSED
+so scopes may nest. Each frame in flight has its own set of queries, a frame's results are only read once its queries
+are about to be reused, by which point the GPU has long finished it and reading them does not stall.
+Frames whose results are still unavailable at that point are dropped rather than waited on.
+*/
+class GPUProfiler
+{
+public:
+
+	GPUProfiler(int nFrameLatency);
+
+	~GPUProfiler();
+
+	/*
+	Description: Read the results of the oldest frame in flight and begin recording a new frame, opening the "Frame" scope.
+	*/
+	void BeginFrame();
+
+	/*
+	Description: Close the "Frame" scope and any scopes left open.
+	*/
+	void EndFrame();
+
+	/*
+	Description: Begin timing commands issued until the matching EndScope.
+	Param:
+	    const char* szName: Name of the scope, samples are combined by name. The string must outlive the profiler.
+	*/
+	void BeginScope(const char* szName);
+
+	/*
+	Description: End the most recently begun scope.
+	*/
+	void EndScope();
+
+	/*
+	Description: Wait for and read every frame still in flight, for reporting at the end of a run.
+	*/
+	void Flush();
+
+	/*
+	Description: Discard all samples.
+	*/
+	void Reset();
+
+	/*
+	Description: Get the amount of distinct scopes recorded so far.
+	Return Type: int
+	*/
+	int ScopeCount() const;
+
+	/*
+	Description: Get the name of a scope.
+	Return Type: const char*
+	Param:
+	    int nScope: Index of the scope, below ScopeCount.
+	*/
+	const char* ScopeName(int nScope) const;
+
+	/*
+	Description: Get how deeply a scope was nested when first recorded, 0 for the frame.
+	Return Type: int
+	Param:
+	    int nScope: Index of the scope, below ScopeCount.
+	*/
+	int ScopeDepth(int nScope) const;
+
+	/*
+	Description: Get the GPU time statistics of a scope.
+	Return Type: bool
+	Returns false if the scope has no samples yet.
+	Param:
+	    int nScope: Index of the scope, below ScopeCount.
+		GPUScopeTimings& outTimings: The statistics of the scope's recent samples.
+	*/
+	bool GetTimings(int nScope, GPUScopeTimings& outTimings) const;
+
+	/*
+	Description: Get the GPU time statistics of a scope by name.
+	Return Type: bool
+	Returns false if no scope of that name has samples yet.
+	Param:
+	    const char* szName: The name the scope was begun with.
+		GPUScopeTimings& outTimings: The statistics of the scope's recent samples.
+	*/
+	bool GetTimings(const char* szName, GPUScopeTimings& outTimings) const;
+
+	/*
+	Description: Get the most recently read GPU time of a scope, for reacting to the GPU load frame by frame.
+	Return Type: bool
+	Returns false if no scope of that name has samples yet.
+	Param:
+	    const char* szName: The name the scope was begun with.
+		float& fOutTime: The GPU time in milliseconds.
+	*/
+	bool GetLatestSample(const char* szName, float& fOutTime) const;
+
+	/*
+	Description: Get the amount of frames whose results have been read, it changes whenever new samples are available.
+	Return Type: int
+	*/
+	int CollectedFrameCount() const;
+
+	/*
+	Description: Write the statistics of every scope to a CSV file, one row per scope.
+	Return Type: bool
+	Returns true if the file was written.
+	Param:
+	    const char* szPath: The path of the file to write.
+	*/
+	bool WriteCSV(const char* szPath) const;
+
+	/*
+	Description: Get the amount of frames dropped because their results were not available when read.
+	Return Type: int
+	*/
+	int DroppedFrameCount() const;
+
+	/*
+	Description: Set how many of the most recent samples each scope keeps, such as every frame of a benchmark run. Discards all samples.
+	Param:
+	    int nSampleCount: The amount of samples kept per scope.
+	*/
+	void SetSampleCount(int nSampleCount);
+
+	/*
+	Description: Get how many of the most recent samples each scope keeps.
+	Return Type: int
+	*/
+	int SampleCount() const;
+
+	// Singleton functions.
+
+	static void Create(int nFrameLatency = GPU_PROFILER_FRAME_LATENCY);
+	static void Destroy();
+	static GPUProfiler* GetInstance();
+
+private:
+
+	struct Scope
+	{
+		const char* m_szName;
+		int m_nDepth;
+		float* m_fSamples; // Ring of the most recent samples, with room for the profiler's sample count.
+		int m_nSampleCount;
+		int m_nNextSample;
+	};
+
+	// Begin and end timestamp queries of every scope recorded in a frame.
+	struct FrameQueries
+	{
+		unsigned int m_glQueries[GPU_PROFILER_MAX_FRAME_SCOPES * 2];
+		int m_scopes[GPU_PROFILER_MAX_FRAME_SCOPES];
+		int m_nScopeCount;
+	};
+
+	// Read a frame's results into its scopes' samples, optionally waiting for them.
+	void Collect(FrameQueries& frame, bool bWait);
+
+	// Find the scope of a name, adding it if it is new.
+	int FindScope(const char* szName, int nDepth);
+
+	static GPUProfiler* m_instance;
+
+	FrameQueries* m_frames;
+	int m_nFrameLatency;
+	int m_nFrameIndex;
+
+	DynamicArray<Scope> m_scopes;
+	int m_nSampleCapacity;
+
+	// Query pairs of open scopes, -1 where the frame ran out of queries.
+	int m_openScopes[GPU_PROFILER_MAX_DEPTH];
+	int m_nOpenScopeCount;
+	int m_nIgnoredScopeCount; // Scopes begun beyond the maximum depth.
+
+	int m_nDroppedFrameCount;
+	int m_nCollectedFrameCount;
+	bool m_bOverflowReported;
+};
+
+/*
+Times the GPU commands issued during its lifetime as a scope of the profiler, if one exists.
+*/
+class GPUProfileScope
+{
+public:
+
+	GPUProfileScope(const char* szName);
+
+	~GPUProfileScope();
+};
@@ -0,0 +1,173 @@
+#include "GeometryPool.h"
+#include "glad/glad.h"
+#include "GLState.h"
+#include "Mesh.h"
+#include <iostream>
+
+GeometryPool* GeometryPool::m_instance = nullptr;
+
+GeometryPool::GeometryPool(unsigned int nVertexCount, unsigned int nIndexCount)
+{
+	m_nVertexCapacity = nVertexCount;
+	m_nIndexCapacity = nIndexCount;
+	m_nUsedVertices = 0;
+	m_nUsedIndices = 0;
+	m_bFullReported = false;
+
+	GLState* glState = GLState::GetInstance();
+
+	// Generate and bind VAO...
+	glGenVertexArrays(1, &m_glVAOHandle);
+	glState->BindVertexArray(m_glVAOHandle);
+
+	// Allocate index buffer...
+	glGenBuffers(1, &m_glEBOHandle);
+	glState->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_glEBOHandle);
+	glBufferStorage(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * m_nIndexCapacity, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+	// Allocate vertex buffer...
+	glGenBuffers(1, &m_glVBOHandle);
+	glState->BindBuffer(GL_ARRAY_BUFFER, m_glVBOHandle);
+	glBufferStorage(GL_ARRAY_BUFFER, sizeof(Mesh::Vertex) * m_nVertexCapacity, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+	// Vertex attributes...
+
+	// Positions
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 14, (void*)0);
+	glEnableVertexAttribArray(0);
+
+	// Normals
+	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 14, (void*)(sizeof(float) * 4));
+	glEnableVertexAttribArray(1);
+
+	// Tangents
+	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 14, (void*)(sizeof(float) * 8));
+	glEnableVertexAttribArray(2);
+
+	// Texture Coordinates
+	glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 14, (void*)(sizeof(float) * 12));
+	glEnableVertexAttribArray(3);
+
+	// Instance attributes are read through their own binding, pointed at the buffer holding a draw's instances when it is drawn...
+
+	// Color
+	glVertexAttribFormat(4, 4, GL_FLOAT, GL_FALSE, 0);
+	glVertexAttribBinding(4, INSTANCE_VERTEX_BINDING);
+	glEnableVertexAttribArray(4);
+
+	// Model matrix
+	glVertexAttribFormat(5, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 4);
+	glVertexAttribBinding(5, INSTANCE_VERTEX_BINDING);
+	glEnableVertexAttribArray(5);
+
+	glVertexAttribFormat(6, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 8);
+	glVertexAttribBinding(6, INSTANCE_VERTEX_BINDING);
+	glEnableVertexAttribArray(6);
+
+	glVertexAttribFormat(7, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 12);
+	glVertexAttribBinding(7, INSTANCE_VERTEX_BINDING);
+	glEnableVertexAttribArray(7);
+
+	glVertexAttribFormat(8, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 16);
+	glVertexAttribBinding(8, INSTANCE_VERTEX_BINDING);
+	glEnableVertexAttribArray(8);
+
+	// Normal matrix
+	glVertexAttribFormat(9, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 20);
+	glVertexAttribBinding(9, INSTANCE_VERTEX_BINDING);
+	glEnableVertexAttribArray(9);
+
+	glVertexAttribFormat(10, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 23);
+	glVertexAttribBinding(10, INSTANCE_VERTEX_BINDING);
+	glEnableVertexAttribArray(10);
+
+	glVertexAttribFormat(11, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 26);
+	glVertexAttribBinding(11, INSTANCE_VERTEX_BINDING);
+	glEnableVertexAttribArray(11);
+
+	glVertexBindingDivisor(INSTANCE_VERTEX_BINDING, 1);
+
+	glState->BindVertexArray(0);
+	glState->BindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+GeometryPool::~GeometryPool()
+{
+	GLState::GetInstance()->DeleteVertexArrays(1, &m_glVAOHandle);
+	GLState::GetInstance()->DeleteBuffers(1, &m_glVBOHandle);
+	GLState::GetInstance()->DeleteBuffers(1, &m_glEBOHandle);
+}
+
+bool GeometryPool::Add(const void* vertices, unsigned int nVertexCount, const unsigned int* indices, unsigned int nIndexCount, GeometryRange& outRange)
+{
+	if(m_nUsedVertices + nVertexCount > m_nVertexCapacity || m_nUsedIndices + nIndexCount > m_nIndexCapacity)
+	{
+		if(!m_bFullReported)
+		{
+			std::cout << "Geometry Pool Warning: Pool is full, meshes will be drawn from their own buffers." << std::endl;
+			m_bFullReported = true;
+		}
+
+		return false;
+	}
+
+	GLState* glState = GLState::GetInstance();
+
+	// Copy vertices...
+	glState->BindBuffer(GL_COPY_WRITE_BUFFER, m_glVBOHandle);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, sizeof(Mesh::Vertex) * m_nUsedVertices, sizeof(Mesh::Vertex) * nVertexCount, vertices);
+
+	// Copy indices, they stay relative to the mesh and are offset by the base vertex when drawn...
+	glState->BindBuffer(GL_COPY_WRITE_BUFFER, m_glEBOHandle);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, sizeof(unsigned int) * m_nUsedIndices, sizeof(unsigned int) * nIndexCount, indices);
+
+	glState->BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	outRange.m_glVAO = m_glVAOHandle;
+	outRange.m_nIndexCount = nIndexCount;
+	outRange.m_nFirstIndex = m_nUsedIndices;
+	outRange.m_nBaseVertex = static_cast<int>(m_nUsedVertices);
+	outRange.m_v4BoundingSphere = glm::vec4(0.0f, 0.0f, 0.0f, -1.0f);
+	outRange.m_glVBO = m_glVBOHandle;
+	outRange.m_glIndexBuffer = m_glEBOHandle;
+
+	m_nUsedVertices += nVertexCount;
+	m_nUsedIndices += nIndexCount;
+
+	return true;
+}
+
+unsigned int GeometryPool::VAOHandle() const
+{
+	return m_glVAOHandle;
+}
+
+unsigned int GeometryPool::VBOHandle() const
+{
+	return m_glVBOHandle;
+}
+
+unsigned int GeometryPool::IndexBufferHandle() const
+{
+	return m_glEBOHandle;
+}
+
+void GeometryPool::Create(unsigned int nVertexCount, unsigned int nIndexCount)
+{
+	if (!m_instance)
+		m_instance = new GeometryPool(nVertexCount, nIndexCount);
+}
+
+void GeometryPool::Destroy()
+{
+	if(m_instance)
+	{
+		delete m_instance;
+		m_instance = nullptr;
+	}
+}
+
+GeometryPool* GeometryPool::GetInstance()
+{
+	return m_instance;
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include "glm.hpp"
+
+// Capacity of the shared vertex and index buffers.
+#define GEOMETRY_POOL_VERTEX_COUNT (512 * 1024)
+#define GEOMETRY_POOL_INDEX_COUNT (2 * 1024 * 1024)
+
+// Vertex buffer binding every instanced VAO reads its per-instance attributes through, bound to the buffer holding a draw's instances before it is drawn.
+#define INSTANCE_VERTEX_BINDING 4
+
+// Location of a mesh's geometry, as drawn with glDrawElementsInstancedBaseVertexBaseInstance or an indirect draw command.
+struct GeometryRange
+{
+	unsigned int m_glVAO;
+	unsigned int m_nIndexCount;
+	unsigned int m_nFirstIndex;
+	int m_nBaseVertex;
+	glm::vec4 m_v4BoundingSphere; // Object space center and radius, a negative radius excludes the geometry from instance culling.
+	unsigned int m_glVBO; // Vertex and index buffers the VAO reads, fetched from directly when resolving the visibility buffer.
+	unsigned int m_glIndexBuffer;
+};
+
+/*
+Shared vertex and index storage for all meshes using the Mesh::Vertex format, with a single VAO reading per-instance attributes through INSTANCE_VERTEX_BINDING.
+Meshes in the pool can be drawn together with one multi-draw indirect call, selecting their geometry with first index and base vertex
+and their instances with base instance. Space is allocated linearly and is not reclaimed when meshes are destroyed.
+*/
+class GeometryPool
+{
+public:
+
+	GeometryPool(unsigned int nVertexCount, unsigned int nIndexCount);
+
+	~GeometryPool();
+
+	/*
+	Description: Copy mesh geometry into the pool.
+	Return Type: bool
+	Param:
+	    const void* vertices: The vertices to copy, in the Mesh::Vertex format.
+		unsigned int nVertexCount: The amount of vertices.
+		const unsigned int* indices: The indices to copy, relative to the first vertex.
+		unsigned int nIndexCount: The amount of indices.
+		GeometryRange& outRange: The location of the geometry in the pool.
+	Returns false if the pool does not have enough space left.
+	*/
+	bool Add(const void* vertices, unsigned int nVertexCount, const unsigned int* indices, unsigned int nIndexCount, GeometryRange& outRange);
+
+	/*
+	Description: Get the OpenGL handle of the VAO shared by all geometry in the pool.
+	Return Type: unsigned int
+	*/
+	unsigned int VAOHandle() const;
+
+	/*
+	Description: Get the OpenGL handle of the shared vertex buffer.
+	Return Type: unsigned int
+	*/
+	unsigned int VBOHandle() const;
+
+	/*
+	Description: Get the OpenGL handle of the shared index buffer.
+	Return Type: unsigned int
+	*/
+	unsigned int IndexBufferHandle() const;
+
+	// Singleton functions.
+
+	static void Create(unsigned int nVertexCount = GEOMETRY_POOL_VERTEX_COUNT, unsigned int nIndexCount = GEOMETRY_POOL_INDEX_COUNT);
+	static void Destroy();
+	static GeometryPool* GetInstance();
+
+private:
+
+	static GeometryPool* m_instance;
+
+	unsigned int m_glVAOHandle;
+	unsigned int m_glVBOHandle;
+	unsigned int m_glEBOHandle;
+
+	unsigned int m_nVertexCapacity;
+	unsigned int m_nIndexCapacity;
+	unsigned int m_nUsedVertices;
+	unsigned int m_nUsedIndices;
+	bool m_bFullReported;
+};
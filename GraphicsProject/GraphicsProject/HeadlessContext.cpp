@@ -0,0 +1,169 @@
+#include "HeadlessContext.h"
+#include <iostream>
+
+#ifdef HEADLESS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <cstring>
+#else
+#include "glfw3.h"
+#endif
+
+#ifdef HEADLESS_EGL
+
+HeadlessContext::HeadlessContext()
+{
+	m_eglDisplay = EGL_NO_DISPLAY;
+	m_eglContext = EGL_NO_CONTEXT;
+	m_eglSurface = EGL_NO_SURFACE;
+}
+
+HeadlessContext::~HeadlessContext()
+{
+	if (m_eglDisplay == EGL_NO_DISPLAY)
+		return;
+
+	eglMakeCurrent(m_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+	if (m_eglSurface != EGL_NO_SURFACE)
+		eglDestroySurface(m_eglDisplay, m_eglSurface);
+
+	if (m_eglContext != EGL_NO_CONTEXT)
+		eglDestroyContext(m_eglDisplay, m_eglContext);
+
+	eglTerminate(m_eglDisplay);
+}
+
+bool HeadlessContext::Create(int nWidth, int nHeight)
+{
+	// Prefer the surfaceless platform, it needs neither a window system nor a GPU device...
+	PFNEGLGETPLATFORMDISPLAYEXTPROC eglGetPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+	if (eglGetPlatformDisplay)
+		m_eglDisplay = eglGetPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+
+	if (m_eglDisplay == EGL_NO_DISPLAY)
+		m_eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	if(m_eglDisplay == EGL_NO_DISPLAY || !eglInitialize(m_eglDisplay, nullptr, nullptr))
+	{
+		std::cout << "Headless Context Error: Failed to initialize an EGL display." << std::endl;
+		m_eglDisplay = EGL_NO_DISPLAY;
+		return false;
+	}
+
+	eglBindAPI(EGL_OPENGL_API);
+
+	// Without surfaceless support the context is made current on a pbuffer...
+	const char* szExtensions = eglQueryString(m_eglDisplay, EGL_EXTENSIONS);
+	bool bSurfaceless = szExtensions && strstr(szExtensions, "EGL_KHR_surfaceless_context");
+
+	const EGLint configAttributes[] =
+	{
+		EGL_SURFACE_TYPE, bSurfaceless ? 0 : EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+
+	EGLConfig config = nullptr;
+	EGLint nConfigCount = 0;
+
+	// A surfaceless context may be created without a config where the display has none.
+	if((!eglChooseConfig(m_eglDisplay, configAttributes, &config, 1, &nConfigCount) || nConfigCount == 0) && !bSurfaceless)
+	{
+		std::cout << "Headless Context Error: No EGL config supports OpenGL pbuffers." << std::endl;
+		return false;
+	}
+
+	if (nConfigCount == 0)
+		config = nullptr;
+
+	const EGLint contextAttributes[] =
+	{
+		EGL_CONTEXT_MAJOR_VERSION, 4,
+		EGL_CONTEXT_MINOR_VERSION, 4,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+
+	m_eglContext = eglCreateContext(m_eglDisplay, config, EGL_NO_CONTEXT, contextAttributes);
+
+	if(m_eglContext == EGL_NO_CONTEXT)
+	{
+		std::cout << "Headless Context Error: Failed to create an OpenGL 4.4 core context." << std::endl;
+		return false;
+	}
+
+	if(!bSurfaceless)
+	{
+		const EGLint surfaceAttributes[] = { EGL_WIDTH, nWidth, EGL_HEIGHT, nHeight, EGL_NONE };
+
+		m_eglSurface = eglCreatePbufferSurface(m_eglDisplay, config, surfaceAttributes);
+	}
+
+	if(!eglMakeCurrent(m_eglDisplay, m_eglSurface, m_eglSurface, m_eglContext))
+	{
+		std::cout << "Headless Context Error: Failed to make the context current." << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+void* HeadlessContext::GetProcAddress(const char* szName)
+{
+	return (void*)eglGetProcAddress(szName);
+}
+
+#else
+
+HeadlessContext::HeadlessContext()
+{
+	m_window = nullptr;
+	m_bGLFWInit = false;
+}
+
+HeadlessContext::~HeadlessContext()
+{
+	if (m_window)
+		glfwDestroyWindow(m_window);
+
+	if (m_bGLFWInit)
+		glfwTerminate();
+}
+
+bool HeadlessContext::Create(int nWidth, int nHeight)
+{
+	if(!glfwInit())
+	{
+		std::cout << "Headless Context Error: Failed to initialize GLFW." << std::endl;
+		return false;
+	}
+
+	m_bGLFWInit = true;
+
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 4);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+	// The window is never shown, it only owns the context...
+	m_window = glfwCreateWindow(nWidth, nHeight, "OpenGL Renderer (Headless)", 0, 0);
+
+	if(!m_window)
+	{
+		std::cout << "Headless Context Error: Failed to create a hidden window." << std::endl;
+		return false;
+	}
+
+	glfwMakeContextCurrent(m_window);
+
+	return true;
+}
+
+void* HeadlessContext::GetProcAddress(const char* szName)
+{
+	return (void*)glfwGetProcAddress(szName);
+}
+
+#endif
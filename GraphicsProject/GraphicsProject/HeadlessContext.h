@@ -0,0 +1,48 @@
+#pragma once
+
+struct GLFWwindow;
+
+/*
+OpenGL context with no visible window, for rendering into offscreen framebuffers and reading the frames back.
+With HEADLESS_EGL defined the context is created through EGL on a surfaceless display, falling back to a pbuffer surface
+on displays without surfaceless support, so no window system or display server is required. With Mesa this runs on the
+llvmpipe software rasterizer when no GPU is present, or when LIBGL_ALWAYS_SOFTWARE=1 is set.
+Otherwise the context belongs to a hidden GLFW window, which still requires a window system.
+*/
+class HeadlessContext
+{
+public:
+
+	HeadlessContext();
+
+	~HeadlessContext();
+
+	/*
+	Description: Create an OpenGL 4.4 core context and make it current on the calling thread.
+	Return Type: bool
+	Returns true if the context is current.
+	Param:
+	    int nWidth: The width of the pbuffer or hidden window, where one is needed.
+		int nHeight: The height of the pbuffer or hidden window, where one is needed.
+	*/
+	bool Create(int nWidth, int nHeight);
+
+	/*
+	Description: Get the address of an OpenGL function, for loading OpenGL with GLAD.
+	Return Type: void*
+	Param:
+	    const char* szName: The name of the function.
+	*/
+	static void* GetProcAddress(const char* szName);
+
+private:
+
+#ifdef HEADLESS_EGL
+	void* m_eglDisplay;
+	void* m_eglContext;
+	void* m_eglSurface; // Only used when the display does not support surfaceless contexts.
+#else
+	GLFWwindow* m_window;
+	bool m_bGLFWInit;
+#endif
+};
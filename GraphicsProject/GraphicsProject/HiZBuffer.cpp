@@ -0,0 +1,136 @@
+#include "HiZBuffer.h"
+#include "glad\glad.h"
+#include "GLState.h"
+#include "Shader.h"
+#include "Texture.h"
+
+HiZBuffer::HiZBuffer(int nDepthWidth, int nDepthHeight)
+{
+	m_glHandle = 0;
+	m_nDepthWidth = nDepthWidth;
+	m_nDepthHeight = nDepthHeight;
+	m_viewProjection = glm::mat4();
+
+	Allocate();
+}
+
+HiZBuffer::~HiZBuffer()
+{
+	GLState::GetInstance()->DeleteTextures(1, &m_glHandle);
+}
+
+void HiZBuffer::Resize(int nDepthWidth, int nDepthHeight)
+{
+	m_nDepthWidth = nDepthWidth;
+	m_nDepthHeight = nDepthHeight;
+
+	// Immutable storage cannot be reallocated, replace the texture...
+	GLState::GetInstance()->DeleteTextures(1, &m_glHandle);
+
+	Allocate();
+}
+
+void HiZBuffer::Build(Shader* downsampleShader, Texture* depthTexture, const glm::mat4& viewProjection)
+{
+	if (depthTexture->GetWidth() != m_nDepthWidth || depthTexture->GetHeight() != m_nDepthHeight)
+		Resize(depthTexture->GetWidth(), depthTexture->GetHeight());
+
+	GLState* glState = GLState::GetInstance();
+
+	downsampleShader->Use();
+
+	int nSourceWidth = m_nDepthWidth;
+	int nSourceHeight = m_nDepthHeight;
+
+	for(int i = 0; i < m_nMipCount; ++i)
+	{
+		int nLevelWidth = glm::max(m_nWidth >> i, 1);
+		int nLevelHeight = glm::max(m_nHeight >> i, 1);
+
+		// The first level reduces the depth texture, the rest reduce the previous level of the pyramid...
+		if (i == 0)
+			glState->BindTexture(0, GL_TEXTURE_2D, depthTexture->GetHandle());
+		else
+			glState->BindTexture(0, GL_TEXTURE_2D, m_glHandle);
+
+		downsampleShader->SetUniformIVec2("sourceSize", nSourceWidth, nSourceHeight);
+		downsampleShader->SetUniformInt("sourceLevel", i > 0 ? i - 1 : 0);
+
+		glBindImageTexture(0, m_glHandle, i, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+		glDispatchCompute((nLevelWidth + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, (nLevelHeight + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, 1);
+
+		// The next level reads this one...
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+		nSourceWidth = nLevelWidth;
+		nSourceHeight = nLevelHeight;
+	}
+
+	glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+	m_viewProjection = viewProjection;
+	m_bValid = true;
+}
+
+unsigned int HiZBuffer::Handle() const
+{
+	return m_glHandle;
+}
+
+int HiZBuffer::Width() const
+{
+	return m_nWidth;
+}
+
+int HiZBuffer::Height() const
+{
+	return m_nHeight;
+}
+
+int HiZBuffer::MipCount() const
+{
+	return m_nMipCount;
+}
+
+const glm::mat4& HiZBuffer::ViewProjection() const
+{
+	return m_viewProjection;
+}
+
+bool HiZBuffer::IsValid() const
+{
+	return m_bValid;
+}
+
+void HiZBuffer::Invalidate()
+{
+	m_bValid = false;
+}
+
+void HiZBuffer::Allocate()
+{
+	// Mip 0 is half the depth resolution rounded up, each texel covers at least a 2x2 block of depth texels...
+	m_nWidth = glm::max((m_nDepthWidth + 1) / 2, 1);
+	m_nHeight = glm::max((m_nDepthHeight + 1) / 2, 1);
+
+	m_nMipCount = 1;
+
+	while ((glm::max(m_nWidth, m_nHeight) >> m_nMipCount) > 0)
+		++m_nMipCount;
+
+	glGenTextures(1, &m_glHandle);
+	GLState::GetInstance()->BindTexture(GL_TEXTURE_2D, m_glHandle);
+
+	glTexStorage2D(GL_TEXTURE_2D, m_nMipCount, GL_R32F, m_nWidth, m_nHeight);
+
+	// Levels are selected explicitly with texelFetch, filtering only needs to keep the texture complete.
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	GLState::GetInstance()->BindTexture(GL_TEXTURE_2D, 0);
+
+	m_bValid = false;
+}
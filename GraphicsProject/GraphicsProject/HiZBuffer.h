@@ -0,0 +1,96 @@
+#pragma once
+#include "glm.hpp"
+
+class Shader;
+class Texture;
+
+// Must match local_size_x and local_size_y in hiz_downsample.comp.
+#define HIZ_GROUP_SIZE 8
+
+/*
+Hierarchical depth pyramid built from a depth texture, used to reject bounds hidden behind previously drawn geometry.
+Each texel stores the farthest depth of the texels it covers, so a bound whose nearest depth lies beyond the stored depth
+of every texel under its screen footprint is fully occluded. Mip 0 is half the resolution of the source depth texture.
+The view projection the pyramid was built with is kept, so bounds can be tested against it in a later frame.
+*/
+class HiZBuffer
+{
+public:
+
+	HiZBuffer(int nDepthWidth, int nDepthHeight);
+
+	~HiZBuffer();
+
+	/*
+	Description: Reallocate the pyramid for a depth texture of a different size. The pyramid is invalid until it is built again.
+	Param:
+	    int nDepthWidth: The width of the source depth texture.
+		int nDepthHeight: The height of the source depth texture.
+	*/
+	void Resize(int nDepthWidth, int nDepthHeight);
+
+	/*
+	Description: Build every level of the pyramid from a depth texture, resizing first if the texture size has changed.
+	Param:
+	    Shader* downsampleShader: The Hi-Z downsample compute shader.
+		Texture* depthTexture: The depth texture to build from.
+		const mat4& viewProjection: The view projection matrix the depth texture was rendered with.
+	*/
+	void Build(Shader* downsampleShader, Texture* depthTexture, const glm::mat4& viewProjection);
+
+	/*
+	Description: Get the OpenGL handle of the R32F pyramid texture.
+	Return Type: unsigned int
+	*/
+	unsigned int Handle() const;
+
+	/*
+	Description: Get the width of mip 0 of the pyramid.
+	Return Type: int
+	*/
+	int Width() const;
+
+	/*
+	Description: Get the height of mip 0 of the pyramid.
+	Return Type: int
+	*/
+	int Height() const;
+
+	/*
+	Description: Get the amount of mip levels in the pyramid.
+	Return Type: int
+	*/
+	int MipCount() const;
+
+	/*
+	Description: Get the view projection matrix of the depth the pyramid was last built from.
+	Return Type: const mat4&
+	*/
+	const glm::mat4& ViewProjection() const;
+
+	/*
+	Description: Get whether the pyramid has been built since it was last allocated.
+	Return Type: bool
+	*/
+	bool IsValid() const;
+
+	/*
+	Description: Mark the pyramid as out of date, such as when it stops being built every frame. It is valid again once rebuilt.
+	*/
+	void Invalidate();
+
+private:
+
+	void Allocate();
+
+	unsigned int m_glHandle;
+
+	int m_nDepthWidth;
+	int m_nDepthHeight;
+	int m_nWidth;
+	int m_nHeight;
+	int m_nMipCount;
+
+	glm::mat4 m_viewProjection;
+	bool m_bValid;
+};
@@ -5,8 +5,8 @@ Input* Input::m_instance = nullptr;
 
 Input::Input()
 {
-	m_currentState = new char[512];
-	m_prevState = new char[512];
+	m_currentState = new char[INPUT_KEY_COUNT];
+	m_prevState = new char[INPUT_KEY_COUNT];
 
 	m_currentMouseState = new MouseState[8];
 	m_prevMouseState = new MouseState[8];
@@ -32,8 +32,8 @@ Input::Input()
 	m_mouseStates[1] = m_prevMouseState;
 
 	// Wipe both input states to 0. (Garbage memory is not always 0.)
-	memset(m_currentState, 0, sizeof(char) * 512);
-	memset(m_prevState, 0, sizeof(char) * 512);
+	memset(m_currentState, 0, sizeof(char) * INPUT_KEY_COUNT);
+	memset(m_prevState, 0, sizeof(char) * INPUT_KEY_COUNT);
 }
 
 Input::~Input()
@@ -90,7 +90,7 @@ float Input::GetScrollY(EInputState state)
 void Input::EndFrame()
 {
 	// Copy current state to previous state.
-	memcpy_s(m_prevState, sizeof(char) * 512, m_currentState, sizeof(char) * 512);
+	memcpy_s(m_prevState, sizeof(char) * INPUT_KEY_COUNT, m_currentState, sizeof(char) * INPUT_KEY_COUNT);
 
 	// Copy current mouse state to previous mouse state.
 	memcpy_s(m_prevMouseState, sizeof(MouseState), m_currentMouseState, sizeof(MouseState));
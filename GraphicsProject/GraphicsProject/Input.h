@@ -1,5 +1,8 @@
 #pragma once
 
+// Size of the keyboard state arrays, indexed by GLFW keycode.
+#define INPUT_KEY_COUNT 512
+
 enum EInputState 
 {
     INPUTSTATE_CURRENT,
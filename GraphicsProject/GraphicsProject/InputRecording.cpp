@@ -0,0 +1,160 @@
+#include "InputRecording.h"
+#include "Input.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstring>
+
+// Frames are added a minute of input at a time at 60 frames per second.
+#define INPUT_RECORDING_FRAME_BLOCK 3600
+
+InputRecording::InputRecording() : m_frames(INPUT_RECORDING_FRAME_BLOCK, INPUT_RECORDING_FRAME_BLOCK)
+{
+
+}
+
+InputRecording::~InputRecording()
+{
+
+}
+
+void InputRecording::RecordFrame(Input* input, float fDeltaTime)
+{
+	InputRecordingFrame frame;
+	frame.m_fDeltaTime = fDeltaTime;
+	frame.m_fCursorX = input->GetCursorX();
+	frame.m_fCursorY = input->GetCursorY();
+	frame.m_buttonMask = 0;
+	frame.m_nKeyCount = 0;
+
+	for(int i = 0; i < 8; ++i)
+	{
+		if (input->GetMouseButton(static_cast<EMouseButton>(i)))
+			frame.m_buttonMask |= 1 << i;
+	}
+
+	for(int i = 0; i < INPUT_KEY_COUNT && frame.m_nKeyCount < INPUT_RECORDING_MAX_KEYS; ++i)
+	{
+		if (input->GetKey(i))
+			frame.m_keys[frame.m_nKeyCount++] = static_cast<short>(i);
+	}
+
+	m_frames.Push(frame);
+}
+
+void InputRecording::PlayFrame(int nFrame, Input* input) const
+{
+	const InputRecordingFrame& frame = m_frames[nFrame];
+
+	// Keys are released unless recorded as held...
+	char* keyState = input->GetCurrentState();
+	memset(keyState, 0, sizeof(char) * INPUT_KEY_COUNT);
+
+	for (int i = 0; i < frame.m_nKeyCount; ++i)
+		keyState[frame.m_keys[i]] = 1;
+
+	// Mouse button states are stored as the GLFW action minus one.
+	MouseState* mouseState = input->GetCurrentMouseState();
+
+	for (int i = 0; i < 8; ++i)
+		mouseState->m_buttons[i] = (frame.m_buttonMask & (1 << i)) ? 0 : -1;
+
+	mouseState->m_fMouseAxes[0] = frame.m_fCursorX;
+	mouseState->m_fMouseAxes[1] = frame.m_fCursorY;
+}
+
+float InputRecording::FrameDeltaTime(int nFrame) const
+{
+	return m_frames[nFrame].m_fDeltaTime;
+}
+
+int InputRecording::FrameCount() const
+{
+	return m_frames.Count();
+}
+
+void InputRecording::Clear()
+{
+	m_frames.Clear();
+}
+
+bool InputRecording::Save(const char* szPath) const
+{
+	std::ofstream file(szPath);
+
+	if(!file.good())
+	{
+		std::cout << "Input Recording Error: Failed to open " << szPath << " for writing." << std::endl;
+		return false;
+	}
+
+	file << "# Delta time, cursor X, cursor Y, mouse button mask, held keycodes.\n";
+
+	for(int i = 0; i < m_frames.Count(); ++i)
+	{
+		const InputRecordingFrame& frame = m_frames[i];
+
+		file << frame.m_fDeltaTime << " " << frame.m_fCursorX << " " << frame.m_fCursorY << " " << static_cast<int>(frame.m_buttonMask);
+
+		for (int j = 0; j < frame.m_nKeyCount; ++j)
+			file << " " << frame.m_keys[j];
+
+		file << "\n";
+	}
+
+	return file.good();
+}
+
+bool InputRecording::Load(const char* szPath)
+{
+	std::ifstream file(szPath);
+
+	if(!file.good())
+	{
+		std::cout << "Input Recording Error: Failed to open " << szPath << " for reading." << std::endl;
+		return false;
+	}
+
+	m_frames.Clear();
+
+	std::string line;
+	int nLine = 0;
+
+	while(std::getline(file, line))
+	{
+		++nLine;
+
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		std::istringstream lineStream(line);
+
+		InputRecordingFrame frame;
+		int nButtonMask = 0;
+
+		if(!(lineStream >> frame.m_fDeltaTime >> frame.m_fCursorX >> frame.m_fCursorY >> nButtonMask))
+		{
+			std::cout << "Input Recording Error: Malformed frame on line " << nLine << " of " << szPath << std::endl;
+			m_frames.Clear();
+			return false;
+		}
+
+		frame.m_buttonMask = static_cast<unsigned char>(nButtonMask);
+		frame.m_nKeyCount = 0;
+
+		int nKey = 0;
+
+		while(lineStream >> nKey)
+		{
+			if (nKey < 0 || nKey >= INPUT_KEY_COUNT || frame.m_nKeyCount >= INPUT_RECORDING_MAX_KEYS)
+				continue;
+
+			frame.m_keys[frame.m_nKeyCount++] = static_cast<short>(nKey);
+		}
+
+		m_frames.Push(frame);
+	}
+
+	return true;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include "DynamicArray.h"
+
+class Input;
+
+// Most keys held at once in a recorded frame, further keys are not recorded.
+#define INPUT_RECORDING_MAX_KEYS 8
+
+// The input state of a single recorded frame.
+struct InputRecordingFrame
+{
+	float m_fDeltaTime;
+	float m_fCursorX;
+	float m_fCursorY;
+	unsigned char m_buttonMask; // Bit per mouse button, set if held.
+	unsigned char m_nKeyCount;
+	short m_keys[INPUT_RECORDING_MAX_KEYS]; // Keycodes of held keys.
+};
+
+/*
+A sequence of per frame keyboard and mouse states along with the frame's delta time, recorded from the live input
+and played back into the input later. Playing back with the recorded delta times moves a camera along exactly the same path
+regardless of how fast frames render, so the same path can be flown before and after a change.
+Saved as text with a line per frame: delta time, cursor X, cursor Y, button mask and held keycodes. Lines starting with # are comments.
+*/
+class InputRecording
+{
+public:
+
+	InputRecording();
+
+	~InputRecording();
+
+	/*
+	Description: Append the current state of the input as a new frame.
+	Param:
+	    Input* input: The input to record.
+		float fDeltaTime: The delta time the frame is updated with.
+	*/
+	void RecordFrame(Input* input, float fDeltaTime);
+
+	/*
+	Description: Overwrite the current state of the input with a recorded frame. The previous state is left as it is,
+	so key presses are still detected by comparing with the previous frame.
+	Param:
+	    int nFrame: The index of the frame to play.
+		Input* input: The input to write to.
+	*/
+	void PlayFrame(int nFrame, Input* input) const;
+
+	/*
+	Description: Get the delta time of a recorded frame.
+	Return Type: float
+	Param:
+	    int nFrame: The index of the frame.
+	*/
+	float FrameDeltaTime(int nFrame) const;
+
+	/*
+	Description: Get the amount of recorded frames.
+	Return Type: int
+	*/
+	int FrameCount() const;
+
+	/*
+	Description: Remove all recorded frames.
+	*/
+	void Clear();
+
+	/*
+	Description: Write the recorded frames to a file.
+	Return Type: bool
+	Returns true if the file was written.
+	Param:
+	    const char* szPath: The path of the file to write.
+	*/
+	bool Save(const char* szPath) const;
+
+	/*
+	Description: Replace the recorded frames with the frames of a file.
+	Return Type: bool
+	Returns true if the file was read.
+	Param:
+	    const char* szPath: The path of the file to read.
+	*/
+	bool Load(const char* szPath);
+
+private:
+
+	DynamicArray<InputRecordingFrame> m_frames;
+};
@@ -0,0 +1,172 @@
+#include "InstancePool.h"
+#include "glad/glad.h"
+#include "GLState.h"
+#include "UploadRing.h"
+#include "CommandBucket.h"
+#include <iostream>
+
+#define INSTANCE_SIZE (sizeof(unsigned int) * INSTANCE_WORD_COUNT)
+
+InstancePool* InstancePool::m_instance = nullptr;
+
+InstancePool::InstancePool(unsigned int nCapacity)
+{
+	m_nCapacity = nCapacity;
+
+	glGenBuffers(1, &m_glBufferHandle);
+	GLState::GetInstance()->BindBuffer(GL_COPY_WRITE_BUFFER, m_glBufferHandle);
+	glBufferStorage(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(INSTANCE_SIZE) * m_nCapacity, nullptr, GL_DYNAMIC_STORAGE_BIT);
+	GLState::GetInstance()->BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	m_freeRanges.Push({ 0, m_nCapacity });
+}
+
+InstancePool::~InstancePool()
+{
+	GLState::GetInstance()->DeleteBuffers(1, &m_glBufferHandle);
+}
+
+bool InstancePool::Reserve(unsigned int nCount, unsigned int& nOutFirst)
+{
+	// Take the front of the first free range large enough...
+	for(int i = 0; i < m_freeRanges.Count(); ++i)
+	{
+		Range& range = m_freeRanges[i];
+
+		if (range.m_nCount < nCount)
+			continue;
+
+		nOutFirst = range.m_nFirst;
+
+		range.m_nFirst += nCount;
+		range.m_nCount -= nCount;
+
+		if (range.m_nCount == 0)
+			m_freeRanges.PopAt(i);
+
+		return true;
+	}
+
+	// Grow and take the new space, which follows any free range at the end of the old buffer...
+	unsigned int nCapacity = m_nCapacity * 2;
+
+	while (nCapacity < m_nCapacity + nCount)
+		nCapacity *= 2;
+
+	if(!Grow(nCapacity))
+	{
+		std::cout << "Instance Pool Error: Failed to grow to " << nCapacity << " instances." << std::endl;
+		return false;
+	}
+
+	return Reserve(nCount, nOutFirst);
+}
+
+void InstancePool::Release(unsigned int nFirst, unsigned int nCount)
+{
+	if (nCount == 0)
+		return;
+
+	// Merge with the free ranges directly before and after...
+	for(int i = 0; i < m_freeRanges.Count(); ++i)
+	{
+		Range& range = m_freeRanges[i];
+
+		if(range.m_nFirst + range.m_nCount == nFirst)
+		{
+			nFirst = range.m_nFirst;
+			nCount += range.m_nCount;
+
+			m_freeRanges.PopAt(i--);
+		}
+		else if(nFirst + nCount == range.m_nFirst)
+		{
+			nCount += range.m_nCount;
+
+			m_freeRanges.PopAt(i--);
+		}
+	}
+
+	m_freeRanges.Push({ nFirst, nCount });
+}
+
+bool InstancePool::Update(unsigned int nFirst, const void* instances, unsigned int nCount)
+{
+	UploadRing* uploadRing = UploadRing::GetInstance();
+
+	unsigned int nSize = static_cast<unsigned int>(INSTANCE_SIZE) * nCount;
+	unsigned int nOffset = 0;
+
+	if (!uploadRing->Upload(instances, nSize, sizeof(unsigned int), nOffset))
+		return false;
+
+	GLState* glState = GLState::GetInstance();
+
+	glState->BindBuffer(GL_COPY_READ_BUFFER, uploadRing->Handle());
+	glState->BindBuffer(GL_COPY_WRITE_BUFFER, m_glBufferHandle);
+
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, nOffset, static_cast<GLintptr>(INSTANCE_SIZE) * nFirst, nSize);
+
+	glState->BindBuffer(GL_COPY_READ_BUFFER, 0);
+	glState->BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	return true;
+}
+
+unsigned int InstancePool::Handle() const
+{
+	return m_glBufferHandle;
+}
+
+bool InstancePool::Grow(unsigned int nCapacity)
+{
+	GLState* glState = GLState::GetInstance();
+
+	// Byte offsets of instances are 32-bit.
+	if (static_cast<unsigned long long>(INSTANCE_SIZE) * nCapacity > 0xFFFFFFFFull)
+		return false;
+
+	unsigned int glNewBufferHandle = 0;
+
+	glGenBuffers(1, &glNewBufferHandle);
+	glState->BindBuffer(GL_COPY_WRITE_BUFFER, glNewBufferHandle);
+	glBufferStorage(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(INSTANCE_SIZE) * nCapacity, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+	// Copy the existing instances on the GPU, draws already issued keep the old buffer alive until they are done with it...
+	glState->BindBuffer(GL_COPY_READ_BUFFER, m_glBufferHandle);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, static_cast<GLsizeiptr>(INSTANCE_SIZE) * m_nCapacity);
+
+	glState->BindBuffer(GL_COPY_READ_BUFFER, 0);
+	glState->BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	glState->DeleteBuffers(1, &m_glBufferHandle);
+
+	m_glBufferHandle = glNewBufferHandle;
+
+	unsigned int nOldCapacity = m_nCapacity;
+	m_nCapacity = nCapacity;
+
+	Release(nOldCapacity, nCapacity - nOldCapacity);
+
+	return true;
+}
+
+void InstancePool::Create(unsigned int nCapacity)
+{
+	if (!m_instance)
+		m_instance = new InstancePool(nCapacity);
+}
+
+void InstancePool::Destroy()
+{
+	if(m_instance)
+	{
+		delete m_instance;
+		m_instance = nullptr;
+	}
+}
+
+InstancePool* InstancePool::GetInstance()
+{
+	return m_instance;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include "DynamicArray.h"
+
+// Instances the pool has room for before it first grows.
+#define INSTANCE_POOL_CAPACITY (64 * 1024)
+
+/*
+Persistent GPU storage for instances that outlive a frame, such as those of a MeshRenderer, in the per-instance layout read through INSTANCE_VERTEX_BINDING.
+Each renderer reserves a range for its maximum instance count and sends only the instances it changed, staged in the UploadRing and copied on the GPU
+so the buffer is never written while it may be in use. The buffer is replaced by a larger one when a reservation doesn't fit, so it is bound by handle where it is used.
+*/
+class InstancePool
+{
+public:
+
+	InstancePool(unsigned int nCapacity);
+
+	~InstancePool();
+
+	/*
+	Description: Reserve a range of instances, growing the pool if no free range is large enough.
+	Return Type: bool
+	Param:
+	    unsigned int nCount: The amount of instances to reserve.
+		unsigned int& nOutFirst: The index of the first reserved instance, used as the base instance of draws reading them.
+	Returns false if the pool could not grow.
+	*/
+	bool Reserve(unsigned int nCount, unsigned int& nOutFirst);
+
+	/*
+	Description: Return a reserved range to the pool.
+	Param:
+	    unsigned int nFirst: The index of the first instance of the range.
+		unsigned int nCount: The amount of instances in the range.
+	*/
+	void Release(unsigned int nFirst, unsigned int nCount);
+
+	/*
+	Description: Copy instances into a reserved range.
+	Return Type: bool
+	Param:
+	    unsigned int nFirst: The index of the first instance to write.
+		const void* instances: The instances to copy.
+		unsigned int nCount: The amount of instances to copy.
+	Returns false if the instances could not be staged in the upload ring.
+	*/
+	bool Update(unsigned int nFirst, const void* instances, unsigned int nCount);
+
+	/*
+	Description: Get the OpenGL handle of the instance buffer, it changes when the pool grows.
+	Return Type: unsigned int
+	*/
+	unsigned int Handle() const;
+
+	// Singleton functions.
+
+	static void Create(unsigned int nCapacity = INSTANCE_POOL_CAPACITY);
+	static void Destroy();
+	static InstancePool* GetInstance();
+
+private:
+
+	struct Range
+	{
+		unsigned int m_nFirst;
+		unsigned int m_nCount;
+	};
+
+	// Replace the buffer with one holding at least nCapacity instances, keeping the instances already in it.
+	bool Grow(unsigned int nCapacity);
+
+	static InstancePool* m_instance;
+
+	unsigned int m_glBufferHandle;
+	unsigned int m_nCapacity;
+
+	DynamicArray<Range> m_freeRanges;
+};
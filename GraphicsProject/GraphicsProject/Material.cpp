@@ -1,20 +1,33 @@
 #include "Material.h"
 #include "glad\glad.h"
+#include "GLState.h"
 #include "Shader.h"
 #include "Texture.h"
 #include "MeshRenderer.h"
 #include "StaticMeshRenderer.h"
+#include "MaterialTable.h"
+#include "CPUProfiler.h"
 #include <iostream>
 
+unsigned short Material::m_nNextSortID = 0;
+
 Material::Material(Shader* shader) 
 {
 	m_shader = shader;
+	m_nSortID = m_nNextSortID++;
+
+	// Reserve a table entry where bindless textures are supported, shaders choose whether to read it.
+	m_nTableSlot = MaterialTable::GetInstance() ? MaterialTable::GetInstance()->Add() : -1;
 }
 
 Material::~Material() 
 {
 	m_shader = nullptr;
 
+	// The table may already be gone if the renderer was deleted first.
+	if (m_nTableSlot >= 0 && MaterialTable::GetInstance())
+		MaterialTable::GetInstance()->Remove(m_nTableSlot);
+
 	// Remove all mesh renderers...
 	for (int i = 0; i < m_meshes.Count(); ++i)
 		m_meshes[i]->SetMaterial(nullptr);
@@ -24,7 +37,10 @@ void Material::AddMap(Texture* map)
 {
 	// Don't allow maps to be added if there is already 16 maps active.
 	if (m_maps.Count() < 16)
+	{
 		m_maps.Push(map);
+		UpdateTableEntry();
+	}
 }
 
 void Material::RemoveMap(Texture* map) 
@@ -34,6 +50,7 @@ void Material::RemoveMap(Texture* map)
 		if(map == m_maps[i]) 
 		{
 			m_maps.PopAt(i);
+			UpdateTableEntry();
 			return;
 		}
 	}
@@ -42,6 +59,7 @@ void Material::RemoveMap(Texture* map)
 void Material::RemoveMap(int nMapIndex) 
 {
 	m_maps.PopAt(nMapIndex);
+	UpdateTableEntry();
 }
 
 int Material::MapCount() 
@@ -53,35 +71,33 @@ void Material::Use()
 {
 	m_shader->Use();
 
-	// Bind all texture maps...
-	for(int i = 0; i < m_maps.Count(); ++i) 
-	{
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, m_maps[i]->GetHandle());
-	}
+	// Table materials are selected per draw by the shader, there is nothing to bind.
+	if (UsesMaterialTable())
+		return;
+
+	// Bind all texture maps, maps already bound to their unit are skipped...
+	GLState* glState = GLState::GetInstance();
 
-	// Reset active texture.
-	glActiveTexture(GL_TEXTURE0);
+	for (int i = 0; i < m_maps.Count(); ++i)
+		glState->BindTexture(i, GL_TEXTURE_2D, m_maps[i]->GetHandle());
 }
 
-void Material::DrawMeshes() 
+void Material::DrawMeshes(CommandBucket* bucket) 
 {
-	// Use this material for drawing...
-	Use();
+	CPU_PROFILE_ZONE("Material::DrawMeshes");
 
-	// Draw all associated meshes.
+	// Add draws of all associated meshes, the bucket binds this material when they are submitted.
 	for (int i = 0; i < m_meshes.Count(); ++i)
-		m_meshes[i]->Draw();
+		m_meshes[i]->Draw(bucket);
 }
 
-void Material::DrawStaticMeshes() 
+void Material::DrawStaticMeshes(CommandBucket* bucket) 
 {
-	// Use this material for drawing...
-	Use();
+	CPU_PROFILE_ZONE("Material::DrawStaticMeshes");
 
-	// Draw all associated static meshes.
+	// Add draws of all associated static meshes.
 	for (int i = 0; i < m_staticMeshes.Count(); ++i)
-		m_staticMeshes[i]->Draw();
+		m_staticMeshes[i]->Draw(bucket);
 }
 
 void Material::SetShader(Shader* shader)
@@ -94,6 +110,21 @@ Shader* Material::GetShader()
 	return m_shader;
 }
 
+unsigned short Material::SortID() const
+{
+	return m_nSortID;
+}
+
+int Material::TableSlot() const
+{
+	return m_nTableSlot;
+}
+
+bool Material::UsesMaterialTable() const
+{
+	return m_nTableSlot >= 0 && m_shader->ReadsMaterialTable();
+}
+
 DynamicArray<MeshRenderer*>& Material::GetMeshes() 
 {
 	return m_meshes;
@@ -104,6 +135,12 @@ DynamicArray<StaticMeshRenderer*>& Material::GetStaticMeshes()
 	return m_staticMeshes;
 }
 
+void Material::UpdateTableEntry()
+{
+	if (m_nTableSlot >= 0 && MaterialTable::GetInstance())
+		MaterialTable::GetInstance()->SetMaps(m_nTableSlot, m_maps.Data(), m_maps.Count());
+}
+
 void Material::SetAmbientColor(float r, float g, float b)
 {
 	m_fAmbientColor[0] = r;
@@ -140,7 +177,7 @@ void Material::SetSpecularShininess(const float& fShininess)
 	{
 		m_shader->Use();
 		m_shader->SetUniformFloat("specularShininess", m_fSpecShininess);
-		glUseProgram(0);
+		GLState::GetInstance()->UseProgram(0);
 	}
 }
 
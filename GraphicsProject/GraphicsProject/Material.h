@@ -5,6 +5,7 @@ class Shader;
 class Texture;
 class MeshRenderer;
 class StaticMeshRenderer;
+class CommandBucket;
 
 class Material 
 {
@@ -42,19 +43,35 @@ public:
 	int MapCount();
 
 	/*
-	Description: Bind the shader and texture maps of this material.
+	Description: Bind the shader and texture maps of this material. Maps are not bound if the shader reads them from the MaterialTable.
 	*/
 	void Use();
 
 	/*
-	Description: Draw all meshes using this material without texture and shader state changes.
+	Description: Get the slot of this material's entry in the MaterialTable, or -1 if it has none.
+	Return Type: int
+	*/
+	int TableSlot() const;
+
+	/*
+	Description: Get whether this material's maps are read from the MaterialTable, so draws of it can share a multi-draw with other such materials of the same shader.
+	Return Type: bool
+	*/
+	bool UsesMaterialTable() const;
+
+	/*
+	Description: Add draws of all meshes using this material to a command bucket.
+	Param:
+	    CommandBucket* bucket: The bucket to add the draws to.
 	*/
-	void DrawMeshes();
+	void DrawMeshes(CommandBucket* bucket);
 
 	/*
-	Description: Draw static meshes for this material.
+	Description: Add draws of static meshes for this material to a command bucket.
+	Param:
+	    CommandBucket* bucket: The bucket to add the draws to.
 	*/
-	void DrawStaticMeshes();
+	void DrawStaticMeshes(CommandBucket* bucket);
 
 	/*
 	Description: Set the shader used by this material for rendering.
@@ -69,6 +86,12 @@ public:
 	*/
 	Shader* GetShader();
 
+	/*
+	Description: Get the ID identifying this material in draw sort keys, unique among the first 65536 materials created.
+	Return Type: unsigned short
+	*/
+	unsigned short SortID() const;
+
 	/*
 	Description: Get the array of all meshes using this material.
 	Return Type: DynamicArray<MeshRenderer*>&
@@ -95,12 +118,19 @@ public:
 
 private:
 
+	// Write the current maps to this material's table entry.
+	void UpdateTableEntry();
+
 	DynamicArray<MeshRenderer*> m_meshes;
 	DynamicArray<StaticMeshRenderer*> m_staticMeshes;
 
 	Shader* m_shader;
 	DynamicArray<Texture*> m_maps;
 
+	static unsigned short m_nNextSortID;
+	unsigned short m_nSortID;
+	int m_nTableSlot;
+
 	float m_fAmbientColor[3];
 	float m_fDiffuseColor[3];
 	float m_fSpecularColor[3];
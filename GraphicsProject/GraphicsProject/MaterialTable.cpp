@@ -0,0 +1,185 @@
+#include "MaterialTable.h"
+#include "glad/glad.h"
+#include "GLState.h"
+#include "Texture.h"
+#include "TextureStreamer.h"
+#include <iostream>
+
+MaterialTable* MaterialTable::m_instance = nullptr;
+
+MaterialTable::MaterialTable(int nCapacity)
+{
+	m_nCapacity = nCapacity;
+	m_bFullReported = false;
+
+	// Entries are rewritten only when a material's maps change, the buffer is never mapped...
+	glGenBuffers(1, &m_glBufferHandle);
+	GLState::GetInstance()->BindBuffer(GL_COPY_WRITE_BUFFER, m_glBufferHandle);
+	glBufferStorage(GL_COPY_WRITE_BUFFER, sizeof(Entry) * m_nCapacity, nullptr, GL_DYNAMIC_STORAGE_BIT);
+	GLState::GetInstance()->BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+MaterialTable::~MaterialTable()
+{
+	// Release residency of every handle still referenced...
+	for (auto it = m_residentCounts.begin(); it != m_residentCounts.end(); ++it)
+		glMakeTextureHandleNonResidentARB(it->first);
+
+	GLState::GetInstance()->DeleteBuffers(1, &m_glBufferHandle);
+}
+
+int MaterialTable::Add()
+{
+	int nSlot = -1;
+
+	if(m_freeSlots.Count() > 0)
+	{
+		nSlot = m_freeSlots[m_freeSlots.Count() - 1];
+		m_freeSlots.PopEnd();
+	}
+	else if(m_entries.Count() < m_nCapacity)
+	{
+		nSlot = m_entries.Count();
+		m_entries.Push(Entry());
+		m_entryMaps.Push(EntryMaps());
+	}
+	else
+	{
+		if(!m_bFullReported)
+		{
+			std::cout << "Material Table Warning: Table is full, further materials will bind their maps." << std::endl;
+			m_bFullReported = true;
+		}
+
+		return -1;
+	}
+
+	SetMaps(nSlot, nullptr, 0);
+
+	return nSlot;
+}
+
+void MaterialTable::Remove(int nSlot)
+{
+	SetMaps(nSlot, nullptr, 0);
+
+	m_freeSlots.Push(nSlot);
+}
+
+void MaterialTable::SetMaps(int nSlot, Texture* const* maps, int nMapCount)
+{
+	Entry& entry = m_entries[nSlot];
+	Entry newEntry;
+	EntryMaps newMaps;
+
+	newMaps.m_nCount = nMapCount;
+
+	// Get handles of the new maps first, so maps kept by the entry never lose residency...
+	for(int i = 0; i < MATERIAL_TABLE_MAP_COUNT; ++i)
+	{
+		newEntry.m_handles[i] = 0;
+		newMaps.m_maps[i] = nullptr;
+
+		if (i >= nMapCount)
+			continue;
+
+		newMaps.m_maps[i] = maps[i];
+
+		// Maps that failed to load have no texture to get a handle of, the streamer's flat placeholder stands in for them.
+		unsigned int glTextureHandle = maps[i]->GetHandle();
+
+		if (glTextureHandle == 0 && TextureStreamer::GetInstance())
+			glTextureHandle = TextureStreamer::GetInstance()->PlaceholderHandle();
+
+		if (glTextureHandle == 0)
+			continue;
+
+		newEntry.m_handles[i] = glGetTextureHandleARB(glTextureHandle);
+		Reference(newEntry.m_handles[i]);
+	}
+
+	for(int i = 0; i < MATERIAL_TABLE_MAP_COUNT; ++i)
+	{
+		if (entry.m_handles[i] != 0)
+			Release(entry.m_handles[i]);
+	}
+
+	entry = newEntry;
+	m_entryMaps[nSlot] = newMaps;
+
+	GLState::GetInstance()->BindBuffer(GL_COPY_WRITE_BUFFER, m_glBufferHandle);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, sizeof(Entry) * nSlot, sizeof(Entry), &entry);
+	GLState::GetInstance()->BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void MaterialTable::RefreshTexture(Texture* texture)
+{
+	for(int i = 0; i < m_entryMaps.Count(); ++i)
+	{
+		// Copied, SetMaps overwrites the slot's maps.
+		EntryMaps maps = m_entryMaps[i];
+
+		for(int j = 0; j < maps.m_nCount; ++j)
+		{
+			if (maps.m_maps[j] != texture)
+				continue;
+
+			SetMaps(i, maps.m_maps, maps.m_nCount);
+			break;
+		}
+	}
+}
+
+unsigned int MaterialTable::Handle() const
+{
+	return m_glBufferHandle;
+}
+
+bool MaterialTable::IsSupported()
+{
+	// Handles are read from storage, the draw ID selects each draw's material within a multi-draw.
+	return GLAD_GL_ARB_bindless_texture && GLAD_GL_ARB_shader_draw_parameters;
+}
+
+void MaterialTable::Reference(unsigned long long handle)
+{
+	int& nCount = m_residentCounts[handle];
+
+	// Making a handle resident twice is an error, only the first reference does.
+	if (nCount++ == 0)
+		glMakeTextureHandleResidentARB(handle);
+}
+
+void MaterialTable::Release(unsigned long long handle)
+{
+	auto it = m_residentCounts.find(handle);
+
+	if (it == m_residentCounts.end())
+		return;
+
+	if(--it->second == 0)
+	{
+		glMakeTextureHandleNonResidentARB(handle);
+		m_residentCounts.erase(it);
+	}
+}
+
+void MaterialTable::Create(int nCapacity)
+{
+	if (!m_instance)
+		m_instance = new MaterialTable(nCapacity);
+}
+
+void MaterialTable::Destroy()
+{
+	if(m_instance)
+	{
+		delete m_instance;
+		m_instance = nullptr;
+	}
+}
+
+MaterialTable* MaterialTable::GetInstance()
+{
+	return m_instance;
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include "DynamicArray.h"
+#include <map>
+
+class Texture;
+
+// Shader storage bindings of the material table and the per-draw material slots, following the instance culling bindings.
+#define MATERIAL_TABLE_SSBO_BINDING 7
+#define MATERIAL_DRAW_SSBO_BINDING 8
+
+// Materials the table can hold, and maps per material matching Material::AddMap.
+#define MATERIAL_TABLE_CAPACITY 1024
+#define MATERIAL_TABLE_MAP_COUNT 16
+
+/*
+Storage buffer of bindless texture handles, one fixed size entry of maps per material.
+Shaders declaring the MaterialTableBuffer block read their maps from the entry of each draw's material instead of from bound texture units,
+so draws of different materials sharing such a shader can be submitted together. Requires ARB_bindless_texture and ARB_shader_draw_parameters,
+the table is only created where both are available and materials fall back to binding their maps otherwise.
+Textures are made resident while any entry references them, and must outlive the materials using them.
+*/
+class MaterialTable
+{
+public:
+
+	MaterialTable(int nCapacity);
+
+	~MaterialTable();
+
+	/*
+	Description: Reserve an empty entry.
+	Return Type: int
+	Returns the slot of the entry, or -1 if the table is full.
+	*/
+	int Add();
+
+	/*
+	Description: Release an entry and the residency of its maps.
+	Param:
+	    int nSlot: The slot returned by Add.
+	*/
+	void Remove(int nSlot);
+
+	/*
+	Description: Replace the maps of an entry, unused map slots are cleared.
+	Param:
+	    int nSlot: The slot returned by Add.
+		Texture* const* maps: The maps in the order the shader reads them.
+		int nMapCount: The amount of maps, up to MATERIAL_TABLE_MAP_COUNT.
+	*/
+	void SetMaps(int nSlot, Texture* const* maps, int nMapCount);
+
+	/*
+	Description: Rewrite the entries using a texture whose OpenGL handle has changed, such as a streamed texture replacing its placeholder.
+	Param:
+	    Texture* texture: The texture whose handle changed.
+	*/
+	void RefreshTexture(Texture* texture);
+
+	/*
+	Description: Get the OpenGL handle of the table's storage buffer.
+	Return Type: unsigned int
+	*/
+	unsigned int Handle() const;
+
+	/*
+	Description: Get whether the current context supports the extensions the table requires.
+	Return Type: bool
+	*/
+	static bool IsSupported();
+
+	// Singleton functions.
+
+	static void Create(int nCapacity = MATERIAL_TABLE_CAPACITY);
+	static void Destroy();
+	static MaterialTable* GetInstance();
+
+private:
+
+	// Layout of one material's entry in the storage buffer, read as uvec2 sampler handles.
+	struct Entry
+	{
+		unsigned long long m_handles[MATERIAL_TABLE_MAP_COUNT];
+	};
+
+	// The textures an entry's handles were taken from.
+	struct EntryMaps
+	{
+		Texture* m_maps[MATERIAL_TABLE_MAP_COUNT];
+		int m_nCount;
+	};
+
+	// Count a reference to a handle, making it resident on the first.
+	void Reference(unsigned long long handle);
+
+	// Release a reference to a handle, making it non-resident on the last.
+	void Release(unsigned long long handle);
+
+	static MaterialTable* m_instance;
+
+	unsigned int m_glBufferHandle;
+	int m_nCapacity;
+
+	DynamicArray<Entry> m_entries; // CPU copy of the buffer contents, to release replaced handles.
+	DynamicArray<EntryMaps> m_entryMaps;
+	DynamicArray<int> m_freeSlots;
+	bool m_bFullReported;
+
+	std::map<unsigned long long, int> m_residentCounts;
+};
@@ -1,8 +1,10 @@
 #include "Mesh.h"
 #include "GLAD\glad.h"
+#include "GLState.h"
 #include "Texture.h"
 #include "Material.h"
 #include "Batch.h"
+#include "CPUProfiler.h"
 #include <iostream>
 
 // Using tiny obj loader header lib for .obj file loading.
@@ -13,6 +15,7 @@ Mesh::Mesh()
 {
 	m_bEmptyMesh = true;
 	m_szFilePath = nullptr;
+	m_drawRange = { 0, 0, 0, 0, glm::vec4(0.0f, 0.0f, 0.0f, -1.0f), 0, 0 };
 }
 
 Mesh::Mesh(const char* szFilePath) 
@@ -31,10 +34,10 @@ Mesh::~Mesh()
 	{
 		for(int i = 0; i < m_nMeshChunkCount; ++i) 
 		{
-			glDeleteVertexArrays(1, &m_meshes[i].m_glVAOHandle);
+			GLState::GetInstance()->DeleteVertexArrays(1, &m_meshes[i].m_glVAOHandle);
 
-			glDeleteBuffers(1, &m_meshes[i].m_glEBOHandle);
-			glDeleteBuffers(1, &m_meshes[i].m_glVBOHandle);
+			GLState::GetInstance()->DeleteBuffers(1, &m_meshes[i].m_glEBOHandle);
+			GLState::GetInstance()->DeleteBuffers(1, &m_meshes[i].m_glVBOHandle);
 		}
 
 		m_nMeshChunkCount = 0;
@@ -48,15 +51,17 @@ Mesh::~Mesh()
 
 void Mesh::Load(const char* szFilePath, unsigned int textureFlags) 
 {
+	CPU_PROFILE_ZONE("Mesh::Load");
+
 	// Delete old mesh if there is one.
 	if(!m_bEmptyMesh) 
 	{
 		for (int i = 0; i < m_nMeshChunkCount; ++i)
 		{
-			glDeleteVertexArrays(1, &m_meshes[i].m_glVAOHandle);
+			GLState::GetInstance()->DeleteVertexArrays(1, &m_meshes[i].m_glVAOHandle);
 
-			glDeleteBuffers(1, &m_meshes[i].m_glEBOHandle);
-			glDeleteBuffers(1, &m_meshes[i].m_glVBOHandle);
+			GLState::GetInstance()->DeleteBuffers(1, &m_meshes[i].m_glEBOHandle);
+			GLState::GetInstance()->DeleteBuffers(1, &m_meshes[i].m_glVBOHandle);
 		}
 		
 		m_nMeshChunkCount = 0;
@@ -100,7 +105,6 @@ void Mesh::Load(const char* szFilePath, unsigned int textureFlags)
 
 	// Generate whole mesh buffers...
 	glGenBuffers(1, &m_glVBOHandle);
-	glGenBuffers(1, &m_glInsHandle);
 	glGenBuffers(1, &m_glEBOHandle);
 	glGenVertexArrays(1, &m_glVAOHandle);
 
@@ -118,10 +122,10 @@ void Mesh::Load(const char* szFilePath, unsigned int textureFlags)
 		glGenVertexArrays(1, &currentChunk.m_glVAOHandle);
 
 		// Bind VAO.
-		glBindVertexArray(currentChunk.m_glVAOHandle);
+		GLState::GetInstance()->BindVertexArray(currentChunk.m_glVAOHandle);
 
 		// Bind and fill index buffer.
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, currentChunk.m_glEBOHandle);
+		GLState::GetInstance()->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, currentChunk.m_glEBOHandle);
 		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * shape.mesh.indices.size(), shape.mesh.indices.data(), GL_STATIC_DRAW);
 
 		// Append chunk indices to the whole mesh index array.
@@ -160,7 +164,7 @@ void Mesh::Load(const char* szFilePath, unsigned int textureFlags)
 		CalculateTangents(vertices, shape.mesh.indices);
 
 		// Bind and fill vertex buffer...
-		glBindBuffer(GL_ARRAY_BUFFER, currentChunk.m_glVBOHandle);
+		GLState::GetInstance()->BindBuffer(GL_ARRAY_BUFFER, currentChunk.m_glVBOHandle);
 		glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * vertices.size(), vertices.data(), GL_STATIC_DRAW);
 
 		// Vertex attributes...
@@ -182,9 +186,9 @@ void Mesh::Load(const char* szFilePath, unsigned int textureFlags)
 		glEnableVertexAttribArray(3);
 
 		// Unbind buffers and VAO
-		glBindVertexArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		GLState::GetInstance()->BindVertexArray(0);
+		GLState::GetInstance()->BindBuffer(GL_ARRAY_BUFFER, 0);
+		GLState::GetInstance()->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 	}
 
 	// Calculate tangents for whole mesh...
@@ -192,14 +196,14 @@ void Mesh::Load(const char* szFilePath, unsigned int textureFlags)
 
 	// Fill whole mesh buffers...
 
-	glBindVertexArray(m_glVAOHandle);
+	GLState::GetInstance()->BindVertexArray(m_glVAOHandle);
 
 	// Bind and fill index buffer...
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_glEBOHandle);
+	GLState::GetInstance()->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_glEBOHandle);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * wholeMeshIndices.size(), wholeMeshIndices.data(), GL_STATIC_DRAW);
 
 	// Bind and fill VBO...
-	glBindBuffer(GL_ARRAY_BUFFER, m_glVBOHandle);
+	GLState::GetInstance()->BindBuffer(GL_ARRAY_BUFFER, m_glVBOHandle);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * wholeMeshVertices.size(), wholeMeshVertices.data(), GL_STATIC_DRAW);
 
 	// Vertex attributes...
@@ -220,57 +224,59 @@ void Mesh::Load(const char* szFilePath, unsigned int textureFlags)
 	glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 14, (void*)(sizeof(float) * 12));
 	glEnableVertexAttribArray(3);
 
-	// Bind instance buffer to VAO...
-	glBindBuffer(GL_ARRAY_BUFFER, m_glInsHandle);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(Instance) * MAX_INSTANCE_COUNT, 0, GL_STATIC_DRAW);
-
-	// Instance Attributes...
+	// Instance attributes are read through their own binding, pointed at the buffer holding a draw's instances when it is drawn...
 
 	// Color
-	glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)0);
+	glVertexAttribFormat(4, 4, GL_FLOAT, GL_FALSE, 0);
+	glVertexAttribBinding(4, INSTANCE_VERTEX_BINDING);
 	glEnableVertexAttribArray(4);
 
-	glVertexAttribDivisor(4, 1);
-
 	// Model matrix
-	glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(sizeof(float) * 4));
+	glVertexAttribFormat(5, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 4);
+	glVertexAttribBinding(5, INSTANCE_VERTEX_BINDING);
 	glEnableVertexAttribArray(5);
 
-	glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(sizeof(float) * 8));
+	glVertexAttribFormat(6, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 8);
+	glVertexAttribBinding(6, INSTANCE_VERTEX_BINDING);
 	glEnableVertexAttribArray(6);
 
-	glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(sizeof(float) * 12));
+	glVertexAttribFormat(7, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 12);
+	glVertexAttribBinding(7, INSTANCE_VERTEX_BINDING);
 	glEnableVertexAttribArray(7);
 
-	glVertexAttribPointer(8, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(sizeof(float) * 16));
+	glVertexAttribFormat(8, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 16);
+	glVertexAttribBinding(8, INSTANCE_VERTEX_BINDING);
 	glEnableVertexAttribArray(8);
 
-	glVertexAttribDivisor(5, 1);
-	glVertexAttribDivisor(6, 1);
-	glVertexAttribDivisor(7, 1);
-	glVertexAttribDivisor(8, 1);
-
 	// Normal matrix
-	glVertexAttribPointer(9, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(sizeof(float) * 20));
+	glVertexAttribFormat(9, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 20);
+	glVertexAttribBinding(9, INSTANCE_VERTEX_BINDING);
 	glEnableVertexAttribArray(9);
-	
-	glVertexAttribPointer(10, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(sizeof(float) * 23));
+
+	glVertexAttribFormat(10, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 23);
+	glVertexAttribBinding(10, INSTANCE_VERTEX_BINDING);
 	glEnableVertexAttribArray(10);
-	
-	glVertexAttribPointer(11, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(sizeof(float) * 26));
+
+	glVertexAttribFormat(11, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 26);
+	glVertexAttribBinding(11, INSTANCE_VERTEX_BINDING);
 	glEnableVertexAttribArray(11);
-	
-	glVertexAttribDivisor(9, 1);
-	glVertexAttribDivisor(10, 1);
-	glVertexAttribDivisor(11, 1);
+
+	glVertexBindingDivisor(INSTANCE_VERTEX_BINDING, 1);
 
 	// Unbind buffers and VAO
-	glBindVertexArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	GLState::GetInstance()->BindVertexArray(0);
+	GLState::GetInstance()->BindBuffer(GL_ARRAY_BUFFER, 0);
+	GLState::GetInstance()->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
 	m_nWholeVertexCount = static_cast<unsigned int>(wholeMeshVertices.size());
 	m_nWholeIndexCount = static_cast<unsigned int>(wholeMeshIndices.size());
+
+	// Copy the whole mesh into the shared geometry pool so it can be drawn alongside other meshes, otherwise draw it from this mesh's VAO...
+	if (!GeometryPool::GetInstance()->Add(wholeMeshVertices.data(), m_nWholeVertexCount, wholeMeshIndices.data(), m_nWholeIndexCount, m_drawRange))
+		m_drawRange = { m_glVAOHandle, m_nWholeIndexCount, 0, 0, glm::vec4(0.0f), m_glVBOHandle, m_glEBOHandle };
+
+	// Bounds for instance culling.
+	m_drawRange.m_v4BoundingSphere = CalculateBoundingSphere(wholeMeshVertices);
 }
 
 //void Mesh::SetShader(Shader* shader, int nMaterialIndex) 
@@ -280,10 +286,8 @@ void Mesh::Load(const char* szFilePath, unsigned int textureFlags)
 
 void Mesh::Bind() 
 {
-	glBindVertexArray(m_glVAOHandle);
-	glBindBuffer(GL_ARRAY_BUFFER, m_glVBOHandle);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_glEBOHandle);
-	glBindBuffer(GL_ARRAY_BUFFER, m_glInsHandle);
+	// Vertex, instance and index buffers are all part of the VAO.
+	GLState::GetInstance()->BindVertexArray(m_glVAOHandle);
 }
 
 unsigned int Mesh::VBOHandle() 
@@ -301,11 +305,6 @@ unsigned int Mesh::VAOHandle()
 	return m_glVAOHandle;
 }
 
-unsigned int Mesh::InstanceHandle() 
-{
-	return m_glInsHandle;
-}
-
 unsigned int Mesh::VertexCount() 
 {
 	return m_nWholeVertexCount;
@@ -316,6 +315,16 @@ unsigned int Mesh::IndexCount()
 	return m_nWholeIndexCount;
 }
 
+const GeometryRange& Mesh::DrawRange() 
+{
+	return m_drawRange;
+}
+
+const glm::vec4& Mesh::BoundingSphere() 
+{
+	return m_drawRange.m_v4BoundingSphere;
+}
+
 void Mesh::CalculateTangents(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices) 
 {
 	// Lengyel, Eric. Computing Tangent Space Basis Vectors for an Arbitrary Mesh. Terathon Software, 2001. http://terathon.com/code/tangent.html
@@ -379,4 +388,35 @@ void Mesh::CalculateTangents(std::vector<Vertex>& vertices, std::vector<unsigned
 	}
 
 	delete[] tan1;
-}
\ No newline at end of file
+}
+
+glm::vec4 Mesh::CalculateBoundingSphere(const std::vector<Vertex>& vertices) 
+{
+	if (vertices.size() == 0)
+		return glm::vec4(0.0f, 0.0f, 0.0f, -1.0f);
+
+	// Find bounding box...
+	glm::vec3 v3Min(vertices[0].m_v4Position.x, vertices[0].m_v4Position.y, vertices[0].m_v4Position.z);
+	glm::vec3 v3Max = v3Min;
+
+	for(size_t i = 1; i < vertices.size(); ++i) 
+	{
+		glm::vec3 v3Position(vertices[i].m_v4Position.x, vertices[i].m_v4Position.y, vertices[i].m_v4Position.z);
+
+		v3Min = glm::min(v3Min, v3Position);
+		v3Max = glm::max(v3Max, v3Position);
+	}
+
+	// Radius is the distance to the furthest vertex from the center of the box.
+	glm::vec3 v3Center = (v3Min + v3Max) * 0.5f;
+	float fRadiusSqr = 0.0f;
+
+	for(size_t i = 0; i < vertices.size(); ++i) 
+	{
+		glm::vec3 v3Offset = glm::vec3(vertices[i].m_v4Position.x, vertices[i].m_v4Position.y, vertices[i].m_v4Position.z) - v3Center;
+
+		fRadiusSqr = glm::max(fRadiusSqr, glm::dot(v3Offset, v3Offset));
+	}
+
+	return glm::vec4(v3Center, glm::sqrt(fRadiusSqr));
+}
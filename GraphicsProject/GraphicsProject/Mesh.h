@@ -3,6 +3,7 @@
 
 #include "DynamicArray.h"
 #include "Vector4.h"
+#include "GeometryPool.h"
 #include <vector>
 
 class Texture;
@@ -67,12 +68,6 @@ public:
 	*/
 	unsigned int VAOHandle();
 
-	/*
-	Description: Get the handle of the instance buffer for this mesh.
-	Return Type: unsigned int
-	*/
-	unsigned int InstanceHandle();
-
 	/*
 	Description: Get the amount of vertices in the entire mesh.
 	Return Type: unsigned int
@@ -85,6 +80,18 @@ public:
 	*/
 	unsigned int IndexCount();
 
+	/*
+	Description: Get the location of the whole mesh for drawing, in the shared GeometryPool if it had space for the mesh and otherwise in this mesh's own buffers.
+	Return Type: const GeometryRange&
+	*/
+	const GeometryRange& DrawRange();
+
+	/*
+	Description: Get the object space bounding sphere of the whole mesh, xyz is the center and w is the radius.
+	Return Type: const vec4&
+	*/
+	const glm::vec4& BoundingSphere();
+
 	struct Vertex
 	{
 		NVZMathLib::Vector4 m_v4Position;
@@ -97,6 +104,9 @@ private:
 
 	void CalculateTangents(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
 
+	// Get a sphere enclosing all vertices, centered on their bounding box.
+	static glm::vec4 CalculateBoundingSphere(const std::vector<Vertex>& vertices);
+
 	struct Instance
 	{
 		NVZMathLib::Vector4 m_v4Color;
@@ -108,11 +118,11 @@ private:
 
 	unsigned int m_glVAOHandle;
 	unsigned int m_glVBOHandle;
-	unsigned int m_glInsHandle;
 	unsigned int m_glEBOHandle;
 
 	unsigned int m_nWholeVertexCount;
 	unsigned int m_nWholeIndexCount;
+	GeometryRange m_drawRange;
 
 	// Mesh chunks
 	struct MeshChunk 
@@ -2,7 +2,11 @@
 #include "Mesh.h"
 #include "Material.h"
 #include "Shader.h"
+#include "UploadRing.h"
+#include "InstancePool.h"
+#include "CommandBucket.h"
 #include "GLAD\glad.h"
+#include "GLState.h"
 #include "glm.hpp"
 #include "glm\include\ext.hpp"
 
@@ -12,6 +16,18 @@ MeshRenderer::MeshRenderer(Mesh* mesh, Material* material, int nMaxInstances)
 {
 	m_mesh = mesh;
 	m_nMaxInstances = nMaxInstances;
+	m_material = nullptr;
+	m_v3OriginSum = glm::vec3(0.0f);
+	m_nDirtyStart = 0;
+	m_nDirtyEnd = 0;
+
+	// Reserve room for every instance in the pool, so unchanged instances are never sent again...
+	unsigned int nPoolFirst = 0;
+
+	if (InstancePool::GetInstance() && InstancePool::GetInstance()->Reserve(static_cast<unsigned int>(m_nMaxInstances), nPoolFirst))
+		m_nPoolFirst = static_cast<int>(nPoolFirst);
+	else
+		m_nPoolFirst = -1;
 
 	SetMaterial(material);
 
@@ -28,117 +44,48 @@ MeshRenderer::MeshRenderer(Mesh* mesh, Material* material, int nMaxInstances)
 		glUniform1i(glSamplerLocation, i);
 	}
 
-	// Construct VAO for this renderer.
-
-	// Generate and bind VAO...
-	glGenVertexArrays(1, &m_glVAOHandle);
-	glBindVertexArray(m_glVAOHandle);
-
-	// Bind Index buffer to this VAO...
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_mesh->IndexBufferHandle());
-
-	// Bind vertex buffer to this VAO...
-	glBindBuffer(GL_ARRAY_BUFFER, m_mesh->VBOHandle());
-
-	// Vertex attributes...
-
-	// Positions
-	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 14, (void*)0);
-	glEnableVertexAttribArray(0);
-
-	// Normals
-	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 14, (void*)(sizeof(float) * 4));
-	glEnableVertexAttribArray(1);
-
-	// Tangents
-	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 14, (void*)(sizeof(float) * 8));
-	glEnableVertexAttribArray(2);
-
-	// Texture Coordinates
-	glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 14, (void*)(sizeof(float) * 12));
-	glEnableVertexAttribArray(3);
-
-	// Generate and bind instance buffer...
-	glGenBuffers(1, &m_glInsHandle);
-	glBindBuffer(GL_ARRAY_BUFFER, m_glInsHandle);
-
-	// Fill with empty single instance data.
-	glBufferData(GL_ARRAY_BUFFER, sizeof(Instance) * 1, 0, GL_DYNAMIC_DRAW);
-
-	// Instance attributes...
-
-	// Color
-	glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)0);
-	glEnableVertexAttribArray(4);
-
-	glVertexAttribDivisor(4, 1);
-
-	// Model matrix
-	glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(sizeof(float) * 4));
-	glEnableVertexAttribArray(5);
-
-	glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(sizeof(float) * 8));
-	glEnableVertexAttribArray(6);
-
-	glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(sizeof(float) * 12));
-	glEnableVertexAttribArray(7);
-
-	glVertexAttribPointer(8, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(sizeof(float) * 16));
-	glEnableVertexAttribArray(8);
-
-	glVertexAttribDivisor(5, 1);
-	glVertexAttribDivisor(6, 1);
-	glVertexAttribDivisor(7, 1);
-	glVertexAttribDivisor(8, 1);
-
-	// Normal matrix
-	glVertexAttribPointer(9, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(sizeof(float) * 20));
-	glEnableVertexAttribArray(9);
-
-	glVertexAttribPointer(10, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(sizeof(float) * 23));
-	glEnableVertexAttribArray(10);
-
-	glVertexAttribPointer(11, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(sizeof(float) * 26));
-	glEnableVertexAttribArray(11);
-
-	glVertexAttribDivisor(9, 1);
-	glVertexAttribDivisor(10, 1);
-	glVertexAttribDivisor(11, 1);
-
-	glBindVertexArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	// Geometry and instance attributes come from the mesh's draw range, shared with every other renderer of the mesh.
 }
 
 MeshRenderer::~MeshRenderer() 
 {
-	glDeleteBuffers(1, &m_glInsHandle);
-	glDeleteVertexArrays(1, &m_glVAOHandle);
-
 	if(m_material)
 	    m_material->GetMeshes().PopAt(m_nMaterialIndex);
+
+	if (m_nPoolFirst >= 0 && InstancePool::GetInstance())
+		InstancePool::GetInstance()->Release(static_cast<unsigned int>(m_nPoolFirst), static_cast<unsigned int>(m_nMaxInstances));
 }
 
-void MeshRenderer::Draw() 
+void MeshRenderer::Draw(CommandBucket* bucket) 
 {
-	// Material should be bound externally.
+	if (m_instances.Count() == 0)
+		return;
 
-	// Bind buffers.
-	glBindVertexArray(m_glVAOHandle);
-	glBindBuffer(GL_ARRAY_BUFFER, m_mesh->VBOHandle());
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_mesh->IndexBufferHandle());
-	glBindBuffer(GL_ARRAY_BUFFER, m_glInsHandle);
+	// Sort by the center of the instances, they are drawn together so one depth stands for all of them...
+	float fViewDepth = bucket->ViewDepth(m_v3OriginSum / static_cast<float>(m_instances.Count()));
+
+	if(m_nPoolFirst >= 0)
+	{
+		InstancePool* instancePool = InstancePool::GetInstance();
+
+		// Send only the instances changed since the last draw, they stay marked if the upload ring is full...
+		if(m_nDirtyStart < m_nDirtyEnd && instancePool->Update(static_cast<unsigned int>(m_nPoolFirst + m_nDirtyStart), &m_instances[m_nDirtyStart], static_cast<unsigned int>(m_nDirtyEnd - m_nDirtyStart)))
+		{
+			m_nDirtyStart = 0;
+			m_nDirtyEnd = 0;
+		}
+
+		bucket->AddDraw(DRAW_PASS_OPAQUE, m_material, m_mesh->DrawRange(), m_instances.Count(), static_cast<unsigned int>(m_nPoolFirst), fViewDepth, instancePool->Handle());
+		return;
+	}
 
-	// Update mesh instance buffer...
-	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(Instance) * m_instances.Count(), m_instances.Data());
+	// Without a pool, copy instances into the upload ring, aligned so their offset is a whole number of instances...
+	unsigned int nOffset = 0;
 
-	// Draw...
-	glDrawElementsInstanced(GL_TRIANGLES, m_mesh->IndexCount(), GL_UNSIGNED_INT, 0, m_instances.Count());
+	if (!UploadRing::GetInstance()->Upload(m_instances.Data(), sizeof(Instance) * m_instances.Count(), sizeof(Instance), nOffset))
+		return;
 
-	// Unbind buffers...
-	glBindVertexArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	bucket->AddDraw(DRAW_PASS_OPAQUE, m_material, m_mesh->DrawRange(), m_instances.Count(), nOffset / sizeof(Instance), fViewDepth);
 }
 
 int MeshRenderer::AddInstance() 
@@ -149,19 +96,14 @@ int MeshRenderer::AddInstance()
 	if (nInstanceCount >= m_nMaxInstances)
 		return -1;
 
+	// New instances start at the origin until they are updated.
 	Instance newInstance;
-
-	int nSize = m_instances.GetSize();
+	memset(newInstance.m_modelMat, 0, sizeof(newInstance.m_modelMat));
+	memset(newInstance.m_normalMat, 0, sizeof(newInstance.m_normalMat));
 
 	m_instances.Push(newInstance);
 
-	// Resize instance buffer if the new instance count exceeds the buffer size...
-	if (nSize < nInstanceCount + 1)
-	{
-		glBindBuffer(GL_ARRAY_BUFFER, m_glInsHandle);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(Instance) * m_instances.Count(), 0, GL_DYNAMIC_DRAW);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-	}
+	MarkDirty(nInstanceCount, nInstanceCount + 1);
 
 	return nInstanceCount;
 }
@@ -170,6 +112,10 @@ void MeshRenderer::UpdateInstance(const int& nIndex, float* modelMatrix)
 {
 	Instance& selectedInstance = m_instances[nIndex];
 
+	// Move the instance's origin within the sum...
+	m_v3OriginSum += glm::vec3(modelMatrix[12], modelMatrix[13], modelMatrix[14]) - 
+		glm::vec3(selectedInstance.m_modelMat[12], selectedInstance.m_modelMat[13], selectedInstance.m_modelMat[14]);
+
 	// Copy model matrix.
 	memcpy_s(selectedInstance.m_modelMat, sizeof(float) * 16, modelMatrix, sizeof(float) * 16);
 
@@ -183,12 +129,18 @@ void MeshRenderer::UpdateInstance(const int& nIndex, float* modelMatrix)
 
 	// Copy normal matrix into instance...
 	memcpy_s(selectedInstance.m_normalMat, sizeof(float) * 9, &normalMat, sizeof(float) * 9);
+
+	MarkDirty(nIndex, nIndex + 1);
 }
 
 void MeshRenderer::UpdateInstance(const int& nIndex, float* modelMatrix, const NVZMathLib::Vector4& v4Color) 
 {
 	Instance& selectedInstance = m_instances[nIndex];
 
+	// Move the instance's origin within the sum...
+	m_v3OriginSum += glm::vec3(modelMatrix[12], modelMatrix[13], modelMatrix[14]) - 
+		glm::vec3(selectedInstance.m_modelMat[12], selectedInstance.m_modelMat[13], selectedInstance.m_modelMat[14]);
+
 	// Copy color.
 	selectedInstance.m_v4Color = v4Color;
 
@@ -205,11 +157,19 @@ void MeshRenderer::UpdateInstance(const int& nIndex, float* modelMatrix, const N
 
 	// Copy normal matrix into instance...
 	memcpy_s(selectedInstance.m_normalMat, sizeof(float) * 9, &normalMat, sizeof(float) * 9);
+
+	MarkDirty(nIndex, nIndex + 1);
 }
 
 void MeshRenderer::RemoveInstance(const int& nIndex) 
 {
+	const float* modelMatrix = m_instances[nIndex].m_modelMat;
+	m_v3OriginSum -= glm::vec3(modelMatrix[12], modelMatrix[13], modelMatrix[14]);
+
 	m_instances.PopAt(nIndex);
+
+	// Every following instance moved down one.
+	MarkDirty(nIndex, m_instances.Count());
 }
 
 void MeshRenderer::SetMaterial(Material* material) 
@@ -228,4 +188,21 @@ void MeshRenderer::SetMaterial(Material* material)
 	}
 	else
 		m_nMaterialIndex = 0;
+}
+
+void MeshRenderer::MarkDirty(int nStart, int nEnd)
+{
+	if (nStart >= nEnd)
+		return;
+
+	if(m_nDirtyStart >= m_nDirtyEnd)
+	{
+		m_nDirtyStart = nStart;
+		m_nDirtyEnd = nEnd;
+	}
+	else
+	{
+		m_nDirtyStart = glm::min(m_nDirtyStart, nStart);
+		m_nDirtyEnd = glm::max(m_nDirtyEnd, nEnd);
+	}
 }
\ No newline at end of file
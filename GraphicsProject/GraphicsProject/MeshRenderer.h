@@ -1,9 +1,11 @@
 #pragma once
 #include "Vector4.h"
 #include "DynamicArray.h"
+#include "glm.hpp"
 
 class Mesh;
 class Material;
+class CommandBucket;
 
 class MeshRenderer 
 {
@@ -13,7 +15,12 @@ public:
 
 	virtual ~MeshRenderer();
 
-	virtual void Draw();
+	/*
+	Description: Send the instances changed since the last draw and add a draw of all instances to a command bucket, sorted by the depth of their center.
+	Param:
+	    CommandBucket* bucket: The bucket to add the draw to.
+	*/
+	virtual void Draw(CommandBucket* bucket);
 
 	/*
 	Description: Add a new mesh instance to be renderered with this renderer's material, returns an index used for accessing the instance for modification.
@@ -62,10 +69,17 @@ private:
 		float m_normalMat[9];
 	};
 
-	unsigned int m_glVAOHandle;
-	unsigned int m_glInsHandle;
+
+	// Mark instances to be sent to the InstancePool with the next draw.
+	void MarkDirty(int nStart, int nEnd);
 
 	DynamicArray<Instance> m_instances;
+	glm::vec3 m_v3OriginSum; // Sum of the instance origins, their center gives the draw's depth.
+
+	// Instances are kept in the InstancePool from the first reserved instance, or sent to the UploadRing each frame if there is no pool.
+	int m_nPoolFirst;
+	int m_nDirtyStart;
+	int m_nDirtyEnd;
 
 	Mesh* m_mesh;
 	Material* m_material;
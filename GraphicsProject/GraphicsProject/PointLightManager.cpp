@@ -0,0 +1,379 @@
+#include "PointLightManager.h"
+#include <iostream>
+#include <cstring>
+#include <xmmintrin.h>
+
+#include "glad/glad.h"
+#include "GLState.h"
+#include "UploadRing.h"
+
+static_assert(LIGHT_UPLOAD_BLOCK_COUNT <= 64, "Dirty light blocks must fit within a 64-bit mask.");
+static_assert(MAX_LIGHT_COUNT < 0xFFFF, "Light slot indices must fit within 16 bits.");
+
+// Dense index of slots not currently holding a light.
+#define FREE_LIGHT_SLOT 0xFFFF
+
+PointLightManager::PointLightManager()
+{
+	m_nCount = 0;
+	m_nDirtyBlocks = 0;
+
+	// Culling reads whole groups of four lights, so lights past the end must hold defined values.
+	memset(m_fPositionX, 0, sizeof(m_fPositionX));
+	memset(m_fPositionY, 0, sizeof(m_fPositionY));
+	memset(m_fPositionZ, 0, sizeof(m_fPositionZ));
+	memset(m_fRadius, 0, sizeof(m_fRadius));
+
+	// Fill free list in reverse so the lowest slots are used first.
+	m_nFreeSlotCount = MAX_LIGHT_COUNT;
+
+	for(int i = 0; i < MAX_LIGHT_COUNT; ++i)
+	{
+		m_slotGenerations[i] = 1;
+		m_slotToDense[i] = FREE_LIGHT_SLOT;
+		m_freeSlots[i] = static_cast<unsigned short>(MAX_LIGHT_COUNT - 1 - i);
+	}
+
+	// Allocate GPU light buffer...
+	glGenBuffers(1, &m_glLightBufferHandle);
+	GLState::GetInstance()->BindBuffer(GL_ARRAY_BUFFER, m_glLightBufferHandle);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(GPULight) * MAX_LIGHT_COUNT, nullptr, GL_DYNAMIC_DRAW);
+	GLState::GetInstance()->BindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+PointLightManager::~PointLightManager()
+{
+	GLState::GetInstance()->DeleteBuffers(1, &m_glLightBufferHandle);
+}
+
+PointLightHandle PointLightManager::Add(const glm::vec3& v3Color, const glm::vec3& v3Position, float fRadius)
+{
+	if (m_nFreeSlotCount == 0)
+	{
+		std::cout << "Point light limit of " << MAX_LIGHT_COUNT << " reached, light not added." << std::endl;
+		return INVALID_POINT_LIGHT_HANDLE;
+	}
+
+	// Take a free slot and point it at the end of the dense arrays...
+	unsigned short nSlot = m_freeSlots[--m_nFreeSlotCount];
+	int nDenseIndex = m_nCount++;
+
+	m_slotToDense[nSlot] = static_cast<unsigned short>(nDenseIndex);
+	m_denseToSlot[nDenseIndex] = nSlot;
+
+	m_fPositionX[nDenseIndex] = v3Position.x;
+	m_fPositionY[nDenseIndex] = v3Position.y;
+	m_fPositionZ[nDenseIndex] = v3Position.z;
+	m_fRadius[nDenseIndex] = fRadius;
+	m_fColorR[nDenseIndex] = v3Color.r;
+	m_fColorG[nDenseIndex] = v3Color.g;
+	m_fColorB[nDenseIndex] = v3Color.b;
+
+	MarkDirty(nDenseIndex);
+
+	return (static_cast<unsigned int>(m_slotGenerations[nSlot]) << 16) | nSlot;
+}
+
+void PointLightManager::Remove(PointLightHandle handle)
+{
+	int nDenseIndex = DenseIndex(handle);
+
+	if (nDenseIndex < 0)
+		return;
+
+	unsigned short nSlot = static_cast<unsigned short>(handle & 0xFFFF);
+	int nLastIndex = --m_nCount;
+
+	// Fill the gap with the last light to keep the arrays tightly packed...
+	if(nDenseIndex != nLastIndex)
+	{
+		m_fPositionX[nDenseIndex] = m_fPositionX[nLastIndex];
+		m_fPositionY[nDenseIndex] = m_fPositionY[nLastIndex];
+		m_fPositionZ[nDenseIndex] = m_fPositionZ[nLastIndex];
+		m_fRadius[nDenseIndex] = m_fRadius[nLastIndex];
+		m_fColorR[nDenseIndex] = m_fColorR[nLastIndex];
+		m_fColorG[nDenseIndex] = m_fColorG[nLastIndex];
+		m_fColorB[nDenseIndex] = m_fColorB[nLastIndex];
+
+		unsigned short nMovedSlot = m_denseToSlot[nLastIndex];
+		m_slotToDense[nMovedSlot] = static_cast<unsigned short>(nDenseIndex);
+		m_denseToSlot[nDenseIndex] = nMovedSlot;
+
+		MarkDirty(nDenseIndex);
+	}
+
+	// Invalidate existing handles to the slot, skipping generation zero so no handle equals INVALID_POINT_LIGHT_HANDLE.
+	if (++m_slotGenerations[nSlot] == 0)
+		m_slotGenerations[nSlot] = 1;
+
+	m_slotToDense[nSlot] = FREE_LIGHT_SLOT;
+	m_freeSlots[m_nFreeSlotCount++] = nSlot;
+}
+
+bool PointLightManager::IsValid(PointLightHandle handle) const
+{
+	return DenseIndex(handle) >= 0;
+}
+
+void PointLightManager::SetTransform(PointLightHandle handle, const glm::vec3& v3Position, float fRadius)
+{
+	int nDenseIndex = DenseIndex(handle);
+
+	if (nDenseIndex < 0)
+		return;
+
+	m_fPositionX[nDenseIndex] = v3Position.x;
+	m_fPositionY[nDenseIndex] = v3Position.y;
+	m_fPositionZ[nDenseIndex] = v3Position.z;
+	m_fRadius[nDenseIndex] = fRadius;
+
+	MarkDirty(nDenseIndex);
+}
+
+void PointLightManager::SetPosition(PointLightHandle handle, const glm::vec3& v3Position)
+{
+	int nDenseIndex = DenseIndex(handle);
+
+	if (nDenseIndex < 0)
+		return;
+
+	m_fPositionX[nDenseIndex] = v3Position.x;
+	m_fPositionY[nDenseIndex] = v3Position.y;
+	m_fPositionZ[nDenseIndex] = v3Position.z;
+
+	MarkDirty(nDenseIndex);
+}
+
+void PointLightManager::SetColor(PointLightHandle handle, const glm::vec3& v3Color)
+{
+	int nDenseIndex = DenseIndex(handle);
+
+	if (nDenseIndex < 0)
+		return;
+
+	m_fColorR[nDenseIndex] = v3Color.r;
+	m_fColorG[nDenseIndex] = v3Color.g;
+	m_fColorB[nDenseIndex] = v3Color.b;
+
+	MarkDirty(nDenseIndex);
+}
+
+void PointLightManager::SetTransforms(const PointLightHandle* handles, const glm::vec3* positions, const float* radii, int nCount)
+{
+	for (int i = 0; i < nCount; ++i)
+		SetTransform(handles[i], positions[i], radii[i]);
+}
+
+void PointLightManager::SetPositions(const PointLightHandle* handles, const glm::vec3* positions, int nCount)
+{
+	for (int i = 0; i < nCount; ++i)
+		SetPosition(handles[i], positions[i]);
+}
+
+void PointLightManager::Translate(const PointLightHandle* handles, int nCount, const glm::vec3& v3Offset)
+{
+	for(int i = 0; i < nCount; ++i)
+	{
+		int nDenseIndex = DenseIndex(handles[i]);
+
+		if (nDenseIndex < 0)
+			continue;
+
+		m_fPositionX[nDenseIndex] += v3Offset.x;
+		m_fPositionY[nDenseIndex] += v3Offset.y;
+		m_fPositionZ[nDenseIndex] += v3Offset.z;
+
+		MarkDirty(nDenseIndex);
+	}
+}
+
+void PointLightManager::SetColors(const PointLightHandle* handles, const glm::vec3* colors, int nCount)
+{
+	for (int i = 0; i < nCount; ++i)
+		SetColor(handles[i], colors[i]);
+}
+
+void PointLightManager::Upload()
+{
+	if (!m_nDirtyBlocks)
+		return;
+
+	UploadRing* uploadRing = UploadRing::GetInstance();
+
+	// Lights are staged in the upload ring and copied on the GPU, so the light buffer is never written while it may be in use.
+	GLState::GetInstance()->BindBuffer(GL_COPY_WRITE_BUFFER, m_glLightBufferHandle);
+
+	int nBlock = 0;
+
+	while(nBlock < LIGHT_UPLOAD_BLOCK_COUNT)
+	{
+		// Skip clean blocks...
+		if(!(m_nDirtyBlocks & (1ull << nBlock)))
+		{
+			++nBlock;
+			continue;
+		}
+
+		// Find the end of this run of dirty blocks...
+		int nRunEnd = nBlock;
+		unsigned long long nRunMask = 0;
+
+		while (nRunEnd < LIGHT_UPLOAD_BLOCK_COUNT && (m_nDirtyBlocks & (1ull << nRunEnd)))
+			nRunMask |= 1ull << nRunEnd++;
+
+		// Lights past the end of the dense arrays are never read, so there is no need to send them.
+		int nStart = nBlock * LIGHT_UPLOAD_BLOCK_SIZE;
+		int nEnd = nRunEnd * LIGHT_UPLOAD_BLOCK_SIZE;
+
+		if (nEnd > m_nCount)
+			nEnd = m_nCount;
+
+		if(nStart < nEnd)
+		{
+			unsigned int nSize = sizeof(GPULight) * (nEnd - nStart);
+			unsigned int nOffset = 0;
+
+			GPULight* stagedLights = static_cast<GPULight*>(uploadRing->Allocate(nSize, sizeof(GPULight), nOffset));
+
+			// Leave the run dirty and try again next frame if the ring is full.
+			if(!stagedLights) 
+			{
+				nBlock = nRunEnd;
+				continue;
+			}
+
+			// Pack run into the GPU layout...
+			for(int i = nStart; i < nEnd; ++i)
+			{
+				stagedLights[i - nStart].m_v4PositionRadius = glm::vec4(m_fPositionX[i], m_fPositionY[i], m_fPositionZ[i], m_fRadius[i]);
+				stagedLights[i - nStart].m_v4Color = glm::vec4(m_fColorR[i], m_fColorG[i], m_fColorB[i], 1.0f);
+			}
+
+			// The ring's buffer changes if it grows, so it is bound after staging.
+			GLState::GetInstance()->BindBuffer(GL_COPY_READ_BUFFER, uploadRing->Handle());
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, nOffset, sizeof(GPULight) * nStart, nSize);
+		}
+
+		m_nDirtyBlocks &= ~nRunMask;
+		nBlock = nRunEnd;
+	}
+
+	GLState::GetInstance()->BindBuffer(GL_COPY_READ_BUFFER, 0);
+	GLState::GetInstance()->BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+int PointLightManager::CullSpheres(const glm::mat4& viewProjection, unsigned int* visibleIndices) const
+{
+	// Extract frustum planes from the rows of the view projection matrix. (Gribb & Hartmann)
+	glm::vec4 v4Row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+	glm::vec4 v4Row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+	glm::vec4 v4Row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+	glm::vec4 v4Row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+	glm::vec4 planes[6] = 
+	{
+		v4Row3 + v4Row0, // Left
+		v4Row3 - v4Row0, // Right
+		v4Row3 + v4Row1, // Bottom
+		v4Row3 - v4Row1, // Top
+		v4Row3 + v4Row2, // Near
+		v4Row3 - v4Row2  // Far
+	};
+
+	// Normalize planes so distances are in world units and broadcast each component across four lanes.
+	__m128 planeX[6];
+	__m128 planeY[6];
+	__m128 planeZ[6];
+	__m128 planeW[6];
+
+	for(int i = 0; i < 6; ++i) 
+	{
+		glm::vec4 v4Plane = planes[i] / glm::length(glm::vec3(planes[i]));
+
+		planeX[i] = _mm_set1_ps(v4Plane.x);
+		planeY[i] = _mm_set1_ps(v4Plane.y);
+		planeZ[i] = _mm_set1_ps(v4Plane.z);
+		planeW[i] = _mm_set1_ps(v4Plane.w);
+	}
+
+	const __m128 zero = _mm_setzero_ps();
+	int nVisibleCount = 0;
+
+	for(int i = 0; i < m_nCount; i += 4) 
+	{
+		__m128 x = _mm_loadu_ps(&m_fPositionX[i]);
+		__m128 y = _mm_loadu_ps(&m_fPositionY[i]);
+		__m128 z = _mm_loadu_ps(&m_fPositionZ[i]);
+		__m128 negRadius = _mm_sub_ps(zero, _mm_loadu_ps(&m_fRadius[i]));
+
+		// A sphere is visible when it is not entirely behind any plane.
+		__m128 inside = _mm_cmpeq_ps(zero, zero);
+
+		for(int p = 0; p < 6; ++p) 
+		{
+			__m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], x), _mm_mul_ps(planeY[p], y)), _mm_add_ps(_mm_mul_ps(planeZ[p], z), planeW[p]));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(dist, negRadius));
+		}
+
+		int nMask = _mm_movemask_ps(inside);
+
+		// Ignore lanes past the last light.
+		if (m_nCount - i < 4)
+			nMask &= (1 << (m_nCount - i)) - 1;
+
+		// Compact visible lanes without branching on visibility.
+		for(int nLane = 0; nLane < 4; ++nLane) 
+		{
+			visibleIndices[nVisibleCount] = i + nLane;
+			nVisibleCount += (nMask >> nLane) & 1;
+		}
+	}
+
+	return nVisibleCount;
+}
+
+int PointLightManager::Count() const
+{
+	return m_nCount;
+}
+
+unsigned int PointLightManager::BufferHandle() const
+{
+	return m_glLightBufferHandle;
+}
+
+const float* PointLightManager::PositionsX() const
+{
+	return m_fPositionX;
+}
+
+const float* PointLightManager::PositionsY() const
+{
+	return m_fPositionY;
+}
+
+const float* PointLightManager::PositionsZ() const
+{
+	return m_fPositionZ;
+}
+
+const float* PointLightManager::Radii() const
+{
+	return m_fRadius;
+}
+
+int PointLightManager::DenseIndex(PointLightHandle handle) const
+{
+	unsigned int nSlot = handle & 0xFFFF;
+	unsigned int nGeneration = handle >> 16;
+
+	if (nSlot >= MAX_LIGHT_COUNT || m_slotGenerations[nSlot] != nGeneration || m_slotToDense[nSlot] == FREE_LIGHT_SLOT)
+		return -1;
+
+	return m_slotToDense[nSlot];
+}
+
+void PointLightManager::MarkDirty(int nDenseIndex)
+{
+	m_nDirtyBlocks |= 1ull << (nDenseIndex / LIGHT_UPLOAD_BLOCK_SIZE);
+}
@@ -0,0 +1,182 @@
+#pragma once
+#include "glm.hpp"
+
+#define MAX_LIGHT_COUNT 4096
+
+// Lights per dirty tracking block, the GPU light buffer is updated in runs of whole dirty blocks.
+#define LIGHT_UPLOAD_BLOCK_SIZE 64
+#define LIGHT_UPLOAD_BLOCK_COUNT (MAX_LIGHT_COUNT / LIGHT_UPLOAD_BLOCK_SIZE)
+
+// Handles store the slot index in the low 16 bits and the slot generation in the high 16 bits.
+typedef unsigned int PointLightHandle;
+
+#define INVALID_POINT_LIGHT_HANDLE 0
+
+/*
+Owns all point lights in the scene. Lights are tightly packed in structure of arrays storage and referenced
+through generational handles which remain valid until the light they refer to is removed.
+The GPU copy of the lights is only updated where lights have changed since the last upload, staged through the UploadRing.
+*/
+class PointLightManager
+{
+public:
+
+	PointLightManager();
+
+	~PointLightManager();
+
+	/*
+	Description: Add a light to the scene.
+	Return Type: PointLightHandle
+	Param:
+	    const vec3& v3Color: The color of the light.
+		const vec3& v3Position: The worldspace position of the light.
+		float fRadius: The effective radius of the light.
+	*/
+	PointLightHandle Add(const glm::vec3& v3Color, const glm::vec3& v3Position, float fRadius);
+
+	/*
+	Description: Remove a light from the scene, the handle and any copies of it become invalid.
+	Param:
+	    PointLightHandle handle: Handle of the light to remove.
+	*/
+	void Remove(PointLightHandle handle);
+
+	/*
+	Description: Whether or not the handle refers to a light that has not been removed.
+	Return Type: bool
+	Param:
+	    PointLightHandle handle: The handle to check.
+	*/
+	bool IsValid(PointLightHandle handle) const;
+
+	/*
+	Description: Set the position and radius of a light.
+	Param:
+	    PointLightHandle handle: Handle of the light to modify.
+		const vec3& v3Position: The new worldspace position of the light.
+		float fRadius: The new radius of the light.
+	*/
+	void SetTransform(PointLightHandle handle, const glm::vec3& v3Position, float fRadius);
+
+	/*
+	Description: Set the position of a light.
+	Param:
+	    PointLightHandle handle: Handle of the light to modify.
+		const vec3& v3Position: The new worldspace position of the light.
+	*/
+	void SetPosition(PointLightHandle handle, const glm::vec3& v3Position);
+
+	/*
+	Description: Set the color of a light.
+	Param:
+	    PointLightHandle handle: Handle of the light to modify.
+		const vec3& v3Color: The new color of the light.
+	*/
+	void SetColor(PointLightHandle handle, const glm::vec3& v3Color);
+
+	/*
+	Description: Set the positions and radii of many lights at once.
+	Param:
+	    const PointLightHandle* handles: Handles of the lights to modify.
+		const vec3* positions: New worldspace positions, one per handle.
+		const float* radii: New radii, one per handle.
+		int nCount: The amount of handles, positions and radii.
+	*/
+	void SetTransforms(const PointLightHandle* handles, const glm::vec3* positions, const float* radii, int nCount);
+
+	/*
+	Description: Set the positions of many lights at once.
+	Param:
+	    const PointLightHandle* handles: Handles of the lights to modify.
+		const vec3* positions: New worldspace positions, one per handle.
+		int nCount: The amount of handles and positions.
+	*/
+	void SetPositions(const PointLightHandle* handles, const glm::vec3* positions, int nCount);
+
+	/*
+	Description: Move many lights by the same offset.
+	Param:
+	    const PointLightHandle* handles: Handles of the lights to move.
+		int nCount: The amount of handles.
+		const vec3& v3Offset: The worldspace offset to move each light by.
+	*/
+	void Translate(const PointLightHandle* handles, int nCount, const glm::vec3& v3Offset);
+
+	/*
+	Description: Set the colors of many lights at once.
+	Param:
+	    const PointLightHandle* handles: Handles of the lights to modify.
+		const vec3* colors: New colors, one per handle.
+		int nCount: The amount of handles and colors.
+	*/
+	void SetColors(const PointLightHandle* handles, const glm::vec3* colors, int nCount);
+
+	/*
+	Description: Send all lights modified since the last upload to the GPU light buffer. Must be called between UploadRing frames.
+	*/
+	void Upload();
+
+	/*
+	Description: Test every light's sphere against the view frustum, four lights at a time.
+	Return Type: int
+	Param:
+	    const mat4& viewProjection: The combined projection and view matrices of the camera.
+		unsigned int* visibleIndices: Output array of at least Count() elements rounded up to a multiple of four, filled with the indices of visible lights.
+	*/
+	int CullSpheres(const glm::mat4& viewProjection, unsigned int* visibleIndices) const;
+
+	/*
+	Description: Get the amount of lights in the scene.
+	Return Type: int
+	*/
+	int Count() const;
+
+	/*
+	Description: Get the OpenGL handle of the GPU light buffer, laid out as an array of GPULight.
+	Return Type: unsigned int
+	*/
+	unsigned int BufferHandle() const;
+
+	// Tightly packed light data, valid from index 0 to Count() - 1.
+	const float* PositionsX() const;
+	const float* PositionsY() const;
+	const float* PositionsZ() const;
+	const float* Radii() const;
+
+	// Light data as laid out in the GPU light buffer.
+	struct GPULight
+	{
+		glm::vec4 m_v4PositionRadius;
+		glm::vec4 m_v4Color;
+	};
+
+private:
+
+	// Get the dense index of the light referred to by the handle, or -1 if the handle is invalid.
+	int DenseIndex(PointLightHandle handle) const;
+
+	// Flag the block containing the dense index for upload.
+	void MarkDirty(int nDenseIndex);
+
+	// Light data
+	float m_fPositionX[MAX_LIGHT_COUNT];
+	float m_fPositionY[MAX_LIGHT_COUNT];
+	float m_fPositionZ[MAX_LIGHT_COUNT];
+	float m_fRadius[MAX_LIGHT_COUNT];
+	float m_fColorR[MAX_LIGHT_COUNT];
+	float m_fColorG[MAX_LIGHT_COUNT];
+	float m_fColorB[MAX_LIGHT_COUNT];
+	int m_nCount;
+
+	// Handle slots
+	unsigned short m_slotGenerations[MAX_LIGHT_COUNT];
+	unsigned short m_slotToDense[MAX_LIGHT_COUNT];
+	unsigned short m_denseToSlot[MAX_LIGHT_COUNT];
+	unsigned short m_freeSlots[MAX_LIGHT_COUNT];
+	int m_nFreeSlotCount;
+
+	// GPU light buffer
+	unsigned long long m_nDirtyBlocks;
+	unsigned int m_glLightBufferHandle;
+};
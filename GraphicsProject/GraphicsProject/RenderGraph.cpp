@@ -0,0 +1,641 @@
+#include "RenderGraph.h"
+#include "glad\glad.h"
+#include "GLState.h"
+#include "Texture.h"
+#include "GPUProfiler.h"
+#include "CPUProfiler.h"
+#include <iostream>
+
+// ------------------------------------------------------------------------------------
+// Pass
+
+RenderGraphPass::RenderGraphPass(const char* szName, RenderGraphExecuteFunc execute)
+{
+	m_szName = szName;
+	m_execute = execute;
+
+	m_nWriteCount = 0;
+	m_depthStencil = INVALID_RENDER_GRAPH_RESOURCE;
+	m_bClearDepthStencil = false;
+	m_bWritesBackbuffer = false;
+	m_bWritesExternal = false;
+
+	m_bLive = false;
+	m_glFramebufferHandle = 0;
+	m_nViewportWidth = 0;
+	m_nViewportHeight = 0;
+}
+
+void RenderGraphPass::Read(RenderGraphResource resource)
+{
+	m_reads.Push(resource);
+}
+
+void RenderGraphPass::Write(RenderGraphResource resource, bool bClear)
+{
+	if (m_nWriteCount >= MAX_COLOR_ATTACHMENT_COUNT)
+	{
+		std::cout << "Render Graph Error: Pass " << m_szName << " exceeds the maximum color attachment count." << std::endl;
+		return;
+	}
+
+	m_writes[m_nWriteCount] = resource;
+	m_bClearWrites[m_nWriteCount] = bClear;
+	++m_nWriteCount;
+}
+
+void RenderGraphPass::WriteDepthStencil(RenderGraphResource resource, bool bClear)
+{
+	m_depthStencil = resource;
+	m_bClearDepthStencil = bClear;
+}
+
+void RenderGraphPass::WriteBackbuffer()
+{
+	m_bWritesBackbuffer = true;
+}
+
+void RenderGraphPass::WriteExternal()
+{
+	m_bWritesExternal = true;
+}
+
+Texture** RenderGraphPass::ReadTextures()
+{
+	return &m_readTextures[0];
+}
+
+int RenderGraphPass::ReadCount()
+{
+	return m_readTextures.Count();
+}
+
+const char* RenderGraphPass::Name() const
+{
+	return m_szName;
+}
+
+// ------------------------------------------------------------------------------------
+// Graph
+
+RenderGraph::RenderGraph(int nWidth, int nHeight)
+{
+	m_nWidth = nWidth;
+	m_nHeight = nHeight;
+	m_nBackbufferWidth = nWidth;
+	m_nBackbufferHeight = nHeight;
+	m_glBackbufferHandle = 0;
+	m_nLivePassCount = 0;
+	m_nElidedBindCount = 0;
+	m_bCompiled = false;
+}
+
+RenderGraph::~RenderGraph()
+{
+	Release();
+
+	for (int i = 0; i < m_passes.Count(); ++i)
+		delete m_passes[i];
+}
+
+RenderGraphResource RenderGraph::CreateTexture(const char* szName, EAttachmentFormat eFormat, float fScale)
+{
+	Resource resource;
+	resource.m_szName = szName;
+	resource.m_eFormat = eFormat;
+	resource.m_fScale = fScale;
+	resource.m_nFirstPass = -1;
+	resource.m_nLastPass = -1;
+	resource.m_nTexture = -1;
+
+	m_resources.Push(resource);
+
+	return m_resources.Count() - 1;
+}
+
+RenderGraphPass* RenderGraph::AddPass(const char* szName, RenderGraphExecuteFunc execute)
+{
+	RenderGraphPass* pass = new RenderGraphPass(szName, execute);
+
+	m_passes.Push(pass);
+
+	return pass;
+}
+
+void RenderGraph::Compile()
+{
+	Release();
+
+	int nResourceCount = m_resources.Count();
+
+	// Cull passes...
+	// Walk backwards from the backbuffer, a pass is live if a later live pass needs the contents of anything it writes.
+	bool* bNeeded = new bool[nResourceCount > 0 ? nResourceCount : 1];
+
+	for (int i = 0; i < nResourceCount; ++i)
+		bNeeded[i] = false;
+
+	for(int i = m_passes.Count() - 1; i >= 0; --i)
+	{
+		RenderGraphPass* pass = m_passes[i];
+
+		pass->m_bLive = pass->m_bWritesBackbuffer || pass->m_bWritesExternal;
+
+		for (int j = 0; j < pass->m_nWriteCount; ++j)
+			pass->m_bLive |= bNeeded[pass->m_writes[j]];
+
+		if (pass->m_depthStencil != INVALID_RENDER_GRAPH_RESOURCE)
+			pass->m_bLive |= bNeeded[pass->m_depthStencil];
+
+		if (!pass->m_bLive)
+			continue;
+
+		// Cleared attachments are fully replaced, earlier writers are not needed for them. Loaded attachments keep the previous contents.
+		for (int j = 0; j < pass->m_nWriteCount; ++j)
+			bNeeded[pass->m_writes[j]] = !pass->m_bClearWrites[j];
+
+		if (pass->m_depthStencil != INVALID_RENDER_GRAPH_RESOURCE)
+			bNeeded[pass->m_depthStencil] = !pass->m_bClearDepthStencil;
+
+		for (int j = 0; j < pass->m_reads.Count(); ++j)
+			bNeeded[pass->m_reads[j]] = true;
+	}
+
+	delete[] bNeeded;
+
+	// Find the first and last live pass using each resource...
+	m_nLivePassCount = 0;
+
+	for(int i = 0; i < m_passes.Count(); ++i)
+	{
+		RenderGraphPass* pass = m_passes[i];
+
+		if (!pass->m_bLive)
+			continue;
+
+		++m_nLivePassCount;
+
+		ForEachUse(pass, [&](RenderGraphResource resource)
+		{
+			Resource& res = m_resources[resource];
+
+			if (res.m_nFirstPass < 0)
+				res.m_nFirstPass = i;
+
+			res.m_nLastPass = i;
+		});
+	}
+
+	// Allocate textures...
+	// Resources take a texture at their first use and return it after their last, so later resources with the same format and size reuse it.
+	for(int i = 0; i < m_passes.Count(); ++i)
+	{
+		RenderGraphPass* pass = m_passes[i];
+
+		if (!pass->m_bLive)
+			continue;
+
+		ForEachUse(pass, [&](RenderGraphResource resource)
+		{
+			Resource& res = m_resources[resource];
+
+			if (res.m_nFirstPass == i && res.m_nTexture < 0)
+				res.m_nTexture = AcquireTexture(res);
+		});
+
+		ForEachUse(pass, [&](RenderGraphResource resource)
+		{
+			Resource& res = m_resources[resource];
+			AllocatedTexture& texture = m_textures[res.m_nTexture];
+
+			if (res.m_nLastPass == i && texture.m_bInUse)
+			{
+				texture.m_bInUse = false;
+				pass->m_glDeadTextures.Push(texture.m_glHandle);
+			}
+		});
+
+		// Framebuffer and viewport...
+		if(pass->m_bWritesBackbuffer)
+		{
+			if (pass->m_nWriteCount > 0 || pass->m_depthStencil != INVALID_RENDER_GRAPH_RESOURCE)
+				std::cout << "Render Graph Error: Pass " << pass->m_szName << " writes both the backbuffer and textures, textures are ignored." << std::endl;
+
+			pass->m_glFramebufferHandle = m_glBackbufferHandle;
+			pass->m_nViewportWidth = m_nBackbufferWidth;
+			pass->m_nViewportHeight = m_nBackbufferHeight;
+		}
+		else if(pass->m_nWriteCount == 0 && pass->m_depthStencil == INVALID_RENDER_GRAPH_RESOURCE)
+		{
+			// Nothing to attach, the pass only writes resources outside the graph.
+			pass->m_glFramebufferHandle = m_glBackbufferHandle;
+			pass->m_nViewportWidth = m_nBackbufferWidth;
+			pass->m_nViewportHeight = m_nBackbufferHeight;
+		}
+		else
+		{
+			pass->m_glFramebufferHandle = AcquireFramebuffer(pass);
+
+			RenderGraphResource sizeResource = pass->m_nWriteCount > 0 ? pass->m_writes[0] : pass->m_depthStencil;
+			ScaledSize(m_resources[sizeResource].m_fScale, pass->m_nViewportWidth, pass->m_nViewportHeight);
+		}
+	}
+
+	UpdateReadTextures();
+
+	m_bCompiled = true;
+
+	// Report savings from aliasing...
+	unsigned int nUnaliasedMemory = 0;
+	int nUsedResourceCount = 0;
+
+	for(int i = 0; i < nResourceCount; ++i)
+	{
+		if (m_resources[i].m_nTexture < 0)
+			continue;
+
+		int nWidth = 0;
+		int nHeight = 0;
+		ScaledSize(m_resources[i].m_fScale, nWidth, nHeight);
+
+		nUnaliasedMemory += nWidth * nHeight * Framebuffer::AttachmentPixelSize(m_resources[i].m_eFormat);
+		++nUsedResourceCount;
+	}
+
+	std::cout << "Render graph compiled: " << m_nLivePassCount << " of " << m_passes.Count() << " passes live, "
+		<< nUsedResourceCount << " textures aliased onto " << m_textures.Count() << " allocations ("
+		<< AllocatedTextureMemory() / (1024 * 1024) << "MB instead of " << nUnaliasedMemory / (1024 * 1024) << "MB)." << std::endl;
+}
+
+void RenderGraph::Execute()
+{
+	CPU_PROFILE_ZONE("RenderGraph::Execute");
+
+	if(!m_bCompiled)
+	{
+		std::cout << "Render Graph Error: Execute called before Compile." << std::endl;
+		return;
+	}
+
+	const float fClearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	const unsigned int nClearInteger[4] = { 0, 0, 0, 0 };
+
+	// No framebuffer is assumed to be bound at the start of the frame, with the viewport covering the backbuffer.
+	unsigned int glBoundFramebuffer = 0xFFFFFFFF;
+	int nViewportWidth = m_nBackbufferWidth;
+	int nViewportHeight = m_nBackbufferHeight;
+
+	m_nElidedBindCount = 0;
+
+	for(int i = 0; i < m_passes.Count(); ++i)
+	{
+		RenderGraphPass* pass = m_passes[i];
+
+		if (!pass->m_bLive)
+			continue;
+
+		// Bind framebuffer, consecutive passes rendering to the same attachments share one...
+		if (pass->m_glFramebufferHandle != glBoundFramebuffer)
+		{
+			glBindFramebuffer(GL_FRAMEBUFFER, pass->m_glFramebufferHandle);
+			glBoundFramebuffer = pass->m_glFramebufferHandle;
+		}
+		else
+			++m_nElidedBindCount;
+
+		if(pass->m_nViewportWidth != nViewportWidth || pass->m_nViewportHeight != nViewportHeight)
+		{
+			glViewport(0, 0, pass->m_nViewportWidth, pass->m_nViewportHeight);
+
+			nViewportWidth = pass->m_nViewportWidth;
+			nViewportHeight = pass->m_nViewportHeight;
+		}
+
+		// Time the pass along with its clears.
+		CPUProfileZone passZone(pass->m_szName);
+		GPUProfiler::GetInstance()->BeginScope(pass->m_szName);
+
+		// Clear only the attachments that request it...
+		for(int j = 0; j < pass->m_nWriteCount; ++j)
+		{
+			if (!pass->m_bClearWrites[j])
+				continue;
+
+			// Float clears of integer attachments are undefined.
+			if (m_resources[pass->m_writes[j]].m_eFormat == BUFFER_UINT_R32 || m_resources[pass->m_writes[j]].m_eFormat == BUFFER_UINT_RG32)
+				glClearBufferuiv(GL_COLOR, j, nClearInteger);
+			else
+				glClearBufferfv(GL_COLOR, j, fClearColor);
+		}
+
+		if (pass->m_depthStencil != INVALID_RENDER_GRAPH_RESOURCE && pass->m_bClearDepthStencil)
+			glClearBufferfi(GL_DEPTH_STENCIL, 0, 1.0f, 0);
+
+		// Record pass...
+		pass->m_execute(*this, *pass);
+
+		// Discard the contents of textures no later pass reads, the next resource aliasing them overwrites them anyway.
+		for (int j = 0; j < pass->m_glDeadTextures.Count(); ++j)
+			glInvalidateTexImage(pass->m_glDeadTextures[j], 0);
+
+		GPUProfiler::GetInstance()->EndScope();
+	}
+
+	// Restore full backbuffer viewport.
+	if (nViewportWidth != m_nBackbufferWidth || nViewportHeight != m_nBackbufferHeight)
+		glViewport(0, 0, m_nBackbufferWidth, m_nBackbufferHeight);
+}
+
+void RenderGraph::Resize(int nWidth, int nHeight)
+{
+	m_nWidth = nWidth;
+	m_nHeight = nHeight;
+
+	if (!m_bCompiled)
+		return;
+
+	// Reallocate texture storage, framebuffers remain valid as the texture handles do not change...
+	for(int i = 0; i < m_textures.Count(); ++i)
+	{
+		AllocatedTexture& texture = m_textures[i];
+
+		int nTexWidth = 0;
+		int nTexHeight = 0;
+		ScaledSize(texture.m_fScale, nTexWidth, nTexHeight);
+
+		GLState::GetInstance()->BindTexture(GL_TEXTURE_2D, texture.m_glHandle);
+		Framebuffer::AllocateAttachmentStorage(texture.m_eFormat, nTexWidth, nTexHeight);
+
+		delete texture.m_texture;
+		texture.m_texture = new Texture(texture.m_glHandle, nTexWidth, nTexHeight);
+	}
+
+	GLState::GetInstance()->BindTexture(GL_TEXTURE_2D, 0);
+
+	UpdateViewports();
+	UpdateReadTextures();
+}
+
+void RenderGraph::SetBackbufferSize(int nWidth, int nHeight)
+{
+	m_nBackbufferWidth = nWidth;
+	m_nBackbufferHeight = nHeight;
+
+	if (m_bCompiled)
+		UpdateViewports();
+}
+
+void RenderGraph::SetBackbuffer(unsigned int glFramebufferHandle)
+{
+	m_glBackbufferHandle = glFramebufferHandle;
+
+	if (!m_bCompiled)
+		return;
+
+	// Passes without attachments of their own render to the backbuffer...
+	for(int i = 0; i < m_passes.Count(); ++i)
+	{
+		RenderGraphPass* pass = m_passes[i];
+
+		if (pass->m_bLive && (pass->m_bWritesBackbuffer || (pass->m_nWriteCount == 0 && pass->m_depthStencil == INVALID_RENDER_GRAPH_RESOURCE)))
+			pass->m_glFramebufferHandle = m_glBackbufferHandle;
+	}
+}
+
+Texture* RenderGraph::GetTexture(RenderGraphResource resource)
+{
+	int nTexture = m_resources[resource].m_nTexture;
+
+	if (nTexture < 0)
+		return nullptr;
+
+	return m_textures[nTexture].m_texture;
+}
+
+int RenderGraph::LivePassCount() const
+{
+	return m_nLivePassCount;
+}
+
+int RenderGraph::AllocatedTextureCount() const
+{
+	return m_textures.Count();
+}
+
+unsigned int RenderGraph::AllocatedTextureMemory() const
+{
+	unsigned int nMemory = 0;
+
+	for(int i = 0; i < m_textures.Count(); ++i)
+	{
+		int nWidth = 0;
+		int nHeight = 0;
+		ScaledSize(m_textures[i].m_fScale, nWidth, nHeight);
+
+		nMemory += nWidth * nHeight * Framebuffer::AttachmentPixelSize(m_textures[i].m_eFormat);
+	}
+
+	return nMemory;
+}
+
+int RenderGraph::ElidedBindCount() const
+{
+	return m_nElidedBindCount;
+}
+
+void RenderGraph::Release()
+{
+	for(int i = 0; i < m_framebuffers.Count(); ++i)
+		glDeleteFramebuffers(1, &m_framebuffers[i].m_glHandle);
+
+	for(int i = 0; i < m_textures.Count(); ++i)
+	{
+		delete m_textures[i].m_texture;
+		GLState::GetInstance()->DeleteTextures(1, &m_textures[i].m_glHandle);
+	}
+
+	m_framebuffers.Clear();
+	m_textures.Clear();
+
+	for(int i = 0; i < m_resources.Count(); ++i)
+	{
+		m_resources[i].m_nFirstPass = -1;
+		m_resources[i].m_nLastPass = -1;
+		m_resources[i].m_nTexture = -1;
+	}
+
+	for(int i = 0; i < m_passes.Count(); ++i)
+	{
+		m_passes[i]->m_bLive = false;
+		m_passes[i]->m_glFramebufferHandle = 0;
+		m_passes[i]->m_readTextures.Clear();
+		m_passes[i]->m_glDeadTextures.Clear();
+	}
+
+	m_nLivePassCount = 0;
+	m_bCompiled = false;
+}
+
+void RenderGraph::ForEachUse(RenderGraphPass* pass, const std::function<void(RenderGraphResource)>& func)
+{
+	for (int i = 0; i < pass->m_reads.Count(); ++i)
+		func(pass->m_reads[i]);
+
+	for (int i = 0; i < pass->m_nWriteCount; ++i)
+		func(pass->m_writes[i]);
+
+	if (pass->m_depthStencil != INVALID_RENDER_GRAPH_RESOURCE)
+		func(pass->m_depthStencil);
+}
+
+int RenderGraph::AcquireTexture(const Resource& resource)
+{
+	// Reuse a texture released by an earlier resource...
+	for(int i = 0; i < m_textures.Count(); ++i)
+	{
+		AllocatedTexture& texture = m_textures[i];
+
+		if(!texture.m_bInUse && texture.m_eFormat == resource.m_eFormat && texture.m_fScale == resource.m_fScale)
+		{
+			texture.m_bInUse = true;
+			return i;
+		}
+	}
+
+	// Otherwise allocate a new one.
+	AllocatedTexture texture;
+	texture.m_eFormat = resource.m_eFormat;
+	texture.m_fScale = resource.m_fScale;
+	texture.m_bInUse = true;
+
+	int nWidth = 0;
+	int nHeight = 0;
+	ScaledSize(resource.m_fScale, nWidth, nHeight);
+
+	glGenTextures(1, &texture.m_glHandle);
+	GLState::GetInstance()->BindTexture(GL_TEXTURE_2D, texture.m_glHandle);
+
+	Framebuffer::AllocateAttachmentStorage(resource.m_eFormat, nWidth, nHeight);
+
+	// Disable texture wrapping for framebuffers.
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	// Texture filtering.
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST); // Nearest neighbour on shrink.
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST); // Nearest neighbour on expand.
+
+	GLState::GetInstance()->BindTexture(GL_TEXTURE_2D, 0);
+
+	texture.m_texture = new Texture(texture.m_glHandle, nWidth, nHeight);
+
+	m_textures.Push(texture);
+
+	return m_textures.Count() - 1;
+}
+
+unsigned int RenderGraph::AcquireFramebuffer(RenderGraphPass* pass)
+{
+	PassFramebuffer framebuffer;
+	framebuffer.m_nColorCount = pass->m_nWriteCount;
+	framebuffer.m_nDepthTexture = pass->m_depthStencil != INVALID_RENDER_GRAPH_RESOURCE ? m_resources[pass->m_depthStencil].m_nTexture : -1;
+
+	for (int i = 0; i < pass->m_nWriteCount; ++i)
+		framebuffer.m_colorTextures[i] = m_resources[pass->m_writes[i]].m_nTexture;
+
+	// Reuse a framebuffer with identical attachments...
+	for(int i = 0; i < m_framebuffers.Count(); ++i)
+	{
+		const PassFramebuffer& existing = m_framebuffers[i];
+
+		if (existing.m_nColorCount != framebuffer.m_nColorCount || existing.m_nDepthTexture != framebuffer.m_nDepthTexture)
+			continue;
+
+		bool bMatch = true;
+
+		for (int j = 0; j < framebuffer.m_nColorCount && bMatch; ++j)
+			bMatch = existing.m_colorTextures[j] == framebuffer.m_colorTextures[j];
+
+		if (bMatch)
+			return existing.m_glHandle;
+	}
+
+	// Create framebuffer...
+	glGenFramebuffers(1, &framebuffer.m_glHandle);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.m_glHandle);
+
+	unsigned int drawBuffers[MAX_COLOR_ATTACHMENT_COUNT];
+
+	for(int i = 0; i < framebuffer.m_nColorCount; ++i)
+	{
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, m_textures[framebuffer.m_colorTextures[i]].m_glHandle, 0);
+		drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+	}
+
+	if (framebuffer.m_nDepthTexture >= 0)
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, m_textures[framebuffer.m_nDepthTexture].m_glHandle, 0);
+
+	if (framebuffer.m_nColorCount > 0)
+		glDrawBuffers(framebuffer.m_nColorCount, drawBuffers);
+	else
+		glDrawBuffer(GL_NONE);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "Render Graph Error: Framebuffer for pass " << pass->m_szName << " is incomplete." << std::endl;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	m_framebuffers.Push(framebuffer);
+
+	return framebuffer.m_glHandle;
+}
+
+void RenderGraph::UpdateReadTextures()
+{
+	for(int i = 0; i < m_passes.Count(); ++i)
+	{
+		RenderGraphPass* pass = m_passes[i];
+
+		pass->m_readTextures.Clear();
+
+		if (!pass->m_bLive)
+			continue;
+
+		for (int j = 0; j < pass->m_reads.Count(); ++j)
+			pass->m_readTextures.Push(GetTexture(pass->m_reads[j]));
+	}
+}
+
+void RenderGraph::UpdateViewports()
+{
+	for(int i = 0; i < m_passes.Count(); ++i)
+	{
+		RenderGraphPass* pass = m_passes[i];
+
+		if (!pass->m_bLive)
+			continue;
+
+		if (pass->m_bWritesBackbuffer || (pass->m_nWriteCount == 0 && pass->m_depthStencil == INVALID_RENDER_GRAPH_RESOURCE))
+		{
+			pass->m_nViewportWidth = m_nBackbufferWidth;
+			pass->m_nViewportHeight = m_nBackbufferHeight;
+		}
+		else
+		{
+			RenderGraphResource sizeResource = pass->m_nWriteCount > 0 ? pass->m_writes[0] : pass->m_depthStencil;
+			ScaledSize(m_resources[sizeResource].m_fScale, pass->m_nViewportWidth, pass->m_nViewportHeight);
+		}
+	}
+}
+
+void RenderGraph::ScaledSize(float fScale, int& nWidth, int& nHeight) const
+{
+	nWidth = static_cast<int>(m_nWidth * fScale);
+	nHeight = static_cast<int>(m_nHeight * fScale);
+
+	if (nWidth < 1)
+		nWidth = 1;
+
+	if (nHeight < 1)
+		nHeight = 1;
+}
\ No newline at end of file
@@ -0,0 +1,266 @@
+#pragma once
+#include "DynamicArray.h"
+#include "FrameBuffer.h"
+#include <functional>
+
+class Texture;
+class RenderGraph;
+class RenderGraphPass;
+
+// Index of a transient texture declared with RenderGraph::CreateTexture.
+typedef int RenderGraphResource;
+
+#define INVALID_RENDER_GRAPH_RESOURCE -1
+
+// Records the pass's draw calls, called with the pass's framebuffer already bound and cleared.
+typedef std::function<void(RenderGraph& graph, RenderGraphPass& pass)> RenderGraphExecuteFunc;
+
+/*
+A single pass within a RenderGraph. Passes declare the transient textures they sample and render to,
+the graph derives pass order dependencies, texture lifetimes and framebuffers from these declarations.
+*/
+class RenderGraphPass
+{
+public:
+
+	/*
+	Description: Declare a texture sampled by this pass. Textures are bound in the order they are declared.
+	Param:
+	    RenderGraphResource resource: The texture to read.
+	*/
+	void Read(RenderGraphResource resource);
+
+	/*
+	Description: Declare a texture rendered to by this pass as the next color attachment.
+	Param:
+	    RenderGraphResource resource: The texture to write.
+		bool bClear: Whether to clear the texture before the pass executes, otherwise existing contents are kept.
+	*/
+	void Write(RenderGraphResource resource, bool bClear = false);
+
+	/*
+	Description: Declare the depth stencil texture used by this pass for depth and stencil testing.
+	Param:
+	    RenderGraphResource resource: A texture created with BUFFER_DEPTH24_STENCIL8.
+		bool bClear: Whether to clear depth and stencil before the pass executes, otherwise existing contents are kept.
+	*/
+	void WriteDepthStencil(RenderGraphResource resource, bool bClear = false);
+
+	/*
+	Description: Declare that this pass renders to the default window framebuffer. Such passes are never culled.
+	*/
+	void WriteBackbuffer();
+
+	/*
+	Description: Declare that this pass writes resources owned outside the graph, such as buffers or persistent textures. Such passes are never culled.
+	Passes without attachments, like compute passes, execute with the default framebuffer bound.
+	*/
+	void WriteExternal();
+
+	/*
+	Description: Get the textures declared with Read, in declaration order.
+	Return Type: Texture**
+	*/
+	Texture** ReadTextures();
+
+	/*
+	Description: Get the amount of textures declared with Read.
+	Return Type: int
+	*/
+	int ReadCount();
+
+	/*
+	Description: Get the name of this pass.
+	Return Type: const char*
+	*/
+	const char* Name() const;
+
+private:
+
+	friend class RenderGraph;
+
+	RenderGraphPass(const char* szName, RenderGraphExecuteFunc execute);
+
+	const char* m_szName;
+	RenderGraphExecuteFunc m_execute;
+
+	// Declarations
+	DynamicArray<RenderGraphResource> m_reads;
+	RenderGraphResource m_writes[MAX_COLOR_ATTACHMENT_COUNT];
+	bool m_bClearWrites[MAX_COLOR_ATTACHMENT_COUNT];
+	int m_nWriteCount;
+	RenderGraphResource m_depthStencil;
+	bool m_bClearDepthStencil;
+	bool m_bWritesBackbuffer;
+	bool m_bWritesExternal;
+
+	// Compiled state
+	bool m_bLive;
+	unsigned int m_glFramebufferHandle;
+	int m_nViewportWidth;
+	int m_nViewportHeight;
+	DynamicArray<Texture*> m_readTextures;
+	DynamicArray<unsigned int> m_glDeadTextures; // Textures whose contents are no longer needed after this pass.
+};
+
+/*
+Declarative frame description. Passes are added in execution order along with the transient textures they read and write,
+Compile then culls passes which do not contribute to the backbuffer and assigns transient textures whose lifetimes
+do not overlap to the same video memory. Textures are invalidated once their last reader has executed.
+*/
+class RenderGraph
+{
+public:
+
+	RenderGraph(int nWidth, int nHeight);
+
+	~RenderGraph();
+
+	/*
+	Description: Declare a transient texture, it has no storage until the graph is compiled.
+	Return Type: RenderGraphResource
+	Param:
+	    const char* szName: Debug name of the texture.
+		EAttachmentFormat eFormat: The format of the texture.
+		float fScale: Size of the texture relative to the graph's dimensions.
+	*/
+	RenderGraphResource CreateTexture(const char* szName, EAttachmentFormat eFormat, float fScale = 1.0f);
+
+	/*
+	Description: Add a pass to the end of the graph, its reads and writes are declared through the returned pass.
+	Return Type: RenderGraphPass*
+	Param:
+	    const char* szName: Debug name of the pass.
+		RenderGraphExecuteFunc execute: Function recording the pass's draw calls.
+	*/
+	RenderGraphPass* AddPass(const char* szName, RenderGraphExecuteFunc execute);
+
+	/*
+	Description: Cull unused passes, allocate aliased textures and create pass framebuffers. Must be called after all passes are added.
+	*/
+	void Compile();
+
+	/*
+	Description: Run all live passes in order.
+	*/
+	void Execute();
+
+	/*
+	Description: Reallocate all textures for new graph dimensions. Passes writing the backbuffer keep the backbuffer's dimensions,
+	so the graph can render at a lower resolution than it outputs.
+	Param:
+	    int nWidth: The new width in pixels.
+		int nHeight: The new height in pixels.
+	*/
+	void Resize(int nWidth, int nHeight);
+
+	/*
+	Description: Set the dimensions of the backbuffer, by default the dimensions the graph was created with.
+	Param:
+	    int nWidth: The width of the backbuffer in pixels.
+		int nHeight: The height of the backbuffer in pixels.
+	*/
+	void SetBackbufferSize(int nWidth, int nHeight);
+
+	/*
+	Description: Set the framebuffer passes writing the backbuffer render to, by default the window's framebuffer 0.
+	Param:
+	    unsigned int glFramebufferHandle: The OpenGL handle of the framebuffer, such as a headless renderer's offscreen backbuffer.
+	*/
+	void SetBackbuffer(unsigned int glFramebufferHandle);
+
+	/*
+	Description: Get the texture currently backing a resource, or nullptr if no live pass uses it.
+	Return Type: Texture*
+	Param:
+	    RenderGraphResource resource: The resource to get the texture of.
+	*/
+	Texture* GetTexture(RenderGraphResource resource);
+
+	/*
+	Description: Get the amount of passes which survived culling.
+	Return Type: int
+	*/
+	int LivePassCount() const;
+
+	/*
+	Description: Get the amount of textures actually allocated after aliasing.
+	Return Type: int
+	*/
+	int AllocatedTextureCount() const;
+
+	/*
+	Description: Get the approximate video memory used by allocated textures, in bytes.
+	Return Type: unsigned int
+	*/
+	unsigned int AllocatedTextureMemory() const;
+
+	/*
+	Description: Get the amount of framebuffer binds skipped during the last Execute because the framebuffer was already bound.
+	Return Type: int
+	*/
+	int ElidedBindCount() const;
+
+private:
+
+	struct Resource
+	{
+		const char* m_szName;
+		EAttachmentFormat m_eFormat;
+		float m_fScale;
+		int m_nFirstPass;
+		int m_nLastPass;
+		int m_nTexture; // Index of the allocated texture backing this resource.
+	};
+
+	struct AllocatedTexture
+	{
+		EAttachmentFormat m_eFormat;
+		float m_fScale;
+		unsigned int m_glHandle;
+		Texture* m_texture;
+		bool m_bInUse;
+	};
+
+	struct PassFramebuffer
+	{
+		int m_colorTextures[MAX_COLOR_ATTACHMENT_COUNT];
+		int m_nColorCount;
+		int m_nDepthTexture;
+		unsigned int m_glHandle;
+	};
+
+	// Delete all compiled state so the graph can be compiled again.
+	void Release();
+
+	// Call func for every resource used by the pass, attachments included.
+	void ForEachUse(RenderGraphPass* pass, const std::function<void(RenderGraphResource)>& func);
+
+	// Find or allocate an unused texture matching the resource.
+	int AcquireTexture(const Resource& resource);
+
+	// Find or create a framebuffer with the pass's attachments.
+	unsigned int AcquireFramebuffer(RenderGraphPass* pass);
+
+	// Fill each live pass's read texture array from the currently allocated textures.
+	void UpdateReadTextures();
+
+	// Set each live pass's viewport to the size of its attachments, or the backbuffer.
+	void UpdateViewports();
+
+	void ScaledSize(float fScale, int& nWidth, int& nHeight) const;
+
+	DynamicArray<RenderGraphPass*> m_passes;
+	DynamicArray<Resource> m_resources;
+	DynamicArray<AllocatedTexture> m_textures;
+	DynamicArray<PassFramebuffer> m_framebuffers;
+
+	int m_nWidth;
+	int m_nHeight;
+	int m_nBackbufferWidth;
+	int m_nBackbufferHeight;
+	unsigned int m_glBackbufferHandle;
+	int m_nLivePassCount;
+	int m_nElidedBindCount;
+	bool m_bCompiled;
+};
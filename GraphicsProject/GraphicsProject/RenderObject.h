@@ -3,6 +3,7 @@
 
 class Mesh;
 class Material;
+class CommandBucket;
 
 class RenderObject 
 {
@@ -12,7 +13,7 @@ public:
 
 	virtual ~RenderObject();
 
-	virtual void Draw() = 0;
+	virtual void Draw(CommandBucket* bucket) = 0;
 
 protected:
 
@@ -0,0 +1,627 @@
+#include "RenderPipeline.h"
+#include "Renderer.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "TemporalHistory.h"
+#include "AutoExposure.h"
+#include "ColorGradingLUT.h"
+#include "glad\glad.h"
+#include <iostream>
+#include <cstring>
+
+RenderPipeline::RenderPipeline(Renderer* renderer, RenderPipelineDrawFunc drawScene)
+{
+	m_renderer = renderer;
+	m_drawScene = drawScene;
+	m_bHiZOcclusion = true;
+	m_bTemporalAA = true;
+	m_fBloomStrength = BLOOM_STRENGTH;
+	m_nBloomLevelCount = BLOOM_LEVEL_COUNT;
+	m_fRenderScale = 1.0f;
+	m_v2Jitter = glm::vec2(0.0f);
+	m_fDeltaTime = 0.0f;
+	m_colorGradingLUT = nullptr;
+
+	// Graph textures are sampled nearest, bloom taps sample through this as does the composite when the internal resolution is lower.
+	glGenSamplers(1, &m_glLinearSampler);
+	glSamplerParameteri(m_glLinearSampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glSamplerParameteri(m_glLinearSampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glSamplerParameteri(m_glLinearSampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glSamplerParameteri(m_glLinearSampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	// Fullscreen quad shaders.
+	m_quadShader = new Shader("Shaders/quad/standard_fsquad.vs", "Shaders/quad/standard_fsquad.fs");
+	m_directionalLightShader = new Shader("Shaders/quad/standard_fsquad.vs", "Shaders/light/deferred_directional_light_pbr.fs");
+
+	// Bloom shaders, the first downsample also extracts bright colors.
+	m_bloomDownsampleShader = new Shader("Shaders/quad/standard_fsquad.vs", "Shaders/quad/bloom_downsample.fs");
+
+	Shader::SetGlobalDefine("BLOOM_PREFILTER", true);
+	m_bloomPrefilterShader = new Shader("Shaders/quad/standard_fsquad.vs", "Shaders/quad/bloom_downsample.fs");
+	Shader::SetGlobalDefine("BLOOM_PREFILTER", false);
+
+	m_bloomUpsampleShader = new Shader("Shaders/quad/standard_fsquad.vs", "Shaders/quad/bloom_upsample.fs");
+
+	// Temporal anti-aliasing shaders.
+	m_velocityShader = new Shader("Shaders/quad/standard_fsquad.vs", "Shaders/quad/velocity.fs");
+	m_temporalResolveShader = new Shader("Shaders/quad/standard_fsquad.vs", "Shaders/quad/temporal_resolve.fs");
+
+	m_temporalResolveShader->Use();
+	m_temporalResolveShader->SetUniformFloat("feedback", TEMPORAL_FEEDBACK);
+
+	// Auto exposure shaders.
+	m_luminanceHistogramShader = new Shader("Shaders/luminance_histogram.comp");
+	m_exposureAdaptShader = new Shader("Shaders/exposure_adapt.comp");
+
+	// Final pass shaders, combining bloom, exposure, gamma and optionally color grading in one pass.
+	m_postShader = new Shader("Shaders/quad/standard_fsquad.vs", "Shaders/quad/post_uber.fs");
+
+	Shader::SetGlobalDefine("COLOR_GRADING", true);
+	m_postGradedShader = new Shader("Shaders/quad/standard_fsquad.vs", "Shaders/quad/post_uber.fs");
+	Shader::SetGlobalDefine("COLOR_GRADING", false);
+
+	// Bloom uniform variables
+	SetBloomStrength(m_fBloomStrength);
+
+	m_pointLightShader = new Shader("Shaders/light/deferred_point_light_pbr.vs", "Shaders/light/deferred_point_light_pbr.fs");
+	m_lightStencilShader = new Shader("Shaders/light/light_volume_stencil.vs", "Shaders/light/light_volume_stencil.fs");
+
+	// Clustered lighting shaders.
+	m_clusterAssignShader = new Shader("Shaders/light/cluster_assign.comp");
+	m_clusteredLightShader = new Shader("Shaders/quad/standard_fsquad.vs", "Shaders/light/deferred_clustered_light_pbr.fs");
+
+	// GPU instance culling shader.
+	m_instanceCullShader = new Shader("Shaders/instance_cull.comp");
+
+	// Hi-Z occlusion culling shaders.
+	m_hiZDownsampleShader = new Shader("Shaders/hiz_downsample.comp");
+	m_lightOcclusionShader = new Shader("Shaders/light/light_occlusion_cull.comp");
+
+	// Set shaders used for deferred shading pass.
+	m_renderer->SetDLightShader(m_directionalLightShader);
+	m_renderer->SetPLightShader(m_pointLightShader);
+	m_renderer->SetLightStencilShader(m_lightStencilShader);
+	m_renderer->SetClusteredLightShaders(m_clusterAssignShader, m_clusteredLightShader);
+	m_renderer->SetInstanceCullShader(m_instanceCullShader);
+	m_renderer->SetHiZShaders(m_hiZDownsampleShader, m_lightOcclusionShader);
+
+	// Scene draws write only triangle IDs and depth, materials are evaluated once per pixel when resolving them.
+	bool bVisibility = m_renderer->GetGBufferLayout() == GBUFFER_LAYOUT_VISIBILITY;
+
+	m_visibilityShader = nullptr;
+	m_visibilityResolveShader = nullptr;
+
+	if(bVisibility)
+	{
+		m_visibilityShader = new Shader("Shaders/visibility.vs", "Shaders/visibility.fs");
+		m_visibilityResolveShader = new Shader("Shaders/quad/standard_fsquad.vs", "Shaders/quad/visibility_resolve.fs");
+	}
+
+	m_renderer->SetVisibilityShaders(m_visibilityShader, m_visibilityResolveShader);
+
+	// History is accumulated at the backbuffer's resolution regardless of the render scale.
+	m_temporalHistory = new TemporalHistory(m_renderer->WindowWidth(), m_renderer->WindowHeight());
+
+	m_autoExposure = new AutoExposure();
+
+	// ------------------------------------------------------------------------------------
+	// Frame graph
+
+	m_graph = nullptr;
+	BuildGraph();
+
+	UpdateJitter();
+}
+
+void RenderPipeline::BuildGraph()
+{
+	delete m_graph;
+
+	// The graph renders at the internal resolution and outputs at the backbuffer's.
+	int nWidth = 0;
+	int nHeight = 0;
+	RenderSize(nWidth, nHeight);
+
+	m_graph = new RenderGraph(nWidth, nHeight);
+	m_graph->SetBackbufferSize(m_renderer->WindowWidth(), m_renderer->WindowHeight());
+	m_graph->SetBackbuffer(m_renderer->BackbufferHandle());
+
+	bool bVisibility = m_renderer->GetGBufferLayout() == GBUFFER_LAYOUT_VISIBILITY;
+
+	// G-buffer textures, in the order scene shaders write them and lighting shaders read them.
+	const char* gBufferNames[MAX_COLOR_ATTACHMENT_COUNT];
+	EAttachmentFormat gBufferFormats[MAX_COLOR_ATTACHMENT_COUNT];
+	int nGBufferTextureCount = 0;
+
+	if(m_renderer->GetGBufferLayout() != GBUFFER_LAYOUT_WIDE) 
+	{
+		// Position is rebuilt from the depth copy, the depth stencil can't be sampled while lights stencil test against it.
+		const char* compactNames[] = { "Albedo, roughness", "Normal", "Specular, reflection coefficient", "Emission", "Depth" };
+		EAttachmentFormat compactFormats[] = { BUFFER_RGBA, BUFFER_FLOAT_RG16, BUFFER_RGBA, BUFFER_RGB, BUFFER_FLOAT_R32 };
+
+		nGBufferTextureCount = sizeof(compactFormats) / sizeof(EAttachmentFormat);
+		memcpy(gBufferNames, compactNames, sizeof(compactNames));
+		memcpy(gBufferFormats, compactFormats, sizeof(compactFormats));
+	}
+	else
+	{
+		const char* wideNames[] = { "Diffuse", "Position", "Normal", "Specular", "Roughness, spec strength, reflection coefficent", "Emission" };
+		EAttachmentFormat wideFormats[] = { BUFFER_FLOAT_RGBA16, BUFFER_FLOAT_RGBA16, BUFFER_FLOAT_RGBA16, BUFFER_FLOAT_RGBA16, BUFFER_RGB, BUFFER_RGB };
+
+		nGBufferTextureCount = sizeof(wideFormats) / sizeof(EAttachmentFormat);
+		memcpy(gBufferNames, wideNames, sizeof(wideNames));
+		memcpy(gBufferFormats, wideFormats, sizeof(wideFormats));
+	}
+
+	RenderGraphResource gBufferTextures[MAX_COLOR_ATTACHMENT_COUNT];
+	int nGBufferPixelSize = 0;
+
+	for (int i = 0; i < nGBufferTextureCount; ++i) 
+	{
+		gBufferTextures[i] = m_graph->CreateTexture(gBufferNames[i], gBufferFormats[i]);
+		nGBufferPixelSize += Framebuffer::AttachmentPixelSize(gBufferFormats[i]);
+	}
+
+	const char* szLayoutNames[] = { "wide", "compact", "visibility" };
+
+	std::cout << "G-buffer: " << nGBufferTextureCount << " targets, " << nGBufferPixelSize << " bytes per pixel (" 
+		<< szLayoutNames[m_renderer->GetGBufferLayout()] << " layout)" << std::endl;
+
+	RenderGraphResource depthStencil = m_graph->CreateTexture("Depth stencil", BUFFER_DEPTH24_STENCIL8);
+	RenderGraphResource hdrColor = m_graph->CreateTexture("HDR color", BUFFER_FLOAT_RGB16);
+
+	if(bVisibility)
+	{
+		// Rasterize the slot and triangle of every pixel, a single shader draws every VAO's geometry in one run.
+		RenderGraphResource visibilityIDs = m_graph->CreateTexture("Visibility", BUFFER_UINT_RG32);
+
+		RenderGraphPass* visibilityPass = m_graph->AddPass("Visibility", [this](RenderGraph& graph, RenderGraphPass& pass)
+		{
+			m_drawScene(m_renderer->GetCommandBucket());
+			m_renderer->DrawFinal();
+		});
+
+		visibilityPass->Write(visibilityIDs, true);
+		visibilityPass->WriteDepthStencil(depthStencil, true);
+
+		// Fetch each pixel's triangle, interpolate its attributes and write the G-buffer without overdraw.
+		RenderGraphPass* resolvePass = m_graph->AddPass("Visibility resolve", [this](RenderGraph& graph, RenderGraphPass& pass)
+		{
+			m_renderer->ResolveVisibility(pass.ReadTextures(), pass.ReadCount());
+		});
+
+		resolvePass->Read(visibilityIDs);
+		resolvePass->Read(depthStencil);
+
+		for (int i = 0; i < nGBufferTextureCount; ++i)
+			resolvePass->Write(gBufferTextures[i], true);
+
+		// Draws the visibility buffer couldn't give IDs are drawn with their materials over the resolved pixels, depth tested against the visibility pass.
+		RenderGraphPass* fallbackPass = m_graph->AddPass("Visibility fallback", [this](RenderGraph& graph, RenderGraphPass& pass)
+		{
+			m_renderer->DrawVisibilityFallback();
+		});
+
+		for (int i = 0; i < nGBufferTextureCount; ++i)
+			fallbackPass->Write(gBufferTextures[i]);
+
+		fallbackPass->WriteDepthStencil(depthStencil);
+	}
+	else
+	{
+		// Draw scene geometry into the G-buffer.
+		RenderGraphPass* gBufferPass = m_graph->AddPass("G-buffer", [this](RenderGraph& graph, RenderGraphPass& pass)
+		{
+			m_drawScene(m_renderer->GetCommandBucket());
+			m_renderer->DrawFinal();
+		});
+
+		for (int i = 0; i < nGBufferTextureCount; ++i)
+			gBufferPass->Write(gBufferTextures[i], true);
+
+		gBufferPass->WriteDepthStencil(depthStencil, true);
+	}
+
+	// Reduce depth into the Hi-Z pyramid, light volumes are occlusion culled against it this frame and scene instances next frame.
+	RenderGraphPass* hiZPass = m_graph->AddPass("Hi-Z", [this](RenderGraph& graph, RenderGraphPass& pass)
+	{
+		m_renderer->BuildHiZ(pass.ReadTextures()[0]);
+	});
+
+	hiZPass->Read(depthStencil);
+	hiZPass->WriteExternal();
+
+	// Deferred shading, the G-buffer depth stencil is attached for stencil masked light volumes.
+	RenderGraphPass* lightingPass = m_graph->AddPass("Lighting", [this](RenderGraph& graph, RenderGraphPass& pass)
+	{
+		// Draw fullscreen quad...
+		m_renderer->DrawFSQuad(m_quadShader, pass.ReadTextures(), pass.ReadCount());
+
+		// Uncomment this to enable the directional light.
+		//m_renderer->RunDeferredDirectionalLight(pass.ReadTextures(), pass.ReadCount(), Vector3(-1.0f, -0.5f, -1.0f).Normalised(), Vector3(1.0f));
+
+		m_renderer->ReportErrors();
+		m_renderer->RunDeferredPointLighting(pass.ReadTextures(), pass.ReadCount());
+	});
+
+	for (int i = 0; i < nGBufferTextureCount; ++i)
+		lightingPass->Read(gBufferTextures[i]);
+
+	lightingPass->Write(hdrColor);
+	lightingPass->WriteDepthStencil(depthStencil);
+
+	// Temporal anti-aliasing passes are only added while it is enabled, the graph is rebuilt when it is toggled.
+	if(m_bTemporalAA)
+	{
+		RenderGraphResource velocity = m_graph->CreateTexture("Velocity", BUFFER_FLOAT_RG16);
+
+		// Screen space motion of each pixel since last frame, reprojecting depth with this and last frame's view projection.
+		RenderGraphPass* velocityPass = m_graph->AddPass("Velocity", [this](RenderGraph& graph, RenderGraphPass& pass)
+		{
+			glm::mat4 inverseViewProjection = glm::inverse(m_renderer->ViewProjection());
+
+			m_renderer->BindFSQuad();
+
+			m_velocityShader->Use();
+			m_velocityShader->SetUniformMat4("inverseViewProjection", glm::value_ptr(inverseViewProjection));
+			m_velocityShader->SetUniformMat4("previousViewProjection", glm::value_ptr(m_renderer->PreviousViewProjection()));
+			m_velocityShader->SetUniformVec2("jitter", NVZMathLib::Vector2(m_v2Jitter.x, m_v2Jitter.y));
+
+			m_renderer->BindTextures(pass.ReadTextures(), pass.ReadCount());
+			m_renderer->DrawFSQuadNoState();
+		});
+
+		velocityPass->Read(depthStencil);
+		velocityPass->Write(velocity);
+
+		// Blend the jittered lighting result into the reprojected history, at the backbuffer's resolution.
+		RenderGraphPass* temporalResolvePass = m_graph->AddPass("Temporal resolve", [this](RenderGraph& graph, RenderGraphPass& pass)
+		{
+			// The history has the backbuffer's dimensions, which the graph has already set the viewport to for this pass.
+			glBindFramebuffer(GL_FRAMEBUFFER, m_temporalHistory->ResolveFramebuffer());
+
+			Texture* textures[] = { pass.ReadTextures()[0], pass.ReadTextures()[1], m_temporalHistory->HistoryTexture() };
+
+			m_renderer->BindFSQuad();
+
+			m_temporalResolveShader->Use();
+			m_temporalResolveShader->SetUniformVec2("jitter", NVZMathLib::Vector2(m_v2Jitter.x, m_v2Jitter.y));
+			m_temporalResolveShader->SetUniformInt("historyValid", m_temporalHistory->HistoryValid() ? 1 : 0);
+
+			m_renderer->BindTextures(textures, 3);
+			m_renderer->DrawFSQuadNoState();
+
+			// Passes without attachments are expected to leave the backbuffer bound.
+			glBindFramebuffer(GL_FRAMEBUFFER, m_renderer->BackbufferHandle());
+		});
+
+		temporalResolvePass->Read(hdrColor);
+		temporalResolvePass->Read(velocity);
+		temporalResolvePass->WriteExternal();
+	}
+
+	// Histogram the lit scene's luminance and adapt the exposure the composite tonemaps with, without reading it back.
+	RenderGraphPass* autoExposurePass = m_graph->AddPass("Auto exposure", [this](RenderGraph& graph, RenderGraphPass& pass)
+	{
+		m_autoExposure->Update(m_luminanceHistogramShader, m_exposureAdaptShader, pass.ReadTextures()[0], m_fDeltaTime);
+	});
+
+	autoExposurePass->Read(hdrColor);
+	autoExposurePass->WriteExternal();
+
+	// Bloom pyramid in a packed HDR format, bright colors are no longer clamped before they are blurred.
+	RenderGraphResource bloomLevels[BLOOM_MAX_LEVEL_COUNT];
+	float bloomScales[BLOOM_MAX_LEVEL_COUNT];
+
+	for (int i = 0; i < m_nBloomLevelCount; ++i)
+	{
+		bloomScales[i] = i > 0 ? bloomScales[i - 1] * 0.5f : 0.5f;
+		bloomLevels[i] = m_graph->CreateTexture("Bloom downsample", BUFFER_FLOAT_R11G11B10, bloomScales[i]);
+	}
+
+	// Extract bright colors for bloom while downsampling straight into the half resolution first level.
+	RenderGraphPass* prefilterPass = m_graph->AddPass("Bloom prefilter", [this](RenderGraph& graph, RenderGraphPass& pass)
+	{
+		RunBloomPass(m_bloomPrefilterShader, pass);
+	});
+
+	prefilterPass->Read(hdrColor);
+	prefilterPass->Write(bloomLevels[0]);
+
+	// Halve the bright colors down the pyramid, each level widens the blur at a quarter of the previous level's cost.
+	for(int i = 1; i < m_nBloomLevelCount; ++i)
+	{
+		RenderGraphPass* downsamplePass = m_graph->AddPass("Bloom downsample", [this](RenderGraph& graph, RenderGraphPass& pass)
+		{
+			RunBloomPass(m_bloomDownsampleShader, pass);
+		});
+
+		downsamplePass->Read(bloomLevels[i - 1]);
+		downsamplePass->Write(bloomLevels[i]);
+	}
+
+	// Blur back up, adding each level to the upsampled blur of the levels below it.
+	RenderGraphResource bloomColor = bloomLevels[m_nBloomLevelCount - 1];
+
+	for(int i = m_nBloomLevelCount - 2; i >= 0; --i)
+	{
+		RenderGraphPass* upsamplePass = m_graph->AddPass("Bloom upsample", [this](RenderGraph& graph, RenderGraphPass& pass)
+		{
+			RunBloomPass(m_bloomUpsampleShader, pass);
+		});
+
+		RenderGraphResource upsampleTarget = m_graph->CreateTexture("Bloom upsample", BUFFER_FLOAT_R11G11B10, bloomScales[i]);
+
+		upsamplePass->Read(bloomColor);
+		upsamplePass->Read(bloomLevels[i]);
+		upsamplePass->Write(upsampleTarget);
+
+		bloomColor = upsampleTarget;
+	}
+
+	// Combine bloom, expose, tonemap, gamma correct and grade into the backbuffer in a single pass, upscaling from the internal resolution unless temporally resolved, then copy G-buffer depth for forward rendering.
+	RenderGraphPass* compositePass = m_graph->AddPass("Composite", [this, depthStencil](RenderGraph& graph, RenderGraphPass& pass)
+	{
+		m_renderer->BindFSQuad();
+
+		bool bUpscale = m_fRenderScale < 1.0f;
+
+		// Bloom is always upscaled from half resolution.
+		if(bUpscale)
+			glBindSampler(0, m_glLinearSampler);
+
+		glBindSampler(1, m_glLinearSampler);
+
+		// Draw final result...
+		Texture* textures[] = { m_bTemporalAA ? m_temporalHistory->ResolvedTexture() : pass.ReadTextures()[0], pass.ReadTextures()[1] };
+
+		Shader* postShader = m_postShader;
+
+		if(m_colorGradingLUT)
+		{
+			float fLUTSize = static_cast<float>(m_colorGradingLUT->Size());
+
+			postShader = m_postGradedShader;
+			postShader->Use();
+			postShader->SetUniformVec2("lutScaleOffset", NVZMathLib::Vector2((fLUTSize - 1.0f) / fLUTSize, 0.5f / fLUTSize));
+
+			m_colorGradingLUT->BindLUT(2);
+		}
+
+		postShader->Use();
+		m_renderer->BindTextures(textures, 2);
+		m_renderer->DrawFSQuadNoState();
+
+		if(bUpscale)
+			glBindSampler(0, 0);
+
+		glBindSampler(1, 0);
+
+		// Unbind fullscreen quad.
+		m_renderer->UnbindVAO();
+
+		// Copy G Buffer's depth to the default FBO's depth texture.
+		m_renderer->UseDepthTextureOf(graph.GetTexture(depthStencil));
+		m_renderer->EnableDepthTesting();
+
+		// Forward rendered objects are drawn straight to the backbuffer and never resolved, so they must not jitter.
+		if (m_bTemporalAA)
+			m_renderer->RemoveProjectionJitter();
+	});
+
+	compositePass->Read(hdrColor);
+	compositePass->Read(bloomColor);
+	compositePass->Read(depthStencil);
+	compositePass->WriteBackbuffer();
+
+	m_graph->Compile();
+}
+
+RenderPipeline::~RenderPipeline()
+{
+	delete m_graph;
+	delete m_temporalHistory;
+	delete m_autoExposure;
+
+	glDeleteSamplers(1, &m_glLinearSampler);
+
+	delete m_quadShader;
+	delete m_postShader;
+	delete m_postGradedShader;
+	delete m_bloomPrefilterShader;
+
+	delete m_bloomDownsampleShader;
+	delete m_bloomUpsampleShader;
+
+	delete m_velocityShader;
+	delete m_temporalResolveShader;
+	delete m_luminanceHistogramShader;
+	delete m_exposureAdaptShader;
+
+	delete m_directionalLightShader;
+	delete m_pointLightShader;
+	delete m_lightStencilShader;
+	delete m_clusterAssignShader;
+	delete m_clusteredLightShader;
+	delete m_instanceCullShader;
+	delete m_hiZDownsampleShader;
+	delete m_lightOcclusionShader;
+
+	// The command bucket outlives the pipeline.
+	m_renderer->SetVisibilityShaders(nullptr, nullptr);
+
+	delete m_visibilityShader;
+	delete m_visibilityResolveShader;
+}
+
+void RenderPipeline::Execute(float fDeltaTime)
+{
+	m_fDeltaTime = fDeltaTime;
+
+	m_graph->Execute();
+
+	// This frame's result is the next frame's history, which is rendered at the next jitter phase.
+	if(m_bTemporalAA)
+	{
+		m_temporalHistory->EndFrame();
+		UpdateJitter();
+	}
+}
+
+void RenderPipeline::RunBloomPass(Shader* shader, RenderGraphPass& pass)
+{
+	m_renderer->BindFSQuad();
+
+	// Bloom kernels place their taps between texels to average four with each.
+	for (int i = 0; i < pass.ReadCount(); ++i)
+		glBindSampler(i, m_glLinearSampler);
+
+	shader->Use();
+	m_renderer->BindTextures(pass.ReadTextures(), pass.ReadCount());
+	m_renderer->DrawFSQuadNoState();
+
+	for (int i = 0; i < pass.ReadCount(); ++i)
+		glBindSampler(i, 0);
+}
+
+void RenderPipeline::SetHiZOcclusion(bool bEnabled)
+{
+	m_bHiZOcclusion = bEnabled;
+
+	if (m_bHiZOcclusion)
+		m_renderer->SetHiZShaders(m_hiZDownsampleShader, m_lightOcclusionShader);
+	else
+		m_renderer->SetHiZShaders(nullptr, nullptr);
+}
+
+void RenderPipeline::SetTemporalAA(bool bEnabled)
+{
+	if (bEnabled == m_bTemporalAA)
+		return;
+
+	m_bTemporalAA = bEnabled;
+
+	// Add or remove the velocity and temporal resolve passes, along with the textures only they use.
+	BuildGraph();
+
+	// The history stops being updated while disabled.
+	m_temporalHistory->Invalidate();
+
+	UpdateJitter();
+}
+
+bool RenderPipeline::TemporalAA() const
+{
+	return m_bTemporalAA;
+}
+
+void RenderPipeline::SetBloomStrength(float fStrength)
+{
+	m_fBloomStrength = fStrength;
+
+	m_postShader->Use();
+	m_postShader->SetUniformFloat("bloomStrength", m_fBloomStrength);
+
+	m_postGradedShader->Use();
+	m_postGradedShader->SetUniformFloat("bloomStrength", m_fBloomStrength);
+
+	Shader::ResetBinding();
+}
+
+float RenderPipeline::BloomStrength() const
+{
+	return m_fBloomStrength;
+}
+
+void RenderPipeline::SetBloomLevelCount(int nLevelCount)
+{
+	nLevelCount = glm::clamp(nLevelCount, 1, BLOOM_MAX_LEVEL_COUNT);
+
+	if (nLevelCount == m_nBloomLevelCount)
+		return;
+
+	m_nBloomLevelCount = nLevelCount;
+
+	// The pyramid's passes and textures are part of the graph.
+	BuildGraph();
+}
+
+int RenderPipeline::BloomLevelCount() const
+{
+	return m_nBloomLevelCount;
+}
+
+void RenderPipeline::SetRenderScale(float fScale)
+{
+	int nCurrentWidth = 0;
+	int nCurrentHeight = 0;
+	RenderSize(nCurrentWidth, nCurrentHeight);
+
+	m_fRenderScale = fScale;
+
+	int nWidth = 0;
+	int nHeight = 0;
+	RenderSize(nWidth, nHeight);
+
+	if (nWidth == nCurrentWidth && nHeight == nCurrentHeight)
+		return;
+
+	m_graph->Resize(nWidth, nHeight);
+
+	// The history is at the backbuffer's resolution and remains valid, only the jitter's size in pixels changes.
+	UpdateJitter();
+}
+
+float RenderPipeline::RenderScale() const
+{
+	return m_fRenderScale;
+}
+
+void RenderPipeline::SetColorGradingLUT(ColorGradingLUT* lut)
+{
+	// A table which failed to load would grade every color to black.
+	if (lut && lut->Size() == 0)
+	{
+		std::cout << "Render Pipeline Warning: Color grading LUT was not loaded, color grading is disabled." << std::endl;
+		lut = nullptr;
+	}
+
+	m_colorGradingLUT = lut;
+}
+
+ColorGradingLUT* RenderPipeline::GetColorGradingLUT() const
+{
+	return m_colorGradingLUT;
+}
+
+bool RenderPipeline::HiZOcclusion() const
+{
+	return m_bHiZOcclusion;
+}
+
+RenderGraph* RenderPipeline::GetGraph()
+{
+	return m_graph;
+}
+
+void RenderPipeline::RenderSize(int& nWidth, int& nHeight) const
+{
+	nWidth = static_cast<int>(m_renderer->WindowWidth() * m_fRenderScale + 0.5f);
+	nHeight = static_cast<int>(m_renderer->WindowHeight() * m_fRenderScale + 0.5f);
+}
+
+void RenderPipeline::UpdateJitter()
+{
+	if(m_bTemporalAA)
+	{
+		int nWidth = 0;
+		int nHeight = 0;
+		RenderSize(nWidth, nHeight);
+
+		m_v2Jitter = m_temporalHistory->Jitter(nWidth, nHeight);
+	}
+	else
+		m_v2Jitter = glm::vec2(0.0f);
+
+	m_renderer->SetProjectionJitter(m_v2Jitter.x, m_v2Jitter.y);
+}
@@ -0,0 +1,206 @@
+#pragma once
+#include "RenderGraph.h"
+#include "glm.hpp"
+#include <functional>
+
+class Renderer;
+class Shader;
+class CommandBucket;
+class TemporalHistory;
+class AutoExposure;
+class ColorGradingLUT;
+
+// Adds the scene's draws to the command bucket during the G-buffer pass, before the bucket is submitted.
+typedef std::function<void(CommandBucket* bucket)> RenderPipelineDrawFunc;
+
+// Default levels of the bloom pyramid, the first at half the render resolution and each following one half the size of the last.
+#define BLOOM_LEVEL_COUNT 5
+
+// Most levels the bloom pyramid can be set to, the last is 1/512 of the render resolution.
+#define BLOOM_MAX_LEVEL_COUNT 9
+
+// Default scale of the bloom added to the scene, added at full strength as before the pyramid.
+// The pyramid sums every level, so the glow is brighter than a single blur and one over the level count roughly matches its energy.
+#define BLOOM_STRENGTH 1.0f
+
+/*
+The deferred frame: G-buffer fill, Hi-Z build, lighting, temporal resolve, auto exposure, bloom pyramid and tonemapped composite into the renderer's backbuffer,
+described as a render graph. Shared by the application and the benchmark so both render exactly the same frame.
+Owns the shaders of its passes and hands the lighting and culling shaders to the renderer.
+*/
+class RenderPipeline
+{
+public:
+
+	/*
+	Param:
+	    Renderer* renderer: The renderer to draw with, its backbuffer is the pipeline's output.
+		RenderPipelineDrawFunc drawScene: Function adding the scene's draws to the command bucket each frame.
+	*/
+	RenderPipeline(Renderer* renderer, RenderPipelineDrawFunc drawScene);
+
+	~RenderPipeline();
+
+	/*
+	Description: Run every pass of the frame. Must be called between Renderer::Start and Renderer::End.
+	Param:
+	    float fDeltaTime: The time since the previous frame in seconds, the exposure adapts over time.
+	*/
+	void Execute(float fDeltaTime);
+
+	/*
+	Description: Enable or disable Hi-Z occlusion culling of scene instances and light volumes.
+	Param:
+	    bool bEnabled: Whether occlusion culling is enabled.
+	*/
+	void SetHiZOcclusion(bool bEnabled);
+
+	/*
+	Description: Get whether Hi-Z occlusion culling is enabled.
+	Return Type: bool
+	*/
+	bool HiZOcclusion() const;
+
+	/*
+	Description: Enable or disable temporal anti-aliasing. Jitters the projection each frame and accumulates the lit scene
+	into a history at the backbuffer's resolution, which also reconstructs detail lost to a render scale below 1.
+	Rebuilds the frame graph when changed, its velocity and temporal resolve passes only exist while enabled.
+	Param:
+	    bool bEnabled: Whether temporal anti-aliasing is enabled.
+	*/
+	void SetTemporalAA(bool bEnabled);
+
+	/*
+	Description: Get whether temporal anti-aliasing is enabled.
+	Return Type: bool
+	*/
+	bool TemporalAA() const;
+
+	/*
+	Description: Set the scale of the bloom added to the scene.
+	Param:
+	    float fStrength: The scale of the bloom, zero leaves only the scene while the bloom passes still run.
+	*/
+	void SetBloomStrength(float fStrength);
+
+	/*
+	Description: Get the scale of the bloom added to the scene.
+	Return Type: float
+	*/
+	float BloomStrength() const;
+
+	/*
+	Description: Set the amount of levels of the bloom pyramid, each level widens the glow. Rebuilds the frame graph when changed.
+	Param:
+	    int nLevelCount: The amount of levels, clamped between 1 and BLOOM_MAX_LEVEL_COUNT.
+	*/
+	void SetBloomLevelCount(int nLevelCount);
+
+	/*
+	Description: Get the amount of levels of the bloom pyramid.
+	Return Type: int
+	*/
+	int BloomLevelCount() const;
+
+	/*
+	Description: Set the resolution the scene is rendered and post processed at, relative to the renderer's backbuffer.
+	The composite upscales the result to the backbuffer. Reallocates the graph's textures if the resolution changes.
+	Param:
+	    float fScale: The scale of the width and height, 1 renders at full resolution.
+	*/
+	void SetRenderScale(float fScale);
+
+	/*
+	Description: Get the scale of the internal render resolution.
+	Return Type: float
+	*/
+	float RenderScale() const;
+
+	/*
+	Description: Set the lookup table the final pass grades the image with, the pipeline does not take ownership.
+	Param:
+	    ColorGradingLUT* lut: The lookup table, or nullptr to disable color grading.
+	*/
+	void SetColorGradingLUT(ColorGradingLUT* lut);
+
+	/*
+	Description: Get the lookup table the final pass grades the image with.
+	Return Type: ColorGradingLUT*
+	*/
+	ColorGradingLUT* GetColorGradingLUT() const;
+
+	/*
+	Description: Get the render graph of the frame.
+	Return Type: RenderGraph*
+	*/
+	RenderGraph* GetGraph();
+
+private:
+
+	// Describe and compile the frame's passes, replacing the current graph.
+	void BuildGraph();
+
+	// Size of the graph's textures at the current render scale.
+	void RenderSize(int& nWidth, int& nHeight) const;
+
+	// Pass the jitter of the next frame to the renderer, zero if temporal anti-aliasing is disabled.
+	void UpdateJitter();
+
+	// Draw a fullscreen bloom pass reading the pass's textures bilinearly.
+	void RunBloomPass(Shader* shader, RenderGraphPass& pass);
+
+	Renderer* m_renderer;
+	RenderGraph* m_graph;
+	RenderPipelineDrawFunc m_drawScene;
+
+	// Post processing shaders
+	Shader* m_quadShader;
+	Shader* m_bloomPrefilterShader;
+	Shader* m_bloomDownsampleShader;
+	Shader* m_bloomUpsampleShader;
+	Shader* m_velocityShader;
+	Shader* m_temporalResolveShader;
+	Shader* m_luminanceHistogramShader;
+	Shader* m_exposureAdaptShader;
+
+	// Final pass permutations, with and without color grading.
+	Shader* m_postShader;
+	Shader* m_postGradedShader;
+
+	// Lighting shaders
+	Shader* m_directionalLightShader;
+	Shader* m_pointLightShader;
+	Shader* m_lightStencilShader;
+	Shader* m_clusterAssignShader;
+	Shader* m_clusteredLightShader;
+
+	// Visibility buffer shaders, only created for the visibility G-buffer layout.
+	Shader* m_visibilityShader;
+	Shader* m_visibilityResolveShader;
+
+	// Culling shaders
+	Shader* m_instanceCullShader;
+	Shader* m_hiZDownsampleShader;
+	Shader* m_lightOcclusionShader;
+
+	// Bilinear sampler for the bloom pyramid's taps and for upscaling the internal resolution in the composite.
+	unsigned int m_glLinearSampler;
+
+	// Temporal anti-aliasing
+	TemporalHistory* m_temporalHistory;
+	glm::vec2 m_v2Jitter; // Projection jitter of the frame being rendered.
+	bool m_bTemporalAA;
+
+	// Bloom
+	float m_fBloomStrength;
+	int m_nBloomLevelCount;
+
+	// Eye adaptation
+	AutoExposure* m_autoExposure;
+	float m_fDeltaTime; // Time since the previous frame, for the frame being rendered.
+
+	ColorGradingLUT* m_colorGradingLUT;
+
+	float m_fRenderScale;
+	bool m_bHiZOcclusion;
+};
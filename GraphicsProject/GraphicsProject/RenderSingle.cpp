@@ -1,7 +1,10 @@
 #include "RenderSingle.h"
 #include "glad\glad.h"
+#include "GLState.h"
 #include "Material.h"
 #include "Mesh.h"
+#include "UploadRing.h"
+#include "CommandBucket.h"
 #include "glm.hpp"
 
 RenderSingle::RenderSingle(Mesh* mesh, Material* material) : RenderObject(mesh, material) 
@@ -14,24 +17,15 @@ RenderSingle::~RenderSingle()
 	
 }
 
-void RenderSingle::Draw() 
+void RenderSingle::Draw(CommandBucket* bucket) 
 {
-	// Bind material...
-	m_material->Use();
+	// Copy instance into the upload ring...
+	unsigned int nOffset = 0;
 
-	// Bind mesh...
-	m_mesh->Bind();
+	if (!UploadRing::GetInstance()->Upload(&m_instance, sizeof(Instance), sizeof(Instance), nOffset))
+		return;
 
-	// Update single instance buffer.
-	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(Instance), &m_instance);
-
-	// Draw...
-	glDrawElements(GL_TRIANGLES, m_mesh->IndexCount(), GL_UNSIGNED_INT, 0);
-
-	// Unbind buffers...
-	glBindVertexArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	bucket->AddDraw(DRAW_PASS_OPAQUE, m_material, m_mesh->DrawRange(), 1, nOffset / sizeof(Instance), bucket->ViewDepth(m_instance.m_modelMat));
 }
 
 void RenderSingle::UpdateObject(float* modelMatrix, NVZMathLib::Vector4 v4Color) 
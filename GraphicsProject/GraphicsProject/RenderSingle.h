@@ -9,7 +9,7 @@ public:
 
 	virtual ~RenderSingle();
 
-	void Draw() override;
+	void Draw(CommandBucket* bucket) override;
 
 	void UpdateObject(float* modelMatrix, NVZMathLib::Vector4 v4Color = { 1.0f, 1.0f, 1.0f, 1.0f });
 
@@ -2,23 +2,48 @@
 #include <iostream>
 
 #include "glad/glad.h"
+#include "GLState.h"
 #include "glfw3.h"
 #include "Mesh.h"
 #include "Batch.h"
 #include "Texture.h"
 #include "Shader.h"
 #include "FrameBuffer.h"
+#include "UploadRing.h"
+#include "GeometryPool.h"
+#include "InstancePool.h"
+#include "CommandBucket.h"
+#include "HiZBuffer.h"
+#include "MaterialTable.h"
+#include "TextureStreamer.h"
+#include "HeadlessContext.h"
+#include "GPUProfiler.h"
+#include "CPUProfiler.h"
 #include "glm.hpp"
+#include <vector>
+#include <map>
+#include <fstream>
 
 using namespace NVZMathLib;
 
+// Layout of a glDrawElementsIndirect command, one is written per light volume when occlusion culling lights.
+struct LightVolumeCommand
+{
+	unsigned int m_nCount;
+	unsigned int m_nInstanceCount;
+	unsigned int m_nFirstIndex;
+	int m_nBaseVertex;
+	unsigned int m_nBaseInstance;
+};
+
+// Must match local_size_x in light_occlusion_cull.comp.
+#define LIGHT_OCCLUSION_GROUP_SIZE 64
+
 Renderer::Renderer(GLFWwindow* window) 
 {
 	m_window = window;
-	m_pointLightShader = nullptr;
-
-	// -----------------------------------------------------------------------------------------
-	// Basic
+	m_headlessContext = nullptr;
+	m_offscreenBackbuffer = nullptr;
 
 	// Make window context current.
 	glfwMakeContextCurrent(m_window);
@@ -29,6 +54,74 @@ Renderer::Renderer(GLFWwindow* window)
 	// Get window dimensions.
 	glfwGetWindowSize(m_window, &m_nWindowWidth, &m_nWindowHeight);
 
+	Init();
+}
+
+Renderer::Renderer(int nWidth, int nHeight)
+{
+	m_window = nullptr;
+	m_offscreenBackbuffer = nullptr;
+	m_nWindowWidth = nWidth;
+	m_nWindowHeight = nHeight;
+
+	// Create a context with no visible window and make it current.
+	m_headlessContext = new HeadlessContext();
+
+	if (!m_headlessContext->Create(nWidth, nHeight))
+		std::cout << "Renderer Error: Failed to create a headless OpenGL context." << std::endl;
+
+	// Load OpenGL library using GLAD
+	gladLoadGLLoader((GLADloadproc)HeadlessContext::GetProcAddress);
+
+	Init();
+
+	// Frames are rendered to an offscreen backbuffer in place of the window's framebuffer...
+	m_offscreenBackbuffer = new Framebuffer(nWidth, nHeight);
+	m_offscreenBackbuffer->AddBufferColorAttachment(BUFFER_RGBA);
+	m_offscreenBackbuffer->AddDepthStencilAttachment();
+}
+
+void Renderer::Init()
+{
+	m_pointLightShader = nullptr;
+	m_lightStencilShader = nullptr;
+	m_directionalLightShader = nullptr;
+	m_clusterAssignShader = nullptr;
+	m_clusteredLightShader = nullptr;
+	m_eLightingMode = LIGHTING_MODE_VOLUME;
+	SetGBufferLayout(GBUFFER_LAYOUT_COMPACT);
+	m_nVisibleLightCount = 0;
+	m_nVisibleLightBaseInstance = 0;
+	m_hiZDownsampleShader = nullptr;
+	m_lightOcclusionShader = nullptr;
+	m_visibilityResolveShader = nullptr;
+	m_nLightCommandOffset = 0;
+	m_bLightCommands = false;
+
+	// -----------------------------------------------------------------------------------------
+	// Basic
+
+	// Create state cache, all binding and fixed function state changes go through it from here on.
+	GLState::Create();
+	GLState* glState = GLState::GetInstance();
+
+	// Create transient upload buffer for per-frame data.
+	UploadRing::Create();
+
+	// Create GPU timer queries, scopes are read back a few frames after they are recorded.
+	GPUProfiler::Create();
+
+	// Create the shared mesh geometry storage, and the storage of instances kept across frames.
+	GeometryPool::Create();
+	InstancePool::Create();
+
+	// Create bindless material storage where supported, materials created afterwards reserve an entry in it.
+	if (MaterialTable::IsSupported())
+		MaterialTable::Create();
+
+	// Create texture decode threads, streamed textures are uploaded a budgeted amount per frame from here on.
+	TextureStreamer::Create();
+
 	// Set up viewport
 	glViewport(0, 0, m_nWindowWidth, m_nWindowHeight);
 
@@ -36,48 +129,94 @@ Renderer::Renderer(GLFWwindow* window)
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
 	// Enable depth testing...
-	glEnable(GL_DEPTH_TEST);
+	glState->SetCapability(GLSTATE_CAP_DEPTH_TEST, true);
 
 	// Enable back face culling...
-	glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
+	glState->SetCapability(GLSTATE_CAP_CULL_FACE, true);
+	glState->CullFace(GL_BACK);
 
 	// Blend function for deferred shading
-	glBlendFunci(0, GL_ONE, GL_ONE);
+	glState->BlendFunc(GL_ONE, GL_ONE);
+
+	// -----------------------------------------------------------------------------------------
+	// Lights
+
+	m_lightManager = new PointLightManager();
+
+	// -----------------------------------------------------------------------------------------
+	// Scene draws
+
+	m_commandBucket = new CommandBucket();
+
+	// Occlusion culling pyramid, built once Hi-Z shaders are set.
+	m_hiZBuffer = new HiZBuffer(m_nWindowWidth, m_nWindowHeight);
 
 	// -----------------------------------------------------------------------------------------
     // Light volume sphere
-	m_lightVolMesh = new Mesh("Assets/Primitives/sphere.obj");
+
+	CreateLightVolumeBuffers();
 
 	// -----------------------------------------------------------------------------------------
-	// Quad and light buffers...
+	// Quad buffers...
 
 	CreateBuffers();
 
 	// -----------------------------------------------------------------------------------------
-	// Uniform blocks
+	// Clustered lighting buffers...
 
-	glGenBuffers(1, &m_glUBOMatrixHandle);
-	glBindBuffer(GL_UNIFORM_BUFFER, m_glUBOMatrixHandle);
+	CreateClusterBuffers();
 
-	// Map buffer range...
-	glBindBufferRange(GL_UNIFORM_BUFFER, 0, m_glUBOMatrixHandle, 0, sizeof(ViewProjBlock));
+	// -----------------------------------------------------------------------------------------
+	// Camera
 
 	// Initialize view matrix...
 	m_matrices.m_v3ViewPos = glm::vec3(0.0f, 1.0f, 3.0f);
+	m_matrices.m_fPadding = 0.0f;
 
 	m_matrices.m_viewMat = glm::lookAt<float>(m_matrices.m_v3ViewPos, m_matrices.m_v3ViewPos + glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+	m_unjitteredProjMat = glm::mat4();
+	m_viewProjection = glm::mat4();
+	m_previousViewProjection = glm::mat4();
+	m_v2ProjectionJitter = glm::vec2(0.0f);
 }
 
 Renderer::~Renderer() 
 {
-	delete m_lightVolMesh;
+	delete m_lightManager;
+	delete m_commandBucket;
+	delete m_hiZBuffer;
+
+	GLState::GetInstance()->DeleteVertexArrays(1, &m_glLightVolVAO);
+	GLState::GetInstance()->DeleteBuffers(1, &m_glLightVolVBO);
+	GLState::GetInstance()->DeleteBuffers(1, &m_glLightVolEBO);
+
+	GLState::GetInstance()->DeleteBuffers(1, &m_glClusterGridSSBOHandle);
+	GLState::GetInstance()->DeleteBuffers(1, &m_glClusterIndexSSBOHandle);
+	GLState::GetInstance()->DeleteBuffers(1, &m_glClusterCounterSSBOHandle);
+	GLState::GetInstance()->DeleteBuffers(1, &m_glClusterReadbackHandle);
 
-	glDeleteBuffers(1, &m_glUBOMatrixHandle);
+	if (m_clusterReadbackFence)
+		glDeleteSync(m_clusterReadbackFence);
 	
-	glDeleteVertexArrays(1, &m_glQuadVAO);
-	glDeleteBuffers(1, &m_glQuadEBO);
-	glDeleteBuffers(1, &m_glQuadVBO);
+	GLState::GetInstance()->DeleteVertexArrays(1, &m_glQuadVAO);
+	GLState::GetInstance()->DeleteBuffers(1, &m_glQuadEBO);
+	GLState::GetInstance()->DeleteBuffers(1, &m_glQuadVBO);
+
+	glDeleteFramebuffers(1, &m_glDepthCopyFBO);
+
+	delete m_offscreenBackbuffer;
+
+	TextureStreamer::Destroy();
+	MaterialTable::Destroy();
+	InstancePool::Destroy();
+	GeometryPool::Destroy();
+	GPUProfiler::Destroy();
+	UploadRing::Destroy();
+	GLState::Destroy();
+
+	// The context is destroyed last, after every object created with it.
+	delete m_headlessContext;
 }
 
 void Renderer::AddBatch(Batch* batch) 
@@ -87,34 +226,77 @@ void Renderer::AddBatch(Batch* batch)
 
 void Renderer::Start() 
 {
-	glDepthMask(GL_TRUE);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	CPU_PROFILE_ZONE("Renderer::Start");
+
+	// Read GPU timings of an old frame and begin timing this one.
+	GPUProfiler::GetInstance()->BeginFrame();
+
+	glBindFramebuffer(GL_FRAMEBUFFER, BackbufferHandle());
+
+	GLState::GetInstance()->DepthMask(true);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+	// Start counting this frame's state changes.
+	GLState::GetInstance()->BeginFrame();
 
 	// Projection matrix...
-	m_matrices.m_projMat = glm::perspective<float>(glm::radians(FIELD_OF_VIEW), static_cast<float>(m_nWindowWidth) / static_cast<float>(m_nWindowHeight), 0.1f, 1000.0f);
+	m_unjitteredProjMat = glm::perspective<float>(glm::radians(FIELD_OF_VIEW), static_cast<float>(m_nWindowWidth) / static_cast<float>(m_nWindowHeight), CAMERA_NEAR_PLANE, CAMERA_FAR_PLANE);
 
-	// Send matrices to GPU...
-	glBindBuffer(GL_UNIFORM_BUFFER, m_glUBOMatrixHandle);
+	// Keep last frame's view projection for reprojection.
+	m_previousViewProjection = m_viewProjection;
+	m_viewProjection = m_unjitteredProjMat * m_matrices.m_viewMat;
+
+	// Shift clip space by the jitter, scaled by w so the offset is constant after the perspective divide.
+	m_matrices.m_projMat = glm::translate(glm::mat4(), glm::vec3(m_v2ProjectionJitter, 0.0f)) * m_unjitteredProjMat;
+	m_matrices.m_inverseViewProjMat = glm::inverse(m_matrices.m_projMat * m_matrices.m_viewMat);
+
+	// Draws added this frame are depth sorted and culled from the current camera.
+	m_commandBucket->SetView(m_matrices.m_viewMat, m_matrices.m_projMat, CAMERA_NEAR_PLANE, CAMERA_FAR_PLANE);
+
+	// Wait until the GPU is done with the oldest frame's uploads so its space can be reused...
+	UploadRing* uploadRing = UploadRing::GetInstance();
+	uploadRing->BeginFrame();
 
-	glBufferData(GL_UNIFORM_BUFFER, sizeof(ViewProjBlock), &m_matrices, GL_STATIC_DRAW);
+	// Continue uploading streamed textures, those completed are switched to before anything is drawn.
+	TextureStreamer::GetInstance()->BeginFrame();
 
-	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	// Send matrices to GPU...
+	UploadMatrices(m_matrices);
 }
 
 void Renderer::ClearFramebuffer() 
 {
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 }
 
 void Renderer::DrawFinal() 
 {
+	CPU_PROFILE_ZONE("Renderer::DrawFinal");
+
 	for (int i = 0; i < m_batches.Count(); ++i)
-		m_batches[i]->Flush();
+		m_batches[i]->Flush(m_commandBucket);
+
+	m_commandBucket->Submit();
+}
+
+CommandBucket* Renderer::GetCommandBucket() 
+{
+	return m_commandBucket;
 }
 
 void Renderer::End() 
 {
-	glfwSwapBuffers(m_window);
+	CPU_PROFILE_ZONE("Renderer::End");
+
+	GPUProfiler::GetInstance()->EndFrame();
+
+	// Fence this frame's uploads.
+	UploadRing::GetInstance()->EndFrame();
+	TextureStreamer::GetInstance()->EndFrame();
+
+	// Headless frames stay in the offscreen backbuffer until they are read back.
+	if (m_window)
+		glfwSwapBuffers(m_window);
 }
 
 void Renderer::DrawFSQuad(Shader* shader, Texture** textures, int nTextureCount) 
@@ -123,46 +305,34 @@ void Renderer::DrawFSQuad(Shader* shader, Texture** textures, int nTextureCount)
 	shader->Use();
 
 	// Bind all textures...
-	for (int i = 0; i < nTextureCount; ++i)
-	{
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, textures[i]->GetHandle());
-	}
-	
-	// Reset active texture.
-	glActiveTexture(GL_TEXTURE0);
+	BindTextures(textures, nTextureCount);
 
-	// Bind quad...
-	glBindVertexArray(m_glQuadVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, m_glQuadVBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_glQuadEBO);
+	// Bind quad, its index buffer is part of the VAO...
+	GLState::GetInstance()->BindVertexArray(m_glQuadVAO);
 
-	// Draw...
+	// Draw, the quad covers the screen regardless of any depth attachment...
+	GLState::GetInstance()->SetCapability(GLSTATE_CAP_DEPTH_TEST, false);
 	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+	GLState::GetInstance()->SetCapability(GLSTATE_CAP_DEPTH_TEST, true);
 }
 
 void Renderer::BindTextures(Texture** textures, int nTextureCount) 
 {
+	GLState* glState = GLState::GetInstance();
+
 	for (int i = 0; i < nTextureCount; ++i)
-	{
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, textures[i]->GetHandle());
-	}
+		glState->BindTexture(i, GL_TEXTURE_2D, textures[i]->GetHandle());
 }
 
 void Renderer::BindFSQuad() 
 {
-	// Bind quad...
-	glBindVertexArray(m_glQuadVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, m_glQuadVBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_glQuadEBO);
+	// Bind quad, its index buffer is part of the VAO...
+	GLState::GetInstance()->BindVertexArray(m_glQuadVAO);
 }
 
 void Renderer::UnbindVAO() 
 {
-	glBindVertexArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	GLState::GetInstance()->BindVertexArray(0);
 }
 
 void Renderer::DrawFSQuadNoState() 
@@ -178,12 +348,60 @@ void Renderer::DrawSkybox()
 
 void Renderer::BindSkybox() 
 {
-	glBindVertexArray(m_glSkyVAO);
+	GLState::GetInstance()->BindVertexArray(m_glSkyVAO);
 }
 
 void Renderer::ResetFramebufferBinding()
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, BackbufferHandle());
+}
+
+unsigned int Renderer::BackbufferHandle()
+{
+	return m_offscreenBackbuffer ? m_offscreenBackbuffer->GetFrameBufferHandle() : 0;
+}
+
+bool Renderer::IsHeadless()
+{
+	return m_window == nullptr;
+}
+
+bool Renderer::SaveFrame(const char* szPath)
+{
+	CPU_PROFILE_ZONE("Renderer::SaveFrame");
+
+	std::ofstream file(szPath, std::ios::binary);
+
+	if(!file.good())
+	{
+		std::cout << "Renderer Error: Failed to open " << szPath << " for writing." << std::endl;
+		return false;
+	}
+
+	// Read back the color of the backbuffer, this waits for the frame to finish rendering...
+	unsigned char* pixels = new unsigned char[m_nWindowWidth * m_nWindowHeight * 3];
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, BackbufferHandle());
+	glReadBuffer(m_offscreenBackbuffer ? GL_COLOR_ATTACHMENT0 : GL_BACK);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, m_nWindowWidth, m_nWindowHeight, GL_BGR, GL_UNSIGNED_BYTE, pixels);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+	// Uncompressed true color TGA, rows are stored bottom to top like OpenGL returns them.
+	unsigned char header[18] = {};
+	header[2] = 2;
+	header[12] = m_nWindowWidth & 0xFF;
+	header[13] = (m_nWindowWidth >> 8) & 0xFF;
+	header[14] = m_nWindowHeight & 0xFF;
+	header[15] = (m_nWindowHeight >> 8) & 0xFF;
+	header[16] = 24;
+
+	file.write(reinterpret_cast<const char*>(header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(pixels), m_nWindowWidth * m_nWindowHeight * 3);
+
+	delete[] pixels;
+
+	return file.good();
 }
 
 void Renderer::SetPLightShader(Shader* lightShader) 
@@ -196,66 +414,137 @@ void Renderer::SetDLightShader(Shader* lightShader)
 	m_directionalLightShader = lightShader;
 }
 
-int Renderer::AddPointLight(Vector4 v4Color, Vector3 v3Position, float fRadius) 
+void Renderer::SetLightStencilShader(Shader* stencilShader)
 {
-	if (m_nPLightCount >= MAX_LIGHT_COUNT)
-		return 0;
+	m_lightStencilShader = stencilShader;
+}
 
-	m_pointLights[m_nPLightCount].m_v4Color = { v4Color.x, v4Color.y, v4Color.z, fRadius };
-	
-	// Create and translate matrix to the correct coordinates.
-	glm::mat4 lightMat = glm::translate(glm::mat4(), glm::vec3(v3Position.x, v3Position.y, v3Position.z));
+void Renderer::SetClusteredLightShaders(Shader* assignShader, Shader* shadeShader)
+{
+	m_clusterAssignShader = assignShader;
+	m_clusteredLightShader = shadeShader;
+}
 
-	// Scale light matrix by radius...
-	lightMat = glm::scale(lightMat, glm::vec3(fRadius));
+void Renderer::SetInstanceCullShader(Shader* cullShader)
+{
+	m_commandBucket->SetCullShader(cullShader);
+}
+
+void Renderer::SetHiZShaders(Shader* downsampleShader, Shader* lightCullShader)
+{
+	m_hiZDownsampleShader = downsampleShader;
+	m_lightOcclusionShader = lightCullShader;
 
-	// Copy matrix into instance and increment light count...
-	memcpy_s(m_pointLights[m_nPLightCount].m_modelMat, sizeof(float) * 16, glm::value_ptr(lightMat), sizeof(float) * 16);
+	// A pyramid left over from before occlusion was turned off holds stale depth, it is rebuilt before being tested against again.
+	if (!downsampleShader)
+		m_hiZBuffer->Invalidate();
 
-	return m_nPLightCount++;
+	// Scene instances are only occlusion tested while the pyramid is being kept up to date.
+	m_commandBucket->SetHiZBuffer(downsampleShader ? m_hiZBuffer : nullptr);
 }
 
-void Renderer::TransformPointLight(int nIndex, NVZMathLib::Vector3 v3Position, float fRadius) 
+void Renderer::SetVisibilityShaders(Shader* visibilityShader, Shader* resolveShader)
 {
-	PointLight& selectedLight = m_pointLights[nIndex];
+	m_visibilityResolveShader = resolveShader;
 
-	// Scale light by radius...
-	glm::mat4 lightMat = glm::scale(glm::mat4(), glm::vec3(fRadius));
+	m_commandBucket->SetVisibilityShader(visibilityShader);
+}
 
-	// Set light color w to radius.
-	selectedLight.m_v4Color.w = fRadius;
+void Renderer::ResolveVisibility(Texture** textures, int nTextureCount)
+{
+	if (!m_visibilityResolveShader)
+		return;
+
+	// Each source's geometry is in different buffers, the pixels of other sources are discarded while resolving one.
+	for(int i = 0; i < m_commandBucket->VisibilitySourceCount(); ++i)
+	{
+		m_commandBucket->BindVisibilitySource(i, m_visibilityResolveShader);
 
-	// Translate light from origin to new position.
-	lightMat[3] = glm::vec4(v3Position.x, v3Position.y, v3Position.z, 1.0f);
+		DrawFSQuad(m_visibilityResolveShader, textures, nTextureCount);
+	}
+}
 
-	// Copy new matrix.
-	memcpy_s(selectedLight.m_modelMat, sizeof(float) * 16, glm::value_ptr(lightMat), sizeof(float) * 16);
+void Renderer::DrawVisibilityFallback()
+{
+	m_commandBucket->SubmitVisibilityFallback();
 }
 
-void Renderer::TransformPointLight(int nIndex, NVZMathLib::Vector3 v3Position)
+void Renderer::BuildHiZ(Texture* depthTexture)
 {
-	PointLight& selectedLight = m_pointLights[nIndex];
+	if (!m_hiZDownsampleShader)
+		return;
 
-	// Set light position.
-	selectedLight.m_modelMat[12] = v3Position.x;
-	selectedLight.m_modelMat[13] = v3Position.y;
-	selectedLight.m_modelMat[14] = v3Position.z;
+	m_hiZBuffer->Build(m_hiZDownsampleShader, depthTexture, m_matrices.m_projMat * m_matrices.m_viewMat);
 }
 
-void Renderer::RemovePointLight(int nIndex) 
+void Renderer::SetLightingMode(ELightingMode eMode)
 {
-	int nSize = MAX_LIGHT_COUNT - nIndex - 1;
+	m_eLightingMode = eMode;
+}
 
-	// Remove array gap...
-	memcpy_s(&m_pointLights[nIndex], nSize, &m_pointLights[nIndex + 1], nSize - 1);
+ELightingMode Renderer::GetLightingMode()
+{
+	return m_eLightingMode;
+}
 
-	--m_nPLightCount;
+void Renderer::SetGBufferLayout(EGBufferLayout eLayout)
+{
+	// Visibility IDs are written with the draw ID of each draw in a multi-draw.
+	if(eLayout == GBUFFER_LAYOUT_VISIBILITY && !GLAD_GL_ARB_shader_draw_parameters)
+	{
+		std::cout << "Renderer Warning: The visibility buffer requires ARB_shader_draw_parameters, using the compact G-buffer layout." << std::endl;
+		eLayout = GBUFFER_LAYOUT_COMPACT;
+	}
+
+	m_eGBufferLayout = eLayout;
+
+	Shader::SetGlobalDefine(GBUFFER_COMPACT_DEFINE, eLayout != GBUFFER_LAYOUT_WIDE);
+}
+
+EGBufferLayout Renderer::GetGBufferLayout()
+{
+	return m_eGBufferLayout;
+}
+
+PointLightHandle Renderer::AddPointLight(Vector4 v4Color, Vector3 v3Position, float fRadius) 
+{
+	return m_lightManager->Add(glm::vec3(v4Color.x, v4Color.y, v4Color.z), glm::vec3(v3Position.x, v3Position.y, v3Position.z), fRadius);
+}
+
+void Renderer::TransformPointLight(PointLightHandle handle, NVZMathLib::Vector3 v3Position, float fRadius) 
+{
+	m_lightManager->SetTransform(handle, glm::vec3(v3Position.x, v3Position.y, v3Position.z), fRadius);
+}
+
+void Renderer::TransformPointLight(PointLightHandle handle, NVZMathLib::Vector3 v3Position)
+{
+	m_lightManager->SetPosition(handle, glm::vec3(v3Position.x, v3Position.y, v3Position.z));
+}
+
+void Renderer::RemovePointLight(PointLightHandle handle) 
+{
+	m_lightManager->Remove(handle);
+}
+
+PointLightManager* Renderer::GetPointLights() 
+{
+	return m_lightManager;
+}
+
+int Renderer::VisibleLightCount() 
+{
+	return m_nVisibleLightCount;
+}
+
+int Renderer::CulledLightCount() 
+{
+	return m_lightManager->Count() - m_nVisibleLightCount;
 }
 
 void Renderer::RunDeferredDirectionalLight(Texture** textures, int nTextureCount, Vector3 v3Direction, Vector3 v3Color) 
 {
 	// Enable blending...
-	glEnable(GL_BLEND);
+	GLState::GetInstance()->SetCapability(GLSTATE_CAP_BLEND, true);
 
 	if (!m_directionalLightShader)
 		return;
@@ -267,78 +556,305 @@ void Renderer::RunDeferredDirectionalLight(Texture** textures, int nTextureCount
 	m_directionalLightShader->SetUniformVec3("lightColor", v3Color);
 
 	// Bind all textures...
-	for (int i = 0; i < nTextureCount; ++i)
-	{
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, textures[i]->GetHandle());
-	}
-
-	// Reset active texture.
-	glActiveTexture(GL_TEXTURE0);
+	BindTextures(textures, nTextureCount);
 
-	// Bind quad...
-	glBindVertexArray(m_glQuadVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, m_glQuadVBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_glQuadEBO);
+	// Bind quad, its index buffer is part of the VAO...
+	GLState::GetInstance()->BindVertexArray(m_glQuadVAO);
 
-	// Draw...
+	// Draw, the quad covers the screen regardless of any depth attachment...
+	GLState::GetInstance()->SetCapability(GLSTATE_CAP_DEPTH_TEST, false);
 	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+	GLState::GetInstance()->SetCapability(GLSTATE_CAP_DEPTH_TEST, true);
 }
 
 void Renderer::RunDeferredPointLighting(Texture** textures, int nTextureCount)
 {
+	GLState* glState = GLState::GetInstance();
+
 	// Enable blending...
-	glEnable(GL_BLEND);
+	glState->SetCapability(GLSTATE_CAP_BLEND, true);
+
+	// Disable depth testing and writes, the stencil technique enables testing where it needs it...
+	glState->DepthMask(false);
+	glState->SetCapability(GLSTATE_CAP_DEPTH_TEST, false);
 
-	// Disable depth testing...
-	glDepthMask(GL_FALSE);
-	glCullFace(GL_FRONT);
+	// Send lights modified since last frame to the GPU, both techniques read the same light buffer.
+	m_lightManager->Upload();
 
+	// Cull lights outside of the view frustum and send the indices of the remaining lights...
+	m_nVisibleLightCount = m_lightManager->CullSpheres(m_matrices.m_projMat * m_matrices.m_viewMat, m_visibleLights);
+
+	UploadRing* uploadRing = UploadRing::GetInstance();
+	unsigned int nVisibleOffset = 0;
+
+	// The offset must suit storage buffer binding and be a whole number of indices.
+	unsigned int nAlignment = uploadRing->StorageAlignment() > sizeof(unsigned int) ? uploadRing->StorageAlignment() : sizeof(unsigned int);
+
+	if (m_nVisibleLightCount > 0 && !uploadRing->Upload(m_visibleLights, sizeof(unsigned int) * m_nVisibleLightCount, nAlignment, nVisibleOffset))
+		m_nVisibleLightCount = 0;
+
+	// Instanced draws start reading the index list at this instance, clustered assignment reads it as a storage buffer range.
+	m_nVisibleLightBaseInstance = nVisibleOffset / sizeof(unsigned int);
+
+	if (m_nVisibleLightCount > 0)
+		glState->BindBufferRange(GL_SHADER_STORAGE_BUFFER, VISIBLE_LIGHT_SSBO_BINDING, uploadRing->Handle(), nVisibleOffset, sizeof(unsigned int) * m_nVisibleLightCount);
+
+	// Remove volumes hidden behind the G-buffer, clustered shading assigns lights per froxel instead...
+	m_bLightCommands = m_eLightingMode != LIGHTING_MODE_CLUSTERED && CullOccludedLights();
+
+	// Bind all textures, after culling as it samples the pyramid on the first unit...
+	BindTextures(textures, nTextureCount);
+
+	switch(m_eLightingMode) 
+	{
+	case LIGHTING_MODE_STENCIL_VOLUME:
+		RunStencilLightVolumes();
+		break;
+
+	case LIGHTING_MODE_CLUSTERED:
+		RunClusteredLighting();
+		break;
+
+	default:
+		RunLightVolumes();
+		break;
+	}
+
+	// Disable blending for the next frame.
+	glState->SetCapability(GLSTATE_CAP_BLEND, false);
+	glState->SetCapability(GLSTATE_CAP_DEPTH_TEST, true);
+}
+
+void Renderer::RunLightVolumes() 
+{
 	if (!m_pointLightShader)
 		return;
 
+	GLState::GetInstance()->CullFace(GL_FRONT);
+
 	m_pointLightShader->Use();
 
-	// Bind all textures...
-	for (int i = 0; i < nTextureCount; ++i)
+	GLState::GetInstance()->BindVertexArray(m_glLightVolVAO);
+	glBindVertexBuffer(INSTANCE_VERTEX_BINDING, UploadRing::GetInstance()->Handle(), 0, sizeof(unsigned int));
+
+	// Draw all visible lights in a single instanced draw, or a single multi-draw skipping occluded lights...
+	if(m_bLightCommands)
 	{
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, textures[i]->GetHandle());
+		GLState::GetInstance()->BindBuffer(GL_DRAW_INDIRECT_BUFFER, UploadRing::GetInstance()->Handle());
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, reinterpret_cast<const void*>(static_cast<size_t>(m_nLightCommandOffset)), m_nVisibleLightCount, 0);
 	}
+	else
+		glDrawElementsInstancedBaseInstance(GL_TRIANGLES, m_nLightVolIndexCount, GL_UNSIGNED_SHORT, 0, m_nVisibleLightCount, m_nVisibleLightBaseInstance);
+
+	GLState::GetInstance()->CullFace(GL_BACK);
+}
+
+void Renderer::RunStencilLightVolumes() 
+{
+	if (!m_pointLightShader || !m_lightStencilShader)
+		return;
 
-	// Bind buffers...
-	m_lightVolMesh->Bind();
+	GLState* glState = GLState::GetInstance();
 
-	// Update lights...
-	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(PointLight) * m_nPLightCount, m_pointLights);
+	glState->BindVertexArray(m_glLightVolVAO);
+	glBindVertexBuffer(INSTANCE_VERTEX_BINDING, UploadRing::GetInstance()->Handle(), 0, sizeof(unsigned int));
+	glState->SetCapability(GLSTATE_CAP_STENCIL_TEST, true);
 
-	// Draw...
-	glDrawElementsInstanced(GL_TRIANGLES, m_lightVolMesh->IndexCount(), GL_UNSIGNED_INT, 0, m_nPLightCount);
+	if (m_bLightCommands)
+		glState->BindBuffer(GL_DRAW_INDIRECT_BUFFER, UploadRing::GetInstance()->Handle());
 
-	// Reset bindings...
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+	for(int i = 0; i < m_nVisibleLightCount; ++i) 
+	{
+		// Occluded lights keep their draws but with no instances, only the GPU knows which they are.
+		const void* command = reinterpret_cast<const void*>(static_cast<size_t>(m_nLightCommandOffset + sizeof(LightVolumeCommand) * i));
 
-	// Disable blending for the next frame.
-	glDisable(GL_BLEND);
-	glCullFace(GL_BACK);
+		// -----------------------------------------------------------------------------------------
+		// Stencil pass: Mark pixels where scene geometry lies between the front and back faces of the volume.
+
+		m_lightStencilShader->Use();
+
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		glState->SetCapability(GLSTATE_CAP_DEPTH_TEST, true);
+		glState->SetCapability(GLSTATE_CAP_CULL_FACE, false);
+
+		// Back faces behind geometry increment, front faces behind geometry decrement.
+		glStencilFunc(GL_ALWAYS, 0, 0);
+		glStencilOpSeparate(GL_BACK, GL_KEEP, GL_INCR_WRAP, GL_KEEP);
+		glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_DECR_WRAP, GL_KEEP);
+
+		if (m_bLightCommands)
+			glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, command);
+		else
+			glDrawElementsInstancedBaseInstance(GL_TRIANGLES, m_nLightVolIndexCount, GL_UNSIGNED_SHORT, 0, 1, m_nVisibleLightBaseInstance + i);
+
+		// -----------------------------------------------------------------------------------------
+		// Light pass: Shade marked pixels, and reset them to zero for the next light.
+
+		m_pointLightShader->Use();
+
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		glState->SetCapability(GLSTATE_CAP_DEPTH_TEST, false);
+		glState->SetCapability(GLSTATE_CAP_CULL_FACE, true);
+		glState->CullFace(GL_FRONT);
+
+		glStencilFunc(GL_NOTEQUAL, 0, 0xFF);
+		glStencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
+
+		if (m_bLightCommands)
+			glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, command);
+		else
+			glDrawElementsInstancedBaseInstance(GL_TRIANGLES, m_nLightVolIndexCount, GL_UNSIGNED_SHORT, 0, 1, m_nVisibleLightBaseInstance + i);
+	}
+
+	glState->SetCapability(GLSTATE_CAP_STENCIL_TEST, false);
+	glState->CullFace(GL_BACK);
+
+	glState->BindVertexArray(0);
+}
+
+void Renderer::RunClusteredLighting() 
+{
+	if (!m_clusterAssignShader || !m_clusteredLightShader)
+		return;
+
+	// -----------------------------------------------------------------------------------------
+	// Light assignment
+
+	glm::mat4 inverseProjection = glm::inverse(m_matrices.m_projMat);
+
+	GLState* glState = GLState::GetInstance();
+
+	// Report clusters which ran out of light indices in a past frame, once its counters have arrived...
+	if(m_clusterReadbackFence && glClientWaitSync(m_clusterReadbackFence, 0, 0) != GL_TIMEOUT_EXPIRED)
+	{
+		glDeleteSync(m_clusterReadbackFence);
+		m_clusterReadbackFence = nullptr;
+
+		if(m_clusterReadback[1] > 0 && !m_bClusterOverflowReported)
+		{
+			std::cout << "Renderer Warning: " << m_clusterReadback[1] << " light clusters exceeded the " << CLUSTER_LIGHT_INDEX_CAPACITY 
+				<< " light indices shared by all clusters, their remaining lights are not shaded." << std::endl;
+			m_bClusterOverflowReported = true;
+		}
+	}
+
+	GPUProfiler::GetInstance()->BeginScope("Light cluster assignment");
+
+	// Start the index list and overflow count from zero.
+	glState->BindBuffer(GL_SHADER_STORAGE_BUFFER, m_glClusterCounterSSBOHandle);
+	glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+	glState->BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	m_clusterAssignShader->Use();
+	m_clusterAssignShader->SetUniformMat4("inverseProjection", glm::value_ptr(inverseProjection));
+	m_clusterAssignShader->SetUniformInt("lightCount", m_nVisibleLightCount);
+	m_clusterAssignShader->SetUniformFloat("nearPlane", CAMERA_NEAR_PLANE);
+	m_clusterAssignShader->SetUniformFloat("farPlane", CAMERA_FAR_PLANE);
+
+	// One work group per depth slice, one invocation per cluster within the slice.
+	glDispatchCompute(1, 1, CLUSTER_GRID_Z);
+
+	// Ensure cluster light lists are written before they are read by the shading pass, and the counters before they are copied.
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	// Copy the counters out unless the last copy hasn't arrived yet.
+	if(!m_clusterReadbackFence)
+	{
+		glState->BindBuffer(GL_COPY_READ_BUFFER, m_glClusterCounterSSBOHandle);
+		glState->BindBuffer(GL_COPY_WRITE_BUFFER, m_glClusterReadbackHandle);
+
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sizeof(unsigned int) * 2);
+
+		glState->BindBuffer(GL_COPY_READ_BUFFER, 0);
+		glState->BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+		m_clusterReadbackFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	GPUProfiler::GetInstance()->EndScope();
+
+	// -----------------------------------------------------------------------------------------
+	// Shading
+
+	m_clusteredLightShader->Use();
+	m_clusteredLightShader->SetUniformFloat("nearPlane", CAMERA_NEAR_PLANE);
+	m_clusteredLightShader->SetUniformFloat("farPlane", CAMERA_FAR_PLANE);
+
+	// Shade every pixel once with the lights of its cluster.
+	BindFSQuad();
+	DrawFSQuadNoState();
+	UnbindVAO();
+}
+
+bool Renderer::CullOccludedLights()
+{
+	if (!m_lightOcclusionShader || !m_hiZDownsampleShader || !m_hiZBuffer->IsValid() || m_nVisibleLightCount == 0)
+		return false;
+
+	GPUProfileScope profileScope("Light occlusion culling");
+
+	GLState* glState = GLState::GetInstance();
+	UploadRing* uploadRing = UploadRing::GetInstance();
+
+	// Every command draws the whole icosphere for one visible light, the shader clears the instance count of occluded lights...
+	LightVolumeCommand* commands = static_cast<LightVolumeCommand*>(uploadRing->Allocate(sizeof(LightVolumeCommand) * m_nVisibleLightCount, sizeof(unsigned int), m_nLightCommandOffset));
+
+	if (!commands)
+		return false;
+
+	for(int i = 0; i < m_nVisibleLightCount; ++i)
+	{
+		commands[i].m_nCount = m_nLightVolIndexCount;
+		commands[i].m_nInstanceCount = 1;
+		commands[i].m_nFirstIndex = 0;
+		commands[i].m_nBaseVertex = 0;
+		commands[i].m_nBaseInstance = m_nVisibleLightBaseInstance + i;
+	}
+
+	m_lightOcclusionShader->Use();
+	m_lightOcclusionShader->SetUniformInt("lightCount", m_nVisibleLightCount);
+	m_lightOcclusionShader->SetUniformMat4("hiZViewProjection", glm::value_ptr(m_hiZBuffer->ViewProjection()));
+	m_lightOcclusionShader->SetUniformInt("hiZMipCount", m_hiZBuffer->MipCount());
+	m_lightOcclusionShader->SetUniformUInt("commandWord", m_nLightCommandOffset / sizeof(unsigned int));
+
+	// Commands are written in place within the upload ring...
+	glState->BindTexture(0, GL_TEXTURE_2D, m_hiZBuffer->Handle());
+	glState->BindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_CULL_RING_SSBO_BINDING, uploadRing->Handle());
+
+	glDispatchCompute((m_nVisibleLightCount + LIGHT_OCCLUSION_GROUP_SIZE - 1) / LIGHT_OCCLUSION_GROUP_SIZE, 1, 1);
+
+	// Make the instance counts visible to the light draws.
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+
+	return true;
 }
 
 void Renderer::EnableDepthTesting() 
 {
-	glDepthMask(GL_TRUE);
+	GLState::GetInstance()->DepthMask(true);
 }
 
 void Renderer::UseDepthTextureOf(const Framebuffer* buffer) 
 {
 	glBindFramebuffer(GL_READ_FRAMEBUFFER, buffer->GetFrameBufferHandle()); // Bind supplied buffer for reading.
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0); // Bind default FBO for writing.
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, BackbufferHandle()); // Bind the backbuffer for writing.
 
 	// Copy contents.
 	glBlitFramebuffer(0, 0, m_nWindowWidth, m_nWindowHeight, 0, 0, m_nWindowWidth, m_nWindowHeight, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
 }
 
+void Renderer::UseDepthTextureOf(Texture* depthTexture) 
+{
+	// Attach texture to the copy framebuffer and bind it for reading.
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_glDepthCopyFBO);
+	glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthTexture->GetHandle(), 0);
+
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, BackbufferHandle()); // Bind the backbuffer for writing.
+
+	// Copy contents.
+	glBlitFramebuffer(0, 0, depthTexture->GetWidth(), depthTexture->GetHeight(), 0, 0, m_nWindowWidth, m_nWindowHeight, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+}
+
 void Renderer::ReportErrors() 
 {
 	// Get first error code.
@@ -367,6 +883,30 @@ void Renderer::SetViewMatrix(glm::mat4 matrix, glm::vec3 v3ViewPos)
 	m_matrices.m_v3ViewPos = v3ViewPos;
 }
 
+void Renderer::SetProjectionJitter(float fX, float fY)
+{
+	m_v2ProjectionJitter = glm::vec2(fX, fY);
+}
+
+void Renderer::RemoveProjectionJitter()
+{
+	ViewProjBlock matrices = m_matrices;
+	matrices.m_projMat = m_unjitteredProjMat;
+	matrices.m_inverseViewProjMat = glm::inverse(m_viewProjection);
+
+	UploadMatrices(matrices);
+}
+
+const glm::mat4& Renderer::ViewProjection() const
+{
+	return m_viewProjection;
+}
+
+const glm::mat4& Renderer::PreviousViewProjection() const
+{
+	return m_previousViewProjection;
+}
+
 int Renderer::WindowWidth() 
 {
 	return m_nWindowWidth;
@@ -379,13 +919,16 @@ int Renderer::WindowHeight()
 
 void Renderer::CreateBuffers() 
 {
+	// Depth copy framebuffer, attachments are set when copying.
+	glGenFramebuffers(1, &m_glDepthCopyFBO);
+
 	// Generate buffers...
 	glGenBuffers(1, &m_glQuadVBO);
 	glGenBuffers(1, &m_glQuadEBO);
 	glGenVertexArrays(1, &m_glQuadVAO);
 
 	// Bind VAO...
-	glBindVertexArray(m_glQuadVAO);
+	GLState::GetInstance()->BindVertexArray(m_glQuadVAO);
 
 	// Vertices... x, y = positions, z, w = tex coords.
 	NVZMathLib::Vector4 v2Vertices[4] = 
@@ -397,7 +940,7 @@ void Renderer::CreateBuffers()
 	};
 
 	// Bind and fill VBO
-	glBindBuffer(GL_ARRAY_BUFFER, m_glQuadVBO);
+	GLState::GetInstance()->BindBuffer(GL_ARRAY_BUFFER, m_glQuadVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 16, v2Vertices, GL_STATIC_DRAW);
 
 	// Attributes...
@@ -418,20 +961,20 @@ void Renderer::CreateBuffers()
 	};
 
 	// Bind and fill index buffer...
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_glQuadEBO);
+	GLState::GetInstance()->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_glQuadEBO);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * 6, indices, GL_STATIC_DRAW);
 
 	// Unbind buffers.
-	glBindVertexArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	GLState::GetInstance()->BindVertexArray(0);
+	GLState::GetInstance()->BindBuffer(GL_ARRAY_BUFFER, 0);
+	GLState::GetInstance()->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
 	// Skybox
 	glGenBuffers(1, &m_glSkyVBO);
 	glGenVertexArrays(1, &m_glSkyVAO);
 	
-	glBindVertexArray(m_glSkyVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, m_glSkyVBO);
+	GLState::GetInstance()->BindVertexArray(m_glSkyVAO);
+	GLState::GetInstance()->BindBuffer(GL_ARRAY_BUFFER, m_glSkyVBO);
 
 	float fSkyboxVertices[] = 
 	{    
@@ -485,6 +1028,169 @@ void Renderer::CreateBuffers()
 	glEnableVertexAttribArray(0);
 
 	// Unbind buffers.
-	glBindVertexArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-}
\ No newline at end of file
+	GLState::GetInstance()->BindVertexArray(0);
+	GLState::GetInstance()->BindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Renderer::CreateLightVolumeBuffers() 
+{
+	// -----------------------------------------------------------------------------------------
+	// Icosphere
+
+	const float fT = (1.0f + sqrtf(5.0f)) * 0.5f;
+
+	// Icosahedron vertices...
+	std::vector<glm::vec3> positions = 
+	{
+		glm::vec3(-1.0f, fT, 0.0f), glm::vec3(1.0f, fT, 0.0f), glm::vec3(-1.0f, -fT, 0.0f), glm::vec3(1.0f, -fT, 0.0f),
+		glm::vec3(0.0f, -1.0f, fT), glm::vec3(0.0f, 1.0f, fT), glm::vec3(0.0f, -1.0f, -fT), glm::vec3(0.0f, 1.0f, -fT),
+		glm::vec3(fT, 0.0f, -1.0f), glm::vec3(fT, 0.0f, 1.0f), glm::vec3(-fT, 0.0f, -1.0f), glm::vec3(-fT, 0.0f, 1.0f)
+	};
+
+	for (unsigned int i = 0; i < positions.size(); ++i)
+		positions[i] = glm::normalize(positions[i]);
+
+	// Icosahedron faces, counter-clockwise when viewed from outside...
+	std::vector<unsigned short> indices = 
+	{
+		0, 11, 5,  0, 5, 1,  0, 1, 7,  0, 7, 10,  0, 10, 11,
+		1, 5, 9,  5, 11, 4,  11, 10, 2,  10, 7, 6,  7, 1, 8,
+		3, 9, 4,  3, 4, 2,  3, 2, 6,  3, 6, 8,  3, 8, 9,
+		4, 9, 5,  2, 4, 11,  6, 2, 10,  8, 6, 7,  9, 8, 1
+	};
+
+	// Split each triangle into four, sharing edge midpoints between neighbouring triangles...
+	for(int nLevel = 0; nLevel < LIGHT_VOLUME_SUBDIVISIONS; ++nLevel) 
+	{
+		std::map<unsigned int, unsigned short> midpoints;
+		std::vector<unsigned short> subdividedIndices;
+
+		auto getMidpoint = [&](unsigned short a, unsigned short b) -> unsigned short
+		{
+			unsigned int nKey = a < b ? (a << 16) | b : (b << 16) | a;
+			auto it = midpoints.find(nKey);
+
+			if (it != midpoints.end())
+				return it->second;
+
+			unsigned short nIndex = static_cast<unsigned short>(positions.size());
+			positions.push_back(glm::normalize(positions[a] + positions[b]));
+			midpoints[nKey] = nIndex;
+
+			return nIndex;
+		};
+
+		for(unsigned int i = 0; i < indices.size(); i += 3) 
+		{
+			unsigned short a = indices[i];
+			unsigned short b = indices[i + 1];
+			unsigned short c = indices[i + 2];
+
+			unsigned short ab = getMidpoint(a, b);
+			unsigned short bc = getMidpoint(b, c);
+			unsigned short ca = getMidpoint(c, a);
+
+			subdividedIndices.insert(subdividedIndices.end(), { a, ab, ca,  b, bc, ab,  c, ca, bc,  ab, bc, ca });
+		}
+
+		indices.swap(subdividedIndices);
+	}
+
+	// The faces lie inside the unit sphere, scale the proxy out so it fully encloses the light's radius...
+	float fMinFaceDist = 1.0f;
+
+	for(unsigned int i = 0; i < indices.size(); i += 3) 
+	{
+		const glm::vec3& a = positions[indices[i]];
+		glm::vec3 v3Normal = glm::normalize(glm::cross(positions[indices[i + 1]] - a, positions[indices[i + 2]] - a));
+
+		fMinFaceDist = glm::min(fMinFaceDist, glm::dot(v3Normal, a));
+	}
+
+	for (unsigned int i = 0; i < positions.size(); ++i)
+		positions[i] /= fMinFaceDist;
+
+	m_nLightVolIndexCount = static_cast<int>(indices.size());
+
+	// -----------------------------------------------------------------------------------------
+	// Buffers
+
+	glGenVertexArrays(1, &m_glLightVolVAO);
+	glGenBuffers(1, &m_glLightVolVBO);
+	glGenBuffers(1, &m_glLightVolEBO);
+
+	GLState::GetInstance()->BindVertexArray(m_glLightVolVAO);
+
+	// Bind and fill index buffer...
+	GLState::GetInstance()->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_glLightVolEBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned short) * indices.size(), indices.data(), GL_STATIC_DRAW);
+
+	// Bind and fill VBO...
+	GLState::GetInstance()->BindBuffer(GL_ARRAY_BUFFER, m_glLightVolVBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * positions.size(), positions.data(), GL_STATIC_DRAW);
+
+	// Positions
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+	glEnableVertexAttribArray(0);
+
+	// Visible light indices are written to the upload ring each frame and read through the instance binding, light data is read from the light storage buffer by index...
+
+	// Light index
+	glVertexAttribIFormat(4, 1, GL_UNSIGNED_INT, 0);
+	glVertexAttribBinding(4, INSTANCE_VERTEX_BINDING);
+	glEnableVertexAttribArray(4);
+	glVertexBindingDivisor(INSTANCE_VERTEX_BINDING, 1);
+
+	// Unbind buffers.
+	GLState::GetInstance()->BindVertexArray(0);
+	GLState::GetInstance()->BindBuffer(GL_ARRAY_BUFFER, 0);
+	GLState::GetInstance()->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void Renderer::CreateClusterBuffers() 
+{
+	const int nClusterCount = CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z;
+
+	// Offset and count of the light indices of each cluster...
+	glGenBuffers(1, &m_glClusterGridSSBOHandle);
+	GLState::GetInstance()->BindBuffer(GL_SHADER_STORAGE_BUFFER, m_glClusterGridSSBOHandle);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(unsigned int) * 2 * nClusterCount, nullptr, GL_DYNAMIC_COPY);
+
+	// Light indices of all clusters, each cluster reserves a range of the list with an atomic counter...
+	glGenBuffers(1, &m_glClusterIndexSSBOHandle);
+	GLState::GetInstance()->BindBuffer(GL_SHADER_STORAGE_BUFFER, m_glClusterIndexSSBOHandle);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(unsigned int) * CLUSTER_LIGHT_INDEX_CAPACITY, nullptr, GL_DYNAMIC_COPY);
+
+	glGenBuffers(1, &m_glClusterCounterSSBOHandle);
+	GLState::GetInstance()->BindBuffer(GL_SHADER_STORAGE_BUFFER, m_glClusterCounterSSBOHandle);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(unsigned int) * 2, nullptr, GL_DYNAMIC_COPY);
+
+	// ...the counters are copied out to find clusters which didn't fit.
+	const unsigned int glReadbackFlags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	glGenBuffers(1, &m_glClusterReadbackHandle);
+	GLState::GetInstance()->BindBuffer(GL_COPY_WRITE_BUFFER, m_glClusterReadbackHandle);
+	glBufferStorage(GL_COPY_WRITE_BUFFER, sizeof(unsigned int) * 2, nullptr, glReadbackFlags | GL_CLIENT_STORAGE_BIT);
+	m_clusterReadback = static_cast<unsigned int*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, sizeof(unsigned int) * 2, glReadbackFlags));
+	GLState::GetInstance()->BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	m_clusterReadbackFence = nullptr;
+	m_bClusterOverflowReported = false;
+
+	GLState::GetInstance()->BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	// Bind buffers to their fixed binding points.
+	GLState::GetInstance()->BindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_SSBO_BINDING, m_lightManager->BufferHandle());
+	GLState::GetInstance()->BindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_GRID_SSBO_BINDING, m_glClusterGridSSBOHandle);
+	GLState::GetInstance()->BindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_INDEX_SSBO_BINDING, m_glClusterIndexSSBOHandle);
+	GLState::GetInstance()->BindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_COUNTER_SSBO_BINDING, m_glClusterCounterSSBOHandle);
+}
+
+void Renderer::UploadMatrices(const ViewProjBlock& matrices)
+{
+	UploadRing* uploadRing = UploadRing::GetInstance();
+	unsigned int nMatrixOffset = 0;
+
+	if (uploadRing->Upload(&matrices, sizeof(ViewProjBlock), uploadRing->UniformAlignment(), nMatrixOffset))
+		GLState::GetInstance()->BindBufferRange(GL_UNIFORM_BUFFER, 0, uploadRing->Handle(), nMatrixOffset, sizeof(ViewProjBlock));
+}
@@ -5,18 +5,59 @@
 #include "glm.hpp"
 #include "gtc/matrix_transform.hpp"
 #include "gtc/type_ptr.hpp"
+#include "PointLightManager.h"
 
 struct GLFWwindow;
+struct __GLsync;
 
 class Shader;
 class Texture;
 class Mesh;
 class Batch;
 class Framebuffer;
+class CommandBucket;
+class HiZBuffer;
+class HeadlessContext;
 
 #define FIELD_OF_VIEW 45.0f
+#define CAMERA_NEAR_PLANE 0.1f
+#define CAMERA_FAR_PLANE 1000.0f
 
-#define MAX_LIGHT_COUNT 512
+// Subdivision count of the icosphere used as a light volume proxy.
+#define LIGHT_VOLUME_SUBDIVISIONS 1
+
+// Clustered lighting froxel grid dimensions.
+#define CLUSTER_GRID_X 16
+#define CLUSTER_GRID_Y 9
+#define CLUSTER_GRID_Z 24
+
+// Light indices shared by all clusters, each cluster takes the range it needs. Room for an average of 256 lights per cluster.
+#define CLUSTER_LIGHT_INDEX_CAPACITY (CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z * 256)
+
+// Shader storage buffer binding points used by clustered lighting.
+#define LIGHT_SSBO_BINDING 1
+#define CLUSTER_GRID_SSBO_BINDING 2
+#define CLUSTER_INDEX_SSBO_BINDING 3
+#define VISIBLE_LIGHT_SSBO_BINDING 4
+#define CLUSTER_COUNTER_SSBO_BINDING 17 // Follows the instance cull output binding.
+
+enum ELightingMode 
+{
+	LIGHTING_MODE_VOLUME, // Instanced sphere light volumes, the G-buffer is read once per overlapping light.
+	LIGHTING_MODE_STENCIL_VOLUME, // Light volumes masked by a stencil pass, only pixels inside each volume are shaded.
+	LIGHTING_MODE_CLUSTERED, // Froxel light assignment followed by a single fullscreen shading pass.
+	LIGHTING_MODE_COUNT
+};
+
+enum EGBufferLayout 
+{
+	GBUFFER_LAYOUT_WIDE, // Float diffuse, position, normal and specular targets along with 8 bit material and emission targets.
+	GBUFFER_LAYOUT_COMPACT, // 8 bit albedo and specular targets holding the material values, an octahedral normal and a depth copy position is rebuilt from.
+	GBUFFER_LAYOUT_VISIBILITY // Only depth and a triangle ID are rasterized, resolving them into the compact layout's targets once per pixel.
+};
+
+// Defined in every shader compiled while the compact or visibility G-buffer layout is selected, lighting reads both the same way.
+#define GBUFFER_COMPACT_DEFINE "GBUFFER_COMPACT"
 
 class Renderer 
 {
@@ -24,6 +65,14 @@ public:
 
 	Renderer(GLFWwindow* window);
 
+	/*
+	Description: Create a headless renderer, rendering frames to an offscreen backbuffer of the provided size through its own context.
+	Param:
+	    int nWidth: The width of the backbuffer in pixels.
+		int nHeight: The height of the backbuffer in pixels.
+	*/
+	Renderer(int nWidth, int nHeight);
+
 	~Renderer();
 
 	/*
@@ -44,10 +93,16 @@ public:
 	void ClearFramebuffer();
 
 	/*
-	Draw any final undrawn objects added to batches.
+	Add any final undrawn objects in batches to the command bucket, then sort and draw everything in the bucket.
 	*/
 	void DrawFinal();
 
+	/*
+	Description: Get the command bucket scene draws are added to, submitted by DrawFinal.
+	Return Type: CommandBucket*
+	*/
+	CommandBucket* GetCommandBucket();
+
 	/*
 	Description: End the rendering process for this frame.
 	*/
@@ -96,10 +151,32 @@ public:
 	void BindSkybox();
 
 	/*
-	Description: Resets the framebuffer binding to the default window framebuffer.
+	Description: Resets the framebuffer binding to the backbuffer.
 	*/
 	void ResetFramebufferBinding();
 
+	/*
+	Description: Get the OpenGL handle of the framebuffer frames are presented from, 0 for the window or the offscreen backbuffer when headless.
+	Return Type: unsigned int
+	*/
+	unsigned int BackbufferHandle();
+
+	/*
+	Description: Get whether this renderer renders to an offscreen backbuffer without a window.
+	Return Type: bool
+	*/
+	bool IsHeadless();
+
+	/*
+	Description: Read back the color of the backbuffer and write it to an uncompressed TGA file. Stalls until the frame has finished rendering,
+	so should be called once all of the frame's passes have executed and before End.
+	Return Type: bool
+	Returns true if the file was written.
+	Param:
+	    const char* szPath: The path of the file to write.
+	*/
+	bool SaveFrame(const char* szPath);
+
 	/*
 	Description: Set the shader used for deferred shading with point lights.
 	Param:
@@ -115,40 +192,142 @@ public:
 	void SetDLightShader(Shader* lightShader);
 
 	/*
-	Description: Add a light for use in the deferred shading pass... The returned value is the index used to select lights for removal or modification.
-	Return Type: int
+	Description: Set the shader used to mark pixels inside light volumes in the stencil buffer. Required by LIGHTING_MODE_STENCIL_VOLUME.
+	Param:
+	    Shader* stencilShader: Position only shader with an empty fragment stage.
+	*/
+	void SetLightStencilShader(Shader* stencilShader);
+
+	/*
+	Description: Set the shaders used for clustered deferred shading with point lights.
+	Param:
+	    Shader* assignShader: Compute shader assigning lights to view frustum clusters.
+		Shader* shadeShader: Fullscreen shader shading each pixel with the lights of its cluster.
+	*/
+	void SetClusteredLightShaders(Shader* assignShader, Shader* shadeShader);
+
+	/*
+	Description: Set the compute shader used to frustum cull scene instances on the GPU, or nullptr to draw every instance.
+	Param:
+	    Shader* cullShader: The instance culling compute shader.
+	*/
+	void SetInstanceCullShader(Shader* cullShader);
+
+	/*
+	Description: Set the shaders used for Hi-Z occlusion culling, or nullptr to disable it.
+	Param:
+	    Shader* downsampleShader: Compute shader reducing depth into the farthest depth pyramid.
+		Shader* lightCullShader: Compute shader removing light volumes hidden behind the G-buffer from the light draws.
+	*/
+	void SetHiZShaders(Shader* downsampleShader, Shader* lightCullShader);
+
+	/*
+	Description: Build the Hi-Z pyramid from this frame's depth. Light volumes are tested against it this frame and scene instances next frame.
+	Param:
+	    Texture* depthTexture: The G-buffer depth stencil texture, after all opaque geometry has been drawn.
+	*/
+	void BuildHiZ(Texture* depthTexture);
+
+	/*
+	Description: Set the shaders drawing and resolving the visibility buffer, or nullptr to draw the G-buffer with each material's shader.
+	Param:
+	    Shader* visibilityShader: Shader rasterizing the visibility ID of every scene draw.
+		Shader* resolveShader: Fullscreen shader fetching the triangle of each ID and writing the G-buffer.
+	*/
+	void SetVisibilityShaders(Shader* visibilityShader, Shader* resolveShader);
+
+	/*
+	Description: Write the G-buffer from the visibility buffer drawn by the last submission of the command bucket.
+	Param:
+	    Texture** textures: The visibility ID and depth stencil textures.
+		int nTextureCount: The amount of textures.
+	*/
+	void ResolveVisibility(Texture** textures, int nTextureCount);
+
+	/*
+	Description: Draw with their materials the draws of the last submission of the command bucket the visibility buffer couldn't identify.
+	*/
+	void DrawVisibilityFallback();
+
+	/*
+	Description: Select the technique used by RunDeferredPointLighting.
+	Param:
+	    ELightingMode eMode: Light volumes, stencil masked light volumes or clustered shading. 
+		Stencil masked volumes require the bound framebuffer to share the G-buffer's depth stencil attachment.
+	*/
+	void SetLightingMode(ELightingMode eMode);
+
+	/*
+	Description: Get the technique currently used to shade point lights.
+	Return Type: ELightingMode
+	*/
+	ELightingMode GetLightingMode();
+
+	/*
+	Description: Set the layout scene shaders write the G-buffer in and lighting shaders read it in.
+	Only shaders created afterwards use the new layout, so it must be set before any G-buffer shader is created.
+	Param:
+	    EGBufferLayout eLayout: The wide, compact or visibility layout. The visibility layout requires ARB_shader_draw_parameters and falls back to compact.
+	*/
+	void SetGBufferLayout(EGBufferLayout eLayout);
+
+	/*
+	Description: Get the current G-buffer layout.
+	Return Type: EGBufferLayout
+	*/
+	EGBufferLayout GetGBufferLayout();
+
+	/*
+	Description: Add a light for use in the deferred shading pass... The returned handle is used to select lights for removal or modification.
+	Return Type: PointLightHandle
 	Param:
 	    Vector4 v4Color: The color of the light to be added.
 		Vector3 v3Position: The worldspace position of the light to be added.
 		float fRadius: The effective radius of the light to be added.
 	*/
-	int AddPointLight(NVZMathLib::Vector4 v4Color, NVZMathLib::Vector3 v3Position, float fRadius);
-
+	PointLightHandle AddPointLight(NVZMathLib::Vector4 v4Color, NVZMathLib::Vector3 v3Position, float fRadius);
 
 	/*
-	Description: Modify the position and radius of a light volume at the specified index.
+	Description: Modify the position and radius of a light.
 	Param:
-	    int nIndex: The index of the light instance to modify.
-	    Vector3 v3Position: The new position of the light volume.
+	    PointLightHandle handle: The handle of the light to modify.
+	    Vector3 v3Position: The new position of the light.
 	    float fRadius: The new radius of the light.
 	*/
-	void TransformPointLight(int nIndex, NVZMathLib::Vector3 v3Position, float fRadius);
+	void TransformPointLight(PointLightHandle handle, NVZMathLib::Vector3 v3Position, float fRadius);
 
 	/*
-	Description: Modify the position and radius of a light volume at the specified index.
+	Description: Modify the position of a light.
 	Param:
-	    int nIndex: The index of the light instance to modify.
-		Vector3 v3Position: The new position of the light volume.
-		float fRadius: The new radius of the light.
+	    PointLightHandle handle: The handle of the light to modify.
+		Vector3 v3Position: The new position of the light.
 	*/
-	void TransformPointLight(int nIndex, NVZMathLib::Vector3 v3Position);
+	void TransformPointLight(PointLightHandle handle, NVZMathLib::Vector3 v3Position);
 
 	/*
 	Description: Remove a light from the scene.
 	Param:
-	    int nIndex: The index of the light in the light array.
+	    PointLightHandle handle: The handle of the light to remove.
+	*/
+	void RemovePointLight(PointLightHandle handle);
+
+	/*
+	Description: Get the point light manager, for modifying many lights at once.
+	Return Type: PointLightManager*
+	*/
+	PointLightManager* GetPointLights();
+
+	/*
+	Description: Get the amount of point lights which passed frustum culling in the last RunDeferredPointLighting call.
+	Return Type: int
 	*/
-	void RemovePointLight(int nIndex);
+	int VisibleLightCount();
+
+	/*
+	Description: Get the amount of point lights rejected by frustum culling in the last RunDeferredPointLighting call.
+	Return Type: int
+	*/
+	int CulledLightCount();
 
 	/*
 	Description: Run deferred shading for directional lighting.
@@ -178,6 +357,13 @@ public:
 	*/
 	void UseDepthTextureOf(const Framebuffer* buffer);
 
+	/*
+	Description: Copy the contents of a depth stencil texture which is not owned by a framebuffer, such as a render graph texture, to the default FBO's depth texture.
+	Param:
+	    Texture* depthTexture: The depth stencil texture to copy from.
+	*/
+	void UseDepthTextureOf(Texture* depthTexture);
+
 	/*
 	Description: Print all OpenGL error codes to the console if any errors occur.
 	*/
@@ -198,6 +384,31 @@ public:
 	*/
 	void SetViewMatrix(glm::mat4 matrix, glm::vec3 v3ViewPos);
 
+	/*
+	Description: Offset the projection from the next Start by a fraction of a pixel, so each frame samples the scene at different positions.
+	Param:
+	    float fX: The horizontal offset in normalized device coordinates.
+		float fY: The vertical offset in normalized device coordinates.
+	*/
+	void SetProjectionJitter(float fX, float fY);
+
+	/*
+	Description: Rebind this frame's matrices without the projection jitter, for drawing directly to the backbuffer after temporal resolve.
+	*/
+	void RemoveProjectionJitter();
+
+	/*
+	Description: Get this frame's view projection matrix, without jitter.
+	Return Type: const mat4&
+	*/
+	const glm::mat4& ViewProjection() const;
+
+	/*
+	Description: Get the previous frame's view projection matrix, without jitter.
+	Return Type: const mat4&
+	*/
+	const glm::mat4& PreviousViewProjection() const;
+
 	// Width of the borderless window in pixels.
 	int WindowWidth();
 
@@ -206,11 +417,32 @@ public:
 
 private:
 
+	// Create state shared by the windowed and headless renderers once a context is current.
+	void Init();
+
 	void CreateBuffers();
 
+	// Create the light volume icosphere and its VAO, combining the sphere vertices with the visible light indices as instance data.
+	void CreateLightVolumeBuffers();
+
+	// Create the storage buffers used for clustered shading.
+	void CreateClusterBuffers();
+
+	// Point light shading techniques.
+	void RunLightVolumes();
+	void RunStencilLightVolumes();
+	void RunClusteredLighting();
+
+	// Write one indirect command per visible light volume into the upload ring, with no instances if the volume is occluded.
+	// Returns false if the commands could not be written, in which case every visible volume is drawn directly.
+	bool CullOccludedLights();
+
 	DynamicArray<Batch*> m_batches;
+	CommandBucket* m_commandBucket;
 
 	GLFWwindow* m_window;
+	HeadlessContext* m_headlessContext;
+	Framebuffer* m_offscreenBackbuffer; // Replaces the window framebuffer when headless.
 	int m_nWindowWidth;
 	int m_nWindowHeight;
 
@@ -226,36 +458,75 @@ private:
 	unsigned int m_glSkyVAO;
 	unsigned int m_glSkyVBO;
 
+	// Read framebuffer for copying depth from textures not owned by a framebuffer.
+	unsigned int m_glDepthCopyFBO;
+
 	// Matrix uniform buffer
 	struct ViewProjBlock
 	{
 		glm::mat4 m_viewMat;
 		glm::mat4 m_projMat;
 		glm::vec3 m_v3ViewPos;
+		float m_fPadding; // Fills the rest of viewPos's std140 slot.
+		glm::mat4 m_inverseViewProjMat; // Rebuilds world positions from depth.
 	};
 
 	ViewProjBlock m_matrices;
-	unsigned int m_glUBOMatrixHandle;
 
-	struct PointLight
-	{
-		NVZMathLib::Vector4 m_v4Color;
-		float m_modelMat[16];
-		float m_normalMatPadding[9];
-	};
+	// Upload matrices to the ring and bind them to the GlobalMatrices block.
+	void UploadMatrices(const ViewProjBlock& matrices);
+
+	// Reprojection, view projections are kept without jitter.
+	glm::mat4 m_unjitteredProjMat;
+	glm::mat4 m_viewProjection;
+	glm::mat4 m_previousViewProjection;
+	glm::vec2 m_v2ProjectionJitter;
 
 	// Directional lighting shader
 	Shader* m_directionalLightShader;
 	NVZMathLib::Vector3 m_v3DirectionalLightDir;
 	NVZMathLib::Vector3 m_v3DirectionalLightCol;
 
-	// Point lighting shader
+	// Point lighting shaders
 	Shader* m_pointLightShader;
-
-	// Light array
-	PointLight m_pointLights[MAX_LIGHT_COUNT];
-	int m_nPLightCount;
-
-	// Light buffer handles
-	Mesh* m_lightVolMesh;
+	Shader* m_lightStencilShader;
+
+	// Clustered lighting shaders
+	Shader* m_clusterAssignShader;
+	Shader* m_clusteredLightShader;
+	ELightingMode m_eLightingMode;
+	EGBufferLayout m_eGBufferLayout;
+
+	// Lights
+	PointLightManager* m_lightManager;
+
+	// Indices of lights inside the view frustum this frame, and the instance their copy in the upload ring starts at.
+	unsigned int m_visibleLights[MAX_LIGHT_COUNT];
+	int m_nVisibleLightCount;
+	unsigned int m_nVisibleLightBaseInstance;
+
+	// Light volume icosphere, drawn with one instance per visible light.
+	unsigned int m_glLightVolVAO;
+	unsigned int m_glLightVolVBO;
+	unsigned int m_glLightVolEBO;
+	int m_nLightVolIndexCount;
+
+	// Hi-Z occlusion culling, light volume commands are written to the upload ring at the command offset.
+	HiZBuffer* m_hiZBuffer;
+	Shader* m_hiZDownsampleShader;
+	Shader* m_lightOcclusionShader;
+	Shader* m_visibilityResolveShader;
+	unsigned int m_nLightCommandOffset;
+	bool m_bLightCommands;
+
+	// Clustered lighting storage buffers
+	unsigned int m_glClusterGridSSBOHandle;
+	unsigned int m_glClusterIndexSSBOHandle;
+	unsigned int m_glClusterCounterSSBOHandle; // Next free light index and the amount of clusters which didn't fit, cleared every frame.
+
+	// Counters of a past frame, copied to a mapped buffer and read once its fence has signalled so lighting never waits on them.
+	unsigned int m_glClusterReadbackHandle;
+	unsigned int* m_clusterReadback;
+	__GLsync* m_clusterReadbackFence;
+	bool m_bClusterOverflowReported;
 };
\ No newline at end of file
@@ -4,15 +4,23 @@
 #include <sstream>
 
 #include "glad/glad.h"
+#include "GLState.h"
+#include "CPUProfiler.h"
 
 #include "Renderer.h"
 
+std::string Shader::m_szGlobalDefines;
+
 Shader::Shader(const char* szVertShaderPath, const char* szFragShaderPath)
 {
+	CPU_PROFILE_ZONE("Shader::Shader");
+
 	m_glHandle = 0;
+	m_bReadsMaterialTable = false;
 
 	m_szVertShaderPath = szVertShaderPath;
 	m_szFragShaderPath = szFragShaderPath;
+	m_szCompShaderPath = nullptr;
 
 	// Load shader contents from shader files.
 	Load();
@@ -20,58 +28,15 @@ Shader::Shader(const char* szVertShaderPath, const char* szFragShaderPath)
 	// Create shader program.
 	m_glHandle = glCreateProgram();
 
-	const char* szVShaderCont = m_szVertShaderContents.c_str();
-	const char* szFShaderCont = m_szFragShaderContents.c_str();
-
-	// Shader compilation information.
-	int nCompilationSuccessful = 0;
-	char compilerOutput[512];
-
 	// -----------------------------------------------------------------------------------------
 	// Vertex Shader
 
-	unsigned int glVertShaderHandle = 0;
-	glVertShaderHandle = glCreateShader(GL_VERTEX_SHADER);
-
-	// Set shader source code.
-	glShaderSource(glVertShaderHandle, 1, &szVShaderCont, nullptr);
-
-	// Compile vertex shader.
-	glCompileShader(glVertShaderHandle);
-
-	// Get shader compilation results.
-	glGetShaderiv(glVertShaderHandle, GL_COMPILE_STATUS, &nCompilationSuccessful);
-
-	// If the compilation failed get the error output and print it to the console.
-	if(!nCompilationSuccessful) 
-	{
-		glGetShaderInfoLog(glVertShaderHandle, 512, nullptr, compilerOutput);
-
-		std::cout << "Shader Error: Vertex Shader compilation failed:\n" << compilerOutput << std::endl;
-	}
+	unsigned int glVertShaderHandle = CompileStage(GL_VERTEX_SHADER, m_szVertShaderContents.c_str(), "Vertex");
 
 	// -----------------------------------------------------------------------------------------
 	// Fragment Shader
 
-	unsigned int glFragShaderHandle = 0;
-	glFragShaderHandle = glCreateShader(GL_FRAGMENT_SHADER);
-
-	// Set shader source code.
-	glShaderSource(glFragShaderHandle, 1, &szFShaderCont, nullptr);
-
-	// Compile vertex shader.
-	glCompileShader(glFragShaderHandle);
-
-	// Get shader compilation results.
-	glGetShaderiv(glFragShaderHandle, GL_COMPILE_STATUS, &nCompilationSuccessful);
-
-	// If the compilation failed get the error output and print it to the console.
-	if (!nCompilationSuccessful)
-	{
-		glGetShaderInfoLog(glFragShaderHandle, 512, nullptr, compilerOutput);
-
-		std::cout << "Shader Error: Fragment Shader compilation failed:\n" << compilerOutput << std::endl;
-	}
+	unsigned int glFragShaderHandle = CompileStage(GL_FRAGMENT_SHADER, m_szFragShaderContents.c_str(), "Fragment");
 
 	// -----------------------------------------------------------------------------------------
 	// Shader program finalization
@@ -80,62 +45,59 @@ Shader::Shader(const char* szVertShaderPath, const char* szFragShaderPath)
 	glAttachShader(m_glHandle, glVertShaderHandle);
 	glAttachShader(m_glHandle, glFragShaderHandle);
 
-
-	// Link shader program.
-	glLinkProgram(m_glHandle);
-
-	// Link error logging...
-	glGetProgramiv(m_glHandle, GL_LINK_STATUS, &nCompilationSuccessful);
-
-	// Log any linking errors...
-	if (!nCompilationSuccessful)
-	{
-		glGetProgramInfoLog(m_glHandle, 512, nullptr, compilerOutput);
-
-		std::cout << "Shader Program Link Error: Program linking failed:\n" << compilerOutput << std::endl;
-	}
+	LinkProgram();
 
 	// Delete independent shaders...
 	glDeleteShader(glVertShaderHandle);
 	glDeleteShader(glFragShaderHandle);
+}
 
-	// Uniform block bindings...
-	unsigned int glMatrixUBOhandle = glGetUniformBlockIndex(m_glHandle, "GlobalMatrices");
+Shader::Shader(const char* szCompShaderPath)
+{
+	CPU_PROFILE_ZONE("Shader::Shader");
 
-	glUniformBlockBinding(m_glHandle, glMatrixUBOhandle, 0);
+	m_glHandle = 0;
+	m_bReadsMaterialTable = false;
 
-	// -----------------------------------------------------------------------------------------
-	// Sampler uniforms.
-	Use();
+	m_szVertShaderPath = nullptr;
+	m_szFragShaderPath = nullptr;
+	m_szCompShaderPath = szCompShaderPath;
 
-	for (int i = 0; i < 16; ++i)
-	{
-		// Get the name of the current sampler block...
-		std::string szSamplerName = "textureMaps[" + std::to_string(i) + "]";
+	// Load shader contents from the compute shader file.
+	Load();
 
-		int nSamplerLocation = glGetUniformLocation(m_glHandle, szSamplerName.c_str());
+	// Create shader program.
+	m_glHandle = glCreateProgram();
 
-		// Assign sampler location...
-		glUniform1i(nSamplerLocation, i);
-	}
+	// -----------------------------------------------------------------------------------------
+	// Compute Shader
+
+	unsigned int glCompShaderHandle = CompileStage(GL_COMPUTE_SHADER, m_szCompShaderContents.c_str(), "Compute");
 
-	glUseProgram(0);
 	// -----------------------------------------------------------------------------------------
+	// Shader program finalization
+
+	glAttachShader(m_glHandle, glCompShaderHandle);
+
+	LinkProgram();
+
+	// Delete independent shader...
+	glDeleteShader(glCompShaderHandle);
 }
 
 Shader::~Shader()
 {
-	glDeleteProgram(m_glHandle);
+	GLState::GetInstance()->DeleteProgram(m_glHandle);
 }
 
 void Shader::Use() 
 {
-	glUseProgram(m_glHandle);
+	GLState::GetInstance()->UseProgram(m_glHandle);
 }
 
 void Shader::ResetBinding() 
 {
-	glUseProgram(0);
+	GLState::GetInstance()->UseProgram(0);
 }
 
 unsigned int Shader::GetHandle() 
@@ -143,6 +105,23 @@ unsigned int Shader::GetHandle()
 	return m_glHandle;
 }
 
+bool Shader::ReadsMaterialTable()
+{
+	return m_bReadsMaterialTable;
+}
+
+void Shader::SetGlobalDefine(const char* szName, bool bDefined)
+{
+	std::string szLine = std::string("#define ") + szName + "\n";
+
+	size_t nPosition = m_szGlobalDefines.find(szLine);
+
+	if (bDefined && nPosition == std::string::npos)
+		m_szGlobalDefines += szLine;
+	else if (!bDefined && nPosition != std::string::npos)
+		m_szGlobalDefines.erase(nPosition, szLine.size());
+}
+
 void Shader::SetUniformInt(const char* szUniformName, int nValue)
 {
 	unsigned int glLocation = glGetUniformLocation(m_glHandle, szUniformName);
@@ -154,6 +133,18 @@ void Shader::SetUniformInt(unsigned int glUniformLocation, int nValue)
 	glUniform1i(glUniformLocation, nValue);
 }
 
+void Shader::SetUniformUInt(const char* szUniformName, unsigned int nValue)
+{
+	unsigned int glLocation = glGetUniformLocation(m_glHandle, szUniformName);
+	glUniform1ui(glLocation, nValue);
+}
+
+void Shader::SetUniformIVec2(const char* szUniformName, int nX, int nY)
+{
+	unsigned int glLocation = glGetUniformLocation(m_glHandle, szUniformName);
+	glUniform2i(glLocation, nX, nY);
+}
+
 void Shader::SetUniformFloat(const char* szUniformName, float fValue)
 {
 	unsigned int glLocation = glGetUniformLocation(m_glHandle, szUniformName);
@@ -198,8 +189,54 @@ void Shader::SetUniformVec4(unsigned int glUniformLocation, NVZMathLib::Vector4
 	glUniform4fv(glUniformLocation, 1, (float*)v4Value);
 }
 
+void Shader::SetUniformVec4Array(const char* szUniformName, const float* fValues, int nCount)
+{
+	unsigned int glLocation = glGetUniformLocation(m_glHandle, szUniformName);
+	glUniform4fv(glLocation, nCount, fValues);
+}
+
+void Shader::SetUniformMat4(const char* szUniformName, const float* fValue)
+{
+	unsigned int glLocation = glGetUniformLocation(m_glHandle, szUniformName);
+	glUniformMatrix4fv(glLocation, 1, GL_FALSE, fValue);
+}
+
+void Shader::SetUniformMat4(unsigned int glUniformLocation, const float* fValue)
+{
+	glUniformMatrix4fv(glUniformLocation, 1, GL_FALSE, fValue);
+}
+
 void Shader::Load() 
 {
+	// Compute programs only have a single source file.
+	if(m_szCompShaderPath) 
+	{
+		std::ifstream computeShaderFile;
+		computeShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+
+		try
+		{
+			computeShaderFile.open(m_szCompShaderPath);
+
+			std::stringstream computeShaderData;
+			computeShaderData << computeShaderFile.rdbuf();
+
+			computeShaderFile.close();
+
+			m_szCompShaderContents = computeShaderData.str();
+		}
+		catch (std::fstream::failure e)
+		{
+			std::cout << "Failed to load compute shader at:\n"
+				<< m_szCompShaderPath
+				<< "\n Error: "
+				<< e.what()
+				<< std::endl;
+		}
+
+		return;
+	}
+
 	// Input file stream
 	std::ifstream vertexShaderFile;
 	std::ifstream fragmentShaderFile;
@@ -240,3 +277,125 @@ void Shader::Load()
 			<< std::endl;
 	}
 }
+
+unsigned int Shader::CompileStage(unsigned int glStageType, const char* szSource, const char* szStageName)
+{
+	// Shader compilation information.
+	int nCompilationSuccessful = 0;
+	char compilerOutput[512];
+
+	unsigned int glStageHandle = glCreateShader(glStageType);
+
+	// Insert global defines after the #version directive, which must come first.
+	std::string szFinalSource = ExpandIncludes(szSource);
+
+	if(!m_szGlobalDefines.empty())
+	{
+		size_t nVersionEnd = szFinalSource.find('\n', szFinalSource.find("#version"));
+		szFinalSource.insert(nVersionEnd == std::string::npos ? szFinalSource.size() : nVersionEnd + 1, m_szGlobalDefines);
+	}
+
+	const char* szFinalSourcePtr = szFinalSource.c_str();
+
+	// Set shader source code.
+	glShaderSource(glStageHandle, 1, &szFinalSourcePtr, nullptr);
+
+	// Compile shader.
+	glCompileShader(glStageHandle);
+
+	// Get shader compilation results.
+	glGetShaderiv(glStageHandle, GL_COMPILE_STATUS, &nCompilationSuccessful);
+
+	// If the compilation failed get the error output and print it to the console.
+	if (!nCompilationSuccessful)
+	{
+		glGetShaderInfoLog(glStageHandle, 512, nullptr, compilerOutput);
+
+		std::cout << "Shader Error: " << szStageName << " Shader compilation failed:\n" << compilerOutput << std::endl;
+	}
+
+	return glStageHandle;
+}
+
+void Shader::LinkProgram()
+{
+	int nLinkSuccessful = 0;
+	char linkerOutput[512];
+
+	// Link shader program.
+	glLinkProgram(m_glHandle);
+
+	// Link error logging...
+	glGetProgramiv(m_glHandle, GL_LINK_STATUS, &nLinkSuccessful);
+
+	// Log any linking errors...
+	if (!nLinkSuccessful)
+	{
+		glGetProgramInfoLog(m_glHandle, 512, nullptr, linkerOutput);
+
+		std::cout << "Shader Program Link Error: Program linking failed:\n" << linkerOutput << std::endl;
+	}
+
+	// Uniform block bindings...
+	unsigned int glMatrixUBOhandle = glGetUniformBlockIndex(m_glHandle, "GlobalMatrices");
+
+	if(glMatrixUBOhandle != GL_INVALID_INDEX)
+	    glUniformBlockBinding(m_glHandle, glMatrixUBOhandle, 0);
+
+	// Shaders declaring the material table take their maps from it instead of the sampler array...
+	m_bReadsMaterialTable = glGetProgramResourceIndex(m_glHandle, GL_SHADER_STORAGE_BLOCK, "MaterialTableBuffer") != GL_INVALID_INDEX;
+
+	// -----------------------------------------------------------------------------------------
+	// Sampler uniforms.
+	Use();
+
+	for (int i = 0; i < 16; ++i)
+	{
+		// Get the name of the current sampler block...
+		std::string szSamplerName = "textureMaps[" + std::to_string(i) + "]";
+
+		int nSamplerLocation = glGetUniformLocation(m_glHandle, szSamplerName.c_str());
+
+		// Assign sampler location...
+		glUniform1i(nSamplerLocation, i);
+	}
+
+	GLState::GetInstance()->UseProgram(0);
+	// -----------------------------------------------------------------------------------------
+}
+
+std::string Shader::ExpandIncludes(const std::string& szSource)
+{
+	std::string szExpanded = szSource;
+	size_t nPosition = szExpanded.find("#include \"");
+
+	// Replace each directive line with the file it names, included files may include others...
+	while(nPosition != std::string::npos)
+	{
+		size_t nPathStart = nPosition + 10;
+		size_t nPathEnd = szExpanded.find('"', nPathStart);
+		size_t nLineEnd = szExpanded.find('\n', nPosition);
+
+		if (nPathEnd == std::string::npos || (nLineEnd != std::string::npos && nPathEnd > nLineEnd))
+			break;
+
+		std::string szPath = szExpanded.substr(nPathStart, nPathEnd - nPathStart);
+		std::ifstream includeFile(szPath);
+		std::string szContents;
+
+		if(includeFile.good())
+		{
+			std::stringstream includeData;
+			includeData << includeFile.rdbuf();
+
+			szContents = ExpandIncludes(includeData.str()) + "\n";
+		}
+		else
+			std::cout << "Shader Error: Failed to open included file: " << szPath << std::endl;
+
+		szExpanded.replace(nPosition, (nLineEnd == std::string::npos ? szExpanded.size() : nLineEnd + 1) - nPosition, szContents);
+		nPosition = szExpanded.find("#include \"", nPosition + szContents.size());
+	}
+
+	return szExpanded;
+}
@@ -8,6 +8,13 @@ public:
 
 	Shader(const char* szVertShaderPath, const char* szFragShaderPath);
 
+	/*
+	Description: Create a compute shader program from a single compute shader source file.
+	Param:
+	    const char* szCompShaderPath: Path to the compute shader source.
+	*/
+	Shader(const char* szCompShaderPath);
+
 	~Shader();
 
 	/*
@@ -26,12 +33,33 @@ public:
 	*/
 	unsigned int GetHandle();
 
+	/*
+	Description: Get whether this shader reads material maps from the MaterialTable, declared by the MaterialTableBuffer storage block.
+	Such shaders select their material with drawMaterials[drawOffset + gl_DrawIDARB], so draws of different materials can share a multi-draw.
+	Return Type: bool
+	*/
+	bool ReadsMaterialTable();
+
+	/*
+	Description: Define or undefine a macro in every shader stage compiled from now on, such as a G-buffer layout shared by scene and lighting shaders.
+	Param:
+	    const char* szName: The name of the macro.
+		bool bDefined: Whether the macro is defined.
+	*/
+	static void SetGlobalDefine(const char* szName, bool bDefined);
+
 	// Set uniform value in shader.
 	void SetUniformInt(const char* szUniformName, int nValue);
 
 	// Set uniform value in shader.
 	void SetUniformInt(unsigned int glUniformLocation, int nValue);
 
+	// Set uniform value in shader.
+	void SetUniformUInt(const char* szUniformName, unsigned int nValue);
+
+	// Set uniform value in shader.
+	void SetUniformIVec2(const char* szUniformName, int nX, int nY);
+
 	// Set uniform value in shader.
 	void SetUniformFloat(const char* szUniformName, float fValue);
 
@@ -56,17 +84,41 @@ public:
 	// Set uniform value in shader.
 	void SetUniformVec4(unsigned int glUniformLocation, NVZMathLib::Vector4 v4Value);
 
+	// Set uniform array value in shader.
+	void SetUniformVec4Array(const char* szUniformName, const float* fValues, int nCount);
+
+	// Set uniform value in shader.
+	void SetUniformMat4(const char* szUniformName, const float* fValue);
+
+	// Set uniform value in shader.
+	void SetUniformMat4(unsigned int glUniformLocation, const float* fValue);
+
 private:
 
 	// Loads the shader contents from the specified shader paths.
 	void Load();
 
+	// Compiles a single shader stage, logging any compiler output. Returns the stage handle.
+	unsigned int CompileStage(unsigned int glStageType, const char* szSource, const char* szStageName);
+
+	// Replaces #include "path" lines with the contents of the named file, paths are relative to the working directory like shader paths.
+	static std::string ExpandIncludes(const std::string& szSource);
+
+	// Links the program and assigns the default uniform block and sampler bindings.
+	void LinkProgram();
+
 	const char* m_szVertShaderPath;
 	const char* m_szFragShaderPath;
+	const char* m_szCompShaderPath;
 
 	std::string m_szVertShaderContents;
 	std::string m_szFragShaderContents;
+	std::string m_szCompShaderContents;
 
 	unsigned int m_glHandle;
+	bool m_bReadsMaterialTable;
+
+	// #define lines inserted after the #version directive of every stage.
+	static std::string m_szGlobalDefines;
 };
 
@@ -0,0 +1,47 @@
+// Hi-Z occlusion test shared by the instance and light culling passes.
+// Expects the including shader to declare the pyramid as hiZ, with hiZViewProjection and hiZMipCount.
+
+// Whether a worldspace sphere lies behind the farthest depth stored in the Hi-Z pyramid everywhere under its screen footprint.
+bool OccludedByHiZ(vec3 center, float radius)
+{
+    vec2 minNDC = vec2(1.0f);
+	vec2 maxNDC = vec2(-1.0f);
+	float nearestDepth = 1.0f;
+
+	// Project the corners of the sphere's bounding box. Projected depth isn't linear, but it grows with view depth, and the box's
+	// nearest view depth is at a corner, so the nearest projected corner is never behind any point of the box...
+	for(int i = 0; i < 8; ++i)
+	{
+	    vec3 corner = center + radius * vec3((i & 1) != 0 ? 1.0f : -1.0f, (i & 2) != 0 ? 1.0f : -1.0f, (i & 4) != 0 ? 1.0f : -1.0f);
+		vec4 clip = hiZViewProjection * vec4(corner, 1.0f);
+
+		// Bounds crossing the camera plane cover an unbounded screen area.
+		if(clip.w <= 0.0f)
+		    return false;
+
+		vec3 ndc = clip.xyz / clip.w;
+
+		minNDC = min(minNDC, ndc.xy);
+		maxNDC = max(maxNDC, ndc.xy);
+		nearestDepth = min(nearestDepth, ndc.z * 0.5f + 0.5f);
+	}
+
+	vec2 minUV = clamp(minNDC * 0.5f + 0.5f, 0.0f, 1.0f);
+	vec2 maxUV = clamp(maxNDC * 0.5f + 0.5f, 0.0f, 1.0f);
+
+	// Pick the level where the footprint spans at most two texels per axis, so four fetches cover it...
+	vec2 extent = (maxUV - minUV) * vec2(textureSize(hiZ, 0));
+	int level = clamp(int(ceil(log2(max(max(extent.x, extent.y), 1.0f)))), 0, hiZMipCount - 1);
+
+	ivec2 levelSize = textureSize(hiZ, level);
+	ivec2 minTexel = min(ivec2(minUV * vec2(levelSize)), levelSize - 1);
+	ivec2 maxTexel = min(ivec2(maxUV * vec2(levelSize)), levelSize - 1);
+
+	float farthestDepth = max
+	(
+	    max(texelFetch(hiZ, minTexel, level).r, texelFetch(hiZ, ivec2(maxTexel.x, minTexel.y), level).r),
+		max(texelFetch(hiZ, ivec2(minTexel.x, maxTexel.y), level).r, texelFetch(hiZ, maxTexel, level).r)
+	);
+
+	return nearestDepth > farthestDepth;
+}
\ No newline at end of file
@@ -0,0 +1,222 @@
+#version 440 core
+
+#define CLUSTER_GRID_X 16
+#define CLUSTER_GRID_Y 9
+#define CLUSTER_GRID_Z 24
+
+in vec2 texCoords;
+
+out vec4 fragColor;
+
+uniform sampler2D textureMaps[16];
+
+struct PointLight
+{
+    vec4 positionRadius;
+	vec4 color;
+};
+
+layout (std430, binding = 1) readonly buffer LightBuffer
+{
+    PointLight lights[];
+};
+
+// Offset of each cluster's lights in the index list and their count.
+layout (std430, binding = 2) readonly buffer ClusterGridBuffer
+{
+    uvec2 clusterLights[];
+};
+
+layout (std430, binding = 3) readonly buffer ClusterIndexBuffer
+{
+    uint clusterLightIndices[];
+};
+
+layout (std140) uniform GlobalMatrices
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    mat4 inverseViewProjection;
+};
+
+#ifdef GBUFFER_COMPACT
+
+// Inverse of the octahedral mapping G-buffer normals are stored with.
+vec3 OctahedralDecode(vec2 encoded) 
+{
+	vec3 normal = vec3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+	
+	// Unfold the lower hemisphere.
+	float fold = max(-normal.z, 0.0f);
+	normal.x += normal.x >= 0.0f ? -fold : fold;
+	normal.y += normal.y >= 0.0f ? -fold : fold;
+	
+	return normalize(normal);
+}
+
+// World position of the surface at the texture coordinates from its depth.
+vec3 ReconstructPosition(vec2 texCoord, float depth) 
+{
+	vec4 position = inverseViewProjection * vec4(texCoord * 2.0f - 1.0f, depth * 2.0f - 1.0f, 1.0f);
+	
+	return position.xyz / position.w;
+}
+
+#endif
+
+uniform float nearPlane;
+uniform float farPlane;
+
+#define PI 3.1415926535897932384626433832f
+#define E  2.71828182845904523536028747135f
+
+vec3 ShadePointLight(PointLight light, vec4 diffuse, vec4 position, vec4 normal, vec4 specularTexel, float roughness, float specularStrength, float reflectionCoefficient) 
+{
+	// -----------------------------------------------------------------------------
+	// Vectors
+	// Distance between the light and fragment position.
+	vec3 posDiff = light.positionRadius.xyz - position.xyz;
+	vec3 lightDir = normalize(posDiff);
+	float dist = length(posDiff);
+
+	// View direction and reflection vector.
+	vec3 viewDir = normalize(viewPos - position.xyz);
+    vec3 reflectionDir = reflect(-lightDir, normal.xyz);
+
+	// -----------------------------------------------------------------------------
+	// Attenuation
+	
+	// Attenuation function...
+	float attenuation = clamp(1.0f - dist / light.positionRadius.w, 0.0f, 1.0f);
+	attenuation *= attenuation;
+
+	// -----------------------------------------------------------------------------
+	// Physically Based Lighting
+	
+	// ---------------- Oren Nayar Diffuse -----------------
+	float roughnessSqr = roughness * roughness;
+	
+	float A = 1.0f - 0.5f * (roughnessSqr / (roughnessSqr + 0.33f));
+	float B = 0.45f * (roughnessSqr / (roughnessSqr + 0.09f)); 
+	
+	float normalDotLight = max(dot(normal.xyz, lightDir), 0.0f);
+	float normalDotView = max(dot(normal.xyz, viewDir), 0.0f);
+	
+	vec3 lightProj = normalize((lightDir - normal.xyz) * normalDotLight);
+    vec3 viewProj = normalize((viewDir - normal.xyz) * normalDotView); 
+	
+	float projDot = max(0.0f, dot(lightProj, viewProj));
+	
+	float alpha = sin(max(acos(normalDotView), acos(normalDotLight)));
+	float beta = tan(min(acos(normalDotView), acos(normalDotLight)));
+	
+	float orenNayar = normalDotLight * (A + (B * projDot * alpha * beta));
+	
+	// ---------------- Cook Torrence Specular -----------------
+	
+	vec3 halfVec = normalize(lightDir + viewDir);
+	
+	float reflectNormalDotView = max(dot(reflectionDir, viewDir), 0.0f);
+	
+	float normalDotHalf = max(dot(normal.xyz, halfVec), 0.0f);
+	float normalDotHalfSqr = normalDotHalf * normalDotHalf;
+	
+	float exponent = -(1 - normalDotHalfSqr) / (normalDotHalfSqr * roughnessSqr);
+	float D = exp(exponent) / (roughnessSqr * (normalDotHalfSqr * normalDotHalfSqr));
+	
+	float F = reflectionCoefficient + (1.0f - reflectionCoefficient) * pow(1.0f - reflectNormalDotView, 5);
+	
+	float frac = 2.0f * normalDotHalf / dot(viewDir, halfVec);
+	float G = min(1, min(frac * reflectNormalDotView, frac * normalDotLight));
+	
+	float cookTorrence = max((D * F * G) / (reflectNormalDotView * PI), 0.0f);
+	
+	// -----------------------------------------------------------------------------
+	// Lighting
+	
+    // Ambient component
+	vec3 lighting = diffuse.rgb * 0.1f; // 0.1 will be replaced with ambient color.
+
+	// Calculate specular.
+	float spec = pow(max(dot(viewDir, reflectionDir), 0.0f), specularTexel.a);
+    vec3 finalSpec = cookTorrence * specularStrength * specularTexel.rgb;
+
+    // Add to light level with attenuation, diffuse and light color.
+	lighting += orenNayar * diffuse.rgb * light.color.rgb;
+	lighting += finalSpec; // Add specular component.
+
+	return lighting * attenuation;
+}
+
+void main() 
+{
+	// Sample texels, once per pixel regardless of the amount of lights...
+#ifdef GBUFFER_COMPACT
+	float depth = texture(textureMaps[4], texCoords).r;
+	
+	// Nothing was written to the G-buffer here.
+	if(depth == 0.0f)
+	    discard;
+	
+	vec4 albedoRoughness = texture(textureMaps[0], texCoords);
+	vec4 specularReflection = texture(textureMaps[2], texCoords);
+	
+	vec4 diffuse = vec4(albedoRoughness.rgb, 1.0f);
+	vec4 position = vec4(ReconstructPosition(texCoords, depth), 1.0f);
+	vec4 normal = vec4(OctahedralDecode(texture(textureMaps[1], texCoords).rg), 0.0f);
+	vec4 specularTexel = vec4(specularReflection.rgb, 0.0f);
+	
+	// Specular strength is premultiplied into the specular color.
+	float roughness = albedoRoughness.a;
+	float specularStrength = 1.0f;
+	float reflectionCoefficient = specularReflection.a;
+#else
+    vec4 diffuse = texture(textureMaps[0], texCoords);
+	vec4 position = texture(textureMaps[1], texCoords);
+	vec4 normal = texture(textureMaps[2], texCoords);
+	vec4 specularTexel = texture(textureMaps[3], texCoords);
+	
+	// Nothing was written to the G-buffer here.
+	if(position.w == 0.0f)
+	    discard;
+	
+    normal.xyz = normalize(normal.xyz);
+
+	vec4 miscData = texture(textureMaps[4], texCoords);
+	
+	float roughness = miscData.r;
+	float specularStrength = miscData.g;
+	float reflectionCoefficient = miscData.b;
+#endif
+	
+	// -----------------------------------------------------------------------------
+	// Cluster lookup
+	
+	vec2 frameDimensions = vec2(textureSize(textureMaps[0], 0));
+	uvec2 tile = uvec2(gl_FragCoord.xy / frameDimensions * vec2(CLUSTER_GRID_X, CLUSTER_GRID_Y));
+	tile = min(tile, uvec2(CLUSTER_GRID_X - 1, CLUSTER_GRID_Y - 1));
+	
+	// Exponential depth slice, matching the slicing used for light assignment.
+	float viewDepth = -(view * vec4(position.xyz, 1.0f)).z;
+	float slice = log(max(viewDepth, nearPlane) / nearPlane) / log(farPlane / nearPlane) * float(CLUSTER_GRID_Z);
+	uint nSlice = min(uint(slice), uint(CLUSTER_GRID_Z - 1));
+	
+	uint clusterIndex = tile.x + (tile.y * CLUSTER_GRID_X) + (nSlice * CLUSTER_GRID_X * CLUSTER_GRID_Y);
+	
+	// -----------------------------------------------------------------------------
+	// Lighting
+	
+	uint nBaseIndex = clusterLights[clusterIndex].x;
+	uint nLightCount = clusterLights[clusterIndex].y;
+	
+	vec3 lighting = vec3(0.0f);
+	
+	for(uint i = 0; i < nLightCount; ++i)
+	    lighting += ShadePointLight(lights[clusterLightIndices[nBaseIndex + i]], diffuse, position, normal, specularTexel, roughness, specularStrength, reflectionCoefficient);
+
+	// Output.
+	fragColor = vec4(lighting, 1.0f);
+	
+	// -----------------------------------------------------------------------------
+}
\ No newline at end of file
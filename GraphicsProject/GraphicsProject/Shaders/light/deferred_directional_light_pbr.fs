@@ -15,8 +15,34 @@ layout (std140) uniform GlobalMatrices
     mat4 view;
     mat4 projection;
     vec3 viewPos;
+    mat4 inverseViewProjection;
 };
 
+#ifdef GBUFFER_COMPACT
+
+// Inverse of the octahedral mapping G-buffer normals are stored with.
+vec3 OctahedralDecode(vec2 encoded) 
+{
+	vec3 normal = vec3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+	
+	// Unfold the lower hemisphere.
+	float fold = max(-normal.z, 0.0f);
+	normal.x += normal.x >= 0.0f ? -fold : fold;
+	normal.y += normal.y >= 0.0f ? -fold : fold;
+	
+	return normalize(normal);
+}
+
+// World position of the surface at the texture coordinates from its depth.
+vec3 ReconstructPosition(vec2 texCoord, float depth) 
+{
+	vec4 position = inverseViewProjection * vec4(texCoord * 2.0f - 1.0f, depth * 2.0f - 1.0f, 1.0f);
+	
+	return position.xyz / position.w;
+}
+
+#endif
+
 #define CONSTANT 1.0f
 #define LINEAR_CONSTANT 0.7f * 2.0f / 0.5f
 #define QUADRATIC_CONSTANT 1.8f * 2.0f / 0.5f
@@ -27,6 +53,20 @@ layout (std140) uniform GlobalMatrices
 void main() 
 {
 	// Sample texels...
+#ifdef GBUFFER_COMPACT
+	vec4 albedoRoughness = texture(textureMaps[0], texCoords);
+	vec4 specularReflection = texture(textureMaps[2], texCoords);
+	
+	vec4 diffuse = vec4(albedoRoughness.rgb, 1.0f);
+	vec4 position = vec4(ReconstructPosition(texCoords, texture(textureMaps[4], texCoords).r), 1.0f);
+	vec4 normal = vec4(OctahedralDecode(texture(textureMaps[1], texCoords).rg), 0.0f);
+	vec4 specularTexel = vec4(specularReflection.rgb, 0.0f);
+	
+	// Specular strength is premultiplied into the specular color.
+	float roughness = albedoRoughness.a;
+	float specularStrength = 1.0f;
+	float reflectionCoefficient = specularReflection.a;
+#else
     vec4 diffuse = texture(textureMaps[0], texCoords);
 	vec4 position = texture(textureMaps[1], texCoords);
 	vec4 normal = texture(textureMaps[2], texCoords);
@@ -39,6 +79,7 @@ void main()
 	float roughness = miscData.r;
 	float specularStrength = miscData.g;
 	float reflectionCoefficient = miscData.b;
+#endif
 	
 	// -----------------------------------------------------------------------------
 	// Vectors
@@ -13,8 +13,34 @@ layout (std140) uniform GlobalMatrices
     mat4 view;
     mat4 projection;
     vec3 viewPos;
+    mat4 inverseViewProjection;
 };
 
+#ifdef GBUFFER_COMPACT
+
+// Inverse of the octahedral mapping G-buffer normals are stored with.
+vec3 OctahedralDecode(vec2 encoded) 
+{
+	vec3 normal = vec3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+	
+	// Unfold the lower hemisphere.
+	float fold = max(-normal.z, 0.0f);
+	normal.x += normal.x >= 0.0f ? -fold : fold;
+	normal.y += normal.y >= 0.0f ? -fold : fold;
+	
+	return normalize(normal);
+}
+
+// World position of the surface at the texture coordinates from its depth.
+vec3 ReconstructPosition(vec2 texCoord, float depth) 
+{
+	vec4 position = inverseViewProjection * vec4(texCoord * 2.0f - 1.0f, depth * 2.0f - 1.0f, 1.0f);
+	
+	return position.xyz / position.w;
+}
+
+#endif
+
 #define CONSTANT 1.0f
 #define LINEAR_CONSTANT 0.7f * 2.0f / 0.5f
 #define QUADRATIC_CONSTANT 1.8f * 2.0f / 0.5f
@@ -37,6 +63,20 @@ void main()
 	fragTexCoord.y /= float(frameDimensions.y);
 	
 	// Sample texels...
+#ifdef GBUFFER_COMPACT
+	vec4 albedoRoughness = texture(textureMaps[0], fragTexCoord);
+	vec4 specularReflection = texture(textureMaps[2], fragTexCoord);
+	
+	vec4 diffuse = vec4(albedoRoughness.rgb, 1.0f);
+	vec4 position = vec4(ReconstructPosition(fragTexCoord, texture(textureMaps[4], fragTexCoord).r), 1.0f);
+	vec4 normal = vec4(OctahedralDecode(texture(textureMaps[1], fragTexCoord).rg), 0.0f);
+	vec4 specularTexel = vec4(specularReflection.rgb, 0.0f);
+	
+	// Specular strength is premultiplied into the specular color.
+	float roughness = albedoRoughness.a;
+	float specularStrength = 1.0f;
+	float reflectionCoefficient = specularReflection.a;
+#else
     vec4 diffuse = texture(textureMaps[0], fragTexCoord);
 	vec4 position = texture(textureMaps[1], fragTexCoord);
 	vec4 normal = texture(textureMaps[2], fragTexCoord);
@@ -49,6 +89,7 @@ void main()
 	float roughness = miscData.r;
 	float specularStrength = miscData.g;
 	float reflectionCoefficient = miscData.b;
+#endif
 	
 	// -----------------------------------------------------------------------------
 	// Vectors
@@ -1,17 +1,25 @@
 #version 440 core
 
-layout (location = 0) in vec4 vertPos;
-layout (location = 1) in vec4 normal;
-layout (location = 2) in vec4 tangent;
-layout (location = 3) in vec2 texCoords;
-layout (location = 4) in vec4 color; // Radius in w.
-layout (location = 5) in mat4 model;
+layout (location = 0) in vec3 vertPos;
+layout (location = 4) in uint lightIndex;
+
+struct PointLight
+{
+    vec4 positionRadius;
+	vec4 color;
+};
+
+layout (std430, binding = 1) readonly buffer LightBuffer
+{
+    PointLight lights[];
+};
 
 layout (std140) uniform GlobalMatrices
 {
     mat4 view;
     mat4 projection;
     vec3 viewPos;
+    mat4 inverseViewProjection;
 };
 
 out vec4 lightColorRadius;
@@ -20,11 +28,14 @@ out vec2 fragPos;
 
 void main() 
 {
-    lightColorRadius = color;
+    vec4 positionRadius = lights[lightIndex].positionRadius;
+
+    lightColorRadius = vec4(lights[lightIndex].color.rgb, positionRadius.w);
 	
-	lightPos = vec3(model[3][0], model[3][1], model[3][2]);
+	lightPos = positionRadius.xyz;
 	
-	vec4 outPos = projection * view * model * vertPos;
+	// Scale unit sphere by radius and move it to the light position.
+	vec4 outPos = projection * view * vec4((vertPos * positionRadius.w) + lightPos, 1.0);
 	
 	fragPos = outPos.xy;
 	
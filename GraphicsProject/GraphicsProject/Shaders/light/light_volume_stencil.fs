@@ -0,0 +1,7 @@
+#version 440 core
+
+// Only the stencil buffer is written when marking light volumes.
+void main() 
+{
+    
+}
\ No newline at end of file
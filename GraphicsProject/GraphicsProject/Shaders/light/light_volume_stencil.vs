@@ -0,0 +1,30 @@
+#version 440 core
+
+layout (location = 0) in vec3 vertPos;
+layout (location = 4) in uint lightIndex;
+
+struct PointLight
+{
+    vec4 positionRadius;
+	vec4 color;
+};
+
+layout (std430, binding = 1) readonly buffer LightBuffer
+{
+    PointLight lights[];
+};
+
+layout (std140) uniform GlobalMatrices
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
+
+void main() 
+{
+    vec4 positionRadius = lights[lightIndex].positionRadius;
+	
+	// Scale unit sphere by radius and move it to the light position.
+	gl_Position = projection * view * vec4((vertPos * positionRadius.w) + positionRadius.xyz, 1.0);
+}
\ No newline at end of file
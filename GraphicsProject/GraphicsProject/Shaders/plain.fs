@@ -1,13 +1,66 @@
 #version 440 core
 
+#ifdef MATERIAL_TABLE
+#extension GL_ARB_bindless_texture : require
+#endif
+
 in vec4 modelColor;
 in vec4 fragPos;
 in vec2 modelTexCoords;
 in vec3 modelNormal;
 in float shininess;
 
+#ifdef MATERIAL_TABLE
+#define MATERIAL_TABLE_MAP_COUNT 16
+
+flat in uint materialSlot;
+
+// Bindless handles of every material's maps, the slot is the same for every fragment of a draw.
+layout (std430, binding = 7) readonly buffer MaterialTableBuffer
+{
+    uvec2 materialMaps[];
+};
+
+// Construct a sampler from the handle of one of the draw's material maps.
+#define MaterialMap(map) sampler2D(materialMaps[materialSlot * MATERIAL_TABLE_MAP_COUNT + (map)])
+#else
 uniform sampler2D textureMaps[16];
 
+#define MaterialMap(map) textureMaps[map]
+#endif
+
+#ifdef NORMAL_MAP
+in mat3 tbnMat;
+
+// Tangent space normal from the X and Y of a normal map, Z is rebuilt from the unit length so two channel BC5 maps work too.
+vec3 UnpackNormalMap(vec2 normalXY)
+{
+	normalXY = normalXY * 2.0f - 1.0f;
+
+	return vec3(normalXY, sqrt(max(1.0f - dot(normalXY, normalXY), 0.0f)));
+}
+#endif
+
+#ifdef GBUFFER_COMPACT
+
+layout (location = 0) out vec4 fragAlbedoRoughnessOut;
+layout (location = 1) out vec2 fragNormalOut;
+layout (location = 2) out vec4 fragSpecularReflectionOut;
+layout (location = 3) out vec3 fragEmissionOut;
+layout (location = 4) out float fragDepthOut;
+
+// Map a unit vector onto an octahedron unfolded into the [-1, 1] square.
+vec2 OctahedralEncode(vec3 normal) 
+{
+	normal /= abs(normal.x) + abs(normal.y) + abs(normal.z);
+	
+	vec2 signs = vec2(normal.x >= 0.0f ? 1.0f : -1.0f, normal.y >= 0.0f ? 1.0f : -1.0f);
+	
+	return normal.z >= 0.0f ? normal.xy : (1.0f - abs(normal.yx)) * signs;
+}
+
+#else
+
 layout (location = 0) out vec4 fragDiffuseOut;
 layout (location = 1) out vec4 fragPositionOut;
 layout (location = 2) out vec4 fragNormalOut;
@@ -15,15 +68,33 @@ layout (location = 3) out vec4 fragSpecularOut;
 layout (location = 4) out vec3 fragRoughnessOut;
 layout (location = 5) out vec3 fragEmissionOut;
 
+#endif
+
 void main() 
 {
+#ifdef NORMAL_MAP
+	// The only map is the normal map, translated from tangent space to worldspace.
+	vec3 finalNormal = tbnMat * UnpackNormalMap(texture(MaterialMap(0), modelTexCoords).xy);
+#else
+    vec3 finalNormal = modelNormal;
+#endif
+	
+	// Roughness, specular strength and reflection coefficient.
+	vec3 material = vec3(0.3f, 0.0f, 0.5f);
+
+#ifdef GBUFFER_COMPACT
+	fragAlbedoRoughnessOut = vec4(1.0f, 1.0f, 1.0f, material.r);
+	fragNormalOut = OctahedralEncode(normalize(finalNormal));
+	
+	// Specular strength is premultiplied, position is rebuilt from depth.
+	fragSpecularReflectionOut = vec4(vec3(1.0f) * material.g, material.b);
+	fragDepthOut = gl_FragCoord.z;
+#else
     fragDiffuseOut = vec4(1.0f);
 	
 	// Output position.
     fragPositionOut = vec4(fragPos.xyz, 1.0f); // Position
 	
-    vec3 finalNormal = modelNormal;
-	
 	// Output normal
     fragNormalOut = vec4(finalNormal, 1.0f);
 
@@ -31,7 +102,8 @@ void main()
 	fragSpecularOut = vec4(1.0f);
 	
 	// Output roughness
-	fragRoughnessOut = vec3(0.3f, 0.0f, 0.5f);
+	fragRoughnessOut = material;
+#endif
 	
 	// Output emission
 	fragEmissionOut = vec3(0.0f);
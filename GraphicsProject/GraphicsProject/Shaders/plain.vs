@@ -1,5 +1,9 @@
 #version 440 core
 
+#ifdef MATERIAL_TABLE
+#extension GL_ARB_shader_draw_parameters : require
+#endif
+
 layout (location = 0) in vec4 vertPos;
 layout (location = 1) in vec4 normal;
 layout (location = 2) in vec4 tangent;
@@ -16,20 +20,44 @@ layout (std140) uniform GlobalMatrices
 
 uniform float specularShininess;
 
+#ifdef MATERIAL_TABLE
+// Material table slot of every draw submitted by the command bucket.
+layout (std430, binding = 8) readonly buffer DrawMaterialBuffer
+{
+    uint drawMaterials[];
+};
+
+uniform int drawOffset;
+
+flat out uint materialSlot;
+#endif
+
 out vec4 modelColor;
 out vec4 fragPos;
 out vec3 modelNormal;
 out vec2 modelTexCoords;
 out float shininess;
 
+#ifdef NORMAL_MAP
+out mat3 tbnMat;
+#endif
+
 void main() 
 {
     // Pass to next stage...
+#ifdef MATERIAL_TABLE
+	materialSlot = drawMaterials[drawOffset + gl_DrawIDARB];
+#endif
     modelColor = color;
 	modelNormal = normal.xyz;
 	modelTexCoords = texCoords * 2;
 	shininess = specularShininess;
 	
+#ifdef NORMAL_MAP
+	vec3 biTangent = cross(normal.xyz, tangent.xyz); // Calculate biTangent.
+	tbnMat = mat3(normalMat * tangent.xyz, normalMat * biTangent, normalMat * normal.xyz); // Calculate TBN matrix.
+#endif
+	
 	fragPos = model * vertPos; // Get worldspace fragment position.
 
     gl_Position = projection * view * model * vertPos;
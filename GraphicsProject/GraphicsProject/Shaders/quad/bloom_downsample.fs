@@ -0,0 +1,58 @@
+#version 440 core
+
+layout (location = 0) out vec3 fragOut;
+
+in vec2 texCoords;
+
+uniform sampler2D textureMaps[16];
+
+vec3 Tap(vec2 coords)
+{
+    vec3 color = texture(textureMaps[0], coords).rgb;
+
+#ifdef BLOOM_PREFILTER
+	// The first level reads the lit scene, only colors bright enough to bloom are kept.
+	float brightness = dot(color, vec3(0.2126f, 0.7152f, 0.0722f));
+	color *= int(brightness > 1.0f);
+#endif
+
+	return color;
+}
+
+// Halve the previous bloom level with 13 bilinear taps, five overlapping 2x2 box filters weighted towards the center. (Jimenez, Next Generation Post Processing in Call of Duty: Advanced Warfare)
+void main() 
+{
+    vec2 texelSize = vec2(1.0f) / textureSize(textureMaps[0], 0);
+
+#ifdef BLOOM_PREFILTER
+	// The full resolution scene is kept to four taps between texels, averaging the 4x4 texels under the pixel.
+	vec3 box = Tap(texCoords + texelSize * vec2(-1.0f, -1.0f));
+	box += Tap(texCoords + texelSize * vec2(1.0f, -1.0f));
+	box += Tap(texCoords + texelSize * vec2(-1.0f, 1.0f));
+	box += Tap(texCoords + texelSize * vec2(1.0f, 1.0f));
+
+	fragOut = box * 0.25f;
+#else
+	vec3 center = Tap(texCoords);
+
+	// Inner box, one source texel from the center...
+	vec3 inner = Tap(texCoords + texelSize * vec2(-1.0f, -1.0f));
+	inner += Tap(texCoords + texelSize * vec2(1.0f, -1.0f));
+	inner += Tap(texCoords + texelSize * vec2(-1.0f, 1.0f));
+	inner += Tap(texCoords + texelSize * vec2(1.0f, 1.0f));
+
+	// Outer corners and edges, two source texels from the center...
+	vec3 corners = Tap(texCoords + texelSize * vec2(-2.0f, -2.0f));
+	corners += Tap(texCoords + texelSize * vec2(2.0f, -2.0f));
+	corners += Tap(texCoords + texelSize * vec2(-2.0f, 2.0f));
+	corners += Tap(texCoords + texelSize * vec2(2.0f, 2.0f));
+
+	vec3 edges = Tap(texCoords + texelSize * vec2(-2.0f, 0.0f));
+	edges += Tap(texCoords + texelSize * vec2(2.0f, 0.0f));
+	edges += Tap(texCoords + texelSize * vec2(0.0f, -2.0f));
+	edges += Tap(texCoords + texelSize * vec2(0.0f, 2.0f));
+
+	// The inner box carries half the weight, the four outer boxes an eighth each.
+	fragOut = center * 0.125f + inner * 0.125f + corners * 0.03125f + edges * 0.0625f;
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#version 440 core
+
+layout (location = 0) out vec3 fragOut;
+
+in vec2 texCoords;
+
+uniform sampler2D textureMaps[16];
+
+void main() 
+{
+    // Blur the lower level with a bilinear 3x3 tent while doubling its resolution, then add this level's downsample.
+	vec2 texelSize = vec2(1.0f) / textureSize(textureMaps[0], 0);
+
+	vec3 blur = texture(textureMaps[0], texCoords).rgb * 4.0f;
+
+	blur += texture(textureMaps[0], texCoords + texelSize * vec2(-1.0f, 0.0f)).rgb * 2.0f;
+	blur += texture(textureMaps[0], texCoords + texelSize * vec2(1.0f, 0.0f)).rgb * 2.0f;
+	blur += texture(textureMaps[0], texCoords + texelSize * vec2(0.0f, -1.0f)).rgb * 2.0f;
+	blur += texture(textureMaps[0], texCoords + texelSize * vec2(0.0f, 1.0f)).rgb * 2.0f;
+
+	blur += texture(textureMaps[0], texCoords + texelSize * vec2(-1.0f, -1.0f)).rgb;
+	blur += texture(textureMaps[0], texCoords + texelSize * vec2(1.0f, -1.0f)).rgb;
+	blur += texture(textureMaps[0], texCoords + texelSize * vec2(-1.0f, 1.0f)).rgb;
+	blur += texture(textureMaps[0], texCoords + texelSize * vec2(1.0f, 1.0f)).rgb;
+
+	fragOut = texture(textureMaps[1], texCoords).rgb + blur * (1.0f / 16.0f);
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#version 440 core
+
+// The final post processing pass, permutations are compiled with COLOR_GRADING defined or not.
+
+layout (location = 0) out vec3 fragOut;
+
+in vec2 texCoords;
+
+uniform sampler2D textureMaps[16];
+
+#ifdef COLOR_GRADING
+layout (binding = 2) uniform sampler3D colorGradingLUT;
+
+// Maps [0, 1] onto the centers of the first and last texels of the lookup table.
+uniform vec2 lutScaleOffset;
+#endif
+
+// Written by exposure_adapt.comp, never read back by the CPU.
+layout (std430, binding = 14) readonly buffer ExposureBuffer
+{
+    float adaptedLuminance;
+	float exposure;
+};
+
+uniform float bloomStrength;
+
+void main() 
+{
+    vec3 fragColor = texture(textureMaps[0], texCoords).rgb;
+	vec3 fragBloomBlur = texture(textureMaps[1], texCoords).rgb * bloomStrength;
+    
+	// Exposure tone mapping
+	vec3 mappedColor = vec3(1.0f) - exp(-(fragColor + fragBloomBlur) * exposure);
+	
+	// Gamma correction
+    mappedColor = pow(mappedColor, vec3(1.0f / 1.2f));
+
+#ifdef COLOR_GRADING
+	// Graded in display space, the space the lookup table was painted in.
+	mappedColor = texture(colorGradingLUT, mappedColor * lutScaleOffset.x + lutScaleOffset.y).rgb;
+#endif
+	
+	fragOut = mappedColor;
+}
\ No newline at end of file
@@ -6,9 +6,16 @@ in vec2 texCoords;
 
 uniform sampler2D textureMaps[16];
 
+// G-buffer emission target.
+#ifdef GBUFFER_COMPACT
+#define EMISSION_MAP 3
+#else
+#define EMISSION_MAP 5
+#endif
+
 void main() 
 {
-    vec4 fragColor = texture(textureMaps[0], texCoords) + (texture(textureMaps[5], texCoords) * 20.0f);
+    vec4 fragColor = texture(textureMaps[0], texCoords) + (texture(textureMaps[EMISSION_MAP], texCoords) * 20.0f);
 
     fragOut = vec4(fragColor.rgb * 0.1f, 1.0f);
 
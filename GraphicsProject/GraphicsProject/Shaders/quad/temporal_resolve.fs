@@ -0,0 +1,103 @@
+#version 440 core
+
+layout (location = 0) out vec3 fragOut;
+
+in vec2 texCoords;
+
+// 0: Current HDR color at render resolution, 1: Velocity at render resolution, 2: History at output resolution.
+uniform sampler2D textureMaps[16];
+
+uniform vec2 jitter;
+uniform float feedback;
+uniform int historyValid;
+
+float Luminance(vec3 color) 
+{
+	return dot(color, vec3(0.2126f, 0.7152f, 0.0722f));
+}
+
+// Catmull-Rom filtered history, bilinear filtering would blur the history a little more each frame it is reprojected.
+// The 16 taps are reduced to 5 bilinear fetches by merging the middle taps and skipping the corners.
+vec3 SampleHistory(vec2 coords, vec2 size) 
+{
+	vec2 samplePos = coords * size;
+	vec2 texPos1 = floor(samplePos - 0.5f) + 0.5f;
+	vec2 f = samplePos - texPos1;
+	
+	vec2 w0 = f * (-0.5f + f * (1.0f - 0.5f * f));
+	vec2 w1 = 1.0f + f * f * (-2.5f + 1.5f * f);
+	vec2 w2 = f * (0.5f + f * (2.0f - 1.5f * f));
+	vec2 w3 = f * f * (-0.5f + 0.5f * f);
+	
+	vec2 w12 = w1 + w2;
+	vec2 texPos0 = (texPos1 - 1.0f) / size;
+	vec2 texPos3 = (texPos1 + 2.0f) / size;
+	vec2 texPos12 = (texPos1 + w2 / w12) / size;
+	
+	vec3 result = texture(textureMaps[2], vec2(texPos12.x, texPos0.y)).rgb * w12.x * w0.y;
+	result += texture(textureMaps[2], vec2(texPos0.x, texPos12.y)).rgb * w0.x * w12.y;
+	result += texture(textureMaps[2], vec2(texPos12.x, texPos12.y)).rgb * w12.x * w12.y;
+	result += texture(textureMaps[2], vec2(texPos3.x, texPos12.y)).rgb * w3.x * w12.y;
+	result += texture(textureMaps[2], vec2(texPos12.x, texPos3.y)).rgb * w12.x * w3.y;
+	
+	float weight = w12.x * w0.y + w0.x * w12.y + w12.x * w12.y + w3.x * w12.y + w12.x * w3.y;
+	
+	// The negative lobes can undershoot next to bright pixels.
+	return max(result / weight, vec3(0.0f));
+}
+
+void main() 
+{
+	vec2 renderSize = vec2(textureSize(textureMaps[0], 0));
+	vec2 outputSize = vec2(textureSize(textureMaps[2], 0));
+	
+	// Find the current frame's sample nearest to this output pixel, the scene is shifted by the jitter in the current frame.
+	vec2 renderPos = (texCoords + jitter * 0.5f) * renderSize - 0.5f;
+	ivec2 nearestTexel = clamp(ivec2(floor(renderPos + 0.5f)), ivec2(0), ivec2(renderSize) - 1);
+	
+	// Sample the neighbourhood, its color distribution limits the history to colors still present in the current frame.
+	vec3 currentColor = vec3(0.0f);
+	vec3 moment1 = vec3(0.0f);
+	vec3 moment2 = vec3(0.0f);
+	
+	for(int y = -1; y <= 1; ++y)
+	{
+		for(int x = -1; x <= 1; ++x)
+		{
+			ivec2 texel = clamp(nearestTexel + ivec2(x, y), ivec2(0), ivec2(renderSize) - 1);
+			vec3 color = texelFetch(textureMaps[0], texel, 0).rgb;
+			
+			moment1 += color;
+			moment2 += color * color;
+			
+			if(x == 0 && y == 0)
+				currentColor = color;
+		}
+	}
+	
+	// Reproject...
+	vec2 historyCoords = texCoords - texelFetch(textureMaps[1], nearestTexel, 0).rg;
+	
+	if(historyValid == 0 || any(lessThan(historyCoords, vec2(0.0f))) || any(greaterThan(historyCoords, vec2(1.0f))))
+	{
+		fragOut = currentColor;
+		return;
+	}
+	
+	// Clamp to the neighbourhood's mean plus or minus its standard deviation, tighter than its minimum and maximum so less ghosting survives.
+	vec3 mean = moment1 / 9.0f;
+	vec3 deviation = sqrt(max(moment2 / 9.0f - mean * mean, vec3(0.0f)));
+	
+	vec3 historyColor = clamp(SampleHistory(historyCoords, outputSize), mean - deviation, mean + deviation);
+	
+	// Samples count less the further they land from the output pixel's centre, measured in output pixels.
+	vec2 sampleOffset = (renderPos - vec2(nearestTexel)) * outputSize / renderSize;
+	float currentWeight = feedback * exp(-2.29f * dot(sampleOffset, sampleOffset));
+	float historyWeight = 1.0f - currentWeight;
+	
+	// Weigh by inverse luminance so single bright samples do not flicker.
+	currentWeight /= 1.0f + Luminance(currentColor);
+	historyWeight /= 1.0f + Luminance(historyColor);
+	
+	fragOut = (currentColor * currentWeight + historyColor * historyWeight) / (currentWeight + historyWeight);
+}
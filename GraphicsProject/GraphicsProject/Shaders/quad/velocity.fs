@@ -0,0 +1,28 @@
+#version 440 core
+
+layout (location = 0) out vec2 fragVelocityOut;
+
+in vec2 texCoords;
+
+uniform sampler2D textureMaps[16];
+
+uniform mat4 inverseViewProjection;
+uniform mat4 previousViewProjection;
+uniform vec2 jitter;
+
+void main() 
+{
+	float depth = texture(textureMaps[0], texCoords).r;
+	
+	// Position of this pixel without the projection jitter, the far plane where nothing was drawn.
+	vec2 currentPos = texCoords * 2.0f - 1.0f - jitter;
+	
+	vec4 worldPos = inverseViewProjection * vec4(currentPos, depth * 2.0f - 1.0f, 1.0f);
+	worldPos /= worldPos.w;
+	
+	// Project into last frame...
+	vec4 previousPos = previousViewProjection * vec4(worldPos.xyz, 1.0f);
+	
+	// Screen space motion since last frame, in texture coordinates.
+	fragVelocityOut = (currentPos - previousPos.xy / previousPos.w) * 0.5f;
+}
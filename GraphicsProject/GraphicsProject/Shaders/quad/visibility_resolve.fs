@@ -0,0 +1,258 @@
+#version 440 core
+#extension GL_ARB_bindless_texture : enable
+
+// Must match VISIBILITY_NO_MATERIAL in CommandBucket.h.
+#define VISIBILITY_NO_MATERIAL 0xFFFFFFFFu
+
+// Sizes of a Mesh::Vertex and an instance in 32-bit words.
+#define VERTEX_WORD_COUNT 14
+#define INSTANCE_WORD_COUNT 29
+
+#define MATERIAL_TABLE_MAP_COUNT 16
+
+in vec2 texCoords;
+
+layout (std140) uniform GlobalMatrices
+{
+    mat4 view;
+    mat4 projection;
+};
+
+struct VisibilityDraw
+{
+    uint firstIndex;
+	int baseVertex;
+	uint baseInstance;
+	uint materialSlot;
+	uint firstSlot;
+	uint source;
+};
+
+// Instances of the source being resolved.
+layout (std430, binding = 15) readonly buffer InstanceBuffer
+{
+    uint instanceWords[];
+};
+
+// Vertices and indices of the source being resolved.
+layout (std430, binding = 9) readonly buffer VertexBuffer
+{
+    float vertexWords[];
+};
+
+layout (std430, binding = 10) readonly buffer IndexBuffer
+{
+    uint indices[];
+};
+
+// Draws in order of their first slots.
+layout (std430, binding = 11) readonly buffer VisibilityDrawBuffer
+{
+    VisibilityDraw draws[];
+};
+
+#ifdef GL_ARB_bindless_texture
+
+layout (std430, binding = 7) readonly buffer MaterialTableBuffer
+{
+    uvec2 materialMaps[];
+};
+
+#define MaterialMap(slot, map) sampler2D(materialMaps[(slot) * MATERIAL_TABLE_MAP_COUNT + (map)])
+
+#endif
+
+layout (binding = 0) uniform usampler2D visibilityMap;
+layout (binding = 1) uniform sampler2D depthMap;
+
+// Pixels of draws from other sources are resolved by their own pass.
+uniform int visibilitySource;
+uniform int visibilityDrawCount;
+
+layout (location = 0) out vec4 fragAlbedoRoughnessOut;
+layout (location = 1) out vec2 fragNormalOut;
+layout (location = 2) out vec4 fragSpecularReflectionOut;
+layout (location = 3) out vec3 fragEmissionOut;
+layout (location = 4) out float fragDepthOut;
+
+// Perspective correct barycentrics of a pixel within a triangle, along with their change to the neighbouring pixels.
+struct Barycentrics
+{
+    vec3 lambda;
+	vec3 ddx;
+	vec3 ddy;
+};
+
+// Map a unit vector onto an octahedron unfolded into the [-1, 1] square.
+vec2 OctahedralEncode(vec3 normal)
+{
+	normal /= abs(normal.x) + abs(normal.y) + abs(normal.z);
+
+	vec2 signs = vec2(normal.x >= 0.0f ? 1.0f : -1.0f, normal.y >= 0.0f ? 1.0f : -1.0f);
+
+	return normal.z >= 0.0f ? normal.xy : (1.0f - abs(normal.yx)) * signs;
+}
+
+// Tangent space normal from the X and Y of a normal map, Z is rebuilt from the unit length so two channel BC5 maps work too.
+vec3 UnpackNormalMap(vec2 normalXY)
+{
+	normalXY = normalXY * 2.0f - 1.0f;
+
+	return vec3(normalXY, sqrt(max(1.0f - dot(normalXY, normalXY), 0.0f)));
+}
+
+vec4 InstanceVec4(uint word)
+{
+    return uintBitsToFloat(uvec4(instanceWords[word], instanceWords[word + 1], instanceWords[word + 2], instanceWords[word + 3]));
+}
+
+vec3 InstanceVec3(uint word)
+{
+    return uintBitsToFloat(uvec3(instanceWords[word], instanceWords[word + 1], instanceWords[word + 2]));
+}
+
+vec4 VertexVec4(uint word)
+{
+    return vec4(vertexWords[word], vertexWords[word + 1], vertexWords[word + 2], vertexWords[word + 3]);
+}
+
+// Barycentrics from the clip space corners of the triangle, the pixel's NDC position and the NDC size of a pixel. (Schied & Dachsbacher)
+Barycentrics CalculateBarycentrics(vec4 clip0, vec4 clip1, vec4 clip2, vec2 pixelNDC, vec2 pixelSize)
+{
+    Barycentrics result;
+
+	vec3 invW = 1.0f / vec3(clip0.w, clip1.w, clip2.w);
+
+	vec2 ndc0 = clip0.xy * invW.x;
+	vec2 ndc1 = clip1.xy * invW.y;
+	vec2 ndc2 = clip2.xy * invW.z;
+
+	// Screen space gradients of the barycentrics divided by w...
+	float invDet = 1.0f / determinant(mat2(ndc2 - ndc1, ndc0 - ndc1));
+	vec3 ddx = vec3(ndc1.y - ndc2.y, ndc2.y - ndc0.y, ndc0.y - ndc1.y) * invDet * invW;
+	vec3 ddy = vec3(ndc2.x - ndc1.x, ndc0.x - ndc2.x, ndc1.x - ndc0.x) * invDet * invW;
+
+	float ddxSum = ddx.x + ddx.y + ddx.z;
+	float ddySum = ddy.x + ddy.y + ddy.z;
+
+	// Interpolate 1 / w and the barycentrics divided by w, then correct for perspective...
+	vec2 delta = pixelNDC - ndc0;
+	float interpInvW = invW.x + delta.x * ddxSum + delta.y * ddySum;
+
+	result.lambda = (vec3(invW.x, 0.0f, 0.0f) + delta.x * ddx + delta.y * ddy) / interpInvW;
+
+	// Step one pixel right and up for the derivatives.
+	ddx *= pixelSize.x;
+	ddy *= pixelSize.y;
+	ddxSum *= pixelSize.x;
+	ddySum *= pixelSize.y;
+
+	result.ddx = (result.lambda * interpInvW + ddx) / (interpInvW + ddxSum) - result.lambda;
+	result.ddy = (result.lambda * interpInvW + ddy) / (interpInvW + ddySum) - result.lambda;
+
+	return result;
+}
+
+void main()
+{
+    // The quad's texture coordinates change by one pixel between neighbours, taken before any pixel is discarded.
+	vec2 pixelSize = 2.0f * vec2(dFdx(texCoords.x), dFdy(texCoords.y));
+
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	uvec2 visibilityID = texelFetch(visibilityMap, pixel, 0).rg;
+
+	uint slot = visibilityID.x;
+	uint triangle = visibilityID.y;
+
+	// No triangle covers the pixel.
+	if(slot == 0u)
+	    discard;
+
+	// The pixel's draw is the last one starting at or before its slot, draws without slots start where the next draw does...
+	uint drawIndex = 0u;
+	uint searchCount = uint(visibilityDrawCount);
+
+	while(searchCount > 0u)
+	{
+	    uint step = searchCount / 2u;
+
+		if(draws[drawIndex + step].firstSlot <= slot)
+		{
+		    drawIndex += step + 1u;
+			searchCount -= step + 1u;
+		}
+		else
+		    searchCount = step;
+	}
+
+	VisibilityDraw draw = draws[drawIndex - 1u];
+
+	if(draw.source != uint(visibilitySource))
+	    discard;
+
+	// Instance of the pixel...
+	uint instanceWord = (draw.baseInstance + slot - draw.firstSlot) * INSTANCE_WORD_COUNT;
+
+	mat4 model = mat4(InstanceVec4(instanceWord + 4), InstanceVec4(instanceWord + 8), InstanceVec4(instanceWord + 12), InstanceVec4(instanceWord + 16));
+	mat3 normalMat = mat3(InstanceVec3(instanceWord + 20), InstanceVec3(instanceWord + 23), InstanceVec3(instanceWord + 26));
+
+	// Vertices of the triangle...
+	uint index = draw.firstIndex + triangle * 3u;
+
+	uint vertexWord0 = uint(int(indices[index]) + draw.baseVertex) * VERTEX_WORD_COUNT;
+	uint vertexWord1 = uint(int(indices[index + 1u]) + draw.baseVertex) * VERTEX_WORD_COUNT;
+	uint vertexWord2 = uint(int(indices[index + 2u]) + draw.baseVertex) * VERTEX_WORD_COUNT;
+
+	mat4 modelViewProjection = projection * view * model;
+
+	Barycentrics bary = CalculateBarycentrics(modelViewProjection * VertexVec4(vertexWord0), modelViewProjection * VertexVec4(vertexWord1),
+	    modelViewProjection * VertexVec4(vertexWord2), texCoords * 2.0f - 1.0f, pixelSize);
+
+	// Interpolate attributes...
+	mat3 normals = mat3(VertexVec4(vertexWord0 + 4).xyz, VertexVec4(vertexWord1 + 4).xyz, VertexVec4(vertexWord2 + 4).xyz);
+	mat3 tangents = mat3(VertexVec4(vertexWord0 + 8).xyz, VertexVec4(vertexWord1 + 8).xyz, VertexVec4(vertexWord2 + 8).xyz);
+
+	vec2 texCoord0 = vec2(vertexWords[vertexWord0 + 12], vertexWords[vertexWord0 + 13]);
+	vec2 texCoord1 = vec2(vertexWords[vertexWord1 + 12], vertexWords[vertexWord1 + 13]);
+	vec2 texCoord2 = vec2(vertexWords[vertexWord2 + 12], vertexWords[vertexWord2 + 13]);
+
+	mat3x2 texCoordMat = mat3x2(texCoord0, texCoord1, texCoord2);
+
+	vec3 normal = normals * bary.lambda;
+	vec3 tangent = tangents * bary.lambda;
+	vec2 modelTexCoords = texCoordMat * bary.lambda;
+
+	// Material, draws outside the material table are shaded like plain.fs, which keeps the object space normal...
+	vec3 albedo = vec3(1.0f);
+	vec3 specular = vec3(1.0f);
+	vec3 finalNormal = normal;
+
+	// Roughness, specular strength and reflection coefficient.
+	vec3 material = vec3(0.3f, 0.0f, 0.5f);
+
+#ifdef GL_ARB_bindless_texture
+	if(draw.materialSlot != VISIBILITY_NO_MATERIAL)
+	{
+	    // Maps are sampled with the analytic derivatives, the quad's own derivatives span unrelated triangles.
+		vec2 texCoordDdx = texCoordMat * bary.ddx;
+		vec2 texCoordDdy = texCoordMat * bary.ddy;
+
+		albedo = textureGrad(MaterialMap(draw.materialSlot, 0), modelTexCoords, texCoordDdx, texCoordDdy).rgb;
+
+		// Read normal map and translate normal vector from tangent space to worldspace using the TBN matrix.
+		mat3 tbnMat = mat3(normalMat * tangent, normalMat * cross(normal, tangent), normalMat * normal);
+		finalNormal = tbnMat * UnpackNormalMap(textureGrad(MaterialMap(draw.materialSlot, 1), modelTexCoords, texCoordDdx, texCoordDdy).xy);
+
+		specular = textureGrad(MaterialMap(draw.materialSlot, 2), modelTexCoords, texCoordDdx, texCoordDdy).rgb;
+		material = vec3(0.2f, 0.2f, 1.0f);
+	}
+#endif
+
+	fragAlbedoRoughnessOut = vec4(albedo, material.r);
+	fragNormalOut = OctahedralEncode(normalize(finalNormal));
+
+	// Specular strength is premultiplied, position is rebuilt from depth.
+	fragSpecularReflectionOut = vec4(specular * material.g, material.b);
+	fragEmissionOut = vec3(0.0f);
+	fragDepthOut = texelFetch(depthMap, pixel, 0).r;
+}
\ No newline at end of file
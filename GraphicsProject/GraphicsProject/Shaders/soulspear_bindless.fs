@@ -0,0 +1,91 @@
+#version 440 core
+#extension GL_ARB_bindless_texture : require
+
+#define MATERIAL_TABLE_MAP_COUNT 16
+
+in mat3 tbnMat;
+in vec4 modelColor;
+in vec4 fragPos;
+in vec2 modelTexCoords;
+in float shininess;
+flat in uint materialSlot;
+
+// Bindless handles of every material's maps, the slot is the same for every fragment of a draw.
+layout (std430, binding = 7) readonly buffer MaterialTableBuffer
+{
+    uvec2 materialMaps[];
+};
+
+// Construct a sampler from the handle of one of the draw's material maps.
+#define MaterialMap(map) sampler2D(materialMaps[materialSlot * MATERIAL_TABLE_MAP_COUNT + (map)])
+
+#ifdef GBUFFER_COMPACT
+
+layout (location = 0) out vec4 fragAlbedoRoughnessOut;
+layout (location = 1) out vec2 fragNormalOut;
+layout (location = 2) out vec4 fragSpecularReflectionOut;
+layout (location = 4) out float fragDepthOut;
+
+// Map a unit vector onto an octahedron unfolded into the [-1, 1] square.
+vec2 OctahedralEncode(vec3 normal) 
+{
+	normal /= abs(normal.x) + abs(normal.y) + abs(normal.z);
+	
+	vec2 signs = vec2(normal.x >= 0.0f ? 1.0f : -1.0f, normal.y >= 0.0f ? 1.0f : -1.0f);
+	
+	return normal.z >= 0.0f ? normal.xy : (1.0f - abs(normal.yx)) * signs;
+}
+
+#else
+
+layout (location = 0) out vec4 fragDiffuseOut;
+layout (location = 1) out vec4 fragPositionOut;
+layout (location = 2) out vec4 fragNormalOut;
+layout (location = 3) out vec4 fragSpecularOut;
+layout (location = 4) out vec3 fragRoughnessOut;
+
+#endif
+
+// Tangent space normal from the X and Y of a normal map, Z is rebuilt from the unit length so two channel BC5 maps work too.
+vec3 UnpackNormalMap(vec2 normalXY)
+{
+	normalXY = normalXY * 2.0f - 1.0f;
+
+	return vec3(normalXY, sqrt(max(1.0f - dot(normalXY, normalXY), 0.0f)));
+}
+
+void main() 
+{
+    vec4 diffuse = texture(MaterialMap(0), modelTexCoords); // Diffuse
+	
+	// Read normal map and translate normal vector from tangent space to worldspace using the TBN matrix.
+	vec3 finalNormal = tbnMat * UnpackNormalMap(texture(MaterialMap(1), modelTexCoords).xy); // Normal
+	
+	vec3 specular = texture(MaterialMap(2), modelTexCoords).rgb; // Specular
+	
+	// Roughness, specular strength and reflection coefficient.
+	vec3 material = vec3(0.2f, 0.2f, 1.0f);
+
+#ifdef GBUFFER_COMPACT
+	fragAlbedoRoughnessOut = vec4(diffuse.rgb, material.r);
+	fragNormalOut = OctahedralEncode(normalize(finalNormal));
+	
+	// Specular strength is premultiplied, position is rebuilt from depth.
+	fragSpecularReflectionOut = vec4(specular * material.g, material.b);
+	fragDepthOut = gl_FragCoord.z;
+#else
+    fragDiffuseOut = diffuse;
+	
+	// Output position.
+    fragPositionOut = vec4(fragPos.xyz, 1.0f); // Position
+
+	// Output normal.
+	fragNormalOut = vec4(finalNormal, 1.0f);
+	
+	// Output specular.
+	fragSpecularOut = vec4(specular, shininess);
+	
+	// Output roughness
+	fragRoughnessOut = material;
+#endif
+}
\ No newline at end of file
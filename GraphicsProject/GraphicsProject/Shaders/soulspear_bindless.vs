@@ -0,0 +1,49 @@
+#version 440 core
+#extension GL_ARB_shader_draw_parameters : require
+
+layout (location = 0) in vec4 vertPos;
+layout (location = 1) in vec4 normal;
+layout (location = 2) in vec4 tangent;
+layout (location = 3) in vec2 texCoords;
+layout (location = 4) in vec4 color;
+layout (location = 5) in mat4 model;
+layout (location = 9) in mat3 normalMat;
+
+layout (std140) uniform GlobalMatrices
+{
+    mat4 view;
+    mat4 projection;
+};
+
+// Material table slot of every draw submitted by the command bucket.
+layout (std430, binding = 8) readonly buffer DrawMaterialBuffer
+{
+    uint drawMaterials[];
+};
+
+uniform float specularShininess;
+uniform int drawOffset;
+
+out mat3 tbnMat;
+out vec4 modelColor;
+out vec4 fragPos;
+out vec2 modelTexCoords;
+out float shininess;
+flat out uint materialSlot;
+
+void main() 
+{
+    // Pass to next stage...
+	materialSlot = drawMaterials[drawOffset + gl_DrawIDARB];
+    modelColor = color;
+	modelTexCoords = texCoords;
+ 	shininess = specularShininess;
+
+
+    vec3 biTangent = cross(normal.xyz, tangent.xyz); // Calculate biTangent.
+	tbnMat = mat3(normalMat * tangent.xyz, normalMat * biTangent, normalMat * normal.xyz); // Calculate TBN matrix.
+	
+	fragPos = model * vertPos; // Get worldspace fragment position.
+
+    gl_Position = projection * view * model * vertPos;
+}
\ No newline at end of file
@@ -7,15 +7,41 @@ in vec2 modelTexCoords;
 
 uniform sampler2D textureMaps[16];
 
+#ifdef GBUFFER_COMPACT
+
+layout (location = 0) out vec4 fragAlbedoRoughnessOut;
+layout (location = 1) out vec2 fragNormalOut;
+layout (location = 4) out float fragDepthOut;
+
+// Map a unit vector onto an octahedron unfolded into the [-1, 1] square.
+vec2 OctahedralEncode(vec3 normal) 
+{
+	normal /= abs(normal.x) + abs(normal.y) + abs(normal.z);
+	
+	vec2 signs = vec2(normal.x >= 0.0f ? 1.0f : -1.0f, normal.y >= 0.0f ? 1.0f : -1.0f);
+	
+	return normal.z >= 0.0f ? normal.xy : (1.0f - abs(normal.yx)) * signs;
+}
+
+#else
+
 layout (location = 0) out vec4 fragDiffuseOut;
 layout (location = 1) out vec4 fragPositionOut;
 layout (location = 2) out vec4 fragNormalOut;
 
+#endif
+
 void main() 
 {
+#ifdef GBUFFER_COMPACT
+	fragAlbedoRoughnessOut = vec4(1.0f, 1.0f, 1.0f, 0.0f);
+	fragNormalOut = OctahedralEncode(normalize(modelNormal.xyz));
+	fragDepthOut = gl_FragCoord.z;
+#else
     //fragDiffuseOut = texture(textureMaps[0], modelTexCoords);
 	fragDiffuseOut = vec4(1.0f);
     fragPositionOut = vec4(fragPos.xyz, 1.0f);
 	fragNormalOut = modelNormal;
 	//fragColor = vec4(1.0f);
+#endif
 }
\ No newline at end of file
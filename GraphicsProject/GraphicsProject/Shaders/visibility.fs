@@ -0,0 +1,11 @@
+#version 440 core
+
+flat in uint instanceSlot;
+
+layout (location = 0) out uvec2 fragVisibilityOut;
+
+void main() 
+{
+    // The primitive ID counts triangles from the start of the draw.
+    fragVisibilityOut = uvec2(instanceSlot, uint(gl_PrimitiveID));
+}
\ No newline at end of file
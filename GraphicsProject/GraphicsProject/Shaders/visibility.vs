@@ -0,0 +1,39 @@
+#version 440 core
+#extension GL_ARB_shader_draw_parameters : require
+
+layout (location = 0) in vec4 vertPos;
+layout (location = 5) in mat4 model;
+
+layout (std140) uniform GlobalMatrices
+{
+    mat4 view;
+    mat4 projection;
+};
+
+struct VisibilityDraw
+{
+    uint firstIndex;
+	int baseVertex;
+	uint baseInstance;
+	uint materialSlot;
+	uint firstSlot;
+	uint source;
+};
+
+// Slots and geometry of every draw submitted by the command bucket.
+layout (std430, binding = 11) readonly buffer VisibilityDrawBuffer
+{
+    VisibilityDraw draws[];
+};
+
+uniform int drawOffset;
+
+flat out uint instanceSlot;
+
+void main() 
+{
+    // Instances of a draw occupy consecutive slots, culled draws only count their visible instances.
+	instanceSlot = draws[drawOffset + gl_DrawIDARB].firstSlot + uint(gl_InstanceID);
+
+    gl_Position = projection * view * model * vertPos;
+}
\ No newline at end of file
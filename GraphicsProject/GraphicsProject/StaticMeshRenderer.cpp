@@ -3,10 +3,17 @@
 #include "Material.h"
 #include "Shader.h"
 #include "GLAD\glad.h"
+#include "GLState.h"
+#include "CommandBucket.h"
+#include "UploadRing.h"
+#include "CPUProfiler.h"
 #include "glm.hpp"
+#include "gtc/type_ptr.hpp"
 
 StaticMeshRenderer::StaticMeshRenderer(Material* material) 
 {
+	m_material = nullptr;
+
 	SetMaterial(material);
 
 	m_material->Use();
@@ -33,18 +40,17 @@ StaticMeshRenderer::StaticMeshRenderer(Material* material)
 	m_glStaticVAOHandle = 0;
 	m_glStaticVBOHandle = 0;
 	m_glStaticEBOHandle = 0;
-	m_glStaticInstanceHandle = 0;
 
 	// Generate and bind VAO.
 	glGenVertexArrays(1, &m_glStaticVAOHandle);
-	glBindVertexArray(m_glStaticVAOHandle);
+	GLState::GetInstance()->BindVertexArray(m_glStaticVAOHandle);
 
 	// Bind static index buffer to this VAO.
 	glGenBuffers(1, &m_glStaticEBOHandle);
 
 	// Bind static vertex buffer to this VAO.
 	glGenBuffers(1, &m_glStaticVBOHandle);
-	glBindBuffer(GL_ARRAY_BUFFER, m_glStaticVBOHandle);
+	GLState::GetInstance()->BindBuffer(GL_ARRAY_BUFFER, m_glStaticVBOHandle);
 
 	// Vertex attributes...
 
@@ -64,62 +70,48 @@ StaticMeshRenderer::StaticMeshRenderer(Material* material)
 	glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 14, (void*)(sizeof(float) * 12));
 	glEnableVertexAttribArray(3);
 
-	// Create and bind instance buffer.
-	glGenBuffers(1, &m_glStaticInstanceHandle);
-	glBindBuffer(GL_ARRAY_BUFFER, m_glStaticInstanceHandle);
-
-	// Create dummy instance with dummy matrices.
-	Instance instance;
-	memcpy_s(instance.m_modelMat, sizeof(float) * 16, &NVZMathLib::Matrix4(), sizeof(float) * 16);
-	memcpy_s(instance.m_normalMat, sizeof(float) * 9, &NVZMathLib::Matrix3(), sizeof(float) * 9);
-	instance.m_v4Color = { 1.0f, 1.0f, 1.0f, 1.0f };
-
-	// Fill with single instance data.
-	glBufferData(GL_ARRAY_BUFFER, sizeof(Instance) * 1, &instance, GL_STATIC_DRAW);
-
-	// Instance attributes...
+	// Instance attributes are read through their own binding, pointed at the buffer holding a draw's instances when it is drawn...
 
 	// Color
-	glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)0);
+	glVertexAttribFormat(4, 4, GL_FLOAT, GL_FALSE, 0);
+	glVertexAttribBinding(4, INSTANCE_VERTEX_BINDING);
 	glEnableVertexAttribArray(4);
 
-	glVertexAttribDivisor(4, 1);
-
 	// Model matrix
-	glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(sizeof(float) * 4));
+	glVertexAttribFormat(5, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 4);
+	glVertexAttribBinding(5, INSTANCE_VERTEX_BINDING);
 	glEnableVertexAttribArray(5);
 
-	glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(sizeof(float) * 8));
+	glVertexAttribFormat(6, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 8);
+	glVertexAttribBinding(6, INSTANCE_VERTEX_BINDING);
 	glEnableVertexAttribArray(6);
 
-	glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(sizeof(float) * 12));
+	glVertexAttribFormat(7, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 12);
+	glVertexAttribBinding(7, INSTANCE_VERTEX_BINDING);
 	glEnableVertexAttribArray(7);
 
-	glVertexAttribPointer(8, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(sizeof(float) * 16));
+	glVertexAttribFormat(8, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 16);
+	glVertexAttribBinding(8, INSTANCE_VERTEX_BINDING);
 	glEnableVertexAttribArray(8);
 
-	glVertexAttribDivisor(5, 1);
-	glVertexAttribDivisor(6, 1);
-	glVertexAttribDivisor(7, 1);
-	glVertexAttribDivisor(8, 1);
-
 	// Normal matrix
-	glVertexAttribPointer(9, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(sizeof(float) * 20));
+	glVertexAttribFormat(9, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 20);
+	glVertexAttribBinding(9, INSTANCE_VERTEX_BINDING);
 	glEnableVertexAttribArray(9);
 
-	glVertexAttribPointer(10, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(sizeof(float) * 23));
+	glVertexAttribFormat(10, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 23);
+	glVertexAttribBinding(10, INSTANCE_VERTEX_BINDING);
 	glEnableVertexAttribArray(10);
 
-	glVertexAttribPointer(11, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(sizeof(float) * 26));
+	glVertexAttribFormat(11, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 26);
+	glVertexAttribBinding(11, INSTANCE_VERTEX_BINDING);
 	glEnableVertexAttribArray(11);
 
-	glVertexAttribDivisor(9, 1);
-	glVertexAttribDivisor(10, 1);
-	glVertexAttribDivisor(11, 1);
+	glVertexBindingDivisor(INSTANCE_VERTEX_BINDING, 1);
 
-	glBindVertexArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	GLState::GetInstance()->BindVertexArray(0);
+	GLState::GetInstance()->BindBuffer(GL_ARRAY_BUFFER, 0);
+	GLState::GetInstance()->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
 StaticMeshRenderer::~StaticMeshRenderer() 
@@ -130,28 +122,43 @@ StaticMeshRenderer::~StaticMeshRenderer()
 	if(m_staticIndices)
 	    delete[] m_staticIndices;
 
-	glDeleteVertexArrays(1, &m_glStaticVAOHandle);
-	glDeleteBuffers(1, &m_glStaticVBOHandle);
-	glDeleteBuffers(1, &m_glStaticEBOHandle);
-	glDeleteBuffers(1, &m_glStaticInstanceHandle);
+	GLState::GetInstance()->DeleteVertexArrays(1, &m_glStaticVAOHandle);
+	GLState::GetInstance()->DeleteBuffers(1, &m_glStaticVBOHandle);
+	GLState::GetInstance()->DeleteBuffers(1, &m_glStaticEBOHandle);
 }
 
-void StaticMeshRenderer::Draw() 
+void StaticMeshRenderer::Draw(CommandBucket* bucket) 
 {
-	glBindVertexArray(m_glStaticVAOHandle);
-	glBindBuffer(GL_ARRAY_BUFFER, m_glStaticVBOHandle);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_glStaticEBOHandle);
-	glBindBuffer(GL_ARRAY_BUFFER, m_glStaticInstanceHandle);
+	if (m_chunks.Count() == 0)
+		return;
 
-	glDrawElements(GL_TRIANGLES, m_nUsedIndSpace / sizeof(unsigned int), GL_UNSIGNED_INT, 0);
+	// Vertices are already in worldspace, every chunk is drawn with one identity instance...
+	Instance instance;
+	memcpy_s(instance.m_modelMat, sizeof(float) * 16, &NVZMathLib::Matrix4(), sizeof(float) * 16);
+	memcpy_s(instance.m_normalMat, sizeof(float) * 9, &NVZMathLib::Matrix3(), sizeof(float) * 9);
+	instance.m_v4Color = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+	unsigned int nInstanceOffset = 0;
+
+	if (!UploadRing::GetInstance()->Upload(&instance, sizeof(Instance), sizeof(Instance), nInstanceOffset))
+		return;
+
+	unsigned int nBaseInstance = nInstanceOffset / sizeof(Instance);
+
+	// Each chunk carries its worldspace bounds, so hidden chunks are culled like any other instance.
+	for(int i = 0; i < m_chunks.Count(); ++i)
+	{
+		const Chunk& chunk = m_chunks[i];
+		GeometryRange geometry = { m_glStaticVAOHandle, chunk.m_nIndexCount, chunk.m_nFirstIndex, 0, chunk.m_v4BoundingSphere, m_glStaticVBOHandle, m_glStaticEBOHandle };
 
-	glBindVertexArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		bucket->AddDraw(DRAW_PASS_OPAQUE, m_material, geometry, 1, nBaseInstance, bucket->ViewDepth(glm::vec3(chunk.m_v4BoundingSphere)));
+	}
 }
 
 void StaticMeshRenderer::PushMesh(Mesh* mesh, const float* modelMatrixData) 
 {
+	CPU_PROFILE_ZONE("StaticMeshRenderer::PushMesh");
+
 	NVZMathLib::Matrix4 modelMatrix;
 	memcpy_s(&modelMatrix, sizeof(float) * 16, modelMatrixData, sizeof(float) * 16);
 
@@ -162,6 +169,19 @@ void StaticMeshRenderer::PushMesh(Mesh* mesh, const float* modelMatrixData)
 		modelMatrixData[8], modelMatrixData[9], modelMatrixData[10]
 	);
 
+	// Transform the mesh's bounds into worldspace, scaling the radius by the largest axis scale...
+	const glm::vec4& v4MeshSphere = mesh->BoundingSphere();
+	glm::mat4 worldMatrix = glm::make_mat4(modelMatrixData);
+
+	float fScale = glm::max(glm::length(glm::vec3(worldMatrix[0])), glm::max(glm::length(glm::vec3(worldMatrix[1])), glm::length(glm::vec3(worldMatrix[2]))));
+
+	Chunk chunk;
+	chunk.m_nFirstIndex = m_nUsedIndSpace / sizeof(unsigned int);
+	chunk.m_nIndexCount = mesh->IndexCount();
+	chunk.m_v4BoundingSphere = glm::vec4(glm::vec3(worldMatrix * glm::vec4(glm::vec3(v4MeshSphere), 1.0f)), v4MeshSphere.w * fScale);
+
+	m_chunks.Push(chunk);
+
 	unsigned int glMeshVBO = mesh->VBOHandle();
 	unsigned int glMeshEBO = mesh->IndexBufferHandle();
 
@@ -171,7 +191,7 @@ void StaticMeshRenderer::PushMesh(Mesh* mesh, const float* modelMatrixData)
 	// -----------------------------------------------------------------------------------
 	// Vertices
 
-	glBindBuffer(GL_ARRAY_BUFFER, glMeshVBO);
+	GLState::GetInstance()->BindBuffer(GL_ARRAY_BUFFER, glMeshVBO);
 	unsigned char* meshData = (unsigned char*)glMapBuffer(GL_ARRAY_BUFFER, GL_READ_ONLY);
 
 	int nPrevMeshVertCount = m_nUsedVertSpace / sizeof(Mesh::Vertex);
@@ -256,13 +276,14 @@ void StaticMeshRenderer::PushMesh(Mesh* mesh, const float* modelMatrixData)
 	}
 
 	glUnmapBuffer(GL_ARRAY_BUFFER);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GLState::GetInstance()->BindBuffer(GL_ARRAY_BUFFER, 0);
 
 	// -----------------------------------------------------------------------------------
 	// Indices
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, glMeshEBO);
-	unsigned char* indexData = (unsigned char*)glMapBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_READ_ONLY);
+	// Read through the copy target, binding the element array target would replace the index buffer of whichever VAO is bound.
+	GLState::GetInstance()->BindBuffer(GL_COPY_READ_BUFFER, glMeshEBO);
+	unsigned char* indexData = (unsigned char*)glMapBuffer(GL_COPY_READ_BUFFER, GL_READ_ONLY);
 
 	if (m_staticIndices == nullptr)
 	{
@@ -311,21 +332,22 @@ void StaticMeshRenderer::PushMesh(Mesh* mesh, const float* modelMatrixData)
 			}
 
 			// Update buffer usage data.
-			m_nUsedIndSpace += nMeshSize;
+			m_nUsedIndSpace += nIndexSize;
 		}
 	}
 
-	glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glUnmapBuffer(GL_COPY_READ_BUFFER);
+	GLState::GetInstance()->BindBuffer(GL_COPY_READ_BUFFER, 0);
 
 	// -----------------------------------------------------------------------------------
 }
 
 void StaticMeshRenderer::FinalizeBuffers() 
 {
-	// Bind buffers to be filled...
-	glBindBuffer(GL_ARRAY_BUFFER, m_glStaticVBOHandle);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_glStaticEBOHandle);
+	// Bind buffers to be filled, the index buffer is bound through its VAO...
+	GLState::GetInstance()->BindVertexArray(m_glStaticVAOHandle);
+	GLState::GetInstance()->BindBuffer(GL_ARRAY_BUFFER, m_glStaticVBOHandle);
+	GLState::GetInstance()->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_glStaticEBOHandle);
 
 	// Fill buffers...
 	glBufferData(GL_ARRAY_BUFFER, m_nUsedVertSpace, m_staticVertices, GL_STATIC_DRAW);
@@ -2,8 +2,11 @@
 #include "Mesh.h"
 #include "Vector4.h"
 #include "Matrix4.h"
+#include "DynamicArray.h"
+#include "glm.hpp"
 
 class Material;
+class CommandBucket;
 
 class StaticMeshRenderer 
 {
@@ -14,9 +17,11 @@ public:
 	~StaticMeshRenderer();
 
 	/*
-	Description: Draw all static meshes contained within this static mesh buffer.
+	Description: Add a draw of each mesh pushed into this static mesh buffer to a command bucket, so meshes can be culled and depth sorted individually.
+	Param:
+	    CommandBucket* bucket: The bucket to add the draw to.
 	*/
-	void Draw();
+	void Draw(CommandBucket* bucket);
 
 	/*
 	Description: Add a mesh to the static mesh buffer, transformed with the provided model matrix.
@@ -62,7 +67,16 @@ private:
 	unsigned int m_glStaticVAOHandle;
 	unsigned int m_glStaticVBOHandle;
 	unsigned int m_glStaticEBOHandle;
-	unsigned int m_glStaticInstanceHandle;
 
 	unsigned int m_nMaterialIndex;
+
+	// Indices of a single pushed mesh within the static buffers, with its worldspace bounds for culling and depth sorting.
+	struct Chunk
+	{
+		unsigned int m_nFirstIndex;
+		unsigned int m_nIndexCount;
+		glm::vec4 m_v4BoundingSphere;
+	};
+
+	DynamicArray<Chunk> m_chunks;
 };
@@ -0,0 +1,107 @@
+#include "TemporalHistory.h"
+#include "glad\glad.h"
+#include "GLState.h"
+#include "FrameBuffer.h"
+#include "Texture.h"
+#include <iostream>
+
+// Element of the Halton low discrepancy sequence, in the range [0, 1).
+static float Halton(int nIndex, int nBase)
+{
+	float fResult = 0.0f;
+	float fFraction = 1.0f;
+
+	while(nIndex > 0)
+	{
+		fFraction /= static_cast<float>(nBase);
+		fResult += fFraction * static_cast<float>(nIndex % nBase);
+		nIndex /= nBase;
+	}
+
+	return fResult;
+}
+
+TemporalHistory::TemporalHistory(int nWidth, int nHeight)
+{
+	m_nCurrent = 0;
+	m_nPhase = 0;
+	m_bHistoryValid = false;
+
+	glGenTextures(2, m_glTextureHandles);
+	glGenFramebuffers(2, m_glFramebufferHandles);
+
+	for(int i = 0; i < 2; ++i)
+	{
+		GLState::GetInstance()->BindTexture(GL_TEXTURE_2D, m_glTextureHandles[i]);
+		Framebuffer::AllocateAttachmentStorage(BUFFER_FLOAT_RGB16, nWidth, nHeight);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		// History is reprojected to arbitrary positions, filter it.
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		m_textures[i] = new Texture(m_glTextureHandles[i], nWidth, nHeight);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, m_glFramebufferHandles[i]);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_glTextureHandles[i], 0);
+
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			std::cout << "Temporal History Error: History framebuffer is incomplete." << std::endl;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLState::GetInstance()->BindTexture(GL_TEXTURE_2D, 0);
+}
+
+TemporalHistory::~TemporalHistory()
+{
+	for (int i = 0; i < 2; ++i)
+		delete m_textures[i];
+
+	glDeleteFramebuffers(2, m_glFramebufferHandles);
+	GLState::GetInstance()->DeleteTextures(2, m_glTextureHandles);
+}
+
+glm::vec2 TemporalHistory::Jitter(int nRenderWidth, int nRenderHeight) const
+{
+	// Offset within a render pixel, centred on the pixel. The sequence starts at 1 as every Halton sequence begins at 0.
+	float fX = Halton(m_nPhase + 1, 2) - 0.5f;
+	float fY = Halton(m_nPhase + 1, 3) - 0.5f;
+
+	// Pixels to normalized device coordinates, which span two units across the viewport.
+	return glm::vec2(fX * 2.0f / static_cast<float>(nRenderWidth), fY * 2.0f / static_cast<float>(nRenderHeight));
+}
+
+void TemporalHistory::EndFrame()
+{
+	m_nCurrent = 1 - m_nCurrent;
+	m_nPhase = (m_nPhase + 1) % TEMPORAL_JITTER_PHASES;
+	m_bHistoryValid = true;
+}
+
+void TemporalHistory::Invalidate()
+{
+	m_bHistoryValid = false;
+}
+
+bool TemporalHistory::HistoryValid() const
+{
+	return m_bHistoryValid;
+}
+
+unsigned int TemporalHistory::ResolveFramebuffer() const
+{
+	return m_glFramebufferHandles[m_nCurrent];
+}
+
+Texture* TemporalHistory::ResolvedTexture() const
+{
+	return m_textures[m_nCurrent];
+}
+
+Texture* TemporalHistory::HistoryTexture() const
+{
+	return m_textures[1 - m_nCurrent];
+}
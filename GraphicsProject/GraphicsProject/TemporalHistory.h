@@ -0,0 +1,83 @@
+#pragma once
+#include "glm.hpp"
+
+class Texture;
+
+// Length of the sub-pixel jitter sequence, long enough to cover each output pixel with several samples at half resolution.
+#define TEMPORAL_JITTER_PHASES 16
+
+// Weight of a current frame sample landing exactly on an output pixel's centre, the history makes up the rest.
+#define TEMPORAL_FEEDBACK 0.1f
+
+/*
+History for temporal reconstruction. Each frame the scene is rendered with a different sub-pixel projection jitter,
+and the resolve blends the new samples into the history reprojected with per-pixel velocity. The history is kept at
+output resolution, so it accumulates detail beyond the internal render resolution and anti-aliases the deferred pipeline.
+Two history textures are swapped each frame, the previous result is read while the new one is written.
+*/
+class TemporalHistory
+{
+public:
+
+	/*
+	Param:
+	    int nWidth: The width of the output in pixels.
+		int nHeight: The height of the output in pixels.
+	*/
+	TemporalHistory(int nWidth, int nHeight);
+
+	~TemporalHistory();
+
+	/*
+	Description: Get the projection jitter of the current frame in normalized device coordinates.
+	Return Type: vec2
+	Param:
+	    int nRenderWidth: The width the scene is rendered at in pixels.
+		int nRenderHeight: The height the scene is rendered at in pixels.
+	*/
+	glm::vec2 Jitter(int nRenderWidth, int nRenderHeight) const;
+
+	/*
+	Description: Make this frame's result the history and advance the jitter sequence. Call once the frame's resolve is done.
+	*/
+	void EndFrame();
+
+	/*
+	Description: Discard the history, the next resolve uses only the current frame.
+	*/
+	void Invalidate();
+
+	/*
+	Description: Get whether the history holds a previous result.
+	Return Type: bool
+	*/
+	bool HistoryValid() const;
+
+	/*
+	Description: Get the OpenGL handle of the framebuffer the resolve writes this frame.
+	Return Type: unsigned int
+	*/
+	unsigned int ResolveFramebuffer() const;
+
+	/*
+	Description: Get the texture the resolve writes this frame, the resolved image once the resolve is done.
+	Return Type: Texture*
+	*/
+	Texture* ResolvedTexture() const;
+
+	/*
+	Description: Get the previous frame's resolved image.
+	Return Type: Texture*
+	*/
+	Texture* HistoryTexture() const;
+
+private:
+
+	unsigned int m_glTextureHandles[2];
+	unsigned int m_glFramebufferHandles[2];
+	Texture* m_textures[2];
+
+	int m_nCurrent; // Index of the texture written this frame.
+	int m_nPhase;
+	bool m_bHistoryValid;
+};
@@ -1,34 +1,70 @@
 #include "Texture.h"
 #include "GLAD/glad.h"
+#include "GLState.h"
+#include "TextureStreamer.h"
+#include "CompressedImage.h"
 #include <iostream>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
-Texture::Texture(const char* szFilePath) 
+Texture::Texture(const char* szFilePath, bool bStream) 
 {
-	m_data = nullptr;
-
 	m_nWidth = 0;
 	m_nHeight = 0;
 	m_nChannels = 0;
 	m_glHandle = 0;
 	m_bOwnsTexture = true;
+	m_bStreaming = false;
 
 	if (!szFilePath)
 		return;
 
+	// Block compressed files need no decoding and upload a fraction of the bytes, they are loaded immediately.
+	if(CompressedImage::IsCompressedFile(szFilePath))
+	{
+		LoadCompressed(szFilePath);
+		return;
+	}
+
+	TextureStreamer* streamer = TextureStreamer::GetInstance();
+
+	if(bStream && streamer)
+	{
+		// Only the header is read here, the streamer decodes the rest on a worker thread...
+		if(!stbi_info(szFilePath, &m_nWidth, &m_nHeight, &m_nChannels))
+		{
+			std::cout << "Failed to load image: " << szFilePath << std::endl;
+			return;
+		}
+
+		m_glHandle = streamer->PlaceholderHandle();
+		m_bStreaming = true;
+
+		streamer->Request(this, szFilePath);
+		return;
+	}
+
 	// Load image...
-	m_data = stbi_load(szFilePath, &m_nWidth, &m_nHeight, &m_nChannels, STBI_rgb_alpha);
+	unsigned char* data = stbi_load(szFilePath, &m_nWidth, &m_nHeight, &m_nChannels, STBI_rgb_alpha);
 
-	if(m_data) 
+	if(data) 
 	{
+		int nMipCount = 1;
+
+		while (((m_nWidth > m_nHeight ? m_nWidth : m_nHeight) >> nMipCount) > 0)
+			++nMipCount;
+
 		// Create and bind texture buffer.s
 		glGenTextures(1, &m_glHandle);
-		glBindTexture(GL_TEXTURE_2D, m_glHandle);
+		GLState::GetInstance()->BindTexture(GL_TEXTURE_2D, m_glHandle);
+
+		// Allocate immutable storage for every mip level and send data to it.
+		glTexStorage2D(GL_TEXTURE_2D, nMipCount, GL_RGBA8, m_nWidth, m_nHeight);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_nWidth, m_nHeight, GL_RGBA, GL_UNSIGNED_BYTE, data);
 
-		// Send data to buffer.
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_nWidth, m_nHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_data);
+		// The GPU has its own copy now.
+		stbi_image_free(data);
 
 		// Generate mipmap
 		glGenerateMipmap(GL_TEXTURE_2D);
@@ -44,7 +80,7 @@ Texture::Texture(const char* szFilePath)
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR); // Nearest neighbour on expand.
 
 		// Unbind texture when finished.
-		glBindTexture(GL_TEXTURE_2D, 0);
+		GLState::GetInstance()->BindTexture(GL_TEXTURE_2D, 0);
 
 		std::cout << "Successfully loaded image: " << szFilePath << std::endl;
 	}
@@ -58,8 +94,9 @@ Texture::Texture(unsigned int glTextureHandle, int nWidth, int nHeight)
 {
 	m_bOwnsTexture = false;
 
+	m_bStreaming = false;
+
 	m_glHandle = glTextureHandle;
-	m_data = nullptr;
 	m_nChannels = 0;
 
 	m_nWidth = nWidth;
@@ -68,19 +105,23 @@ Texture::Texture(unsigned int glTextureHandle, int nWidth, int nHeight)
 
 Texture::~Texture() 
 {
-	if (m_data && m_bOwnsTexture)
-		stbi_image_free(m_data);
+	// The placeholder belongs to the streamer.
+	if(m_bStreaming)
+	{
+		TextureStreamer::GetInstance()->Cancel(this);
+		m_glHandle = 0;
+	}
 
 	if (m_glHandle > 0 && m_bOwnsTexture)
 	{
-		glDeleteTextures(1, &m_glHandle);
+		GLState::GetInstance()->DeleteTextures(1, &m_glHandle);
 		m_glHandle = 0;
 	}
 }
 
 void Texture::Bind() 
 {
-	glBindTexture(GL_TEXTURE_2D, m_glHandle);
+	GLState::GetInstance()->BindTexture(GL_TEXTURE_2D, m_glHandle);
 }
 
 unsigned int Texture::GetHandle() 
@@ -96,4 +137,50 @@ int Texture::GetWidth()
 int Texture::GetHeight() 
 {
 	return m_nHeight;
+}
+
+bool Texture::IsStreaming() 
+{
+	return m_bStreaming;
+}
+
+void Texture::LoadCompressed(const char* szFilePath) 
+{
+	CompressedImage image(szFilePath);
+
+	if(!image.IsValid())
+	{
+		std::cout << "Failed to load image: " << szFilePath << std::endl;
+		return;
+	}
+
+	m_nWidth = image.Width();
+	m_nHeight = image.Height();
+	m_nChannels = 4;
+
+	// Create and bind texture buffer.
+	glGenTextures(1, &m_glHandle);
+	GLState::GetInstance()->BindTexture(GL_TEXTURE_2D, m_glHandle);
+
+	// Storage covers only the mips in the file, they are uploaded as stored since compressed mips can't be generated.
+	glTexStorage2D(GL_TEXTURE_2D, image.LevelCount(), image.Format(), m_nWidth, m_nHeight);
+
+	for(int i = 0; i < image.LevelCount(); ++i)
+	{
+		int nLevelWidth = m_nWidth >> i > 0 ? m_nWidth >> i : 1;
+		int nLevelHeight = m_nHeight >> i > 0 ? m_nHeight >> i : 1;
+
+		glCompressedTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, nLevelWidth, nLevelHeight, image.Format(), image.LevelSize(i), image.LevelData(i));
+	}
+
+	// Same sampling as uncompressed textures.
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	// Unbind texture when finished.
+	GLState::GetInstance()->BindTexture(GL_TEXTURE_2D, 0);
+
+	std::cout << "Successfully loaded compressed image: " << szFilePath << std::endl;
 }
\ No newline at end of file
@@ -4,7 +4,14 @@ class Texture
 {
 public:
 
-	Texture(const char* szFilePath);
+	/*
+	Param:
+	    const char* szFilePath: Path to the image file.
+		bool bStream: Whether to decode and upload the image over the following frames through the TextureStreamer, the texture
+		holds a placeholder until it is done. Loaded immediately if there is no streamer.
+	DDS and KTX2 files are uploaded in their block compressed format with the mips they contain, other images are decoded by stb_image.
+	*/
+	Texture(const char* szFilePath, bool bStream = false);
 
 	Texture(unsigned int glTextureHandle, int nWidth, int nHeight);
 
@@ -33,12 +40,23 @@ public:
 	*/
 	int GetHeight();
 
+	/*
+	Description: Get whether this texture still holds the placeholder while its image is streamed.
+	Return Type: bool
+	*/
+	bool IsStreaming();
+
 protected:
 
-	unsigned char* m_data;
+	friend class TextureStreamer;
+
+	// Upload a DDS or KTX2 file's blocks and mips as stored.
+	void LoadCompressed(const char* szFilePath);
+
 	unsigned int m_glHandle;
 	int m_nWidth;
 	int m_nHeight;
 	int m_nChannels;
 	bool m_bOwnsTexture;
+	bool m_bStreaming;
 };
\ No newline at end of file
@@ -0,0 +1,468 @@
+#include "TextureCompressor.h"
+#include "CPUProfiler.h"
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cmath>
+#include <climits>
+#include <cstdlib>
+#include <utility>
+#include <cstdio>
+#include <sys/stat.h>
+
+#include "stb_image.h"
+
+#define DDS_MAGIC 0x20534444 // "DDS "
+#define DDS_HEADER_SIZE 124
+
+// DDS header flags: caps, height, width, pixel format, mip map count and linear size are set.
+#define DDS_HEADER_FLAGS (0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000)
+#define DDS_PIXEL_FORMAT_FOURCC 0x4
+#define DDS_CAPS_MIPMAPPED_TEXTURE (0x8 | 0x1000 | 0x400000)
+
+// Build a little endian FourCC code from its characters.
+#define FOURCC(a, b, c, d) (static_cast<unsigned int>(a) | (static_cast<unsigned int>(b) << 8) | (static_cast<unsigned int>(c) << 16) | (static_cast<unsigned int>(d) << 24))
+
+// Copy a 4x4 block of RGBA texels, repeating the edge texels for blocks hanging over the edge of the image.
+static void FetchBlock(const unsigned char* texels, int nWidth, int nHeight, int nBlockX, int nBlockY, unsigned char block[16][4])
+{
+	for(int y = 0; y < 4; ++y)
+	{
+		int nY = nBlockY * 4 + y < nHeight ? nBlockY * 4 + y : nHeight - 1;
+
+		for(int x = 0; x < 4; ++x)
+		{
+			int nX = nBlockX * 4 + x < nWidth ? nBlockX * 4 + x : nWidth - 1;
+
+			memcpy(block[y * 4 + x], texels + (nY * nWidth + nX) * 4, 4);
+		}
+	}
+}
+
+static unsigned short PackRGB565(const float color[3])
+{
+	int nR = static_cast<int>(color[0] * (31.0f / 255.0f) + 0.5f);
+	int nG = static_cast<int>(color[1] * (63.0f / 255.0f) + 0.5f);
+	int nB = static_cast<int>(color[2] * (31.0f / 255.0f) + 0.5f);
+
+	return static_cast<unsigned short>((nR << 11) | (nG << 5) | nB);
+}
+
+// Expand a 565 color the way the hardware does, replicating the high bits into the low ones.
+static void UnpackRGB565(unsigned short nColor, int outColor[3])
+{
+	int nR = (nColor >> 11) & 31;
+	int nG = (nColor >> 5) & 63;
+	int nB = nColor & 31;
+
+	outColor[0] = (nR << 3) | (nR >> 2);
+	outColor[1] = (nG << 2) | (nG >> 4);
+	outColor[2] = (nB << 3) | (nB >> 2);
+}
+
+/*
+Encode the color of a block into 8 bytes of BC1. Endpoints are the corners of the block's bounding box along the diagonal its colors
+spread on, pulled in slightly so the interpolated colors cover the cluster rather than its extremes.
+*/
+static void EncodeBC1(const unsigned char block[16][4], unsigned char* out)
+{
+	float min[3] = { 255.0f, 255.0f, 255.0f };
+	float max[3] = { 0.0f, 0.0f, 0.0f };
+
+	for(int i = 0; i < 16; ++i)
+	{
+		for(int c = 0; c < 3; ++c)
+		{
+			min[c] = fminf(min[c], block[i][c]);
+			max[c] = fmaxf(max[c], block[i][c]);
+		}
+	}
+
+	// Pick the diagonal of the box by the sign of green and blue's covariance with red.
+	float fCovarianceRG = 0.0f;
+	float fCovarianceRB = 0.0f;
+
+	for(int i = 0; i < 16; ++i)
+	{
+		float fR = block[i][0] - (min[0] + max[0]) * 0.5f;
+
+		fCovarianceRG += fR * (block[i][1] - (min[1] + max[1]) * 0.5f);
+		fCovarianceRB += fR * (block[i][2] - (min[2] + max[2]) * 0.5f);
+	}
+
+	if (fCovarianceRG < 0.0f)
+		std::swap(min[1], max[1]);
+
+	if (fCovarianceRB < 0.0f)
+		std::swap(min[2], max[2]);
+
+	for(int c = 0; c < 3; ++c)
+	{
+		float fInset = (max[c] - min[c]) / 16.0f;
+
+		max[c] -= fInset;
+		min[c] += fInset;
+	}
+
+	unsigned short nColor0 = PackRGB565(max);
+	unsigned short nColor1 = PackRGB565(min);
+
+	// The first endpoint must be greater for the four color mode...
+	if (nColor0 < nColor1)
+		std::swap(nColor0, nColor1);
+
+	int palette[4][3];
+	UnpackRGB565(nColor0, palette[0]);
+	UnpackRGB565(nColor1, palette[1]);
+
+	for(int c = 0; c < 3; ++c)
+	{
+		palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+	}
+
+	unsigned int nIndices = 0;
+
+	// Equal endpoints decode every index to the same color.
+	if(nColor0 != nColor1)
+	{
+		for(int i = 0; i < 16; ++i)
+		{
+			int nBestIndex = 0;
+			int nBestDistance = INT_MAX;
+
+			for(int j = 0; j < 4; ++j)
+			{
+				int nDistance = 0;
+
+				for(int c = 0; c < 3; ++c)
+					nDistance += (block[i][c] - palette[j][c]) * (block[i][c] - palette[j][c]);
+
+				if(nDistance < nBestDistance)
+				{
+					nBestIndex = j;
+					nBestDistance = nDistance;
+				}
+			}
+
+			nIndices |= static_cast<unsigned int>(nBestIndex) << (i * 2);
+		}
+	}
+
+	memcpy(out, &nColor0, 2);
+	memcpy(out + 2, &nColor1, 2);
+	memcpy(out + 4, &nIndices, 4);
+}
+
+// Encode one channel of a block into 8 bytes of BC4, endpoints are the channel's extremes.
+static void EncodeBC4(const unsigned char block[16][4], int nChannel, unsigned char* out)
+{
+	int nMin = 255;
+	int nMax = 0;
+
+	for(int i = 0; i < 16; ++i)
+	{
+		nMin = block[i][nChannel] < nMin ? block[i][nChannel] : nMin;
+		nMax = block[i][nChannel] > nMax ? block[i][nChannel] : nMax;
+	}
+
+	// With the first endpoint greater, six values are interpolated between them.
+	int palette[8];
+	palette[0] = nMax;
+	palette[1] = nMin;
+
+	for (int i = 2; i < 8; ++i)
+		palette[i] = ((8 - i) * nMax + (i - 1) * nMin) / 7;
+
+	unsigned long long nIndices = 0;
+
+	if(nMax != nMin)
+	{
+		for(int i = 0; i < 16; ++i)
+		{
+			int nBestIndex = 0;
+			int nBestDistance = INT_MAX;
+
+			for(int j = 0; j < 8; ++j)
+			{
+				int nDistance = abs(block[i][nChannel] - palette[j]);
+
+				if(nDistance < nBestDistance)
+				{
+					nBestIndex = j;
+					nBestDistance = nDistance;
+				}
+			}
+
+			nIndices |= static_cast<unsigned long long>(nBestIndex) << (i * 3);
+		}
+	}
+
+	out[0] = static_cast<unsigned char>(nMax);
+	out[1] = static_cast<unsigned char>(nMin);
+
+	// 48 bits of 3 bit indices follow the endpoints.
+	for (int i = 0; i < 6; ++i)
+		out[2 + i] = static_cast<unsigned char>(nIndices >> (i * 8));
+}
+
+/*
+Halve an image with a box filter, odd rows and columns repeat the edge. Normal maps are renormalized so shorter averaged
+normals don't dim lighting at a distance.
+*/
+static void Downsample(const unsigned char* source, int nWidth, int nHeight, unsigned char* destination, bool bNormalMap)
+{
+	int nDestWidth = nWidth > 1 ? nWidth / 2 : 1;
+	int nDestHeight = nHeight > 1 ? nHeight / 2 : 1;
+
+	for(int y = 0; y < nDestHeight; ++y)
+	{
+		int nY0 = y * 2 < nHeight ? y * 2 : nHeight - 1;
+		int nY1 = y * 2 + 1 < nHeight ? y * 2 + 1 : nHeight - 1;
+
+		for(int x = 0; x < nDestWidth; ++x)
+		{
+			int nX0 = x * 2 < nWidth ? x * 2 : nWidth - 1;
+			int nX1 = x * 2 + 1 < nWidth ? x * 2 + 1 : nWidth - 1;
+
+			float sum[4];
+
+			for (int c = 0; c < 4; ++c)
+			{
+				sum[c] = source[(nY0 * nWidth + nX0) * 4 + c] + source[(nY0 * nWidth + nX1) * 4 + c] +
+					source[(nY1 * nWidth + nX0) * 4 + c] + source[(nY1 * nWidth + nX1) * 4 + c];
+
+				sum[c] *= 0.25f;
+			}
+
+			if(bNormalMap)
+			{
+				float normal[3];
+				float fLength = 0.0f;
+
+				for(int c = 0; c < 3; ++c)
+				{
+					normal[c] = sum[c] * (2.0f / 255.0f) - 1.0f;
+					fLength += normal[c] * normal[c];
+				}
+
+				fLength = sqrtf(fLength);
+
+				for (int c = 0; c < 3 && fLength > 0.0f; ++c)
+					sum[c] = (normal[c] / fLength * 0.5f + 0.5f) * 255.0f;
+			}
+
+			for (int c = 0; c < 4; ++c)
+				destination[(y * nDestWidth + x) * 4 + c] = static_cast<unsigned char>(sum[c] + 0.5f);
+		}
+	}
+}
+
+bool TextureCompressor::Compress(const char* szSourcePath, const char* szDestPath, ETextureCompression eFormat)
+{
+	CPU_PROFILE_ZONE("TextureCompressor::Compress");
+
+	int nWidth = 0;
+	int nHeight = 0;
+	int nChannels = 0;
+
+	unsigned char* texels = stbi_load(szSourcePath, &nWidth, &nHeight, &nChannels, STBI_rgb_alpha);
+
+	if(!texels)
+	{
+		std::cout << "Failed to load image: " << szSourcePath << std::endl;
+		return false;
+	}
+
+	// Written beside the destination and moved into place once complete, so an interrupted encode never leaves a truncated file to be reused.
+	std::string tempPath = std::string(szDestPath) + ".tmp";
+	std::ofstream file(tempPath, std::ios::binary);
+
+	if(!file.good())
+	{
+		std::cout << "Texture Compressor Error: Could not write " << tempPath << std::endl;
+
+		stbi_image_free(texels);
+		return false;
+	}
+
+	unsigned int nBlockSize = eFormat == TEXTURE_COMPRESSION_BC1 || eFormat == TEXTURE_COMPRESSION_BC4 ? 8 : 16;
+
+	unsigned int nFourCC = 0;
+
+	switch(eFormat)
+	{
+	case TEXTURE_COMPRESSION_BC1:
+		nFourCC = FOURCC('D', 'X', 'T', '1');
+		break;
+
+	case TEXTURE_COMPRESSION_BC3:
+		nFourCC = FOURCC('D', 'X', 'T', '5');
+		break;
+
+	case TEXTURE_COMPRESSION_BC4:
+		nFourCC = FOURCC('A', 'T', 'I', '1');
+		break;
+
+	case TEXTURE_COMPRESSION_BC5:
+		nFourCC = FOURCC('A', 'T', 'I', '2');
+		break;
+	}
+
+	int nLevelCount = 1;
+
+	while (((nWidth > nHeight ? nWidth : nHeight) >> nLevelCount) > 0)
+		++nLevelCount;
+
+	// Write header...
+	unsigned int header[DDS_HEADER_SIZE / 4];
+	memset(header, 0, sizeof(header));
+
+	header[0] = DDS_HEADER_SIZE;
+	header[1] = DDS_HEADER_FLAGS;
+	header[2] = nHeight;
+	header[3] = nWidth;
+	header[4] = ((nWidth + 3) / 4) * ((nHeight + 3) / 4) * nBlockSize; // Size of the first level.
+	header[6] = nLevelCount;
+	header[18] = 32; // Pixel format size.
+	header[19] = DDS_PIXEL_FORMAT_FOURCC;
+	header[20] = nFourCC;
+	header[26] = DDS_CAPS_MIPMAPPED_TEXTURE;
+
+	unsigned int nMagic = DDS_MAGIC;
+
+	file.write(reinterpret_cast<const char*>(&nMagic), sizeof(nMagic));
+	file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+	// Encode each level, then halve it for the next...
+	unsigned char* levelTexels = texels;
+	unsigned char* blocks = new unsigned char[((nWidth + 3) / 4) * ((nHeight + 3) / 4) * nBlockSize];
+
+	int nLevelWidth = nWidth;
+	int nLevelHeight = nHeight;
+
+	for(int i = 0; i < nLevelCount; ++i)
+	{
+		int nBlockCountX = (nLevelWidth + 3) / 4;
+		int nBlockCountY = (nLevelHeight + 3) / 4;
+
+		for(int y = 0; y < nBlockCountY; ++y)
+		{
+			for(int x = 0; x < nBlockCountX; ++x)
+			{
+				unsigned char block[16][4];
+				FetchBlock(levelTexels, nLevelWidth, nLevelHeight, x, y, block);
+
+				unsigned char* out = blocks + (y * nBlockCountX + x) * nBlockSize;
+
+				switch(eFormat)
+				{
+				case TEXTURE_COMPRESSION_BC1:
+					EncodeBC1(block, out);
+					break;
+
+				case TEXTURE_COMPRESSION_BC3:
+					EncodeBC4(block, 3, out);
+					EncodeBC1(block, out + 8);
+					break;
+
+				case TEXTURE_COMPRESSION_BC4:
+					EncodeBC4(block, 0, out);
+					break;
+
+				case TEXTURE_COMPRESSION_BC5:
+					EncodeBC4(block, 0, out);
+					EncodeBC4(block, 1, out + 8);
+					break;
+				}
+			}
+		}
+
+		file.write(reinterpret_cast<const char*>(blocks), nBlockCountX * nBlockCountY * nBlockSize);
+
+		if (i == nLevelCount - 1)
+			break;
+
+		int nNextWidth = nLevelWidth > 1 ? nLevelWidth / 2 : 1;
+		int nNextHeight = nLevelHeight > 1 ? nLevelHeight / 2 : 1;
+
+		unsigned char* nextTexels = new unsigned char[nNextWidth * nNextHeight * 4];
+		Downsample(levelTexels, nLevelWidth, nLevelHeight, nextTexels, eFormat == TEXTURE_COMPRESSION_BC5);
+
+		if (levelTexels != texels)
+			delete[] levelTexels;
+
+		levelTexels = nextTexels;
+		nLevelWidth = nNextWidth;
+		nLevelHeight = nNextHeight;
+	}
+
+	if (levelTexels != texels)
+		delete[] levelTexels;
+
+	delete[] blocks;
+	stbi_image_free(texels);
+
+	bool bWritten = file.good();
+	file.close();
+
+	if(!bWritten || file.fail())
+	{
+		std::cout << "Texture Compressor Error: Could not write " << tempPath << std::endl;
+
+		std::remove(tempPath.c_str());
+		return false;
+	}
+
+	// Rename does not replace an existing file on every platform.
+	std::remove(szDestPath);
+
+	if(std::rename(tempPath.c_str(), szDestPath) != 0)
+	{
+		std::cout << "Texture Compressor Error: Could not move " << tempPath << " to " << szDestPath << std::endl;
+
+		std::remove(tempPath.c_str());
+		return false;
+	}
+
+	std::cout << "Successfully compressed image: " << szSourcePath << " to " << szDestPath << std::endl;
+
+	return true;
+}
+
+std::string TextureCompressor::CompressedPath(const char* szSourcePath, ETextureCompression eFormat)
+{
+	const char* formatExtensions[] = { ".bc1.dds", ".bc3.dds", ".bc4.dds", ".bc5.dds" };
+
+	std::string compressedPath = std::string(szSourcePath) + formatExtensions[eFormat];
+
+	struct stat sourceStat;
+	struct stat compressedStat;
+
+	// Encoded on the first run, and again whenever the source is modified after its copy was written.
+	if (stat(compressedPath.c_str(), &compressedStat) == 0 && (stat(szSourcePath, &sourceStat) != 0 || sourceStat.st_mtime <= compressedStat.st_mtime))
+		return compressedPath;
+
+	if (!Compress(szSourcePath, compressedPath.c_str(), eFormat))
+		return szSourcePath;
+
+	return compressedPath;
+}
+
+ETextureCompression TextureCompressor::FormatForMap(ETextureMapType eMapType)
+{
+	switch(eMapType)
+	{
+	case TEXTURE_MAP_NORMAL:
+		return TEXTURE_COMPRESSION_BC5;
+
+	// Single channel maps.
+	case TEXTURE_MAP_SPECULARHIGHLIGHT:
+	case TEXTURE_MAP_DISPLACEMENT:
+	case TEXTURE_MAP_ALPHA:
+		return TEXTURE_COMPRESSION_BC4;
+
+	default:
+		return TEXTURE_COMPRESSION_BC1;
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "Mesh.h"
+#include <string>
+
+// Block compressed formats the encoder writes.
+enum ETextureCompression
+{
+	TEXTURE_COMPRESSION_BC1, // Opaque color, 8 bytes per 4x4 block.
+	TEXTURE_COMPRESSION_BC3, // Color with alpha, 16 bytes per block.
+	TEXTURE_COMPRESSION_BC4, // Single channel from red, 8 bytes per block.
+	TEXTURE_COMPRESSION_BC5 // Two channels from red and green, 16 bytes per block. Used for normal maps, Z is rebuilt in the shaders.
+};
+
+/*
+Encoder converting images stb_image can load into DDS files with a full mip chain of BC1, BC3, BC4 or BC5 blocks, to be loaded by
+Texture and CubeMap in place of the source. Compression favours speed over quality so assets can be converted the first time they are used,
+files encoded offline by other tools, including BC7, load the same way.
+*/
+class TextureCompressor
+{
+public:
+
+	/*
+	Description: Encode an image file and its mip chain into a DDS file. The file is only replaced once it has been written completely.
+	Return Type: bool
+	Param:
+	    const char* szSourcePath: Path to the source image.
+		const char* szDestPath: Path of the DDS file to write.
+		ETextureCompression eFormat: The block format to encode to.
+	Returns true if the DDS file was written.
+	*/
+	static bool Compress(const char* szSourcePath, const char* szDestPath, ETextureCompression eFormat);
+
+	/*
+	Description: Get the path of an image's compressed copy next to it, encoding it first if it does not exist yet or is older than the source.
+	Return Type: std::string
+	Param:
+	    const char* szSourcePath: Path to the source image.
+		ETextureCompression eFormat: The block format of the copy.
+	Returns the path of the compressed copy, or the source path if it could not be encoded.
+	*/
+	static std::string CompressedPath(const char* szSourcePath, ETextureCompression eFormat);
+
+	/*
+	Description: Get the block format suited to a kind of material map.
+	Return Type: ETextureCompression
+	Param:
+	    ETextureMapType eMapType: The kind of map.
+	*/
+	static ETextureCompression FormatForMap(ETextureMapType eMapType);
+};
@@ -0,0 +1,365 @@
+#include "TextureStreamer.h"
+#include "glad/glad.h"
+#include "GLState.h"
+#include "Texture.h"
+#include "UploadRing.h"
+#include "MaterialTable.h"
+#include "CPUProfiler.h"
+#include <iostream>
+#include <cstring>
+#include <cstdint>
+
+#include "stb_image.h"
+
+TextureStreamer* TextureStreamer::m_instance = nullptr;
+
+TextureStreamer::TextureStreamer(unsigned int nFrameBudget, int nWorkerCount)
+{
+	m_nFrameBudget = nFrameBudget;
+	m_bStopping = false;
+
+	// Texels are staged in a ring of their own, so streaming never takes space from the frame's instance and draw data...
+	m_unpackRing = new UploadRing(nFrameBudget, UPLOAD_RING_FRAME_COUNT);
+
+	// A flat tangent space normal, the least disruptive stand-in for any kind of map.
+	const unsigned char placeholderTexel[] = { 128, 128, 255, 255 };
+
+	glGenTextures(1, &m_glPlaceholderHandle);
+	GLState::GetInstance()->BindTexture(GL_TEXTURE_2D, m_glPlaceholderHandle);
+
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, 1, 1);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, placeholderTexel);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	GLState::GetInstance()->BindTexture(GL_TEXTURE_2D, 0);
+
+	for (int i = 0; i < nWorkerCount; ++i)
+		m_workers.Push(new std::thread(&TextureStreamer::WorkerMain, this));
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	// Let workers finish the image they are decoding...
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_bStopping = true;
+	}
+
+	m_wakeCondition.notify_all();
+
+	for(int i = 0; i < m_workers.Count(); ++i)
+	{
+		m_workers[i]->join();
+		delete m_workers[i];
+	}
+
+	// Textures still streaming are left empty, the placeholder is deleted with the streamer.
+	for (int i = 0; i < m_jobs.Count(); ++i)
+	{
+		Texture* texture = m_jobs[i]->m_texture;
+
+		if(texture)
+		{
+			texture->m_glHandle = 0;
+			texture->m_bStreaming = false;
+		}
+
+		Release(m_jobs[i]);
+	}
+
+	GLState::GetInstance()->DeleteTextures(1, &m_glPlaceholderHandle);
+
+	delete m_unpackRing;
+}
+
+void TextureStreamer::Request(Texture* texture, const char* szFilePath)
+{
+	Job* job = new Job();
+	job->m_texture = texture;
+	job->m_szFilePath = szFilePath;
+	job->m_texels = nullptr;
+	job->m_nWidth = 0;
+	job->m_nHeight = 0;
+	job->m_bDecoded = false;
+	job->m_glHandle = 0;
+	job->m_nRowsUploaded = 0;
+
+	m_jobs.Push(job);
+
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_decodeQueue.push_back(job);
+	}
+
+	m_wakeCondition.notify_one();
+}
+
+void TextureStreamer::Cancel(Texture* texture)
+{
+	for(int i = 0; i < m_jobs.Count(); ++i)
+	{
+		Job* job = m_jobs[i];
+
+		if (job->m_texture != texture)
+			continue;
+
+		bool bWaiting = false;
+		bool bDecoded = false;
+
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+
+			job->m_texture = nullptr;
+			bDecoded = job->m_bDecoded;
+
+			for (auto it = m_decodeQueue.begin(); it != m_decodeQueue.end() && !bWaiting; ++it)
+			{
+				if (*it != job)
+					continue;
+
+				m_decodeQueue.erase(it);
+				bWaiting = true;
+			}
+		}
+
+		// A job still being decoded is released by BeginFrame once its worker is done with it.
+		if(bWaiting || bDecoded)
+		{
+			Release(job);
+			m_jobs.PopAt(i);
+		}
+
+		return;
+	}
+}
+
+void TextureStreamer::BeginFrame()
+{
+	CPU_PROFILE_ZONE("TextureStreamer::BeginFrame");
+
+	// Wait until the GPU is done with the oldest frame's uploads so its space can be reused...
+	m_unpackRing->BeginFrame();
+
+	unsigned int nBudget = m_nFrameBudget;
+
+	// Textures are uploaded in the order they were requested, those still decoding are skipped...
+	int i = 0;
+
+	while(i < m_jobs.Count())
+	{
+		Job* job = m_jobs[i];
+		bool bDecoded = false;
+
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+			bDecoded = job->m_bDecoded;
+		}
+
+		if(!bDecoded)
+		{
+			++i;
+			continue;
+		}
+
+		// Cancelled or failed to decode, the texture keeps the placeholder.
+		if(!job->m_texture || !job->m_texels)
+		{
+			if (job->m_texture)
+			{
+				std::cout << "Failed to load image: " << job->m_szFilePath << std::endl;
+
+				// No longer streaming, but the placeholder still belongs to the streamer.
+				job->m_texture->m_bStreaming = false;
+				job->m_texture->m_bOwnsTexture = false;
+			}
+
+			Release(job);
+			m_jobs.PopAt(i);
+			continue;
+		}
+
+		if (nBudget == 0 || !Upload(job, nBudget))
+			break;
+
+		Complete(job);
+		m_jobs.PopAt(i);
+	}
+}
+
+void TextureStreamer::EndFrame()
+{
+	m_unpackRing->EndFrame();
+}
+
+unsigned int TextureStreamer::PlaceholderHandle() const
+{
+	return m_glPlaceholderHandle;
+}
+
+int TextureStreamer::PendingCount() const
+{
+	return m_jobs.Count();
+}
+
+unsigned int TextureStreamer::BytesUploaded() const
+{
+	return m_unpackRing->BytesUploaded();
+}
+
+void TextureStreamer::Create(unsigned int nFrameBudget, int nWorkerCount)
+{
+	if (!m_instance)
+		m_instance = new TextureStreamer(nFrameBudget, nWorkerCount);
+}
+
+void TextureStreamer::Destroy()
+{
+	if(m_instance)
+	{
+		delete m_instance;
+		m_instance = nullptr;
+	}
+}
+
+TextureStreamer* TextureStreamer::GetInstance()
+{
+	return m_instance;
+}
+
+void TextureStreamer::WorkerMain()
+{
+	if (CPUProfiler::GetInstance())
+		CPUProfiler::GetInstance()->SetThreadName("Texture decode");
+
+	while(true)
+	{
+		Job* job = nullptr;
+
+		{
+			std::unique_lock<std::mutex> lock(m_lock);
+			m_wakeCondition.wait(lock, [this]() { return m_bStopping || !m_decodeQueue.empty(); });
+
+			if (m_bStopping)
+				return;
+
+			job = m_decodeQueue.front();
+			m_decodeQueue.pop_front();
+		}
+
+		int nWidth = 0;
+		int nHeight = 0;
+		int nChannels = 0;
+		unsigned char* texels = nullptr;
+
+		{
+			CPU_PROFILE_ZONE("Decode texture");
+			texels = stbi_load(job->m_szFilePath.c_str(), &nWidth, &nHeight, &nChannels, STBI_rgb_alpha);
+		}
+
+		// The render thread reads the result once the job is marked decoded...
+		std::lock_guard<std::mutex> lock(m_lock);
+
+		job->m_texels = texels;
+		job->m_nWidth = nWidth;
+		job->m_nHeight = nHeight;
+		job->m_bDecoded = true;
+	}
+}
+
+bool TextureStreamer::Upload(Job* job, unsigned int& nBudget)
+{
+	GLState* glState = GLState::GetInstance();
+
+	if(job->m_glHandle == 0)
+	{
+		int nMipCount = 1;
+
+		while (((job->m_nWidth > job->m_nHeight ? job->m_nWidth : job->m_nHeight) >> nMipCount) > 0)
+			++nMipCount;
+
+		glGenTextures(1, &job->m_glHandle);
+		glState->BindTexture(GL_TEXTURE_2D, job->m_glHandle);
+
+		glTexStorage2D(GL_TEXTURE_2D, nMipCount, GL_RGBA8, job->m_nWidth, job->m_nHeight);
+
+		// Same sampling as textures loaded immediately.
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	}
+
+	// Whole rows only, a texture continues from the next row the following frame...
+	unsigned int nRowSize = static_cast<unsigned int>(job->m_nWidth) * 4;
+	int nRowCount = job->m_nHeight - job->m_nRowsUploaded;
+
+	if (static_cast<unsigned int>(nRowCount) > nBudget / nRowSize)
+		nRowCount = static_cast<int>(nBudget / nRowSize);
+
+	if (nRowCount == 0)
+		return false;
+
+	unsigned int nSize = nRowSize * nRowCount;
+	unsigned int nOffset = 0;
+
+	void* destination = m_unpackRing->Allocate(nSize, 4, nOffset);
+
+	if (!destination)
+		return false;
+
+	memcpy(destination, job->m_texels + static_cast<size_t>(job->m_nRowsUploaded) * nRowSize, nSize);
+
+	// Copy from the ring on the GPU timeline, the ring's fence keeps the region intact until it has...
+	glState->BindBuffer(GL_PIXEL_UNPACK_BUFFER, m_unpackRing->Handle());
+	glState->BindTexture(GL_TEXTURE_2D, job->m_glHandle);
+
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, job->m_nRowsUploaded, job->m_nWidth, nRowCount, GL_RGBA, GL_UNSIGNED_BYTE, reinterpret_cast<void*>(static_cast<uintptr_t>(nOffset)));
+
+	glState->BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	job->m_nRowsUploaded += nRowCount;
+	nBudget -= nSize;
+
+	bool bComplete = job->m_nRowsUploaded == job->m_nHeight;
+
+	if (bComplete)
+		glGenerateMipmap(GL_TEXTURE_2D);
+
+	glState->BindTexture(GL_TEXTURE_2D, 0);
+
+	return bComplete;
+}
+
+void TextureStreamer::Complete(Job* job)
+{
+	Texture* texture = job->m_texture;
+
+	texture->m_glHandle = job->m_glHandle;
+	texture->m_nWidth = job->m_nWidth;
+	texture->m_nHeight = job->m_nHeight;
+	texture->m_bStreaming = false;
+
+	// The texture owns the storage from here on.
+	job->m_glHandle = 0;
+
+	// Bindless handles of the placeholder in material entries are replaced with the texture's own...
+	if (MaterialTable::GetInstance())
+		MaterialTable::GetInstance()->RefreshTexture(texture);
+
+	std::cout << "Successfully streamed image: " << job->m_szFilePath << std::endl;
+
+	Release(job);
+}
+
+void TextureStreamer::Release(Job* job)
+{
+	if (job->m_texels)
+		stbi_image_free(job->m_texels);
+
+	if (job->m_glHandle > 0)
+		GLState::GetInstance()->DeleteTextures(1, &job->m_glHandle);
+
+	delete job;
+}
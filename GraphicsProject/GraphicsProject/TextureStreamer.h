@@ -0,0 +1,128 @@
+#pragma once
+#include "DynamicArray.h"
+#include <string>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+class Texture;
+class UploadRing;
+
+// Bytes of texel data uploaded each frame at most, the rest of a texture continues the next frame.
+#define TEXTURE_STREAMING_FRAME_BUDGET (2 * 1024 * 1024)
+
+// Threads decoding image files.
+#define TEXTURE_STREAMING_WORKER_COUNT 2
+
+/*
+Loads textures without stalling the render thread. Image files are decoded on worker threads, and the decoded texels are uploaded
+a bounded amount of bytes per frame through a pixel unpack ring into immutable storage. Until its upload is complete a streamed
+texture's handle is a shared 1x1 placeholder, the texture switches to its own storage and the decoded texels are freed once it is.
+Materials in the MaterialTable are refreshed when a texture they use switches.
+*/
+class TextureStreamer
+{
+public:
+
+	/*
+	Param:
+	    unsigned int nFrameBudget: Bytes uploaded per frame at most.
+		int nWorkerCount: The amount of decoding threads.
+	*/
+	TextureStreamer(unsigned int nFrameBudget, int nWorkerCount);
+
+	~TextureStreamer();
+
+	/*
+	Description: Queue an image file to be decoded and uploaded to a texture, which holds the placeholder until the upload is done.
+	Param:
+	    Texture* texture: The texture to stream into.
+		const char* szFilePath: Path to the image file.
+	*/
+	void Request(Texture* texture, const char* szFilePath);
+
+	/*
+	Description: Discard the pending work of a texture being deleted before its upload completed.
+	Param:
+	    Texture* texture: The texture being deleted.
+	*/
+	void Cancel(Texture* texture);
+
+	/*
+	Description: Upload decoded texels up to the frame budget, and switch textures whose upload is done to their own storage.
+	Waits for the GPU to finish reading this frame's region of the unpack ring from its last use.
+	*/
+	void BeginFrame();
+
+	/*
+	Description: Place a fence after the commands reading this frame's uploads.
+	*/
+	void EndFrame();
+
+	/*
+	Description: Get the OpenGL handle of the placeholder texture streamed textures hold until uploaded.
+	Return Type: unsigned int
+	*/
+	unsigned int PlaceholderHandle() const;
+
+	/*
+	Description: Get the amount of textures still being decoded or uploaded.
+	Return Type: int
+	*/
+	int PendingCount() const;
+
+	/*
+	Description: Get the amount of texel bytes uploaded during the last completed frame.
+	Return Type: unsigned int
+	*/
+	unsigned int BytesUploaded() const;
+
+	// Singleton functions.
+
+	static void Create(unsigned int nFrameBudget = TEXTURE_STREAMING_FRAME_BUDGET, int nWorkerCount = TEXTURE_STREAMING_WORKER_COUNT);
+	static void Destroy();
+	static TextureStreamer* GetInstance();
+
+private:
+
+	struct Job
+	{
+		Texture* m_texture; // Cleared if the texture is deleted first.
+		std::string m_szFilePath;
+		unsigned char* m_texels; // Decoded RGBA8 texels, nullptr until decoded or if decoding failed.
+		int m_nWidth;
+		int m_nHeight;
+		bool m_bDecoded;
+		unsigned int m_glHandle; // Storage the texels are uploaded to, created once decoded.
+		int m_nRowsUploaded;
+	};
+
+	// Decode queued jobs until the streamer is destroyed.
+	void WorkerMain();
+
+	// Allocate a decoded job's storage and upload as many of its rows as the budget allows. Returns true once every row is uploaded.
+	bool Upload(Job* job, unsigned int& nBudget);
+
+	// Switch the job's texture to its uploaded storage and release the job.
+	void Complete(Job* job);
+
+	// Free a job's texels and storage.
+	void Release(Job* job);
+
+	static TextureStreamer* m_instance;
+
+	UploadRing* m_unpackRing;
+	unsigned int m_nFrameBudget;
+	unsigned int m_glPlaceholderHandle;
+
+	DynamicArray<Job*> m_jobs; // Every job in request order, only touched by the render thread.
+
+	// Shared with the workers.
+	std::deque<Job*> m_decodeQueue;
+	std::mutex m_lock;
+	std::condition_variable m_wakeCondition;
+	bool m_bStopping;
+
+	DynamicArray<std::thread*> m_workers;
+};
@@ -0,0 +1,296 @@
+#include "UploadRing.h"
+#include "glad/glad.h"
+#include "GLState.h"
+#include <iostream>
+#include <chrono>
+#include <cstring>
+
+UploadRing* UploadRing::m_instance = nullptr;
+
+UploadRing::UploadRing(unsigned int nFrameSize, int nFrameCount, bool bGrowable)
+{
+	m_nFrameSize = nFrameSize;
+	m_nFrameCount = nFrameCount;
+	m_nFrameIndex = 0;
+	m_nFrameOffset = 0;
+	m_bGrowable = bGrowable;
+
+	m_nFrameBytes = 0;
+	m_nBytesUploaded = 0;
+	m_fFenceWaitTime = 0.0f;
+	m_bOverflowReported = false;
+
+	m_fences = new GLsync[m_nFrameCount];
+
+	for (int i = 0; i < m_nFrameCount; ++i)
+		m_fences[i] = nullptr;
+
+	// Get binding alignment requirements...
+	int nAlignment = 0;
+
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &nAlignment);
+	m_nUniformAlignment = static_cast<unsigned int>(nAlignment);
+
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &nAlignment);
+	m_nStorageAlignment = static_cast<unsigned int>(nAlignment);
+
+	// Allocate immutable storage and keep it mapped for the lifetime of the ring...
+	const unsigned int glFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	glGenBuffers(1, &m_glBufferHandle);
+	GLState::GetInstance()->BindBuffer(GL_COPY_WRITE_BUFFER, m_glBufferHandle);
+	glBufferStorage(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(m_nFrameSize) * m_nFrameCount, nullptr, glFlags);
+
+	m_mappedData = static_cast<unsigned char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, static_cast<GLsizeiptr>(m_nFrameSize) * m_nFrameCount, glFlags));
+
+	GLState::GetInstance()->BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	if (!m_mappedData)
+		std::cout << "Upload Ring Error: Failed to map ring buffer." << std::endl;
+}
+
+UploadRing::~UploadRing()
+{
+	for(int i = 0; i < m_nFrameCount; ++i) 
+	{
+		if (m_fences[i])
+			glDeleteSync(m_fences[i]);
+	}
+
+	delete[] m_fences;
+
+	ReleaseRetiredBuffers();
+
+	// Unmap and delete buffer.
+	GLState::GetInstance()->BindBuffer(GL_COPY_WRITE_BUFFER, m_glBufferHandle);
+	glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+	GLState::GetInstance()->BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	GLState::GetInstance()->DeleteBuffers(1, &m_glBufferHandle);
+}
+
+void UploadRing::BeginFrame()
+{
+	// Remember how much the last frame uploaded...
+	m_nBytesUploaded = m_nFrameBytes;
+	m_nFrameBytes = 0;
+
+	m_nFrameIndex = (m_nFrameIndex + 1) % m_nFrameCount;
+	m_nFrameOffset = 0;
+
+	// Nothing holds a pointer into replaced buffers past the frame they were replaced in.
+	ReleaseRetiredBuffers();
+
+	m_fFenceWaitTime = 0.0f;
+
+	GLsync& fence = m_fences[m_nFrameIndex];
+
+	if (!fence)
+		return;
+
+	// Wait for the GPU to finish reading this region from its last use...
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	GLenum glWaitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+
+	while (glWaitResult == GL_TIMEOUT_EXPIRED)
+		glWaitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1ms
+
+	auto endTime = std::chrono::high_resolution_clock::now();
+
+	m_fFenceWaitTime = static_cast<float>(std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count()) / 1000.0f;
+
+	glDeleteSync(fence);
+	fence = nullptr;
+}
+
+void UploadRing::EndFrame()
+{
+	GLsync& fence = m_fences[m_nFrameIndex];
+
+	if (fence)
+		glDeleteSync(fence);
+
+	fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void* UploadRing::Allocate(unsigned int nSize, unsigned int nAlignment, unsigned int& nOutOffset)
+{
+	// Offset of this frame's region within the buffer.
+	unsigned int nRegionStart = m_nFrameIndex * m_nFrameSize;
+
+	// Align the absolute offset, alignments such as instance strides are not powers of two.
+	unsigned int nOffset = nRegionStart + m_nFrameOffset;
+
+	if (nAlignment > 1)
+		nOffset = ((nOffset + nAlignment - 1) / nAlignment) * nAlignment;
+
+	if(!m_mappedData || nOffset + nSize > nRegionStart + m_nFrameSize) 
+	{
+		// Grow to fit, the frame's region moves to the start of the new buffer so everything up to the new space keeps its offset...
+		if (m_mappedData && m_bGrowable && Grow(nOffset + nSize))
+			return Allocate(nSize, nAlignment, nOutOffset);
+
+		if(!m_bOverflowReported) 
+		{
+			std::cout << "Upload Ring Error: Frame region of " << m_nFrameSize << " bytes exceeded, upload skipped." << std::endl;
+			m_bOverflowReported = true;
+		}
+
+		return nullptr;
+	}
+
+	m_nFrameOffset = (nOffset + nSize) - nRegionStart;
+	m_nFrameBytes += nSize;
+
+	nOutOffset = nOffset;
+
+	return m_mappedData + nOffset;
+}
+
+bool UploadRing::Upload(const void* data, unsigned int nSize, unsigned int nAlignment, unsigned int& nOutOffset)
+{
+	void* dest = Allocate(nSize, nAlignment, nOutOffset);
+
+	if (!dest)
+		return false;
+
+	memcpy(dest, data, nSize);
+
+	return true;
+}
+
+void* UploadRing::MappedData(unsigned int nOffset) const
+{
+	return m_mappedData + nOffset;
+}
+
+unsigned int UploadRing::Handle() const
+{
+	return m_glBufferHandle;
+}
+
+unsigned int UploadRing::UniformAlignment() const
+{
+	return m_nUniformAlignment;
+}
+
+unsigned int UploadRing::StorageAlignment() const
+{
+	return m_nStorageAlignment;
+}
+
+unsigned int UploadRing::BytesUploaded() const
+{
+	return m_nBytesUploaded;
+}
+
+float UploadRing::FenceWaitTime() const
+{
+	return m_fFenceWaitTime;
+}
+
+bool UploadRing::Grow(unsigned int nRequiredSize)
+{
+	// Double the regions until the frame's data fits in the first of them...
+	unsigned long long nFrameSize = static_cast<unsigned long long>(m_nFrameSize) * 2;
+
+	while (nFrameSize < nRequiredSize)
+		nFrameSize *= 2;
+
+	// Offsets are 32-bit.
+	if (nFrameSize * m_nFrameCount > 0xFFFFFFFFull)
+		return false;
+
+	GLState* glState = GLState::GetInstance();
+
+	const unsigned int glFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	unsigned int glNewBufferHandle = 0;
+
+	glGenBuffers(1, &glNewBufferHandle);
+	glState->BindBuffer(GL_COPY_WRITE_BUFFER, glNewBufferHandle);
+	glBufferStorage(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(nFrameSize * m_nFrameCount), nullptr, glFlags);
+
+	unsigned char* newData = static_cast<unsigned char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, static_cast<GLsizeiptr>(nFrameSize * m_nFrameCount), glFlags));
+
+	if(!newData)
+	{
+		glState->BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		glState->DeleteBuffers(1, &glNewBufferHandle);
+
+		return false;
+	}
+
+	// Copy this frame's data to the same offsets on the GPU, after anything shaders have written into it...
+	unsigned int nRegionStart = m_nFrameIndex * m_nFrameSize;
+
+	if(m_nFrameOffset > 0)
+	{
+		glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+		glState->BindBuffer(GL_COPY_READ_BUFFER, m_glBufferHandle);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, nRegionStart, nRegionStart, m_nFrameOffset);
+		glState->BindBuffer(GL_COPY_READ_BUFFER, 0);
+	}
+
+	glState->BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	// Earlier pointers into the old buffer stay writable until the next frame, commands already issued keep reading it.
+	m_retiredBuffers.Push(m_glBufferHandle);
+
+	// The other regions of the new buffer have never been used, so no fence guards them...
+	for(int i = 0; i < m_nFrameCount; ++i) 
+	{
+		if (m_fences[i])
+			glDeleteSync(m_fences[i]);
+
+		m_fences[i] = nullptr;
+	}
+
+	m_glBufferHandle = glNewBufferHandle;
+	m_mappedData = newData;
+	m_nFrameSize = static_cast<unsigned int>(nFrameSize);
+	m_nFrameIndex = 0;
+	m_nFrameOffset += nRegionStart;
+
+	std::cout << "Upload Ring Warning: Frame region exceeded, grown to " << m_nFrameSize << " bytes." << std::endl;
+
+	return true;
+}
+
+void UploadRing::ReleaseRetiredBuffers()
+{
+	GLState* glState = GLState::GetInstance();
+
+	for(int i = 0; i < m_retiredBuffers.Count(); ++i)
+	{
+		glState->BindBuffer(GL_COPY_WRITE_BUFFER, m_retiredBuffers[i]);
+		glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		glState->BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+		glState->DeleteBuffers(1, &m_retiredBuffers[i]);
+	}
+
+	m_retiredBuffers.Clear();
+}
+
+void UploadRing::Create(unsigned int nFrameSize, int nFrameCount)
+{
+	if (!m_instance)
+		m_instance = new UploadRing(nFrameSize, nFrameCount, true);
+}
+
+void UploadRing::Destroy()
+{
+	if (m_instance)
+	{
+		delete m_instance;
+		m_instance = nullptr;
+	}
+}
+
+UploadRing* UploadRing::GetInstance()
+{
+	return m_instance;
+}
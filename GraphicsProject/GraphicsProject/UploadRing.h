@@ -0,0 +1,137 @@
+#pragma once
+#include "DynamicArray.h"
+
+// Bytes available to each frame for transient uploads.
+#define UPLOAD_RING_FRAME_SIZE (4 * 1024 * 1024)
+
+// Frames the CPU may write ahead of the GPU before waiting.
+#define UPLOAD_RING_FRAME_COUNT 3
+
+struct __GLsync;
+
+/*
+Transient per-frame upload allocator. A single persistently mapped buffer is split into one region per frame in flight,
+data written this frame is never overwritten until the GPU has signalled the fence placed at the end of the frame that used it.
+A growable ring replaces its buffer with a larger one when a frame's region is full, keeping the offsets of everything reserved so far this frame.
+The buffer handle changes when it grows, so it is bound where the data is used rather than kept in vertex arrays or other state.
+*/
+class UploadRing
+{
+public:
+
+	UploadRing(unsigned int nFrameSize, int nFrameCount, bool bGrowable = false);
+
+	~UploadRing();
+
+	/*
+	Description: Move on to the next frame's region, waiting for the GPU to finish with it if necessary.
+	*/
+	void BeginFrame();
+
+	/*
+	Description: Place a fence after all commands using this frame's region.
+	*/
+	void EndFrame();
+
+	/*
+	Description: Reserve space in this frame's region.
+	Return Type: void*
+	Param:
+	    unsigned int nSize: The amount of bytes to reserve.
+		unsigned int nAlignment: The alignment of the reserved offset within the buffer, it does not need to be a power of two.
+		unsigned int& nOutOffset: The offset of the reserved space from the start of the buffer.
+	Returns the mapped pointer to write to, or nullptr if the frame's region is full and the ring can't grow.
+	The pointer is only valid until the next allocation, which may grow the ring. Use MappedData to write to the space later.
+	*/
+	void* Allocate(unsigned int nSize, unsigned int nAlignment, unsigned int& nOutOffset);
+
+	/*
+	Description: Copy data into this frame's region.
+	Return Type: bool
+	Param:
+	    const void* data: The data to copy.
+		unsigned int nSize: The size of the data in bytes.
+		unsigned int nAlignment: The alignment of the offset within the buffer.
+		unsigned int& nOutOffset: The offset of the data from the start of the buffer.
+	Returns false if the frame's region is full and the ring can't grow.
+	*/
+	bool Upload(const void* data, unsigned int nSize, unsigned int nAlignment, unsigned int& nOutOffset);
+
+	/*
+	Description: Get the mapped pointer to space reserved earlier this frame.
+	Return Type: void*
+	Param:
+	    unsigned int nOffset: The offset returned when the space was reserved.
+	*/
+	void* MappedData(unsigned int nOffset) const;
+
+	/*
+	Description: Get the OpenGL handle of the ring buffer, it changes when the ring grows.
+	Return Type: unsigned int
+	*/
+	unsigned int Handle() const;
+
+	/*
+	Description: Get the required offset alignment for ranges bound as uniform buffers.
+	Return Type: unsigned int
+	*/
+	unsigned int UniformAlignment() const;
+
+	/*
+	Description: Get the required offset alignment for ranges bound as shader storage buffers.
+	Return Type: unsigned int
+	*/
+	unsigned int StorageAlignment() const;
+
+	/*
+	Description: Get the amount of bytes written to the ring during the last completed frame.
+	Return Type: unsigned int
+	*/
+	unsigned int BytesUploaded() const;
+
+	/*
+	Description: Get the time spent waiting on the GPU fence at the start of the current frame, in milliseconds.
+	Return Type: float
+	*/
+	float FenceWaitTime() const;
+
+	// Singleton functions.
+
+	static void Create(unsigned int nFrameSize = UPLOAD_RING_FRAME_SIZE, int nFrameCount = UPLOAD_RING_FRAME_COUNT);
+	static void Destroy();
+	static UploadRing* GetInstance();
+
+private:
+
+	static UploadRing* m_instance;
+
+	// Replace the buffer with one whose regions hold at least nRequiredSize bytes, copying what this frame has written so far.
+	bool Grow(unsigned int nRequiredSize);
+
+	// Unmap and delete buffers replaced by growing, once the frame that may still write to their mappings is over.
+	void ReleaseRetiredBuffers();
+
+	unsigned int m_glBufferHandle;
+	unsigned char* m_mappedData;
+
+	unsigned int m_nFrameSize;
+	int m_nFrameCount;
+	int m_nFrameIndex;
+	unsigned int m_nFrameOffset;
+	bool m_bGrowable;
+
+	// Buffers replaced by growing this frame.
+	DynamicArray<unsigned int> m_retiredBuffers;
+
+	// Fence placed after the last frame to use each region.
+	__GLsync** m_fences;
+
+	unsigned int m_nUniformAlignment;
+	unsigned int m_nStorageAlignment;
+
+	// Statistics
+	unsigned int m_nFrameBytes;
+	unsigned int m_nBytesUploaded;
+	float m_fFenceWaitTime;
+	bool m_bOverflowReported;
+};
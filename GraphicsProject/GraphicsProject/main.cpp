@@ -2,15 +2,37 @@
 
 #include <crtdbg.h>
 #include <iostream>
+#include <cstring>
+#include <cstdlib>
 
-int main() 
+int main(int argc, char** argv) 
 {
 	_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 
 	Application* application = new Application();
 
 	// Initialize and quit if the code is not zero.
-	int code = application->Init();
+	int code = 0;
+
+	// --headless [width] [height] [frame count] [output.tga] renders without a window and saves the last frame.
+	if(argc > 1 && strcmp(argv[1], "--headless") == 0)
+	{
+		int nWidth = argc > 2 ? atoi(argv[2]) : 1280;
+		int nHeight = argc > 3 ? atoi(argv[3]) : 720;
+		int nFrameCount = argc > 4 ? atoi(argv[4]) : 1;
+		const char* szCapturePath = argc > 5 ? argv[5] : "frame.tga";
+
+		if(nWidth <= 0 || nHeight <= 0 || nFrameCount <= 0)
+		{
+			std::cout << "Usage: --headless [width] [height] [frame count] [output.tga]" << std::endl;
+			return -1;
+		}
+
+		code = application->InitHeadless(nWidth, nHeight, nFrameCount, szCapturePath);
+	}
+	else
+		code = application->Init();
+
 	if (code)
 		return code;
 